@@ -21,13 +21,7 @@ using Array = std::array<T, N>;
 template <typename T>
 struct ByteHash {
     size_t operator()(const T &v) const noexcept {
-        const uint8_t *p = reinterpret_cast<const uint8_t *>(&v);
-        const size_t size = sizeof(v);
-        size_t hash = 0;
-        for (size_t i = 0; i < size; i++) {
-            hash = HashCombine(hash, p[i]);
-        }
-        return hash;
+        return HashBytes(&v, sizeof(v));
     }
 };
 
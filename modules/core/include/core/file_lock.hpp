@@ -0,0 +1,31 @@
+#pragma once
+
+#include <filesystem>
+
+#include "bismuth.hpp"
+
+BISMUTH_NAMESPACE_BEGIN
+
+// exclusive lock between processes, taken on a separate lock file so that it is kept
+// when the protected file is replaced, blocks until the lock is acquired
+class FileLock final {
+public:
+    explicit FileLock(const std::filesystem::path &path);
+    ~FileLock();
+
+    FileLock(const FileLock &rhs) = delete;
+    FileLock &operator=(const FileLock &rhs) = delete;
+
+    // false if the lock file can't be opened
+    bool Locked() const { return locked_; }
+
+private:
+#ifdef _WIN32
+    void *file_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+    bool locked_ = false;
+};
+
+BISMUTH_NAMESPACE_END
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+#include "bismuth.hpp"
+
+BISMUTH_NAMESPACE_BEGIN
+
+// read-only memory mapping of a whole file
+class MappedFile final {
+public:
+    MappedFile() = default;
+    // mapping is empty if the file doesn't exist or is empty
+    explicit MappedFile(const std::filesystem::path &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &rhs) = delete;
+    MappedFile &operator=(const MappedFile &rhs) = delete;
+
+    MappedFile(MappedFile &&rhs) noexcept;
+    MappedFile &operator=(MappedFile &&rhs) noexcept;
+
+    const uint8_t *Data() const { return data_; }
+    size_t Size() const { return size_; }
+    bool Empty() const { return size_ == 0; }
+
+private:
+    void Unmap();
+
+    const uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+BISMUTH_NAMESPACE_END
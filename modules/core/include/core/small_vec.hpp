@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <initializer_list>
+#include <memory>
+#include <new>
+
+#include "bismuth.hpp"
+#include "container.hpp"
+
+BISMUTH_NAMESPACE_BEGIN
+
+// elements are stored inline until there are more than N of them, then all of them are moved to heap
+template <typename T, size_t N>
+class SmallVec {
+public:
+    SmallVec() {}
+
+    SmallVec(std::initializer_list<T> list) { Assign(list.begin(), list.end()); }
+
+    SmallVec(const Vec<T> &vec) { Assign(vec.data(), vec.data() + vec.size()); }
+
+    SmallVec(Vec<T> &&vec) : heap_(std::move(vec)), on_heap_(true) {}
+
+    SmallVec(const SmallVec &rhs) { Assign(rhs.begin(), rhs.end()); }
+
+    SmallVec(SmallVec &&rhs) noexcept { MoveFrom(std::move(rhs)); }
+
+    ~SmallVec() { Clear(); }
+
+    SmallVec &operator=(const SmallVec &rhs) {
+        if (this != &rhs) {
+            Clear();
+            Assign(rhs.begin(), rhs.end());
+        }
+        return *this;
+    }
+
+    SmallVec &operator=(SmallVec &&rhs) noexcept {
+        if (this != &rhs) {
+            Clear();
+            MoveFrom(std::move(rhs));
+        }
+        return *this;
+    }
+
+    T *Data() { return on_heap_ ? heap_.data() : InlineData(); }
+    const T *Data() const { return on_heap_ ? heap_.data() : InlineData(); }
+
+    size_t Size() const { return on_heap_ ? heap_.size() : inline_size_; }
+
+    bool Empty() const { return Size() == 0; }
+
+    bool IsInline() const { return !on_heap_; }
+
+    T &operator[](size_t index) { return Data()[index]; }
+    const T &operator[](size_t index) const { return Data()[index]; }
+
+    template <typename... Args>
+    T &EmplaceBack(Args &&... args) {
+        if (!on_heap_ && inline_size_ == N) {
+            MoveToHeap();
+        }
+        if (on_heap_) {
+            return heap_.emplace_back(std::forward<Args>(args)...);
+        }
+        T *elem = new (InlineData() + inline_size_) T(std::forward<Args>(args)...);
+        ++inline_size_;
+        return *elem;
+    }
+
+    void PushBack(const T &value) { EmplaceBack(value); }
+    void PushBack(T &&value) { EmplaceBack(std::move(value)); }
+
+    void Clear() {
+        if (on_heap_) {
+            heap_.clear();
+            on_heap_ = false;
+        } else {
+            std::destroy_n(InlineData(), inline_size_);
+            inline_size_ = 0;
+        }
+    }
+
+    T *begin() { return Data(); }
+    T *end() { return Data() + Size(); }
+    const T *begin() const { return Data(); }
+    const T *end() const { return Data() + Size(); }
+    size_t size() const { return Size(); }
+
+    bool operator==(const SmallVec &rhs) const { return std::equal(begin(), end(), rhs.begin(), rhs.end()); }
+
+private:
+    T *InlineData() { return std::launder(reinterpret_cast<T *>(inline_storage_)); }
+    const T *InlineData() const { return std::launder(reinterpret_cast<const T *>(inline_storage_)); }
+
+    void Assign(const T *first, const T *last) {
+        const size_t size = last - first;
+        if (size > N) {
+            heap_.assign(first, last);
+            on_heap_ = true;
+        } else {
+            std::uninitialized_copy(first, last, InlineData());
+            inline_size_ = size;
+        }
+    }
+
+    void MoveFrom(SmallVec &&rhs) {
+        if (rhs.on_heap_) {
+            heap_ = std::move(rhs.heap_);
+            on_heap_ = true;
+            rhs.heap_.clear();
+            rhs.on_heap_ = false;
+        } else {
+            std::uninitialized_move_n(rhs.InlineData(), rhs.inline_size_, InlineData());
+            inline_size_ = rhs.inline_size_;
+            rhs.Clear();
+        }
+    }
+
+    void MoveToHeap() {
+        heap_.reserve(2 * N);
+        heap_.insert(heap_.end(), std::make_move_iterator(InlineData()),
+            std::make_move_iterator(InlineData() + inline_size_));
+        std::destroy_n(InlineData(), inline_size_);
+        inline_size_ = 0;
+        on_heap_ = true;
+    }
+
+    alignas(T) uint8_t inline_storage_[N * sizeof(T)];
+    size_t inline_size_ = 0;
+    Vec<T> heap_;
+    bool on_heap_ = false;
+};
+
+BISMUTH_NAMESPACE_END
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+#include "container.hpp"
+
+BISMUTH_NAMESPACE_BEGIN
+
+class ThreadPool final {
+public:
+    explicit ThreadPool(uint32_t num_threads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &rhs) = delete;
+    ThreadPool &operator=(const ThreadPool &rhs) = delete;
+
+    uint32_t NumThreads() const { return static_cast<uint32_t>(workers_.size()); }
+
+    template <typename F>
+    auto Submit(F &&func) -> std::future<std::invoke_result_t<F>> {
+        using R = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(func));
+        auto future = task->get_future();
+        Enqueue([task]() { (*task)(); });
+        return future;
+    }
+
+    // run func(0) ... func(count - 1) on workers and block until all of them finish
+    // must not be called from a worker of the same pool
+    void ParallelFor(size_t count, const std::function<void(size_t)> &func);
+
+private:
+    void Enqueue(std::function<void()> &&task);
+    void WorkerLoop();
+
+    Vec<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+};
+
+BISMUTH_NAMESPACE_END
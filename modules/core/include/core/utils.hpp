@@ -2,6 +2,8 @@
 
 #include <functional>
 #include <filesystem>
+#include <bit>
+#include <cstring>
 
 #include "bismuth.hpp"
 
@@ -17,6 +19,38 @@ size_t HashCombine(size_t seed, const T &v) {
     return HashCombine(seed, hasher(v));
 }
 
+// hash 8 bytes at a time, based on MurmurHash3
+inline size_t HashBytes(const void *data, size_t size, size_t seed = 0) {
+    auto mix_word = [](uint64_t hash, uint64_t word) {
+        word *= 0x87c37b91114253d5ull;
+        word = std::rotl(word, 31);
+        word *= 0x4cf5ad432745937full;
+        hash ^= word;
+        return std::rotl(hash, 27) * 5 + 0x52dce729;
+    };
+
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    uint64_t hash = seed ^ size;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, p + i, sizeof(uint64_t));
+        hash = mix_word(hash, word);
+    }
+    if (i < size) {
+        uint64_t word = 0;
+        std::memcpy(&word, p + i, size - i);
+        hash = mix_word(hash, word);
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    hash ^= hash >> 33;
+    return static_cast<size_t>(hash);
+}
+
 template <typename T>
 size_t Hash(const T &v) {
     std::hash<T> hasher;
@@ -37,4 +71,12 @@ size_t Hash(const T &first, Args &&... last) {
 
 std::filesystem::path CurrentExecutablePath();
 
+// 'path' with a suffix of process id and a random number, for writing a file before renaming it to 'path',
+// so that processes or threads saving the same file don't write to the same temporary one
+std::filesystem::path UniqueTempPath(const std::filesystem::path &path);
+
+// flush written data of the file to the storage device, not only to the os,
+// return false if the file can't be opened or flushed
+bool SyncFile(const std::filesystem::path &path);
+
 BISMUTH_NAMESPACE_END
@@ -0,0 +1,54 @@
+#include "core/file_lock.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+BISMUTH_NAMESPACE_BEGIN
+
+FileLock::FileLock(const std::filesystem::path &path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    file_ = file;
+    OVERLAPPED overlapped {};
+    locked_ = LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &overlapped);
+#else
+    fd_ = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0) {
+        return;
+    }
+    int result;
+    do {
+        result = flock(fd_, LOCK_EX);
+    } while (result != 0 && errno == EINTR);
+    locked_ = result == 0;
+#endif
+}
+
+FileLock::~FileLock() {
+#ifdef _WIN32
+    if (file_ != nullptr) {
+        if (locked_) {
+            OVERLAPPED overlapped {};
+            UnlockFileEx(file_, 0, MAXDWORD, MAXDWORD, &overlapped);
+        }
+        CloseHandle(file_);
+    }
+#else
+    // closing the file releases the lock
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+#endif
+}
+
+BISMUTH_NAMESPACE_END
@@ -0,0 +1,59 @@
+#include "core/thread_pool.hpp"
+
+BISMUTH_NAMESPACE_BEGIN
+
+ThreadPool::ThreadPool(uint32_t num_threads) {
+    num_threads = std::max(num_threads, 1u);
+    workers_.reserve(num_threads);
+    for (uint32_t i = 0; i < num_threads; i++) {
+        workers_.emplace_back([this]() { WorkerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto &worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)> &func) {
+    Vec<std::future<void>> futures;
+    futures.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        futures.emplace_back(Submit([&func, i]() { func(i); }));
+    }
+    for (auto &future : futures) {
+        future.get();
+    }
+}
+
+void ThreadPool::Enqueue(std::function<void()> &&task) {
+    {
+        std::lock_guard lock(mutex_);
+        tasks_.push(std::move(task));
+    }
+    cv_.notify_one();
+}
+
+void ThreadPool::WorkerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(mutex_);
+            cv_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            if (stopping_ && tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop();
+        }
+        task();
+    }
+}
+
+BISMUTH_NAMESPACE_END
@@ -1,8 +1,12 @@
 #include "core/utils.hpp"
 
+#include <random>
+#include <string>
+
 #ifdef _WIN32
 #include <windows.h>
 #else
+#include <fcntl.h>
 #include <limits.h>
 #include <unistd.h>
 #endif
@@ -21,4 +25,37 @@ std::filesystem::path CurrentExecutablePath() {
 #endif
 }
 
+std::filesystem::path UniqueTempPath(const std::filesystem::path &path) {
+#ifdef _WIN32
+    const auto pid = static_cast<uint32_t>(GetCurrentProcessId());
+#else
+    const auto pid = static_cast<uint32_t>(getpid());
+#endif
+    thread_local std::mt19937 rng(std::random_device {}());
+    auto temp_path = path;
+    temp_path += "." + std::to_string(pid) + "-" + std::to_string(rng()) + ".tmp";
+    return temp_path;
+}
+
+bool SyncFile(const std::filesystem::path &path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    const bool succeeded = FlushFileBuffers(file);
+    CloseHandle(file);
+    return succeeded;
+#else
+    int fd = open(path.c_str(), O_RDWR);
+    if (fd < 0) {
+        return false;
+    }
+    const bool succeeded = fsync(fd) == 0;
+    close(fd);
+    return succeeded;
+#endif
+}
+
 BISMUTH_NAMESPACE_END
@@ -7,3 +7,6 @@ target("bismuth-core")
     add_headerfiles("src/core/**.hpp", {install = false})
     add_includedirs("include/", {public = true})
     add_packages("spdlog", {public = true})
+    if is_plat("linux") then
+        add_syslinks("pthread", {public = true})
+    end
@@ -0,0 +1,127 @@
+#include <chrono>
+
+#include <GLFW/glfw3.h>
+
+#include <core/module_manager.hpp>
+#include <graphics/bench.hpp>
+#include <graphics/device.hpp>
+#include <graphics/pipeline.hpp>
+#include <graphics/shader_compiler.hpp>
+
+using namespace bismuth;
+
+// more descriptors than a push descriptor set can hold, so that sets go through the descriptor set cache
+static constexpr uint32_t kNumBindings = 20;
+// distinct params bound in turn, all but the first bind of each one hit the cache
+static constexpr uint32_t kNumDistinctParams = 16;
+static constexpr uint32_t kNumBindsPerFrame = 100000;
+static constexpr uint32_t kNumFrames = 10;
+
+int main(int argc, char **argv) {
+    gfx::GraphicsBackend backend = gfx::GraphicsBackend::eVulkan;
+#ifdef WIN32
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && (strcmp("--backend", argv[i]) == 0 || strcmp("-b", argv[i]) == 0)) {
+            ++i;
+            if (strcmp("d3d12", argv[i]) == 0) {
+                backend = gfx::GraphicsBackend::eD3D12;
+            } else if (strcmp("vulkan", argv[i]) == 0) {
+                backend = gfx::GraphicsBackend::eVulkan;
+            } else {
+                BI_WARN(gGeneralLogger, "unknown backend '{}'", argv[i]);
+                return -1;
+            }
+        } else {
+            BI_WARN(gGeneralLogger, "unknown argument '{}'", argv[i]);
+            return -1;
+        }
+    }
+#endif
+    BI_INFO(gGeneralLogger, "Use backend: {}", backend == gfx::GraphicsBackend::eVulkan ? "Vulkan" : "D3D12");
+
+    glfwInit();
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow *window = glfwCreateWindow(64, 64, "Bismuth", nullptr, nullptr);
+
+    ModuleManager::Load<gfx::GraphicsModule>();
+
+    // validation layers would dominate the measured time
+    gfx::DeviceDesc device_desc {
+        .backend = backend,
+        .enable_validation = false,
+        .window = window,
+    };
+    auto device = gfx::Device::Create(device_desc);
+    auto context = device->CreateFrameContext();
+
+    gfx::TextureDesc texture_desc {
+        .name = "bench texture",
+        .extent = { 4, 4 },
+        .levels = 1,
+        .format = gfx::ResourceFormat::eRgba8UNorm,
+        .dim = gfx::TextureDimension::e2D,
+        .usages = { gfx::TextureUsage::eSampled },
+    };
+    Ptr<gfx::Texture> textures[2] = { device->CreateTexture(texture_desc), device->CreateTexture(texture_desc) };
+
+    gfx::DescriptorSetLayout set_layout {};
+    for (uint32_t i = 0; i < kNumBindings; i++) {
+        set_layout.bindings.push_back(gfx::DescriptorSetLayoutBinding {
+            .type = gfx::DescriptorType::eSampledTexture,
+            .tex_dim = gfx::TextureViewDimension::e2D,
+            .count = 1,
+        });
+    }
+
+    std::filesystem::path shader_file = std::filesystem::path(kBenchDir) / "descriptor_set.hlsl";
+    auto shader_bytes = device->GetShaderCompiler()->Compile(shader_file, "MainCS", gfx::ShaderStage::eCompute);
+    auto shader = device->CreateShaderModule(shader_bytes);
+    gfx::ComputePipelineDesc pipeline_desc {
+        .name = "bench pipeline",
+        .layout = gfx::PipelineLayout {
+            .sets_layout = { set_layout },
+            .push_constants_size = 0,
+        },
+        .thread_group = { 1, 1, 1 },
+        .compute = shader.AsRef(),
+    };
+    auto pipeline = device->CreateComputePipeline(pipeline_desc);
+
+    // bits of the index choose textures of the first bindings
+    Vec<gfx::ShaderParams> params;
+    for (uint32_t i = 0; i < kNumDistinctParams; i++) {
+        Vec<gfx::BindingResource> resources;
+        for (uint32_t binding = 0; binding < kNumBindings; binding++) {
+            resources.push_back(gfx::TextureView { textures[(i >> binding) & 1].AsRef() });
+        }
+        params.push_back(gfx::ShaderParams(std::move(resources)));
+    }
+
+    double total_time_ms = 0.0;
+    for (uint32_t frame = 0; frame < kNumFrames; frame++) {
+        context->Reset();
+        auto cmd_encoder = context->GetCommandEncoder();
+        {
+            auto compute_encoder = cmd_encoder->BeginComputePass({ "bench" });
+            compute_encoder->SetPipeline(pipeline);
+
+            const auto start = std::chrono::steady_clock::now();
+            for (uint32_t i = 0; i < kNumBindsPerFrame; i++) {
+                compute_encoder->BindShaderParams(0, params[i % kNumDistinctParams]);
+            }
+            total_time_ms +=
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        // recorded commands are never submitted
+        cmd_encoder->Finish();
+    }
+
+    const auto stats = context->GetDescriptorStats();
+    BI_INFO(gGeneralLogger, "BindShaderParams: {:.1f} ns per call, cache hit rate of last frame: {:.4f}",
+        total_time_ms * 1e6 / (static_cast<double>(kNumBindsPerFrame) * kNumFrames), stats.CacheHitRate());
+
+    glfwDestroyWindow(window);
+
+    return 0;
+}
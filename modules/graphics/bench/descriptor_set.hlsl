@@ -0,0 +1,2 @@
+[numthreads(1, 1, 1)]
+void MainCS() {}
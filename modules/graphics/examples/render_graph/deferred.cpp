@@ -260,42 +260,23 @@ int main(int argc, char **argv) {
 
 
     auto shader_compiler = device->GetShaderCompiler();
+    // reflection of compiling is reused by module, it's stripped from d3d12 binaries in release mode
+    auto create_shader_module = [&](const std::filesystem::path &path, const char *entry, gfx::ShaderStage stage) {
+        gfx::ShaderCompileInfo info;
+        auto bytes = shader_compiler->Compile(path, entry, stage, {}, {}, {}, &info);
+        return device->CreateShaderModule(bytes, &info.reflection);
+    };
 
     std::filesystem::path gbuffer_shader = std::filesystem::path(kExamplesDir) / "render_graph/deferred_gbuffer.hlsl";
-    auto gbuffer_vs_bytes = shader_compiler->Compile(gbuffer_shader, "VS", gfx::ShaderStage::eVertex);
-    auto gbuffer_vs_sm = device->CreateShaderModule(gbuffer_vs_bytes);
-    auto gbuffer_fs_bytes = shader_compiler->Compile(gbuffer_shader, "FS", gfx::ShaderStage::eFragment);
-    auto gbuffer_fs_sm = device->CreateShaderModule(gbuffer_fs_bytes);
+    auto gbuffer_vs_sm = create_shader_module(gbuffer_shader, "VS", gfx::ShaderStage::eVertex);
+    auto gbuffer_fs_sm = create_shader_module(gbuffer_shader, "FS", gfx::ShaderStage::eFragment);
 
     std::filesystem::path lighting_shader = std::filesystem::path(kExamplesDir) / "render_graph/deferred_lighting.hlsl";
-    auto lighting_vs_bytes = shader_compiler->Compile(lighting_shader, "VS", gfx::ShaderStage::eVertex);
-    auto lighting_vs_sm = device->CreateShaderModule(lighting_vs_bytes);
-    auto lighting_fs_bytes = shader_compiler->Compile(lighting_shader, "FS", gfx::ShaderStage::eFragment);
-    auto lighting_fs_sm = device->CreateShaderModule(lighting_fs_bytes);
-
-    gfx::PipelineLayout gbuffer_pipeline_layout {
-        .sets_layout = {
-            gfx::DescriptorSetLayout {
-                .bindings = {
-                    gfx::DescriptorSetLayoutBinding { .type = gfx::DescriptorType::eNone },
-                    gfx::DescriptorSetLayoutBinding {
-                        .type = gfx::DescriptorType::eUniformBuffer,
-                        .count = 1,
-                        .struct_stride = sizeof(Camera),
-                    },
-                    gfx::DescriptorSetLayoutBinding {
-                        .type = gfx::DescriptorType::eStorageBuffer,
-                        .count = 1,
-                        .struct_stride = sizeof(InstanceData),
-                    },
-                }
-            },
-        },
-        .push_constants_size = 0,
-    };
+    auto lighting_vs_sm = create_shader_module(lighting_shader, "VS", gfx::ShaderStage::eVertex);
+    auto lighting_fs_sm = create_shader_module(lighting_shader, "FS", gfx::ShaderStage::eFragment);
+
     gfx::RenderPipelineDesc gbuffer_pipeline_desc {
         .name = "gbuffer pipeline",
-        .layout = gbuffer_pipeline_layout,
         .vertex_input_buffers = {
             gfx::VertexInputBufferDesc {
                 .stride = 6 * sizeof(float),
@@ -318,45 +299,12 @@ int main(int argc, char **argv) {
             .fragment = gbuffer_fs_sm.AsRef(),
         }
     };
+    // layout is derived from shaders, so it can't mismatch them
+    gbuffer_pipeline_desc.layout = gfx::ReflectPipelineLayout(gbuffer_pipeline_desc.shaders);
     auto gbuffer_pipeline = device->CreateRenderPipeline(gbuffer_pipeline_desc);
 
-    gfx::PipelineLayout lighting_pipeline_layout {
-        .sets_layout = {
-            gfx::DescriptorSetLayout {
-                .bindings = {
-                    gfx::DescriptorSetLayoutBinding { .type = gfx::DescriptorType::eNone },
-                    gfx::DescriptorSetLayoutBinding {
-                        .type = gfx::DescriptorType::eSampledTexture,
-                        .tex_dim = gfx::TextureViewDimension::e2D,
-                        .count = 1,
-                    },
-                    gfx::DescriptorSetLayoutBinding {
-                        .type = gfx::DescriptorType::eSampledTexture,
-                        .tex_dim = gfx::TextureViewDimension::e2D,
-                        .count = 1,
-                    },
-                    gfx::DescriptorSetLayoutBinding {
-                        .type = gfx::DescriptorType::eSampledTexture,
-                        .tex_dim = gfx::TextureViewDimension::e2D,
-                        .count = 1,
-                    },
-                },
-            },
-            gfx::DescriptorSetLayout {
-                .bindings = {
-                    gfx::DescriptorSetLayoutBinding {
-                        .type = gfx::DescriptorType::eUniformBuffer,
-                        .count = 1,
-                        .struct_stride = sizeof(PointLight),
-                    },
-                }
-            },
-        },
-        .push_constants_size = 0,
-    };
     gfx::RenderPipelineDesc lighting_pipeline_desc {
         .name = "lighting pipeline",
-        .layout = lighting_pipeline_layout,
         .vertex_input_buffers = {},
         .primitive_state = gfx::PrimitiveState {},
         .depth_stencil_state = gfx::DepthStencilState {},
@@ -368,6 +316,7 @@ int main(int argc, char **argv) {
             .fragment = lighting_fs_sm.AsRef(),
         }
     };
+    lighting_pipeline_desc.layout = gfx::ReflectPipelineLayout(lighting_pipeline_desc.shaders);
     auto lighting_pipeline = device->CreateRenderPipeline(lighting_pipeline_desc);
 
     uint32_t curr_frame = 0;
@@ -4,6 +4,7 @@
 
 #include "core/span.hpp"
 #include "descriptor.hpp"
+#include "query.hpp"
 
 BISMUTH_NAMESPACE_BEGIN
 
@@ -72,6 +73,8 @@ struct BufferBarrier {
     BitFlags<ResourceAccessType> dst_access_type;
     class Queue *src_queue = nullptr;
     class Queue *dst_queue = nullptr;
+    // memory may have been used by other placed resource, previous contents are discarded
+    bool discard = false;
 };
 struct TextureBarrier {
     TextureView texture;
@@ -79,6 +82,18 @@ struct TextureBarrier {
     BitFlags<ResourceAccessType> dst_access_type;
     class Queue *src_queue = nullptr;
     class Queue *dst_queue = nullptr;
+    // memory may have been used by other placed resource, previous contents are discarded
+    bool discard = false;
+};
+
+// barriers recorded in two halves, the first half after the last access of resources
+// and the second half before the next access, commands in between don't need to wait for them
+class SplitBarrier {
+public:
+    virtual ~SplitBarrier() = default;
+
+protected:
+    SplitBarrier() = default;
 };
 
 struct Viewport {
@@ -139,6 +154,16 @@ public:
 
     virtual void ResourceBarrier(Span<BufferBarrier> buffer_barriers, Span<TextureBarrier> texture_barriers) = 0;
 
+    // both halves of a split barrier must be recorded in the same command encoder
+    virtual void BeginSplitBarrier(Span<Ref<SplitBarrier>> barriers) = 0;
+    virtual void EndSplitBarrier(Span<Ref<SplitBarrier>> barriers) = 0;
+
+    // queries must be reset before they are written, outside of render passes
+    virtual void ResetQueries(Ref<QuerySet> query_set, uint32_t first_query, uint32_t num_queries) = 0;
+    // written when all previous commands are finished
+    virtual void WriteTimestamp(Ref<QuerySet> query_set, uint32_t query) = 0;
+    virtual void ResolveQueries(Ref<QuerySet> query_set, uint32_t first_query, uint32_t num_queries) = 0;
+
     virtual Ptr<RenderCommandEncoder> BeginRenderPass(const CommandLabel &label, const RenderTargetDesc &desc) = 0;
 
     virtual Ptr<ComputeCommandEncoder> BeginComputePass(const CommandLabel &label) = 0;
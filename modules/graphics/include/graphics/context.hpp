@@ -7,14 +7,43 @@ BISMUTH_NAMESPACE_BEGIN
 
 BISMUTH_GFX_NAMESPACE_BEGIN
 
+struct DescriptorAllocationStats {
+    // counted since last reset
+    size_t num_cache_hits = 0;
+    size_t num_cache_misses = 0;
+    size_t num_allocated_sets = 0;
+    // descriptor pools (vulkan) or shader visible descriptor heaps (d3d12)
+    size_t num_pools = 0;
+    size_t num_used_pools = 0;
+
+    float CacheHitRate() const {
+        const size_t num_lookups = num_cache_hits + num_cache_misses;
+        return num_lookups == 0 ? 0.0f : static_cast<float>(num_cache_hits) / num_lookups;
+    }
+};
+
 class FrameContext {
 public:
     virtual ~FrameContext() = default;
 
+    // resources allocated from this context, including descriptor sets, are recycled,
+    // so they must no longer be used by gpu
     virtual void Reset() = 0;
 
     virtual Ptr<class CommandEncoder> GetCommandEncoder(QueueType queue = QueueType::eGraphics) = 0;
 
+    // context used to record commands on another thread, it owns separate command and descriptor pools
+    // and is reset along with this one, index 0 is this context itself
+    // must be called on the thread that owns this context
+    virtual Ref<FrameContext> GetThreadContext(uint32_t thread_index) = 0;
+
+    // split barriers are valid until this context is reset
+    virtual Ref<SplitBarrier> CreateSplitBarrier(Span<BufferBarrier> buffer_barriers,
+        Span<TextureBarrier> texture_barriers) = 0;
+
+    // summed over this context and its thread contexts
+    virtual DescriptorAllocationStats GetDescriptorStats() const = 0;
+
 protected:
     FrameContext() = default;
 };
@@ -13,6 +13,10 @@ enum class GraphicsBackend : uint8_t {
     eD3D12,
 };
 
+// index of a resource in the global bindless descriptor set, invalid if bindless is disabled
+// or resource usage doesn't allow it
+inline constexpr uint32_t kInvalidBindlessIndex = ~0u;
+
 struct Extent3D {
     uint32_t width = 1;
     uint32_t height = 1;
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <algorithm>
+
 #include "core/container.hpp"
+#include "core/small_vec.hpp"
 #include "core/span.hpp"
 #include "core/variant.hpp"
 #include "resource.hpp"
@@ -49,10 +52,16 @@ struct DescriptorSetLayoutBinding {
     ResourceFormat tex_format = ResourceFormat::eUndefined;
     uint32_t count = 1;
     uint32_t struct_stride = 0;
-    Span<Ref<Sampler>> immutable_samplers = {};
+    // owned by layout, since layouts are copied into pipelines and used as long-lived cache keys,
+    // compared by unique ids so that a new sampler at the address of a destroyed one is not taken for it
+    Vec<Ref<Sampler>> immutable_samplers = {};
 
     bool operator==(const DescriptorSetLayoutBinding &rhs) const {
-        return type == rhs.type && count == rhs.count;
+        return type == rhs.type && tex_dim == rhs.tex_dim && tex_format == rhs.tex_format && count == rhs.count
+            && struct_stride == rhs.struct_stride
+            && std::equal(immutable_samplers.begin(), immutable_samplers.end(),
+                rhs.immutable_samplers.begin(), rhs.immutable_samplers.end(),
+                [](Ref<Sampler> a, Ref<Sampler> b) { return a->UniqueId() == b->UniqueId(); });
     }
 };
 struct DescriptorSetLayout {
@@ -64,17 +73,75 @@ struct DescriptorSetLayout {
 template <typename T>
 struct PushConstants { T value; };
 
+// bindings of the global bindless descriptor set, each one is an array indexed by bindless indices of resources
+enum class BindlessBinding : uint32_t {
+    eSampledTexture,
+    eStorageTexture,
+    eStorageBuffer,
+    eSampler,
+};
+inline constexpr uint32_t kNumBindlessBindings = 4;
+
+inline constexpr uint32_t kNoBindlessSet = ~0u;
+
 struct PipelineLayout {
     Vec<DescriptorSetLayout> sets_layout;
     uint32_t push_constants_size;
+    // global bindless set of device is bound at this set index when pipeline is set,
+    // sets_layout[bindless_set] is ignored if it exists
+    uint32_t bindless_set = kNoBindlessSet;
+
+    bool operator==(const PipelineLayout &rhs) const = default;
 };
 
-struct ShaderParams {
-    Vec<BindingResource> resources;
+// params of most sets fit in inline storage and can be built without heap allocation
+inline constexpr size_t kNumInlineShaderParams = 8;
+
+// resources can't be modified after construction, so the cached hash never goes stale
+class ShaderParams {
+public:
+    ShaderParams() = default;
+    ShaderParams(SmallVec<BindingResource, kNumInlineShaderParams> resources) : resources_(std::move(resources)) {}
+
+    // indexed by binding
+    const SmallVec<BindingResource, kNumInlineShaderParams> &Resources() const { return resources_; }
+
+    // computed when first called and then cached
+    size_t Hash() const;
+
+    bool operator==(const ShaderParams &rhs) const {
+        return Hash() == rhs.Hash() && resources_ == rhs.resources_;
+    }
 
-    bool operator==(const ShaderParams &rhs) const = default;
+private:
+    SmallVec<BindingResource, kNumInlineShaderParams> resources_;
+    // 0 if not computed yet
+    mutable size_t cached_hash_ = 0;
 };
 
+inline size_t ShaderParams::Hash() const {
+    if (cached_hash_ != 0) {
+        return cached_hash_;
+    }
+    size_t hash = resources_.size();
+    for (const auto &resource : resources_) {
+        hash = HashCombine(hash, resource.index());
+        hash = resource.Match(
+            [hash](std::monostate) {
+                return hash;
+            },
+            [hash]<typename T>(const Vec<T> &r) {
+                return HashBytes(r.data(), r.size() * sizeof(T), hash);
+            },
+            [hash]<typename T>(const T &r) {
+                return HashBytes(&r, sizeof(T), hash);
+            }
+        );
+    }
+    cached_hash_ = hash == 0 ? 1 : hash;
+    return cached_hash_;
+}
+
 BISMUTH_GFX_NAMESPACE_END
 
 BISMUTH_NAMESPACE_END
@@ -84,36 +151,30 @@ struct std::hash<bismuth::gfx::DescriptorSetLayout> {
     size_t operator()(const bismuth::gfx::DescriptorSetLayout &v) const noexcept {
         size_t hash = 0;
         for (const auto &binding : v.bindings) {
-            hash = bismuth::HashCombine(hash, bismuth::Hash(binding.type, binding.count));
+            hash = bismuth::HashCombine(hash, bismuth::Hash(binding.type, binding.tex_dim, binding.tex_format,
+                binding.count, binding.struct_stride));
+            for (const auto &sampler : binding.immutable_samplers) {
+                hash = bismuth::HashCombine(hash, sampler->UniqueId());
+            }
         }
         return hash;
     }
 };
 
 template <>
-struct std::hash<bismuth::gfx::ShaderParams> {
-    size_t operator()(const bismuth::gfx::ShaderParams &v) const noexcept {
-        size_t hash = 0;
-        for (const auto &resource : v.resources) {
-            size_t resource_hash = resource.Match(
-                [](std::monostate) -> size_t {
-                    return 0;
-                },
-                []<typename T>(const bismuth::Vec<T> &r) {
-                    bismuth::ByteHash<T> hasher;
-                    size_t hash = 0;
-                    for (const auto &rr : r) {
-                        hash = bismuth::HashCombine(hash, hasher(rr));
-                    }
-                    return hash;
-                },
-                []<typename T>(const T &r) {
-                    bismuth::ByteHash<T> hasher;
-                    return hasher(r);
-                }
-            );
-            hash = bismuth::HashCombine(hash, resource_hash);
+struct std::hash<bismuth::gfx::PipelineLayout> {
+    size_t operator()(const bismuth::gfx::PipelineLayout &v) const noexcept {
+        size_t hash = bismuth::Hash(v.push_constants_size, v.bindless_set);
+        for (const auto &set_layout : v.sets_layout) {
+            hash = bismuth::HashCombine(hash, set_layout);
         }
         return hash;
     }
 };
+
+template <>
+struct std::hash<bismuth::gfx::ShaderParams> {
+    size_t operator()(const bismuth::gfx::ShaderParams &v) const noexcept {
+        return v.Hash();
+    }
+};
@@ -1,6 +1,12 @@
 #pragma once
 
 #include <memory>
+#include <filesystem>
+#include <future>
+#include <mutex>
+
+#include "core/span.hpp"
+#include "core/thread_pool.hpp"
 
 #include "defines.hpp"
 #include "queue.hpp"
@@ -24,6 +30,51 @@ struct DeviceDesc {
     bool enable_validation = false;
     GLFWwindow *window = nullptr;
     ResourceFormat surface_format = ResourceFormat::eBgra8Srgb;
+    // create global bindless descriptor set, ignored if not supported
+    bool enable_bindless = false;
+    // driver pipeline cache is loaded from and saved to this file, relative path is relative to executable path,
+    // cache isn't persisted if empty
+    std::filesystem::path pipeline_cache_file = "pipeline_cache.bin";
+    // compiled shader binaries are cached in an archive in this directory, relative path is relative to executable
+    // path, binaries are only cached in memory if empty
+    std::filesystem::path shader_cache_dir = "shader_cache";
+};
+
+// pipeline being created on worker threads of device
+template <typename Pipeline>
+class AsyncPipeline {
+public:
+    explicit AsyncPipeline(std::future<Ptr<Pipeline>> &&future) : future_(std::move(future)) {}
+
+    bool IsReady() const {
+        return pipeline_.IsInitialized() || future_.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    // null if pipeline is still being created
+    Pipeline *TryGet() {
+        if (!pipeline_.IsInitialized() && IsReady()) {
+            pipeline_ = future_.get();
+        }
+        return pipeline_.Get();
+    }
+
+    // block until pipeline is created
+    Ref<Pipeline> Wait() {
+        if (!pipeline_.IsInitialized()) {
+            pipeline_ = future_.get();
+        }
+        return pipeline_.AsRef();
+    }
+
+    // block until pipeline is created and take its ownership, this handle can't be used anymore
+    Ptr<Pipeline> Take() {
+        Wait();
+        return std::move(pipeline_);
+    }
+
+private:
+    std::future<Ptr<Pipeline>> future_;
+    Ptr<Pipeline> pipeline_;
 };
 
 class Device {
@@ -43,13 +94,25 @@ public:
 #endif
     virtual Ptr<Semaphore> CreateSemaphore() = 0;
 
+    virtual Ptr<QuerySet> CreateQuerySet(const QuerySetDesc &desc) = 0;
+
     virtual Ptr<Buffer> CreateBuffer(const BufferDesc &desc) = 0;
 
     virtual Ptr<Texture> CreateTexture(const TextureDesc &desc) = 0;
 
+    virtual ResourceMemoryRequirements GetBufferMemoryRequirements(const BufferDesc &desc) = 0;
+    virtual ResourceMemoryRequirements GetTextureMemoryRequirements(const TextureDesc &desc) = 0;
+
+    virtual Ptr<MemoryHeap> CreateMemoryHeap(const MemoryHeapDesc &desc) = 0;
+
+    virtual Ptr<Buffer> CreatePlacedBuffer(const BufferDesc &desc, Ref<MemoryHeap> heap, uint64_t offset) = 0;
+    virtual Ptr<Texture> CreatePlacedTexture(const TextureDesc &desc, Ref<MemoryHeap> heap, uint64_t offset) = 0;
+
     virtual Ptr<Sampler> CreateSampler(const SamplerDesc &desc) = 0;
 
-    virtual Ptr<ShaderModule> CreateShaderModule(const Vec<uint8_t> &src_bytes) = 0;
+    // binary is reflected when module is created if 'reflection' is null
+    virtual Ptr<ShaderModule> CreateShaderModule(Span<uint8_t> src_bytes,
+        const ShaderReflection *reflection = nullptr) = 0;
 
     virtual Ref<ShaderCompiler> GetShaderCompiler() const = 0;
 
@@ -57,10 +120,31 @@ public:
 
     virtual Ptr<ComputePipeline> CreateComputePipeline(const ComputePipelineDesc &desc) = 0;
 
+    // pipelines are created in parallel on worker threads of device, descs are copied,
+    // render pipeline descs must have target formats, otherwise compilation would still happen when first bound
+    Vec<AsyncPipeline<RenderPipeline>> CreateRenderPipelinesAsync(Span<RenderPipelineDesc> descs);
+    Vec<AsyncPipeline<ComputePipeline>> CreateComputePipelinesAsync(Span<ComputePipelineDesc> descs);
+
     virtual Ptr<FrameContext> CreateFrameContext() = 0;
 
+    virtual bool BindlessEnabled() const = 0;
+
+    // whether pipeline descs can have specialization constants
+    virtual bool SpecializationConstantsSupported() const = 0;
+
+    virtual PipelineCacheStats GetPipelineCacheStats() const = 0;
+
 protected:
     Device() = default;
+
+    // must be called at the beginning of destructor of backend device, pending pipelines are finished first
+    void WaitPipelineCreation();
+
+private:
+    ThreadPool &PipelineThreadPool();
+
+    std::once_flag pipeline_thread_pool_flag_;
+    Ptr<ThreadPool> pipeline_thread_pool_;
 };
 
 BISMUTH_GFX_NAMESPACE_END
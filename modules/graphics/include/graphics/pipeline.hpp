@@ -30,11 +30,15 @@ struct VertexInputAttribute {
     uint32_t offset;
     VertexSemantics semantics;
     ResourceFormat format;
+
+    bool operator==(const VertexInputAttribute &rhs) const = default;
 };
 struct VertexInputBufferDesc {
     uint32_t stride = 0;
     bool per_instance = 0;
     Vec<VertexInputAttribute> attributes;
+
+    bool operator==(const VertexInputBufferDesc &rhs) const = default;
 };
 
 enum class PrimitiveTopology : uint8_t {
@@ -69,6 +73,8 @@ struct PrimitiveState {
     CullMode cull_mode = CullMode::eNone;
     PolygonMode polygon_mode = PolygonMode::eFill;
     bool conservative = false;
+
+    bool operator==(const PrimitiveState &rhs) const = default;
 };
 
 enum class StencilOp : uint8_t {
@@ -86,9 +92,11 @@ struct StencilFaceState {
     StencilOp fail_op = StencilOp::eKeep;
     StencilOp pass_op = StencilOp::eKeep;
     StencilOp depth_fail_op = StencilOp::eKeep;
+
+    bool operator==(const StencilFaceState &rhs) const = default;
 };
 struct DepthStencilState {
-    // not needed
+    // optional, see HasTargetFormats()
     ResourceFormat format = ResourceFormat::eUndefined;
     bool depth_write : 1 = true;
     bool depth_test : 1 = true;
@@ -99,6 +107,8 @@ struct DepthStencilState {
     uint8_t stencil_compare_mask = 0xff;
     uint8_t stencil_write_mask = 0xff;
     uint8_t stencil_reference = 0;
+
+    bool operator==(const DepthStencilState &rhs) const = default;
 };
 
 enum class BlendOp : uint8_t {
@@ -132,7 +142,7 @@ enum class ColorWriteComponent : uint8_t {
     eRgba = eR | eG | eB | eA,
 };
 struct ColorTargetAttachmentState {
-    // not needed
+    // optional, see HasTargetFormats()
     ResourceFormat format = ResourceFormat::eUndefined;
     bool blend_enable = false;
     BlendOp blend_op = BlendOp::eAdd;
@@ -142,17 +152,38 @@ struct ColorTargetAttachmentState {
     BlendFactor src_alpha_blend_factor = BlendFactor::eOne;
     BlendFactor dst_alpha_blend_factor = BlendFactor::eZero;
     BitFlags<ColorWriteComponent> color_write_mask = { ColorWriteComponent::eRgba };
+
+    bool operator==(const ColorTargetAttachmentState &rhs) const = default;
 };
 struct ColorTargetState {
     Vec<ColorTargetAttachmentState> attachments;
-    struct {
+    struct BlendConstants {
         float r = 0.0f;
         float g = 0.0f;
         float b = 0.0f;
         float a = 0.0f;
+
+        bool operator==(const BlendConstants &rhs) const = default;
     } blend_constants;
+
+    bool operator==(const ColorTargetState &rhs) const = default;
 };
 
+// value of a constant declared with [[vk::constant_id(id)]] in hlsl, bool / int / float values are given by their
+// 32-bit representation (e.g. std::bit_cast<uint32_t>(1.0f))
+struct SpecializationConstant {
+    uint32_t id;
+    uint32_t value;
+
+    bool operator==(const SpecializationConstant &rhs) const = default;
+};
+
+// 0 for absent stages
+inline size_t ShaderContentHash(const ShaderModule *shader) {
+    return shader ? shader->ContentHash() : 0;
+}
+
+// pipelines are cached by desc, 'name' is not part of the key and only applies when the pipeline is first created
 struct RenderPipelineDesc {
     std::string name = "";
 
@@ -163,15 +194,51 @@ struct RenderPipelineDesc {
     DepthStencilState depth_stencil_state;
     ColorTargetState color_target_state;
     
-    struct {
+    struct Shaders {
         Ref<ShaderModule> vertex;
         ShaderModule *tessellation_control = nullptr;
         ShaderModule *tessellation_evaluation = nullptr;
         ShaderModule *geometry = nullptr;
         Ref<ShaderModule> fragment;
+
+        // compared by content so that a new module at the address of a destroyed one is not taken for it
+        bool operator==(const Shaders &rhs) const {
+            return vertex->ContentHash() == rhs.vertex->ContentHash()
+                && ShaderContentHash(tessellation_control) == ShaderContentHash(rhs.tessellation_control)
+                && ShaderContentHash(tessellation_evaluation) == ShaderContentHash(rhs.tessellation_evaluation)
+                && ShaderContentHash(geometry) == ShaderContentHash(rhs.geometry)
+                && fragment->ContentHash() == rhs.fragment->ContentHash();
+        }
     } shaders;
+
+    // shared by all stages, only supported if Device::SpecializationConstantsSupported()
+    Vec<SpecializationConstant> specialization_constants = {};
+
+    bool operator==(const RenderPipelineDesc &rhs) const {
+        return layout == rhs.layout && vertex_input_buffers == rhs.vertex_input_buffers
+            && primitive_state == rhs.primitive_state && depth_stencil_state == rhs.depth_stencil_state
+            && color_target_state == rhs.color_target_state && shaders == rhs.shaders
+            && specialization_constants == rhs.specialization_constants;
+    }
 };
 
+// pipeline is compiled when created if any target format is given in desc,
+// otherwise it's compiled when first bound with the formats of render pass
+inline bool HasTargetFormats(const RenderPipelineDesc &desc) {
+    if (desc.depth_stencil_state.format != ResourceFormat::eUndefined) {
+        return true;
+    }
+    for (const auto &attachment : desc.color_target_state.attachments) {
+        if (attachment.format != ResourceFormat::eUndefined) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// derive layout from reflection of all stages, immutable samplers and bindless set are left for caller to fill
+PipelineLayout ReflectPipelineLayout(const RenderPipelineDesc::Shaders &shaders);
+
 class RenderPipeline {
 public:
     virtual ~RenderPipeline() = default;
@@ -180,17 +247,45 @@ protected:
     RenderPipeline() = default;
 };
 
+// same as RenderPipelineDesc, 'name' is not part of the cache key
 struct ComputePipelineDesc {
     std::string name = "";
 
     PipelineLayout layout;
 
-    struct {
+    struct ThreadGroup {
         uint32_t x;
         uint32_t y;
         uint32_t z;
+
+        bool operator==(const ThreadGroup &rhs) const = default;
     } thread_group;
     Ref<ShaderModule> compute;
+
+    // only supported if Device::SpecializationConstantsSupported()
+    Vec<SpecializationConstant> specialization_constants = {};
+
+    bool operator==(const ComputePipelineDesc &rhs) const {
+        return layout == rhs.layout && thread_group == rhs.thread_group
+            && compute->ContentHash() == rhs.compute->ContentHash()
+            && specialization_constants == rhs.specialization_constants;
+    }
+};
+
+PipelineLayout ReflectPipelineLayout(const ShaderModule &compute);
+
+struct PipelineCacheStats {
+    // bytes of cache data loaded from file, 0 if file doesn't exist or doesn't match current device
+    size_t loaded_size = 0;
+    double load_time_ms = 0.0;
+    // bytes written when cache is saved, 0 if it hasn't been saved yet
+    size_t saved_size = 0;
+    double save_time_ms = 0.0;
+
+    uint32_t num_created_pipelines = 0;
+    // pipelines that were created from cache without compilation, only counted when driver reports it
+    uint32_t num_cache_hits = 0;
+    double creation_time_ms = 0.0;
 };
 
 class ComputePipeline {
@@ -204,3 +299,64 @@ protected:
 BISMUTH_GFX_NAMESPACE_END
 
 BISMUTH_NAMESPACE_END
+
+template <>
+struct std::hash<bismuth::gfx::RenderPipelineDesc> {
+    size_t operator()(const bismuth::gfx::RenderPipelineDesc &v) const noexcept {
+        size_t hash = bismuth::Hash(v.layout);
+        for (const auto &buffer : v.vertex_input_buffers) {
+            hash = bismuth::HashCombine(hash, bismuth::Hash(buffer.stride, buffer.per_instance));
+            for (const auto &attribute : buffer.attributes) {
+                hash = bismuth::HashCombine(hash,
+                    bismuth::Hash(attribute.offset, attribute.semantics, attribute.format));
+            }
+        }
+
+        const auto &primitive = v.primitive_state;
+        hash = bismuth::HashCombine(hash, bismuth::Hash(primitive.topology, primitive.front_face,
+            primitive.cull_mode, primitive.polygon_mode, primitive.conservative));
+
+        const auto &depth_stencil = v.depth_stencil_state;
+        hash = bismuth::HashCombine(hash, bismuth::Hash(depth_stencil.format,
+            static_cast<bool>(depth_stencil.depth_write), static_cast<bool>(depth_stencil.depth_test),
+            static_cast<bool>(depth_stencil.stencil_test), depth_stencil.depth_compare_op,
+            depth_stencil.stencil_compare_mask, depth_stencil.stencil_write_mask, depth_stencil.stencil_reference));
+        for (const auto &face : { depth_stencil.stencil_front_face, depth_stencil.stencil_back_face }) {
+            hash = bismuth::HashCombine(hash,
+                bismuth::Hash(face.compare_op, face.fail_op, face.pass_op, face.depth_fail_op));
+        }
+
+        for (const auto &attachment : v.color_target_state.attachments) {
+            hash = bismuth::HashCombine(hash, bismuth::Hash(attachment.format, attachment.blend_enable,
+                attachment.blend_op, attachment.src_blend_factor, attachment.dst_blend_factor,
+                attachment.alpha_blend_op, attachment.src_alpha_blend_factor, attachment.dst_alpha_blend_factor,
+                attachment.color_write_mask));
+        }
+        const auto &blend_constants = v.color_target_state.blend_constants;
+        hash = bismuth::HashCombine(hash,
+            bismuth::Hash(blend_constants.r, blend_constants.g, blend_constants.b, blend_constants.a));
+
+        const auto &shaders = v.shaders;
+        hash = bismuth::HashCombine(hash, bismuth::Hash(shaders.vertex->ContentHash(),
+            bismuth::gfx::ShaderContentHash(shaders.tessellation_control),
+            bismuth::gfx::ShaderContentHash(shaders.tessellation_evaluation),
+            bismuth::gfx::ShaderContentHash(shaders.geometry), shaders.fragment->ContentHash()));
+
+        for (const auto &constant : v.specialization_constants) {
+            hash = bismuth::HashCombine(hash, bismuth::Hash(constant.id, constant.value));
+        }
+        return hash;
+    }
+};
+
+template <>
+struct std::hash<bismuth::gfx::ComputePipelineDesc> {
+    size_t operator()(const bismuth::gfx::ComputePipelineDesc &v) const noexcept {
+        size_t hash = bismuth::Hash(v.layout, v.thread_group.x, v.thread_group.y, v.thread_group.z,
+            v.compute->ContentHash());
+        for (const auto &constant : v.specialization_constants) {
+            hash = bismuth::HashCombine(hash, bismuth::Hash(constant.id, constant.value));
+        }
+        return hash;
+    }
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "graphics/mod.hpp"
+
+BISMUTH_NAMESPACE_BEGIN
+
+BISMUTH_GFX_NAMESPACE_BEGIN
+
+enum class QueryType : uint8_t {
+    eTimestamp,
+};
+
+struct QuerySetDesc {
+    std::string name = "";
+    QueryType type = QueryType::eTimestamp;
+    uint32_t count = 0;
+};
+
+class QuerySet {
+public:
+    virtual ~QuerySet() = default;
+
+    const QuerySetDesc &Desc() const { return desc_; }
+
+    // queries must have been resolved by a command encoder, returns false if results are not available yet,
+    // timestamps are in ticks of Queue::TimestampFrequency()
+    virtual bool GetResults(uint32_t first_query, uint32_t num_queries, uint64_t *results) = 0;
+
+protected:
+    QuerySet() = default;
+
+    QuerySetDesc desc_;
+};
+
+BISMUTH_GFX_NAMESPACE_END
+
+BISMUTH_NAMESPACE_END
@@ -17,6 +17,11 @@ class Queue {
 public:
     virtual ~Queue() = default;
 
+    virtual QueueType Type() const = 0;
+
+    // ticks per second of timestamps written by commands on this queue
+    virtual uint64_t TimestampFrequency() const = 0;
+
     virtual void WaitIdle() const = 0;
 
     virtual void SubmitCommandBuffer(Span<Ptr<CommandBuffer>> &&cmd_buffers, Span<Ref<Semaphore>> wait_semaphores = {},
@@ -69,10 +69,14 @@ public:
 
     virtual void Unmap() = 0;
 
+    // set for storage buffers, whole buffer is bound
+    uint32_t BindlessIndex() const { return bindless_index_; }
+
 protected:
     Buffer() = default;
 
     BufferDesc desc_;
+    uint32_t bindless_index_ = kInvalidBindlessIndex;
 };
 
 struct BufferRange {
@@ -113,10 +117,16 @@ public:
 
     const TextureDesc &Desc() const { return desc_; }
 
+    // set for sampled or storage textures, all levels and layers are bound
+    uint32_t BindlessSampledIndex() const { return bindless_sampled_index_; }
+    uint32_t BindlessStorageIndex() const { return bindless_storage_index_; }
+
 protected:
     Texture() = default;
 
     TextureDesc desc_;
+    uint32_t bindless_sampled_index_ = kInvalidBindlessIndex;
+    uint32_t bindless_storage_index_ = kInvalidBindlessIndex;
 };
 
 enum class TextureViewDimension : uint8_t {
@@ -129,6 +139,35 @@ enum class TextureViewDimension : uint8_t {
     e3D,
 };
 
+struct ResourceMemoryRequirements {
+    uint64_t size = 0;
+    uint64_t alignment = 1;
+    // backend specific, resources can share a memory heap only if their bits intersect
+    uint32_t memory_type_bits = ~0u;
+};
+
+struct MemoryHeapDesc {
+    std::string name = "";
+    uint64_t size = 0;
+    uint64_t alignment = 1;
+    uint32_t memory_type_bits = ~0u;
+
+    bool operator==(const MemoryHeapDesc &rhs) const = default;
+};
+
+// gpu only memory that buffers and textures can be placed on, placed resources may alias each other
+class MemoryHeap {
+public:
+    virtual ~MemoryHeap() = default;
+
+    const MemoryHeapDesc &Desc() const { return desc_; }
+
+protected:
+    MemoryHeap() = default;
+
+    MemoryHeapDesc desc_;
+};
+
 struct TextureView {
     Ref<Texture> texture;
     uint32_t base_level = 0;
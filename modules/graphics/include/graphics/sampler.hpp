@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <string>
 
@@ -59,8 +60,19 @@ class Sampler {
 public:
     virtual ~Sampler() = default;
 
+    uint32_t BindlessIndex() const { return bindless_index_; }
+
+    // never reused, unlike the address, so it can identify the sampler in long-lived cache keys
+    uint64_t UniqueId() const { return unique_id_; }
+
 protected:
-    Sampler() = default;
+    Sampler() {
+        static std::atomic<uint64_t> next_unique_id = 1;
+        unique_id_ = next_unique_id.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint32_t bindless_index_ = kInvalidBindlessIndex;
+    uint64_t unique_id_;
 };
 
 BISMUTH_GFX_NAMESPACE_END
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <cstdint>
+#include <string>
 
 #include "graphics/mod.hpp"
+#include "descriptor.hpp"
 
 BISMUTH_NAMESPACE_BEGIN
 
@@ -17,12 +19,34 @@ enum class ShaderStage : uint8_t {
     eCompute,
 };
 
+// resources declared by a shader, set and binding indices are the same as in PipelineLayout,
+// immutable samplers are never reflected
+struct ShaderReflection {
+    ShaderStage stage = ShaderStage::eVertex;
+    std::string entry_point;
+    Vec<DescriptorSetLayout> sets_layout;
+    uint32_t push_constants_size = 0;
+    // thread group size of compute shader
+    uint32_t thread_group_x = 0;
+    uint32_t thread_group_y = 0;
+    uint32_t thread_group_z = 0;
+
+    bool operator==(const ShaderReflection &rhs) const = default;
+};
+
 class ShaderModule {
 public:
     virtual ~ShaderModule() = default;
 
+    virtual const ShaderReflection &Reflection() const = 0;
+
+    // hash of binary and entry point, pipelines are cached by it so that modules with the same content share them
+    size_t ContentHash() const { return content_hash_; }
+
 protected:
     ShaderModule() = default;
+
+    size_t content_hash_ = 0;
 };
 
 BISMUTH_GFX_NAMESPACE_END
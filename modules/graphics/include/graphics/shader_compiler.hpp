@@ -13,15 +13,40 @@ BISMUTH_GFX_NAMESPACE_BEGIN
 
 namespace fs = std::filesystem;
 
+enum class ShaderOptimizationLevel : uint8_t {
+    eNone,
+    eSize,
+    ePerformance,
+};
+
+struct ShaderCompileOptions {
+    ShaderOptimizationLevel optimization = ShaderOptimizationLevel::ePerformance;
+};
+
+struct ShaderCompileInfo {
+    // files read during compiling, source file first, then included files
+    Vec<fs::path> dependencies;
+    // reflection of the compiled binary, can be given to Device::CreateShaderModule later to skip reflecting again
+    ShaderReflection reflection;
+    // 0 if the compiler doesn't report them, e.g. dxc
+    uint32_t num_instructions_unoptimized = 0;
+    uint32_t num_instructions = 0;
+    double optimization_time_ms = 0.0;
+};
+
 class ShaderCompiler {
 public:
     virtual ~ShaderCompiler() = default;
 
     virtual Vec<uint8_t> Compile(const fs::path &src_path, const std::string &entry, ShaderStage stage,
-        const HashMap<std::string, std::string> &defines = {}, const Vec<fs::path> &include_dirs = {}) const = 0;
+        const HashMap<std::string, std::string> &defines = {}, const Vec<fs::path> &include_dirs = {},
+        const ShaderCompileOptions &options = {}, ShaderCompileInfo *info = nullptr) const = 0;
 
     virtual const char *BinarySuffix() const = 0;
 
+    // identifies compiler and its options, binaries compiled by a different version should be recompiled
+    virtual const std::string &Version() const = 0;
+
 protected:
     ShaderCompiler() = default;
 };
@@ -1,16 +1,44 @@
 #pragma once
 
+#include <chrono>
 #include <functional>
 
+#include "core/thread_pool.hpp"
 #include "resource_pool.hpp"
 #include "pass.hpp"
 #include "resource.hpp"
 #include "helper_pipelines.hpp"
+#include "profile.hpp"
+#include "report.hpp"
 
 BISMUTH_NAMESPACE_BEGIN
 
 BISMUTH_GFX_NAMESPACE_BEGIN
 
+struct TransientMemoryStats {
+    // total size if every transient resource had its own allocation
+    uint64_t unaliased_size = 0;
+    // total size of shared heaps that transient resources are placed on
+    uint64_t aliased_size = 0;
+    // max total size of transient resources alive at the same time in execution order, without aliasing
+    uint64_t peak_live_size = 0;
+};
+
+enum class PassOrdering : uint8_t {
+    // topological order following the order passes are declared in
+    eDeclaration,
+    // among valid orders, greedily prefer passes that release transient memory and change fewer resource states
+    eOptimized,
+};
+
+struct AsyncComputeStats {
+    size_t num_async_passes = 0;
+    // counted in last executed frame
+    size_t num_submissions = 0;
+    size_t num_semaphores = 0;
+    size_t num_ownership_transfers = 0;
+};
+
 class RenderGraph {
 public:
     RenderGraph(Ref<gfx::Device> device, Ref<gfx::Queue> queue, uint32_t num_frames = 3);
@@ -28,27 +56,129 @@ public:
     void AddPresentPass(TextureHandle texture);
     void AddBlitPass(const std::string &name, const std::function<void(BlitPassBuilder &)> &setup_func);
 
+    // keep compiled graph across frames, only recompile when declared passes or resources change
+    void SetPersistent(bool persistent) { persistent_ = persistent; }
+
+    // place transient resources with disjoint lifetimes on the same memory
+    void SetMemoryAliasing(bool enable) {
+        if (memory_aliasing_ != enable) {
+            memory_aliasing_ = enable;
+            compiled_ = false;
+        }
+    }
+    const TransientMemoryStats &GetTransientMemoryStats() const { return transient_memory_stats_; }
+
+    void SetPassOrdering(PassOrdering ordering) {
+        if (pass_ordering_ != ordering) {
+            pass_ordering_ = ordering;
+            compiled_ = false;
+        }
+    }
+
+    // split passes into contiguous chunks and record each chunk into its own command buffer on a worker thread,
+    // 0 or 1 records all passes on the calling thread
+    void SetRecordingThreads(uint32_t num_threads);
+
+    // run compute passes marked as async on another queue, synchronized with the graphics queue by semaphores,
+    // with auto_select, compute passes that can overlap some render pass also run on it
+    void SetAsyncComputeQueue(gfx::Queue *queue, bool auto_select = false) {
+        async_compute_queue_ = queue;
+        async_compute_auto_select_ = auto_select;
+        compiled_ = false;
+    }
+    const AsyncComputeStats &GetAsyncComputeStats() const { return async_compute_stats_; }
+
+    // settings are applied to resource pool of every frame in flight, see ResourcePool
+    void SetResourcePoolMaxIdleFrames(uint32_t frames) {
+        for (auto &pool : resource_pools_) {
+            pool->SetMaxIdleFrames(frames);
+        }
+    }
+    void SetResourcePoolBudget(uint64_t budget) {
+        for (auto &pool : resource_pools_) {
+            pool->SetMemoryBudget(budget);
+        }
+    }
+    void TrimResourcePools() {
+        for (auto &pool : resource_pools_) {
+            pool->Trim();
+        }
+    }
+    const ResourcePoolStats &GetResourcePoolStats(uint32_t frame) const { return resource_pools_[frame]->GetStats(); }
+
+    // record timestamps around passes and cpu time of recording,
+    // results of a frame are read when its frame context is reused
+    void SetProfiling(bool enable);
+    // latest frame whose results have been read, null if there is none yet
+    const FrameProfile *GetFrameProfile() const {
+        return latest_profile_.has_value() ? &latest_profile_.value() : nullptr;
+    }
+
     void Compile();
 
+    // built by Compile(), per frame counts are updated by Execute()
+    const CompileReport &GetCompileReport() const { return compile_report_; }
+
     void Execute(Span<Ref<gfx::Semaphore>> wait_semaphores = {}, Span<Ref<gfx::Semaphore>> signal_semaphores = {},
         gfx::Fence *signal_fence = nullptr);
 
 private:
     friend PassResource;
 
+    struct ResourceAccess {
+        size_t index;
+        gfx::ResourceAccessType access_type;
+    };
+    // planned at compile time, handles and source access types are filled in when the pass is prepared
+    struct BarrierPlan {
+        size_t resource;
+        gfx::ResourceAccessType access_type;
+        bool is_buffer;
+    };
+    // transition of a resource to the access type of its next user, begun right after the previous user
+    struct SplitBarrierPlan {
+        size_t resource;
+        size_t consumer_order;
+        gfx::ResourceAccessType access_type;
+    };
+
     struct Node {
         Vec<Ref<Node>> in_nodes;
         Vec<Ref<Node>> out_nodes;
         std::string name;
         size_t index;
+        bool async_compute = false;
 
         virtual ~Node() = default;
 
+        // barriers are computed in pass order and recorded later, possibly on another thread,
+        // barriers of later passes in a batch are moved to the first pass of the batch
+        Vec<gfx::BufferBarrier> buffer_barriers;
+        Vec<gfx::TextureBarrier> texture_barriers;
+        // counted before barriers are moved to the first pass of the batch
+        size_t num_barriers = 0;
+        // planned at compile time from GetAccesses()
+        Vec<BarrierPlan> barrier_plans;
+        // set on the first pass of a batch of adjacent passes that don't depend on each other,
+        // barriers of passes at orders up to barrier_batch_end are recorded before this pass, 0 if not the first
+        size_t barrier_batch_end = 0;
+        // planned at compile time, split barriers begun after this pass
+        Vec<SplitBarrierPlan> split_barrier_plans;
+        Vec<Ref<gfx::SplitBarrier>> begin_split_barriers;
+        Vec<Ref<gfx::SplitBarrier>> end_split_barriers;
+
         virtual bool IsResource() const { return false; }
 
-        virtual void SetBarriers(const Ptr<gfx::CommandEncoder> &cmd_encoder, RenderGraph &rg) {}
+        // accesses of resources as PrepareBarriers() transitions them to, not including mipmaps generation
+        virtual void GetAccesses(Vec<ResourceAccess> &accesses) const {}
+
+        // barriers of planned accesses from current access types of resources
+        virtual void PrepareBarriers(RenderGraph &rg);
+        // end halves of split barriers and barriers before the pass
+        void SetBarriers(const Ptr<gfx::CommandEncoder> &cmd_encoder) const;
+        void BeginSplitBarriers(const Ptr<gfx::CommandEncoder> &cmd_encoder) const;
         virtual void Execute(const Ptr<gfx::CommandEncoder> &cmd_encoder, const RenderGraph &rg) const {}
-        virtual void AfterExcution(const Ptr<gfx::CommandEncoder> &cmd_encoder, RenderGraph &rg) {}
+        virtual void AfterExcution(const Ptr<gfx::CommandEncoder> &cmd_encoder, const RenderGraph &rg) const {}
 
         virtual void Create(RenderGraph &rg) {}
         virtual void Destroy(RenderGraph &rg) {}
@@ -80,23 +210,29 @@ private:
         std::optional<RenderPassDepthStencilTarget> depth_stencil_target;
         std::function<void(Ref<gfx::RenderCommandEncoder>, const PassResource &)> execute_func;
         size_t num_color_targets;
+        // access types of textures before their mipmaps are generated
+        Vec<gfx::ResourceAccessType> mipmaps_access_types;
 
-        void SetBarriers(const Ptr<gfx::CommandEncoder> &cmd_encoder, RenderGraph &rg) override;
+        void GetAccesses(Vec<ResourceAccess> &accesses) const override;
+        void PrepareBarriers(RenderGraph &rg) override;
         void Execute(const Ptr<gfx::CommandEncoder> &cmd_encoder, const RenderGraph &rg) const override;
-        void AfterExcution(const Ptr<gfx::CommandEncoder> &cmd_encoder, RenderGraph &rg) override;
+        void AfterExcution(const Ptr<gfx::CommandEncoder> &cmd_encoder, const RenderGraph &rg) const override;
     };
     struct ComputePassNode : Node {
         PassResource resource;
         std::function<void(Ref<gfx::ComputeCommandEncoder>, const PassResource &)> execute_func;
+        Vec<gfx::ResourceAccessType> mipmaps_access_types;
+        bool prefer_async_compute = false;
 
-        void SetBarriers(const Ptr<gfx::CommandEncoder> &cmd_encoder, RenderGraph &rg) override;
+        void GetAccesses(Vec<ResourceAccess> &accesses) const override;
+        void PrepareBarriers(RenderGraph &rg) override;
         void Execute(const Ptr<gfx::CommandEncoder> &cmd_encoder, const RenderGraph &rg) const override;
-        void AfterExcution(const Ptr<gfx::CommandEncoder> &cmd_encoder, RenderGraph &rg) override;
+        void AfterExcution(const Ptr<gfx::CommandEncoder> &cmd_encoder, const RenderGraph &rg) const override;
     };
     struct PresentPassNode : Node {
         TextureHandle texture;
 
-        void SetBarriers(const Ptr<gfx::CommandEncoder> &cmd_encoder, RenderGraph &rg) override;
+        void GetAccesses(Vec<ResourceAccess> &accesses) const override;
     };
     struct BlitPassNode : Node {
         TextureHandle src_handle;
@@ -106,12 +242,69 @@ private:
         uint32_t dst_level;
         uint32_t dst_layer;
 
-        void SetBarriers(const Ptr<gfx::CommandEncoder> &cmd_encoder, RenderGraph &rg) override;
+        void PrepareBarriers(RenderGraph &rg) override;
         void Execute(const Ptr<gfx::CommandEncoder> &cmd_encoder, const RenderGraph &rg) const override;
     };
 
     void AddEdge(Ref<Node> from, Ref<Node> to);
 
+    template <typename Builder>
+    static size_t HashPassAccesses(const Builder &builder);
+
+    bool MatchCachedNode(size_t node_hash);
+    void PushNode(Ptr<Node> &&node, size_t node_hash);
+    void DropCachedNodes(size_t from);
+
+    // size of memory of a transient resource node, 0 for imported ones
+    uint64_t TransientSize(const Node &node) const;
+    void SchedulePasses(const Vec<bool> &used);
+
+    void PlanTransientMemory(const Vec<bool> &used, const Vec<size_t> &lifetime_start,
+        const Vec<size_t> &lifetime_end);
+
+    void BuildCompileReport(const Vec<bool> &used, const Vec<size_t> &lifetime_start,
+        const Vec<size_t> &lifetime_end);
+    void UpdateCompileReport();
+
+    static void GetShaderAccesses(const PassResource &resource, bool is_render_pass,
+        Vec<ResourceAccess> &accesses);
+    void PlanBarriers();
+    // placed resources are created in the batch before its first pass, so planned after transient memory
+    void PlanBarrierBatches();
+    // create resources and prepare barriers of the batch from order, ending no later than end_order,
+    // returns the end of the batch
+    size_t PrepareBarrierBatch(size_t order, size_t end_order);
+    // create split barriers begun after the pass, whose consumers are recorded before end_order
+    // in the same command encoder
+    void PrepareSplitBarriers(size_t order, size_t end_order);
+
+    void RecordParallel(Vec<Ptr<gfx::CommandBuffer>> &cmd_buffers);
+
+    using ProfileTimePoint = std::chrono::steady_clock::time_point;
+    ProfileTimePoint ProfileNow() const { return profiling_ ? std::chrono::steady_clock::now() : ProfileTimePoint {}; }
+    double ProfileTime(ProfileTimePoint time) const;
+    // read results of the frame that last used current frame context and prepare profile of this frame
+    void BeginProfile();
+    // timestamps of the pass at order are queries 2i and 2i + 1, i is its index in frame profile
+    void WriteProfileTimestamp(const Ptr<gfx::CommandEncoder> &cmd_encoder, size_t order, bool end);
+    void ResetProfileQueries(const Ptr<gfx::CommandEncoder> &cmd_encoder);
+    void ResolveProfileQueries(const Ptr<gfx::CommandEncoder> &cmd_encoder);
+    void ProfilePrepare(size_t order, ProfileTimePoint create_begin, ProfileTimePoint barrier_begin,
+        ProfileTimePoint barrier_end);
+    void ProfileRecord(size_t order, ProfileTimePoint record_begin, ProfileTimePoint record_end, uint32_t thread);
+
+    void AssignAsyncCompute(const Vec<bool> &used);
+
+    struct Submission {
+        bool async_compute = false;
+        Ptr<gfx::CommandEncoder> cmd_encoder;
+        Vec<Ref<gfx::Semaphore>> wait_semaphores;
+        Vec<Ref<gfx::Semaphore>> signal_semaphores;
+        // a submission is closed after it signals a semaphore, later commands go to a new one
+        bool closed = false;
+    };
+    void RecordAsyncCompute(Vec<Submission> &submissions);
+
     void Clear();
 
     ResourcePool::Buffer &Buffer(BufferHandle handle);
@@ -120,18 +313,61 @@ private:
     const ResourcePool::Texture &Texture(TextureHandle handle) const;
 
     Vec<Ptr<Node>> graph_nodes_;
+    Vec<size_t> node_hashes_;
+    size_t num_declared_nodes_ = 0;
+    bool persistent_ = true;
+    bool compiled_ = false;
     Vec<size_t> graph_order_;
     Vec<Vec<size_t>> resources_to_create_;
     Vec<Vec<size_t>> resources_to_destroy_;
     size_t present_pass_index_ = static_cast<size_t>(-1);
 
+    struct TransientPlacement {
+        size_t heap = static_cast<size_t>(-1);
+        uint64_t offset = 0;
+
+        bool operator==(const TransientPlacement &rhs) const = default;
+    };
+    Vec<TransientPlacement> transient_placements_;
+    Vec<gfx::MemoryHeapDesc> transient_heaps_;
+    // bumped only when heaps or placements change, so that resource pools keep their heaps across recompiling
+    size_t transient_heaps_version_ = 0;
+    TransientMemoryStats transient_memory_stats_;
+    bool memory_aliasing_ = true;
+    PassOrdering pass_ordering_ = PassOrdering::eDeclaration;
+    CompileReport compile_report_;
+
     Ref<gfx::Device> device_;
     Ref<gfx::Queue> queue_;
     Vec<Ptr<gfx::FrameContext>> contexts_;
     Vec<Ptr<ResourcePool>> resource_pools_;
     size_t curr_frame_ = 0;
+    uint64_t frame_index_ = 0;
 
     Ptr<HelperPipelines> helper_pipelines_;
+
+    Ptr<ThreadPool> thread_pool_;
+
+    Vec<gfx::BufferBarrier> split_buffer_barriers_;
+    Vec<gfx::TextureBarrier> split_texture_barriers_;
+
+    gfx::Queue *async_compute_queue_ = nullptr;
+    bool async_compute_auto_select_ = false;
+    Vec<Vec<Ptr<gfx::Semaphore>>> semaphores_;
+    AsyncComputeStats async_compute_stats_;
+
+    bool profiling_ = false;
+    ProfileTimePoint profile_epoch_;
+    struct ProfileSlot {
+        Ptr<gfx::QuerySet> query_set;
+        bool pending = false;
+        FrameProfile profile;
+    };
+    // indexed by frame context
+    Vec<ProfileSlot> profile_slots_;
+    // index in profile of current frame for each order, -1 for resources
+    Vec<size_t> profile_pass_index_;
+    std::optional<FrameProfile> latest_profile_;
 };
 
 BISMUTH_GFX_NAMESPACE_END
@@ -23,10 +23,13 @@ public:
 
     void GenerateMipmaps2D(Ref<CommandEncoder> cmd_encoder, Ref<Texture> texture,
         ResourceAccessType &tex_access_type, MipmapMode mode = MipmapMode::eAverage) const;
+    // access type that texture is left in by GenerateMipmaps2D
+    static ResourceAccessType MipmapsAccessType(ResourceFormat format);
 
 private:
-    void InitBlitPipelines();
-    void InitMipmapPipelines();
+    // shaders are compiled in one batch by the constructor
+    void InitBlitPipelines(Span<Ptr<ShaderModule>> shaders);
+    void InitMipmapPipelines(Span<Ptr<ShaderModule>> shaders);
 
     Ref<Device> device_;
     Ptr<ShaderManager> shader_manager_;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string_view>
+
 #include "graphics/command.hpp"
 
 BISMUTH_NAMESPACE_BEGIN
@@ -11,16 +13,35 @@ class RenderGraph;
 struct BufferHandle {
 private:
     friend RenderGraph;
+    friend class PassResource;
 
     size_t node_index_;
 };
 struct TextureHandle {
 private:
     friend RenderGraph;
+    friend class PassResource;
 
     size_t node_index_;
 };
 
+// binding name of a pass resource interned as a hash, always computed at compile time
+struct PassBindingId {
+    uint64_t value;
+
+    consteval PassBindingId(std::string_view name) : value(14695981039346656037ull) {
+        for (const char c : name) {
+            value = (value ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+        }
+    }
+    consteval PassBindingId(const char *name) : PassBindingId(std::string_view(name)) {}
+
+    bool operator==(const PassBindingId &rhs) const = default;
+};
+
+template <typename T>
+using PassBindings = Vec<std::pair<PassBindingId, T>>;
+
 enum class BufferReadType : uint8_t {
     eUniform,
     eStorage,
@@ -41,20 +62,43 @@ struct PassWriteTexture {
 };
 class PassResource {
 public:
-    Ref<gfx::Buffer> Buffer(const std::string &name) const;
-    Ref<gfx::Texture> Texture(const std::string &name) const;
+    // handle declared by the pass, direct index into graph resources
+    Ref<gfx::Buffer> Buffer(BufferHandle handle) const;
+    Ref<gfx::Texture> Texture(TextureHandle handle) const;
+
+    // binding declared by the pass, read bindings are preferred if an id is both read and written
+    Ref<gfx::Buffer> Buffer(PassBindingId id) const;
+    Ref<gfx::Texture> Texture(PassBindingId id) const;
 
 private:
     friend RenderGraph;
 
-    void GetShaderBarriers(RenderGraph &rg, bool is_render_pass,
-        Vec<gfx::BufferBarrier> &buffer_barriers, Vec<gfx::TextureBarrier> &texture_barriers);
+    static gfx::ResourceAccessType ReadBufferAccessType(BufferReadType type, bool is_render_pass);
+    static gfx::ResourceAccessType ReadTextureAccessType(bool is_render_pass);
+    static gfx::ResourceAccessType WriteAccessType(bool is_render_pass);
+
+    // called by render graph after declared bindings are set
+    void ResolveSlots(Span<TextureHandle> target_handles);
+
+    // open addressing with keys as start indices, so lookups usually index the slot directly, 0 means empty
+    static constexpr size_t kNumSlots = 64;
+    static constexpr size_t kMaxSlotKeys = kNumSlots / 2;
+    struct Slot {
+        uint64_t key = 0;
+        size_t node_index = 0;
+    };
+    static void InsertSlot(Array<Slot, kNumSlots> &slots, uint64_t key, size_t node_index);
+    static const Slot *FindSlot(const Array<Slot, kNumSlots> &slots, uint64_t key);
 
     const RenderGraph *graph_;
-    HashMap<std::string, PassReadBuffer> read_buffers_;
-    HashMap<std::string, PassWriteBuffer> write_buffers_;
-    HashMap<std::string, PassReadTexture> read_textures_;
-    HashMap<std::string, PassWriteTexture> write_textures_;
+    PassBindings<PassReadBuffer> read_buffers_;
+    PassBindings<PassWriteBuffer> write_buffers_;
+    PassBindings<PassReadTexture> read_textures_;
+    PassBindings<PassWriteTexture> write_textures_;
+    // binding id of buffers and textures (with a different salt) -> node index of resource
+    Array<Slot, kNumSlots> binding_slots_ {};
+    // node index + 1 of resources declared by the pass, including render targets
+    Array<Slot, kNumSlots> declared_slots_ {};
 };
 
 struct RenderPassColorTarget {
@@ -120,11 +164,11 @@ public:
     RenderPassBuilder &Color(uint32_t index, const RenderPassColorTargetBuilder &target);
     RenderPassBuilder &DepthStencil(const RenderPassDepthStencilTargetBuilder &target);
 
-    RenderPassBuilder &Read(const std::string &name, BufferHandle handle, BufferReadType type);
-    RenderPassBuilder &Read(const std::string &name, TextureHandle handle);
+    RenderPassBuilder &Read(PassBindingId id, BufferHandle handle, BufferReadType type);
+    RenderPassBuilder &Read(PassBindingId id, TextureHandle handle);
 
-    RenderPassBuilder &Write(const std::string &name, BufferHandle handle);
-    RenderPassBuilder &Write(const std::string &name, TextureHandle handle, bool generate_mipmaps = false);
+    RenderPassBuilder &Write(PassBindingId id, BufferHandle handle);
+    RenderPassBuilder &Write(PassBindingId id, TextureHandle handle, bool generate_mipmaps = false);
 
 private:
     friend RenderGraph;
@@ -132,27 +176,32 @@ private:
     std::optional<RenderPassColorTarget> color_targets_[gfx::kMaxRenderTargetsCount];
     std::optional<RenderPassDepthStencilTarget> depth_stencil_target_;
 
-    HashMap<std::string, PassReadBuffer> read_buffers_;
-    HashMap<std::string, PassWriteBuffer> write_buffers_;
-    HashMap<std::string, PassReadTexture> read_textures_;
-    HashMap<std::string, PassWriteTexture> write_textures_;
+    PassBindings<PassReadBuffer> read_buffers_;
+    PassBindings<PassWriteBuffer> write_buffers_;
+    PassBindings<PassReadTexture> read_textures_;
+    PassBindings<PassWriteTexture> write_textures_;
 };
 
 class ComputePassBuilder {
 public:
-    ComputePassBuilder &Read(const std::string &name, BufferHandle handle, BufferReadType type);
-    ComputePassBuilder &Read(const std::string &name, TextureHandle handle);
+    ComputePassBuilder &Read(PassBindingId id, BufferHandle handle, BufferReadType type);
+    ComputePassBuilder &Read(PassBindingId id, TextureHandle handle);
+
+    ComputePassBuilder &Write(PassBindingId id, BufferHandle handle);
+    ComputePassBuilder &Write(PassBindingId id, TextureHandle handle, bool generate_mipmaps = false);
 
-    ComputePassBuilder &Write(const std::string &name, BufferHandle handle);
-    ComputePassBuilder &Write(const std::string &name, TextureHandle handle, bool generate_mipmaps = false);
+    // run on the async compute queue of render graph if there is one,
+    // ignored when the pass generates mipmaps since that needs graphics pipelines
+    ComputePassBuilder &AsyncCompute(bool async = true);
 
 private:
     friend RenderGraph;
 
-    HashMap<std::string, PassReadBuffer> read_buffers_;
-    HashMap<std::string, PassWriteBuffer> write_buffers_;
-    HashMap<std::string, PassReadTexture> read_textures_;
-    HashMap<std::string, PassWriteTexture> write_textures_;
+    PassBindings<PassReadBuffer> read_buffers_;
+    PassBindings<PassWriteBuffer> write_buffers_;
+    PassBindings<PassReadTexture> read_textures_;
+    PassBindings<PassWriteTexture> write_textures_;
+    bool async_compute_ = false;
 };
 
 class BlitPassBuilder {
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+
+#include "core/span.hpp"
+#include "graphics/mod.hpp"
+
+BISMUTH_NAMESPACE_BEGIN
+
+BISMUTH_GFX_NAMESPACE_BEGIN
+
+// times are in microseconds, cpu times are relative to the moment profiling is enabled
+struct PassProfile {
+    std::string name;
+    // thread index of the recording thread
+    uint32_t cpu_thread = 0;
+    double cpu_barrier_start = 0.0;
+    double cpu_barrier_duration = 0.0;
+    double cpu_record_start = 0.0;
+    double cpu_record_duration = 0.0;
+    // not available for passes on async compute queue
+    bool has_gpu_time = false;
+    // relative to the first timestamp of the frame
+    double gpu_start = 0.0;
+    double gpu_duration = 0.0;
+};
+
+// resources created before a pass
+struct ResourceCreationProfile {
+    double cpu_start = 0.0;
+    double cpu_duration = 0.0;
+};
+
+struct FrameProfile {
+    uint64_t frame = 0;
+    double cpu_start = 0.0;
+    double cpu_submit = 0.0;
+    // sum of durations of all resource creations
+    double cpu_resource_creation_duration = 0.0;
+    Vec<ResourceCreationProfile> resource_creations;
+    Vec<PassProfile> passes;
+};
+
+// chrome trace event format, which can be loaded by chrome://tracing and perfetto,
+// gpu events are put on their own track starting at the submission time of their frame
+std::string ToChromeTrace(Span<FrameProfile> frames);
+
+BISMUTH_GFX_NAMESPACE_END
+
+BISMUTH_NAMESPACE_END
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+
+#include "core/container.hpp"
+#include "graphics/mod.hpp"
+
+BISMUTH_NAMESPACE_BEGIN
+
+BISMUTH_GFX_NAMESPACE_BEGIN
+
+struct CompileReport {
+    struct Node {
+        std::string name;
+        bool is_resource = false;
+        bool culled = false;
+        // position in execution order, -1 if culled
+        size_t order = static_cast<size_t>(-1);
+        Vec<size_t> out_nodes;
+
+        // for passes
+        bool async_compute = false;
+        size_t num_planned_split_barriers = 0;
+        // counted in last executed frame
+        size_t num_barriers = 0;
+        size_t num_split_barriers = 0;
+
+        // for resources, lifetime is the range of orders in which the resource is alive
+        bool imported = false;
+        uint64_t size = 0;
+        size_t lifetime_start = 0;
+        size_t lifetime_end = 0;
+        bool placed = false;
+        size_t heap = 0;
+        uint64_t offset = 0;
+    };
+    // indexed by node index
+    Vec<Node> nodes;
+    size_t num_passes = 0;
+    size_t num_culled_passes = 0;
+    size_t num_resources = 0;
+    size_t num_culled_resources = 0;
+
+    uint64_t unaliased_size = 0;
+    uint64_t aliased_size = 0;
+    uint64_t peak_live_size = 0;
+
+    // counted in last executed frame
+    size_t num_barriers = 0;
+    // barrier calls recorded, barriers of adjacent independent passes are recorded in one call
+    size_t num_barrier_batches = 0;
+    size_t num_pool_hits = 0;
+    size_t num_pool_misses = 0;
+};
+
+std::string ToJson(const CompileReport &report);
+
+// passes are boxes and resources are ellipses, culled nodes are dashed and gray
+std::string ToGraphviz(const CompileReport &report);
+
+BISMUTH_GFX_NAMESPACE_END
+
+BISMUTH_NAMESPACE_END
@@ -29,6 +29,22 @@ struct TextureKey {
     bool operator==(const TextureKey &rhs) const = default;
 };
 
+struct PlacedBufferKey {
+    BufferKey key;
+    size_t heap;
+    uint64_t offset;
+
+    bool operator==(const PlacedBufferKey &rhs) const = default;
+};
+
+struct PlacedTextureKey {
+    TextureKey key;
+    size_t heap;
+    uint64_t offset;
+
+    bool operator==(const PlacedTextureKey &rhs) const = default;
+};
+
 BISMUTH_GFX_NAMESPACE_END
 
 BISMUTH_NAMESPACE_END
@@ -48,18 +64,62 @@ struct std::hash<bismuth::gfx::TextureKey> {
     }
 };
 
+template <>
+struct std::hash<bismuth::gfx::PlacedBufferKey> {
+    size_t operator()(const bismuth::gfx::PlacedBufferKey &v) const noexcept {
+        return bismuth::Hash(v.key, v.heap, v.offset);
+    }
+};
+
+template <>
+struct std::hash<bismuth::gfx::PlacedTextureKey> {
+    size_t operator()(const bismuth::gfx::PlacedTextureKey &v) const noexcept {
+        return bismuth::Hash(v.key, v.heap, v.offset);
+    }
+};
+
 BISMUTH_NAMESPACE_BEGIN
 
 BISMUTH_GFX_NAMESPACE_BEGIN
 
+struct ResourcePoolStats {
+    // placed resources are not counted, their memory belongs to transient heaps
+    uint64_t live_bytes = 0;
+    uint64_t idle_bytes = 0;
+    // accumulated since the pool was created
+    uint64_t evicted_bytes = 0;
+    size_t num_live = 0;
+    size_t num_idle = 0;
+    size_t num_evicted = 0;
+    // counted since last BeginFrame()
+    size_t num_hits = 0;
+    size_t num_misses = 0;
+};
+
 class ResourcePool {
 public:
     ResourcePool(Ref<gfx::Device> device);
 
+    // must be called before any resource is got in a frame, when resources of this pool are no longer used by gpu,
+    // idle resources are evicted here
+    void BeginFrame(uint64_t frame);
+
+    // idle resources not used for more than this number of frames are evicted, 0 disables eviction by age
+    void SetMaxIdleFrames(uint32_t frames) { max_idle_frames_ = frames; }
+    // least recently used idle resources are evicted when live and idle memory exceeds budget,
+    // 0 means unlimited, live resources and idle ones recycled in current frame are never evicted
+    void SetMemoryBudget(uint64_t budget) { memory_budget_ = budget; }
+    // evict all idle resources at the beginning of next frame
+    void Trim() { trim_requested_ = true; }
+
+    const ResourcePoolStats &GetStats() const { return stats_; }
+
     struct Buffer {
         Ref<gfx::Buffer> buffer;
         size_t index;
         gfx::ResourceAccessType access_type;
+        // set for placed resources, memory may have been used by other resources
+        bool discard = false;
     };
     Buffer GetBuffer(const gfx::BufferDesc &desc);
     void RemoveBuffer(const gfx::BufferDesc &desc, const Buffer &buffer);
@@ -68,28 +128,72 @@ public:
         Ref<gfx::Texture> texture;
         size_t index;
         gfx::ResourceAccessType access_type;
+        bool discard = false;
     };
     Texture GetTexure(const gfx::TextureDesc &desc);
     void RemoveTexture(const gfx::TextureDesc &desc, const Texture &texture);
 
+    // heaps are recreated (with resources placed on them) only when version changes
+    void SetTransientHeaps(Span<gfx::MemoryHeapDesc> heaps, size_t version);
+
+    Buffer GetPlacedBuffer(const gfx::BufferDesc &desc, size_t heap, uint64_t offset);
+    void RemovePlacedBuffer(const Buffer &buffer);
+
+    Texture GetPlacedTexture(const gfx::TextureDesc &desc, size_t heap, uint64_t offset);
+    void RemovePlacedTexture(const Texture &texture);
+
 private:
     Ref<gfx::Device> device_;
 
-    struct BufferPool {
-        Vec<Ptr<gfx::Buffer>> created_buffers;
-        // only updated when creating & deleting, used for initial state
-        Vec<gfx::ResourceAccessType> access;
-        Vec<size_t> recycled_index;
-    };
-    HashMap<BufferKey, BufferPool> buffer_pools_;
-
-    struct TexturePool {
-        Vec<Ptr<gfx::Texture>> created_textures;
-        // only updated when creating & deleting, used for initial state
-        Vec<gfx::ResourceAccessType> access;
+    Vec<Ptr<gfx::MemoryHeap>> transient_heaps_;
+    size_t transient_heaps_version_ = 0;
+
+    HashMap<PlacedBufferKey, size_t> placed_buffer_indices_;
+    Vec<Ptr<gfx::Buffer>> placed_buffers_;
+    Vec<gfx::ResourceAccessType> placed_buffers_access_;
+
+    HashMap<PlacedTextureKey, size_t> placed_texture_indices_;
+    Vec<Ptr<gfx::Texture>> placed_textures_;
+    Vec<gfx::ResourceAccessType> placed_textures_access_;
+
+    template <typename T>
+    struct Pool {
+        struct Entry {
+            // null if evicted
+            Ptr<T> resource;
+            // only updated when creating & deleting, used for initial state
+            gfx::ResourceAccessType access;
+            uint64_t size;
+            uint64_t last_used_frame;
+        };
+        Vec<Entry> entries;
+        // idle entries, ordered by last use
         Vec<size_t> recycled_index;
+        // entries that can be reused by newly created resources
+        Vec<size_t> evicted_index;
     };
-    HashMap<TextureKey, TexturePool> texture_pools_;
+    HashMap<BufferKey, Pool<gfx::Buffer>> buffer_pools_;
+    HashMap<TextureKey, Pool<gfx::Texture>> texture_pools_;
+
+    template <typename T>
+    size_t AddEntry(Pool<T> &pool, Ptr<T> &&resource, uint64_t size);
+    template <typename T>
+    size_t GetIdleEntry(Pool<T> &pool);
+    template <typename T>
+    void RecycleEntry(Pool<T> &pool, size_t index, gfx::ResourceAccessType access);
+    template <typename T>
+    void EvictEntry(Pool<T> &pool, size_t index);
+
+    template <typename T>
+    void EvictByAge(Pool<T> &pool);
+    // evict least recently used idle resources until live and idle memory (plus extra size) fits in budget
+    void EvictToBudget(uint64_t extra_size);
+
+    uint64_t frame_ = 0;
+    uint32_t max_idle_frames_ = 64;
+    uint64_t memory_budget_ = 0;
+    bool trim_requested_ = false;
+    ResourcePoolStats stats_;
 };
 
 BISMUTH_GFX_NAMESPACE_END
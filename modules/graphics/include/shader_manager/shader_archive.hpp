@@ -0,0 +1,78 @@
+#pragma once
+
+#include <shared_mutex>
+
+#include "core/mapped_file.hpp"
+#include "core/span.hpp"
+#include "graphics/shader_compiler.hpp"
+
+BISMUTH_NAMESPACE_BEGIN
+
+BISMUTH_GFX_NAMESPACE_BEGIN
+
+// shader binaries and their metadata packed in one memory-mapped file
+// layout: header slot 0 | header slot 1 | blobs and indices appended over time ... , the valid header of the
+// highest generation points to the latest index, which lists all live entries. new blobs and index are written
+// after the end of file and then the header of the next generation overwrites the older slot, so an interrupted
+// append, even with a torn header write, leaves the archive as it was
+// appends from different processes are serialized by a lock file next to the archive
+class ShaderArchive final {
+public:
+    struct Entry {
+        std::string name;
+        std::string metadata;
+        Vec<uint8_t> data;
+    };
+
+    // archives of the same path are shared in a process
+    static Rc<ShaderArchive> Open(const fs::path &path);
+
+    explicit ShaderArchive(const fs::path &path);
+
+    // return false if not found
+    bool FindMetadata(const std::string &name, std::string &metadata) const;
+
+    // call 'func' with the mapped bytes of the entry, which are only valid during the call
+    // return false if not found or the bytes don't match their hash
+    template <typename F>
+    bool Read(const std::string &name, F &&func) const {
+        std::shared_lock lock(mutex_);
+        auto it = entries_.find(name);
+        if (it == entries_.end() || !VerifyEntry(name, it->second)) {
+            return false;
+        }
+        func(Span<uint8_t>(mapped_file_.Data() + it->second.offset, it->second.size));
+        return true;
+    }
+
+    // entries with an existing name replace the old ones
+    void Append(Span<Entry> entries);
+
+private:
+    struct IndexEntry {
+        uint64_t offset;
+        uint64_t size;
+        uint64_t hash;
+        std::string metadata;
+    };
+
+    // map the file and parse the index, archive is treated as empty if it's invalid
+    void Load();
+
+    bool VerifyEntry(const std::string &name, const IndexEntry &entry) const;
+
+    fs::path path_;
+
+    mutable std::shared_mutex mutex_;
+    MappedFile mapped_file_;
+    HashMap<std::string, IndexEntry> entries_;
+    bool valid_ = false;
+    // of the header in use, the next append writes its header to the other slot
+    uint64_t generation_ = 0;
+    // bytes of live blobs and the latest index, the rest of file is garbage
+    uint64_t live_size_ = 0;
+};
+
+BISMUTH_GFX_NAMESPACE_END
+
+BISMUTH_NAMESPACE_END
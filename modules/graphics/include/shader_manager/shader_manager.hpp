@@ -1,5 +1,9 @@
 #pragma once
 
+#include <mutex>
+
+#include "core/span.hpp"
+#include "core/thread_pool.hpp"
 #include "graphics/shader_compiler.hpp"
 
 BISMUTH_NAMESPACE_BEGIN
@@ -7,6 +11,28 @@ BISMUTH_NAMESPACE_BEGIN
 BISMUTH_GFX_NAMESPACE_BEGIN
 
 class Device;
+class ShaderArchive;
+
+struct ShaderModuleDesc {
+    std::string src_name;
+    fs::path src_path;
+    std::string entry;
+    ShaderStage stage;
+    HashMap<std::string, std::string> defines = {};
+    Vec<fs::path> include_dirs = {};
+    ShaderOptimizationLevel optimization = ShaderOptimizationLevel::ePerformance;
+    bool force = false;
+};
+
+struct ShaderCompileStats {
+    // time of loading binary or compiling
+    double time_ms = 0.0;
+    bool binary_loaded = false;
+    // recorded when the binary was compiled, so they are also available for loaded binaries
+    double optimization_time_ms = 0.0;
+    uint32_t num_instructions_unoptimized = 0;
+    uint32_t num_instructions = 0;
+};
 
 class ShaderManager {
 public:
@@ -16,10 +42,25 @@ public:
         ShaderStage stage, const HashMap<std::string, std::string> &defines = {},
         const Vec<fs::path> &include_dirs = {}, bool force = false);
 
+    Ptr<ShaderModule> GetShaderModule(const ShaderModuleDesc &desc, ShaderCompileStats *stats = nullptr);
+
+    // load or compile shaders concurrently, result and stats are in the same order as 'descs'
+    // newly compiled binaries are appended to the archive in 'binary_dir' together
+    Vec<Ptr<ShaderModule>> GetShaderModules(Span<ShaderModuleDesc> descs, Vec<ShaderCompileStats> *stats = nullptr);
+
 private:
+    std::string BinaryName(const ShaderModuleDesc &desc) const;
+
+    ThreadPool &CompileThreadPool();
+
     Ref<Device> device_;
     fs::path binary_dir_;
     Ref<ShaderCompiler> compiler_;
+    Rc<ShaderArchive> archive_;
+
+    // created when shaders are compiled in batch for the first time
+    std::once_flag thread_pool_flag_;
+    Ptr<ThreadPool> thread_pool_;
 };
 
 BISMUTH_GFX_NAMESPACE_END
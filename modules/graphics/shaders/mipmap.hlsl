@@ -21,18 +21,20 @@ float4 VS(uint vertex_id : SV_VertexID) : SV_POSITION {
 #define MIPMAP_MODE_AVG 0
 #define MIPMAP_MODE_MIN 1
 #define MIPMAP_MODE_MAX 2
-#ifndef MIPMAP_MODE
-#define MIPMAP_MODE MIPMAP_MODE_AVG
+#ifdef MIPMAP_MODE
+static const uint kMipmapMode = MIPMAP_MODE;
+#else
+// specialization constant, branches on it are folded when pipeline is created
+[[vk::constant_id(0)]] const uint kMipmapMode = MIPMAP_MODE_AVG;
 #endif
 
 inline float4 Op(float4 a, float4 b) {
-#if MIPMAP_MODE == MIPMAP_MODE_AVG
-    return a + b;
-#elif MIPMAP_MODE == MIPMAP_MODE_MIN
-    return min(a, b);
-#else
+    if (kMipmapMode == MIPMAP_MODE_AVG) {
+        return a + b;
+    } else if (kMipmapMode == MIPMAP_MODE_MIN) {
+        return min(a, b);
+    }
     return max(a, b);
-#endif
 }
 
 #ifndef USE_CS
@@ -56,38 +58,30 @@ void CS(int3 dtid : SV_DispatchThreadID) {
     float4 value11 = src_texture[pixel_coord_src + uint2(1, 1)];
 
     float4 result = Op(Op(value00, value01), Op(value10, value11));
-#if MIPMAP_MODE == MIPMAP_MODE_AVG
     uint num_pixels = 4;
-#endif
 
     const bool2 is_odd = (push_c.tex_size & 1) != 0;
     if (is_odd.x) {
         float4 value20 = src_texture[pixel_coord_src + uint2(2, 0)];
         float4 value21 = src_texture[pixel_coord_src + uint2(2, 1)];
         result = Op(result, Op(value20, value21));
-#if MIPMAP_MODE == MIPMAP_MODE_AVG
         num_pixels += 2;
-#endif
     }
     if (is_odd.y) {
         float4 value02 = src_texture[pixel_coord_src + uint2(0, 2)];
         float4 value12 = src_texture[pixel_coord_src + uint2(1, 2)];
         result = Op(result, Op(value02, value12));
-#if MIPMAP_MODE == MIPMAP_MODE_AVG
         num_pixels += 2;
-#endif
     }
     if (is_odd.x && is_odd.y) {
         float4 value22 = src_texture[pixel_coord_src + uint2(2, 2)];
         result = Op(result, value22);
-#if MIPMAP_MODE == MIPMAP_MODE_AVG
         num_pixels += 1;
-#endif
     }
 
-#if MIPMAP_MODE == MIPMAP_MODE_AVG
-    result /= num_pixels;
-#endif
+    if (kMipmapMode == MIPMAP_MODE_AVG) {
+        result /= num_pixels;
+    }
 
 #ifndef USE_CS
     return result;
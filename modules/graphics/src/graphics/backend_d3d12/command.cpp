@@ -6,6 +6,8 @@
 #include "device.hpp"
 #include "resource.hpp"
 #include "pipeline.hpp"
+#include "queue.hpp"
+#include "query.hpp"
 
 BISMUTH_NAMESPACE_BEGIN
 
@@ -17,6 +19,15 @@ UINT64 EncodeEventColor(float r, float g, float b) {
     return PIX_COLOR(static_cast<BYTE>(r * 255.0f), static_cast<BYTE>(g * 255.0f), static_cast<BYTE>(b * 255.0f));
 }
 
+// d3d12 has no queue ownership, a cross queue barrier is recorded only once on the direct queue
+// since compute and copy queues can't transition from or to graphics states
+bool SkipCrossQueueBarrier(const Queue *src_queue, const Queue *dst_queue, D3D12_COMMAND_LIST_TYPE list_type) {
+    if (src_queue == nullptr || dst_queue == nullptr || src_queue->Type() == dst_queue->Type()) {
+        return false;
+    }
+    return list_type != D3D12_COMMAND_LIST_TYPE_DIRECT;
+}
+
 D3D12_RESOURCE_STATES ToDxBufferState(BitFlags<ResourceAccessType> type) {
     D3D12_RESOURCE_STATES states = D3D12_RESOURCE_STATE_COMMON;
     if (type.Contains(ResourceAccessType::eVertexBufferRead)
@@ -90,11 +101,132 @@ D3D12_RESOURCE_STATES ToDxTextureState(BitFlags<ResourceAccessType> type) {
     return states;
 }
 
+void ToDxBarriers(Span<BufferBarrier> buffer_barriers, Span<TextureBarrier> texture_barriers,
+    D3D12_COMMAND_LIST_TYPE list_type, D3D12_RESOURCE_BARRIER_FLAGS transition_flags,
+    Vec<D3D12_RESOURCE_BARRIER> &barriers_dx) {
+    // aliasing and uav barriers can't be split, they are recorded with the end half
+    bool begin_only = transition_flags == D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+    barriers_dx.reserve(barriers_dx.size() + buffer_barriers.Size() + texture_barriers.Size());
+    for (const auto &barrier : buffer_barriers) {
+        auto buffer_dx = barrier.buffer.CastTo<BufferD3D12>();
+        if (buffer_dx->IsStateRestricted()
+            || SkipCrossQueueBarrier(barrier.src_queue, barrier.dst_queue, list_type)) {
+            continue;
+        }
+        if (barrier.discard && !begin_only) {
+            barriers_dx.push_back(D3D12_RESOURCE_BARRIER {
+                .Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING,
+                .Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE,
+                .Aliasing = D3D12_RESOURCE_ALIASING_BARRIER {
+                    .pResourceBefore = nullptr,
+                    .pResourceAfter = buffer_dx->Raw(),
+                },
+            });
+        }
+        auto src_states = ToDxBufferState(barrier.src_access_type);
+        auto dst_states = ToDxBufferState(barrier.dst_access_type);
+        if (src_states != dst_states) {
+            barriers_dx.push_back(D3D12_RESOURCE_BARRIER {
+                .Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION,
+                .Flags = transition_flags,
+                .Transition = D3D12_RESOURCE_TRANSITION_BARRIER {
+                    .pResource = buffer_dx->Raw(),
+                    .Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+                    .StateBefore = src_states,
+                    .StateAfter = dst_states,
+                },
+            });
+        } else if ((src_states & D3D12_RESOURCE_STATE_UNORDERED_ACCESS) != 0 && !begin_only) {
+            barriers_dx.push_back(D3D12_RESOURCE_BARRIER {
+                .Type = D3D12_RESOURCE_BARRIER_TYPE_UAV,
+                .Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE,
+                .UAV = D3D12_RESOURCE_UAV_BARRIER {
+                    .pResource = buffer_dx->Raw(),
+                },
+            });
+        }
+    }
+    for (const auto &barrier : texture_barriers) {
+        const auto texture_dx = barrier.texture.texture.CastTo<TextureD3D12>();
+        if (texture_dx->IsStateRestricted()
+            || SkipCrossQueueBarrier(barrier.src_queue, barrier.dst_queue, list_type)) {
+            continue;
+        }
+        if (barrier.discard && !begin_only) {
+            barriers_dx.push_back(D3D12_RESOURCE_BARRIER {
+                .Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING,
+                .Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE,
+                .Aliasing = D3D12_RESOURCE_ALIASING_BARRIER {
+                    .pResourceBefore = nullptr,
+                    .pResourceAfter = texture_dx->Raw(),
+                },
+            });
+        }
+        auto src_states = ToDxTextureState(barrier.src_access_type);
+        auto dst_states = ToDxTextureState(barrier.dst_access_type);
+        if (src_states != dst_states) {
+            if (barrier.texture.base_layer == 0 && barrier.texture.layers >= texture_dx->Layers()
+                && barrier.texture.base_level == 0 && barrier.texture.levels >= texture_dx->Desc().levels) {
+                barriers_dx.push_back(D3D12_RESOURCE_BARRIER {
+                    .Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION,
+                    .Flags = transition_flags,
+                    .Transition = D3D12_RESOURCE_TRANSITION_BARRIER {
+                        .pResource = texture_dx->Raw(),
+                        .Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+                        .StateBefore = src_states,
+                        .StateAfter = dst_states,
+                    },
+                });
+            } else {
+                for (uint32_t layer = 0; layer < barrier.texture.layers; layer++) {
+                    if (barrier.texture.base_layer + layer >= texture_dx->Layers()) {
+                        break;
+                    }
+                    for (uint32_t level = 0; level < barrier.texture.levels; level++) {
+                        if (barrier.texture.base_level + level >= texture_dx->Desc().levels) {
+                            break;
+                        }
+                        barriers_dx.push_back(D3D12_RESOURCE_BARRIER {
+                            .Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION,
+                            .Flags = transition_flags,
+                            .Transition = D3D12_RESOURCE_TRANSITION_BARRIER {
+                                .pResource = texture_dx->Raw(),
+                                .Subresource = texture_dx->SubresourceIndex(barrier.texture.base_level + level,
+                                    barrier.texture.base_layer + layer),
+                                .StateBefore = src_states,
+                                .StateAfter = dst_states,
+                            },
+                        });
+                    }
+                }
+            }
+        } else if ((src_states & D3D12_RESOURCE_STATE_UNORDERED_ACCESS) != 0 && !begin_only) {
+            barriers_dx.push_back(D3D12_RESOURCE_BARRIER {
+                .Type = D3D12_RESOURCE_BARRIER_TYPE_UAV,
+                .Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE,
+                .UAV = D3D12_RESOURCE_UAV_BARRIER {
+                    .pResource = texture_dx->Raw(),
+                },
+            });
+        }
+    }
+}
+
 }
 
 CommandBufferD3D12::CommandBufferD3D12(Ref<DeviceD3D12> device, ID3D12GraphicsCommandList4 *cmd_list)
     : device_(device), cmd_list_(cmd_list) {}
 
+void SplitBarrierD3D12::SetBarriers(Span<BufferBarrier> buffer_barriers, Span<TextureBarrier> texture_barriers) {
+    // split barriers are never used for queue ownership transfer
+    begin_barriers_dx_.clear();
+    ToDxBarriers(buffer_barriers, texture_barriers, D3D12_COMMAND_LIST_TYPE_DIRECT,
+        D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY, begin_barriers_dx_);
+    end_barriers_dx_.clear();
+    ToDxBarriers(buffer_barriers, texture_barriers, D3D12_COMMAND_LIST_TYPE_DIRECT,
+        D3D12_RESOURCE_BARRIER_FLAG_END_ONLY, end_barriers_dx_);
+}
+
 
 CommandEncoderD3D12::CommandEncoderD3D12(Ref<DeviceD3D12> device, Ref<FrameContextD3D12> context,
     ID3D12GraphicsCommandList4 *cmd_list) : device_(device), context_(context), cmd_list_(cmd_list) {}
@@ -255,95 +387,52 @@ void CommandEncoderD3D12::CopyTextureToBuffer(Ref<Texture> src_texture, Ref<Buff
 }
 
 void CommandEncoderD3D12::ResourceBarrier(Span<BufferBarrier> buffer_barriers, Span<TextureBarrier> texture_barriers) {
-    Vec<D3D12_RESOURCE_BARRIER> barriers_dx;
-    barriers_dx.reserve(buffer_barriers.Size() + texture_barriers.Size());
-    for (const auto &barrier : buffer_barriers) {
-        auto buffer_dx = barrier.buffer.CastTo<BufferD3D12>();
-        if (buffer_dx->IsStateRestricted()) {
-            continue;
-        }
-        auto src_states = ToDxBufferState(barrier.src_access_type);
-        auto dst_states = ToDxBufferState(barrier.dst_access_type);
-        if (src_states != dst_states) {
-            barriers_dx.push_back(D3D12_RESOURCE_BARRIER {
-                .Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION,
-                .Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE,
-                .Transition = D3D12_RESOURCE_TRANSITION_BARRIER {
-                    .pResource = buffer_dx->Raw(),
-                    .Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
-                    .StateBefore = src_states,
-                    .StateAfter = dst_states,
-                },
-            });
-        } else if ((src_states & D3D12_RESOURCE_STATE_UNORDERED_ACCESS) != 0) {
-            barriers_dx.push_back(D3D12_RESOURCE_BARRIER {
-                .Type = D3D12_RESOURCE_BARRIER_TYPE_UAV,
-                .Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE,
-                .UAV = D3D12_RESOURCE_UAV_BARRIER {
-                    .pResource = buffer_dx->Raw(),
-                },
-            });
-        }
+    barriers_dx_.clear();
+    ToDxBarriers(buffer_barriers, texture_barriers, cmd_list_->GetType(), D3D12_RESOURCE_BARRIER_FLAG_NONE,
+        barriers_dx_);
+
+    if (!barriers_dx_.empty()) {
+        cmd_list_->ResourceBarrier(barriers_dx_.size(), barriers_dx_.data());
     }
-    for (const auto &barrier : texture_barriers) {
-        const auto texture_dx = barrier.texture.texture.CastTo<TextureD3D12>();
-        if (texture_dx->IsStateRestricted()) {
-            continue;
-        }
-        auto src_states = ToDxTextureState(barrier.src_access_type);
-        auto dst_states = ToDxTextureState(barrier.dst_access_type);
-        if (src_states != dst_states) {
-            if (barrier.texture.base_layer == 0 && barrier.texture.layers >= texture_dx->Layers()
-                && barrier.texture.base_level == 0 && barrier.texture.levels >= texture_dx->Desc().levels) {
-                barriers_dx.push_back(D3D12_RESOURCE_BARRIER {
-                    .Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION,
-                    .Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE,
-                    .Transition = D3D12_RESOURCE_TRANSITION_BARRIER {
-                        .pResource = texture_dx->Raw(),
-                        .Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
-                        .StateBefore = src_states,
-                        .StateAfter = dst_states,
-                    },
-                });
-            } else {
-                for (uint32_t layer = 0; layer < barrier.texture.layers; layer++) {
-                    if (barrier.texture.base_layer + layer >= texture_dx->Layers()) {
-                        break;
-                    }
-                    for (uint32_t level = 0; level < barrier.texture.levels; level++) {
-                        if (barrier.texture.base_level + level >= texture_dx->Desc().levels) {
-                            break;
-                        }
-                        barriers_dx.push_back(D3D12_RESOURCE_BARRIER {
-                            .Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION,
-                            .Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE,
-                            .Transition = D3D12_RESOURCE_TRANSITION_BARRIER {
-                                .pResource = texture_dx->Raw(),
-                                .Subresource = texture_dx->SubresourceIndex(barrier.texture.base_level + level,
-                                    barrier.texture.base_layer + layer),
-                                .StateBefore = src_states,
-                                .StateAfter = dst_states,
-                            },
-                        });
-                    }
-                }
-            }
-        } else if ((src_states & D3D12_RESOURCE_STATE_UNORDERED_ACCESS) != 0) {
-            barriers_dx.push_back(D3D12_RESOURCE_BARRIER {
-                .Type = D3D12_RESOURCE_BARRIER_TYPE_UAV,
-                .Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE,
-                .UAV = D3D12_RESOURCE_UAV_BARRIER {
-                    .pResource = texture_dx->Raw(),
-                },
-            });
-        }
+}
+
+void CommandEncoderD3D12::BeginSplitBarrier(Span<Ref<SplitBarrier>> barriers) {
+    barriers_dx_.clear();
+    for (const auto &barrier : barriers) {
+        const auto &begin_barriers_dx = barrier.CastTo<SplitBarrierD3D12>()->RawBeginBarriers();
+        barriers_dx_.insert(barriers_dx_.end(), begin_barriers_dx.begin(), begin_barriers_dx.end());
     }
+    if (!barriers_dx_.empty()) {
+        cmd_list_->ResourceBarrier(barriers_dx_.size(), barriers_dx_.data());
+    }
+}
 
-    if (!barriers_dx.empty()) {
-        cmd_list_->ResourceBarrier(barriers_dx.size(), barriers_dx.data());
+void CommandEncoderD3D12::EndSplitBarrier(Span<Ref<SplitBarrier>> barriers) {
+    barriers_dx_.clear();
+    for (const auto &barrier : barriers) {
+        const auto &end_barriers_dx = barrier.CastTo<SplitBarrierD3D12>()->RawEndBarriers();
+        barriers_dx_.insert(barriers_dx_.end(), end_barriers_dx.begin(), end_barriers_dx.end());
+    }
+    if (!barriers_dx_.empty()) {
+        cmd_list_->ResourceBarrier(barriers_dx_.size(), barriers_dx_.data());
     }
 }
 
+void CommandEncoderD3D12::ResetQueries(Ref<QuerySet> query_set, uint32_t first_query, uint32_t num_queries) {
+    // queries don't need to be reset in d3d12
+}
+
+void CommandEncoderD3D12::WriteTimestamp(Ref<QuerySet> query_set, uint32_t query) {
+    auto query_set_dx = query_set.CastTo<QuerySetD3D12>();
+    cmd_list_->EndQuery(query_set_dx->Raw(), query_set_dx->RawType(), query);
+}
+
+void CommandEncoderD3D12::ResolveQueries(Ref<QuerySet> query_set, uint32_t first_query, uint32_t num_queries) {
+    auto query_set_dx = query_set.CastTo<QuerySetD3D12>();
+    cmd_list_->ResolveQueryData(query_set_dx->Raw(), query_set_dx->RawType(), first_query, num_queries,
+        query_set_dx->RawReadbackBuffer(), first_query * sizeof(uint64_t));
+}
+
 Ptr<RenderCommandEncoder> CommandEncoderD3D12::BeginRenderPass(const CommandLabel &label, const RenderTargetDesc &desc) {
     if (!label.label.empty()) {
         PushLabel(label);
@@ -482,9 +571,7 @@ void RenderCommandEncoderD3D12::PopLabel() {
 void RenderCommandEncoderD3D12::SetPipeline(Ref<RenderPipeline> pipeline) {
     curr_pipeline_ = pipeline.CastTo<RenderPipelineD3D12>().Get();
 
-    curr_pipeline_->SetTargetFormats(color_formats_, depth_stencil_format_);
-
-    cmd_list_->SetPipelineState(curr_pipeline_->RawPipeline());
+    cmd_list_->SetPipelineState(curr_pipeline_->RawPipeline(color_formats_, depth_stencil_format_));
     cmd_list_->SetGraphicsRootSignature(curr_pipeline_->RawRootSignature());
     cmd_list_->IASetPrimitiveTopology(curr_pipeline_->RawPrimitiveTopology());
 }
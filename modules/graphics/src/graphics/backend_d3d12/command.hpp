@@ -21,6 +21,18 @@ private:
     ID3D12GraphicsCommandList4 *cmd_list_;
 };
 
+class SplitBarrierD3D12 final : public SplitBarrier {
+public:
+    void SetBarriers(Span<BufferBarrier> buffer_barriers, Span<TextureBarrier> texture_barriers);
+
+    const Vec<D3D12_RESOURCE_BARRIER> &RawBeginBarriers() const { return begin_barriers_dx_; }
+    const Vec<D3D12_RESOURCE_BARRIER> &RawEndBarriers() const { return end_barriers_dx_; }
+
+private:
+    Vec<D3D12_RESOURCE_BARRIER> begin_barriers_dx_;
+    Vec<D3D12_RESOURCE_BARRIER> end_barriers_dx_;
+};
+
 class RenderCommandEncoderD3D12;
 class ComputeCommandEncoderD3D12;
 
@@ -50,6 +62,13 @@ public:
 
     void ResourceBarrier(Span<BufferBarrier> buffer_barriers, Span<TextureBarrier> texture_barriers) override;
 
+    void BeginSplitBarrier(Span<Ref<SplitBarrier>> barriers) override;
+    void EndSplitBarrier(Span<Ref<SplitBarrier>> barriers) override;
+
+    void ResetQueries(Ref<QuerySet> query_set, uint32_t first_query, uint32_t num_queries) override;
+    void WriteTimestamp(Ref<QuerySet> query_set, uint32_t query) override;
+    void ResolveQueries(Ref<QuerySet> query_set, uint32_t first_query, uint32_t num_queries) override;
+
     Ptr<RenderCommandEncoder> BeginRenderPass(const CommandLabel &label, const RenderTargetDesc &desc) override;
 
     Ptr<ComputeCommandEncoder> BeginComputePass(const CommandLabel &label) override;
@@ -61,6 +80,9 @@ private:
     Ref<DeviceD3D12> device_;
     Ref<FrameContextD3D12> context_;
     ID3D12GraphicsCommandList4 *cmd_list_;
+
+    // scratch storage reused by barrier commands so that they don't allocate once capacity is reached
+    Vec<D3D12_RESOURCE_BARRIER> barriers_dx_;
 };
 
 class RenderCommandEncoderD3D12 final : public RenderCommandEncoder {
@@ -7,9 +7,22 @@ BISMUTH_NAMESPACE_BEGIN
 
 BISMUTH_GFX_NAMESPACE_BEGIN
 
+namespace {
+
+D3D12_COMMAND_LIST_TYPE ToDxCommandListType(QueueType queue) {
+    switch (queue) {
+        case QueueType::eGraphics: return D3D12_COMMAND_LIST_TYPE_DIRECT;
+        case QueueType::eCompute: return D3D12_COMMAND_LIST_TYPE_COMPUTE;
+        case QueueType::eTransfer: return D3D12_COMMAND_LIST_TYPE_COPY;
+    }
+    Unreachable();
+}
+
+}
+
 FrameContextD3D12::FrameContextD3D12(Ref<class DeviceD3D12> device) : device_(device) {
-    device->Raw()->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&graphics_command_allocator_));
-    available_command_list_index_ = 0;
+    device->Raw()->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
+        IID_PPV_ARGS(&command_allocators_[static_cast<uint8_t>(QueueType::eGraphics)].allocator));
 
     cbv_srv_uav_heap_ =
         Ptr<ShaderVisibleDescriptorHeapD3D12>::Make(device_, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 65536);
@@ -19,36 +32,112 @@ FrameContextD3D12::FrameContextD3D12(Ref<class DeviceD3D12> device) : device_(de
 FrameContextD3D12::~FrameContextD3D12() {}
 
 void FrameContextD3D12::Reset() {
-    graphics_command_allocator_->Reset();
+    for (auto &command_allocator : command_allocators_) {
+        if (command_allocator.allocator) {
+            command_allocator.allocator->Reset();
+            command_allocator.available_command_list_index = 0;
+        }
+    }
+    available_split_barrier_index_ = 0;
+
+    cbv_srv_uav_heap_->Reset();
+    sampler_heap_->Reset();
+    descriptor_sets_.clear();
+    num_descriptor_cache_hits_ = 0;
+    num_descriptor_cache_misses_ = 0;
+
+    for (auto &context : thread_contexts_) {
+        if (context.IsInitialized()) {
+            context->Reset();
+        }
+    }
 }
 
 Ptr<CommandEncoder> FrameContextD3D12::GetCommandEncoder(QueueType queue) {
+    const auto type_dx = ToDxCommandListType(queue);
+    auto &command_allocator = command_allocators_[static_cast<uint8_t>(queue)];
+    if (!command_allocator.allocator) {
+        device_->Raw()->CreateCommandAllocator(type_dx, IID_PPV_ARGS(&command_allocator.allocator));
+    }
+
     ID3D12GraphicsCommandList4 *cmd_list = nullptr;
-    if (available_command_list_index_ < allocated_command_lists_.size()) {
-        cmd_list = allocated_command_lists_[available_command_list_index_].Get();
-        ++available_command_list_index_;
+    if (command_allocator.available_command_list_index < command_allocator.allocated_command_lists.size()) {
+        cmd_list = command_allocator.allocated_command_lists[command_allocator.available_command_list_index].Get();
+        ++command_allocator.available_command_list_index;
 
-        cmd_list->Reset(graphics_command_allocator_.Get(), nullptr);
+        cmd_list->Reset(command_allocator.allocator.Get(), nullptr);
     } else {
         ComPtr<ID3D12GraphicsCommandList4> cmd_list_ptr;
-        device_->Raw()->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, graphics_command_allocator_.Get(), nullptr,
+        device_->Raw()->CreateCommandList(0, type_dx, command_allocator.allocator.Get(), nullptr,
             IID_PPV_ARGS(&cmd_list_ptr));
-        allocated_command_lists_.emplace_back(cmd_list_ptr);
-        ++available_command_list_index_;
-        cmd_list = allocated_command_lists_.back().Get();
+        command_allocator.allocated_command_lists.emplace_back(cmd_list_ptr);
+        ++command_allocator.available_command_list_index;
+        cmd_list = command_allocator.allocated_command_lists.back().Get();
     }
 
-    ID3D12DescriptorHeap *heaps[] = { cbv_srv_uav_heap_->Raw(), sampler_heap_->Raw() };
-    cmd_list->SetDescriptorHeaps(2, heaps);
+    // copy command lists can't bind descriptor heaps
+    if (type_dx != D3D12_COMMAND_LIST_TYPE_COPY) {
+        ID3D12DescriptorHeap *heaps[] = { cbv_srv_uav_heap_->Raw(), sampler_heap_->Raw() };
+        cmd_list->SetDescriptorHeaps(2, heaps);
+    }
 
     return Ptr<CommandEncoderD3D12>::Make(device_, RefThis(), cmd_list);
 }
 
+Ref<FrameContext> FrameContextD3D12::GetThreadContext(uint32_t thread_index) {
+    if (thread_index == 0) {
+        return RefThis();
+    }
+    if (thread_contexts_.size() < thread_index) {
+        thread_contexts_.resize(thread_index);
+    }
+    auto &context = thread_contexts_[thread_index - 1];
+    if (!context.IsInitialized()) {
+        context = Ptr<FrameContextD3D12>::Make(device_);
+    }
+    return context.AsRef();
+}
+
+Ref<SplitBarrier> FrameContextD3D12::CreateSplitBarrier(Span<BufferBarrier> buffer_barriers,
+    Span<TextureBarrier> texture_barriers) {
+    if (available_split_barrier_index_ == split_barriers_.size()) {
+        split_barriers_.emplace_back(Ptr<SplitBarrierD3D12>::Make());
+    }
+    auto &split_barrier = split_barriers_[available_split_barrier_index_++];
+    split_barrier->SetBarriers(buffer_barriers, texture_barriers);
+    return split_barrier.AsRef();
+}
+
+DescriptorAllocationStats FrameContextD3D12::GetDescriptorStats() const {
+    DescriptorAllocationStats stats {
+        .num_cache_hits = num_descriptor_cache_hits_,
+        .num_cache_misses = num_descriptor_cache_misses_,
+        .num_allocated_sets = num_descriptor_cache_misses_,
+        .num_pools = 2,
+        .num_used_pools = (cbv_srv_uav_heap_->UsedCount() > 0 ? 1u : 0u) + (sampler_heap_->UsedCount() > 0 ? 1u : 0u),
+    };
+    for (const auto &context : thread_contexts_) {
+        if (context.IsInitialized()) {
+            const auto thread_stats = context->GetDescriptorStats();
+            stats.num_cache_hits += thread_stats.num_cache_hits;
+            stats.num_cache_misses += thread_stats.num_cache_misses;
+            stats.num_allocated_sets += thread_stats.num_allocated_sets;
+            stats.num_pools += thread_stats.num_pools;
+            stats.num_used_pools += thread_stats.num_used_pools;
+        }
+    }
+    return stats;
+}
+
 DescriptorHandle FrameContextD3D12::GetDescriptorSet(const DescriptorSetLayout &layout, const ShaderParams &values) {
-    auto key = std::make_pair(layout, values);
-    if (auto it = descriptor_sets_.find(key); it != descriptor_sets_.end()) {
-        return it->second;
+    auto &entries = descriptor_sets_[std::make_pair(std::hash<DescriptorSetLayout>{}(layout), values.Hash())];
+    for (const auto &entry : entries) {
+        if (entry.values == values && entry.layout == layout) {
+            ++num_descriptor_cache_hits_;
+            return entry.descriptors;
+        }
     }
+    ++num_descriptor_cache_misses_;
     
     bool use_sampler_heap = false;
     for (const auto binding : layout.bindings) {
@@ -62,7 +151,11 @@ DescriptorHandle FrameContextD3D12::GetDescriptorSet(const DescriptorSetLayout &
 
     auto descriptor_set =
         (use_sampler_heap ? sampler_heap_ : cbv_srv_uav_heap_)->AllocateAndWriteDescriptors(layout, values);
-    descriptor_sets_.insert({key, descriptor_set});
+    entries.EmplaceBack(DescriptorSetEntry {
+        .layout = layout,
+        .values = values,
+        .descriptors = descriptor_set,
+    });
     return descriptor_set;
 }
 
@@ -16,19 +16,44 @@ public:
 
     Ptr<class CommandEncoder> GetCommandEncoder(QueueType queue = QueueType::eGraphics) override;
 
+    Ref<FrameContext> GetThreadContext(uint32_t thread_index) override;
+
+    Ref<SplitBarrier> CreateSplitBarrier(Span<BufferBarrier> buffer_barriers,
+        Span<TextureBarrier> texture_barriers) override;
+
+    DescriptorAllocationStats GetDescriptorStats() const override;
+
     DescriptorHandle GetDescriptorSet(const DescriptorSetLayout &layout, const ShaderParams &values);
 
 private:
     Ref<DeviceD3D12> device_;
 
-    ComPtr<ID3D12CommandAllocator> graphics_command_allocator_;
-    Vec<ComPtr<ID3D12GraphicsCommandList4>> allocated_command_lists_;
-    size_t available_command_list_index_;
+    struct CommandAllocator {
+        ComPtr<ID3D12CommandAllocator> allocator;
+        Vec<ComPtr<ID3D12GraphicsCommandList4>> allocated_command_lists;
+        size_t available_command_list_index = 0;
+    };
+    // indexed by queue type, allocators of other queues than graphics are created when first used
+    CommandAllocator command_allocators_[3];
 
     Ptr<ShaderVisibleDescriptorHeapD3D12> cbv_srv_uav_heap_;
     Ptr<ShaderVisibleDescriptorHeapD3D12> sampler_heap_;
 
-    HashMap<std::pair<DescriptorSetLayout, ShaderParams>, DescriptorHandle> descriptor_sets_;
+    struct DescriptorSetEntry {
+        DescriptorSetLayout layout;
+        ShaderParams values;
+        DescriptorHandle descriptors;
+    };
+    // descriptors are valid until heaps are reset, found by hashes of layout and params without copying them,
+    // sets with colliding hashes share the same entry
+    HashMap<std::pair<size_t, size_t>, SmallVec<DescriptorSetEntry, 1>> descriptor_sets_;
+    size_t num_descriptor_cache_hits_ = 0;
+    size_t num_descriptor_cache_misses_ = 0;
+
+    Vec<Ptr<FrameContextD3D12>> thread_contexts_;
+
+    Vec<Ptr<class SplitBarrierD3D12>> split_barriers_;
+    size_t available_split_barrier_index_ = 0;
 };
 
 BISMUTH_GFX_NAMESPACE_END
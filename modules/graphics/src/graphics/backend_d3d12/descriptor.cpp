@@ -61,6 +61,7 @@ DescriptorHeapD3D12::DescriptorHeapD3D12(Ref<class DeviceD3D12> device, D3D12_DE
 DescriptorHeapD3D12::~DescriptorHeapD3D12() {}
 
 DescriptorHandle DescriptorHeapD3D12::AllocateDecriptor() {
+    std::lock_guard lock(mutex_);
     BI_ASSERT(used_count_ < max_count_);
 
     DescriptorHandle handle {
@@ -79,7 +80,7 @@ DescriptorHandle ShaderVisibleDescriptorHeapD3D12::AllocateAndWriteDescriptors(c
     const ShaderParams &values) {
     uint32_t num_descriptors = 0;
     for (const auto &binding : layout.bindings) {
-        num_descriptors += binding.immutable_samplers.Empty() ? binding.count : 0;
+        num_descriptors += binding.immutable_samplers.empty() ? binding.count : 0;
     }
     if (num_descriptors == 0) {
         return DescriptorHandle { { 0 }, { 0 } };
@@ -93,8 +94,8 @@ DescriptorHandle ShaderVisibleDescriptorHeapD3D12::AllocateAndWriteDescriptors(c
     used_count_ += num_descriptors;
 
     DescriptorHandle p_handle = handle;
-    for (uint32_t binding = 0; binding < values.resources.size(); binding++) {
-        const auto &resource = values.resources[binding];
+    for (uint32_t binding = 0; binding < values.Resources().size(); binding++) {
+        const auto &resource = values.Resources()[binding];
         const auto &binding_info = layout.bindings[binding];
         resource.Match(
             [](std::monostate) {},
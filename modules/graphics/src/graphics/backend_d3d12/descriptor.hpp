@@ -1,5 +1,7 @@
 #pragma once
 
+#include <mutex>
+
 #include "graphics/descriptor.hpp"
 #include "utils.hpp"
 
@@ -23,6 +25,8 @@ public:
     ID3D12DescriptorHeap *Raw() const { return heap_.Get(); }
     D3D12_DESCRIPTOR_HEAP_TYPE RawType() const { return type_; }
 
+    UINT UsedCount() const { return used_count_; }
+
 protected:
     Ref<DeviceD3D12> device_;
     ComPtr<ID3D12DescriptorHeap> heap_;
@@ -32,6 +36,8 @@ protected:
     UINT descriptor_size_;
     UINT max_count_;
     UINT used_count_;
+    // cpu heaps of device are shared by resources used on different threads
+    std::mutex mutex_;
 };
 
 class ShaderVisibleDescriptorHeapD3D12 : public DescriptorHeapD3D12 {
@@ -40,6 +46,9 @@ public:
         : DescriptorHeapD3D12(device, type, max_count, true) {}
 
     DescriptorHandle AllocateAndWriteDescriptors(const DescriptorSetLayout &layout, const ShaderParams &values);
+
+    // free all allocated descriptors
+    void Reset() { used_count_ = 0; }
 };
 
 BISMUTH_GFX_NAMESPACE_END
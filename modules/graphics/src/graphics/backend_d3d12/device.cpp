@@ -9,6 +9,7 @@
 #include "queue.hpp"
 #include "swap_chain.hpp"
 #include "sync.hpp"
+#include "query.hpp"
 #include "resource.hpp"
 #include "sampler.hpp"
 #include "pipeline.hpp"
@@ -72,6 +73,9 @@ DeviceD3D12::DeviceD3D12(const DeviceDesc &desc) {
         BI_CRTICAL(ModuleManager::Get<GraphicsModule>()->Lgr(), "No available GPU found");
     }
     BI_INFO(ModuleManager::Get<GraphicsModule>()->Lgr(), "Use GPU: {}", WCharsToString(adapter_desc.Description));
+    if (desc.enable_bindless) {
+        BI_WARN(ModuleManager::Get<GraphicsModule>()->Lgr(), "Bindless is not supported by D3D12 backend, disabled");
+    }
 
     D3D12CreateDevice(selected_adapter, kD3D12FeatureLevel, IID_PPV_ARGS(&device_));
 
@@ -110,6 +114,8 @@ DeviceD3D12::DeviceD3D12(const DeviceDesc &desc) {
 }
 
 DeviceD3D12::~DeviceD3D12() {
+    WaitPipelineCreation();
+
     allocator_->Release();
     allocator_ = nullptr;
 }
@@ -148,7 +154,7 @@ Ptr<Queue> DeviceD3D12::GetQueue(QueueType type) {
             type_dx = D3D12_COMMAND_LIST_TYPE_COPY;
             break;
     }
-    return Ptr<QueueD3D12>::Make(RefThis(), type_dx);
+    return Ptr<QueueD3D12>::Make(RefThis(), type, type_dx);
 }
 
 Ptr<SwapChain> DeviceD3D12::CreateSwapChain(const SwapChainDesc &desc) {
@@ -160,7 +166,11 @@ Ptr<Fence> DeviceD3D12::CreateFence() {
 }
 
 Ptr<Semaphore> DeviceD3D12::CreateSemaphore() {
-    return Ptr<SemaphoreD3D12>::Make();
+    return Ptr<SemaphoreD3D12>::Make(RefThis());
+}
+
+Ptr<QuerySet> DeviceD3D12::CreateQuerySet(const QuerySetDesc &desc) {
+    return Ptr<QuerySetD3D12>::Make(RefThis(), desc);
 }
 
 Ptr<Buffer> DeviceD3D12::CreateBuffer(const BufferDesc &desc) {
@@ -171,12 +181,32 @@ Ptr<Texture> DeviceD3D12::CreateTexture(const TextureDesc &desc) {
     return Ptr<TextureD3D12>::Make(RefThis(), desc);
 }
 
+ResourceMemoryRequirements DeviceD3D12::GetBufferMemoryRequirements(const BufferDesc &desc) {
+    return BufferD3D12::GetMemoryRequirements(RefThis(), desc);
+}
+
+ResourceMemoryRequirements DeviceD3D12::GetTextureMemoryRequirements(const TextureDesc &desc) {
+    return TextureD3D12::GetMemoryRequirements(RefThis(), desc);
+}
+
+Ptr<MemoryHeap> DeviceD3D12::CreateMemoryHeap(const MemoryHeapDesc &desc) {
+    return Ptr<MemoryHeapD3D12>::Make(RefThis(), desc);
+}
+
+Ptr<Buffer> DeviceD3D12::CreatePlacedBuffer(const BufferDesc &desc, Ref<MemoryHeap> heap, uint64_t offset) {
+    return Ptr<BufferD3D12>::Make(RefThis(), desc, heap.CastTo<MemoryHeapD3D12>(), offset);
+}
+
+Ptr<Texture> DeviceD3D12::CreatePlacedTexture(const TextureDesc &desc, Ref<MemoryHeap> heap, uint64_t offset) {
+    return Ptr<TextureD3D12>::Make(RefThis(), desc, heap.CastTo<MemoryHeapD3D12>(), offset);
+}
+
 Ptr<Sampler> DeviceD3D12::CreateSampler(const SamplerDesc &desc) {
     return Ptr<SamplerD3D12>::Make(RefThis(), desc);
 }
 
-Ptr<ShaderModule> DeviceD3D12::CreateShaderModule(const Vec<uint8_t> &src_bytes) {
-    return Ptr<ShaderModuleD3D12>::Make(RefThis(), src_bytes);
+Ptr<ShaderModule> DeviceD3D12::CreateShaderModule(Span<uint8_t> src_bytes, const ShaderReflection *reflection) {
+    return Ptr<ShaderModuleD3D12>::Make(RefThis(), src_bytes, reflection);
 }
 
 Ref<ShaderCompiler> DeviceD3D12::GetShaderCompiler() const {
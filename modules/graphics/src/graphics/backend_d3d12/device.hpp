@@ -24,13 +24,24 @@ public:
 
     Ptr<Semaphore> CreateSemaphore() override;
 
+    Ptr<QuerySet> CreateQuerySet(const QuerySetDesc &desc) override;
+
     Ptr<Buffer> CreateBuffer(const BufferDesc &desc) override;
 
     Ptr<Texture> CreateTexture(const TextureDesc &desc) override;
 
+    ResourceMemoryRequirements GetBufferMemoryRequirements(const BufferDesc &desc) override;
+    ResourceMemoryRequirements GetTextureMemoryRequirements(const TextureDesc &desc) override;
+
+    Ptr<MemoryHeap> CreateMemoryHeap(const MemoryHeapDesc &desc) override;
+
+    Ptr<Buffer> CreatePlacedBuffer(const BufferDesc &desc, Ref<MemoryHeap> heap, uint64_t offset) override;
+    Ptr<Texture> CreatePlacedTexture(const TextureDesc &desc, Ref<MemoryHeap> heap, uint64_t offset) override;
+
     Ptr<Sampler> CreateSampler(const SamplerDesc &desc) override;
 
-    Ptr<ShaderModule> CreateShaderModule(const Vec<uint8_t> &src_bytes) override;
+    Ptr<ShaderModule> CreateShaderModule(Span<uint8_t> src_bytes,
+        const ShaderReflection *reflection = nullptr) override;
 
     Ref<ShaderCompiler> GetShaderCompiler() const override;
 
@@ -40,6 +51,15 @@ public:
 
     Ptr<FrameContext> CreateFrameContext() override;
 
+    // descriptor heaps are owned by frame contexts, there is no global heap to index into
+    bool BindlessEnabled() const override { return false; }
+
+    // dxil has no specialization constants
+    bool SpecializationConstantsSupported() const override { return false; }
+
+    // pipeline cache is not implemented on D3D12
+    PipelineCacheStats GetPipelineCacheStats() const override { return {}; }
+
     ID3D12Device2 *Raw() const { return device_.Get(); }
 
     IDXGIFactory6 *RawFactory() const { return factory_.Get(); }
@@ -1,5 +1,7 @@
 #include "pipeline.hpp"
 
+#include <algorithm>
+
 #include "device.hpp"
 #include "sampler.hpp"
 
@@ -30,6 +32,8 @@ D3D12_DESCRIPTOR_RANGE_TYPE ToDxDescriptorRangeType(DescriptorType type) {
 
 void CreateSignature(const PipelineLayout &rhi_layout, ID3D12Device2 *device, ComPtr<ID3D12RootSignature> &signature,
     bool allow_input_assembler) {
+    BI_ASSERT_MSG(rhi_layout.bindless_set == kNoBindlessSet, "Bindless is not supported by D3D12 backend");
+
     Vec<D3D12_ROOT_PARAMETER1> root_params(rhi_layout.sets_layout.size()
         + (rhi_layout.push_constants_size > 0 ? 1 : 0));
     Vec<D3D12_STATIC_SAMPLER_DESC> static_samplers;
@@ -38,7 +42,7 @@ void CreateSignature(const PipelineLayout &rhi_layout, ID3D12Device2 *device, Co
     for (const auto &rhi_bindings : rhi_layout.sets_layout) {
         num_bindings += std::count_if(rhi_bindings.bindings.begin(), rhi_bindings.bindings.end(),
             [](const gfx::DescriptorSetLayoutBinding &rhi_binding) {
-                return rhi_binding.immutable_samplers.Empty() && rhi_binding.type != DescriptorType::eNone;
+                return rhi_binding.immutable_samplers.empty() && rhi_binding.type != DescriptorType::eNone;
             });
     }
     Vec<D3D12_DESCRIPTOR_RANGE1> bindings_info(num_bindings);
@@ -53,7 +57,7 @@ void CreateSignature(const PipelineLayout &rhi_layout, ID3D12Device2 *device, Co
             if (rhi_binding.type == DescriptorType::eNone) {
                 continue;
             }
-            if (rhi_binding.immutable_samplers.Empty()) {
+            if (rhi_binding.immutable_samplers.empty()) {
                 *p_binding_info = D3D12_DESCRIPTOR_RANGE1 {
                     .RangeType = ToDxDescriptorRangeType(rhi_binding.type),
                     .NumDescriptors = rhi_binding.count,
@@ -238,148 +242,185 @@ D3D12_PRIMITIVE_TOPOLOGY ToDxPrimitiveTopology(PrimitiveTopology topo) {
 
 RenderPipelineD3D12::RenderPipelineD3D12(Ref<DeviceD3D12> device, const RenderPipelineDesc &desc)
     : device_(device), desc_(desc) {
+    BI_ASSERT_MSG(desc.specialization_constants.empty(), "specialization constants are not supported by D3D12");
     CreateSignature(desc.layout, device->Raw(), root_signature_, true);
-}
+    topology_ = ToDxPrimitiveTopology(desc_.primitive_state.topology);
 
-void RenderPipelineD3D12::SetTargetFormats(Span<ResourceFormat> color_formats, ResourceFormat depth_stencil_format) {
-    bool need_to_rebuild = pipeline_ == nullptr;
-
-    for (size_t i = 0; i < std::min(color_formats.Size(), desc_.color_target_state.attachments.size()); i++) {
-        need_to_rebuild |= desc_.color_target_state.attachments[i].format != color_formats[i];
-        desc_.color_target_state.attachments[i].format = color_formats[i];
+    if (HasTargetFormats(desc_)) {
+        Vec<ResourceFormat> color_formats(desc_.color_target_state.attachments.size());
+        for (size_t i = 0; i < color_formats.size(); i++) {
+            color_formats[i] = desc_.color_target_state.attachments[i].format;
+        }
+        RawPipeline(color_formats, desc_.depth_stencil_state.format);
     }
-    need_to_rebuild |= desc_.depth_stencil_state.format != depth_stencil_format;
-    desc_.depth_stencil_state.format = depth_stencil_format;
-
-    if (need_to_rebuild) {
-        D3D12_GRAPHICS_PIPELINE_STATE_DESC pipeline_desc {};
+}
 
-        {
-            auto shader_vk = desc_.shaders.vertex.CastTo<ShaderModuleD3D12>();
-            pipeline_desc.VS = shader_vk->RawBytecode();
-        }
-        if (desc_.shaders.tessellation_control) {
-            auto shader_vk = static_cast<ShaderModuleD3D12 *>(desc_.shaders.tessellation_control);
-            pipeline_desc.DS = shader_vk->RawBytecode();
-        }
-        if (desc_.shaders.tessellation_evaluation) {
-            auto shader_vk = static_cast<ShaderModuleD3D12 *>(desc_.shaders.tessellation_evaluation);
-            pipeline_desc.HS = shader_vk->RawBytecode();
-        }
-        if (desc_.shaders.geometry) {
-            auto shader_vk = static_cast<ShaderModuleD3D12 *>(desc_.shaders.geometry);
-            pipeline_desc.GS = shader_vk->RawBytecode();
+ID3D12PipelineState *RenderPipelineD3D12::RawPipeline(Span<ResourceFormat> color_formats,
+    ResourceFormat depth_stencil_format) {
+    // formats of attachments beyond those in desc are ignored
+    const size_t num_colors = std::min(color_formats.Size(), desc_.color_target_state.attachments.size());
+    auto find_variant = [&]() -> const FormatVariant * {
+        for (const auto &variant : variants_) {
+            if (variant.depth_stencil_format == depth_stencil_format
+                && std::equal(variant.color_formats.begin(), variant.color_formats.end(),
+                    color_formats.begin(), color_formats.begin() + num_colors)) {
+                return &variant;
+            }
         }
-        {
-            auto shader_vk = desc_.shaders.fragment.CastTo<ShaderModuleD3D12>();
-            pipeline_desc.PS = shader_vk->RawBytecode();
+        return nullptr;
+    };
+    {
+        std::lock_guard lock(variants_mutex_);
+        if (const auto variant = find_variant(); variant) {
+            return variant->pipeline.Get();
         }
+    }
 
-        pipeline_desc.pRootSignature = root_signature_.Get();
-
-        pipeline_desc.NumRenderTargets = desc_.color_target_state.attachments.size();
-        for (size_t i = 0; i < desc_.color_target_state.attachments.size(); i++) {
-            const auto &attachment = desc_.color_target_state.attachments[i];
-            pipeline_desc.RTVFormats[i] = ToDxFormat(attachment.format);
-            pipeline_desc.BlendState.RenderTarget[i] = D3D12_RENDER_TARGET_BLEND_DESC {
-                .BlendEnable = attachment.blend_enable,
-                .LogicOpEnable = false,
-                .SrcBlend = ToDxBlendFactor(attachment.src_blend_factor),
-                .DestBlend = ToDxBlendFactor(attachment.dst_blend_factor),
-                .BlendOp = ToDxBlendOp(attachment.blend_op),
-                .SrcBlendAlpha = ToDxBlendFactor(attachment.src_alpha_blend_factor),
-                .DestBlendAlpha = ToDxBlendFactor(attachment.dst_alpha_blend_factor),
-                .BlendOpAlpha = ToDxBlendOp(attachment.alpha_blend_op),
-                .LogicOp = D3D12_LOGIC_OP_NOOP,
-                .RenderTargetWriteMask = attachment.color_write_mask.RawValue(),
-            };
-        }
+    auto pipeline = CreateRawPipeline(Span<ResourceFormat>(color_formats.Data(), num_colors), depth_stencil_format);
 
-        pipeline_desc.SampleMask = ~0u;
-
-        pipeline_desc.RasterizerState = D3D12_RASTERIZER_DESC {
-            .FillMode = ToDxFillMode(desc_.primitive_state.polygon_mode),
-            .CullMode = ToDxCullMode(desc_.primitive_state.cull_mode),
-            .FrontCounterClockwise = desc_.primitive_state.front_face == FrontFace::eCcw,
-            .DepthBias = 0,
-            .DepthBiasClamp = 0.0f,
-            .SlopeScaledDepthBias = 0.0f,
-            .DepthClipEnable = false,
-            .MultisampleEnable = false,
-            .AntialiasedLineEnable = false,
-            .ForcedSampleCount = 0,
-            .ConservativeRaster = desc_.primitive_state.conservative ? D3D12_CONSERVATIVE_RASTERIZATION_MODE_ON
-                : D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF,
-        };
+    std::lock_guard lock(variants_mutex_);
+    if (const auto variant = find_variant(); variant) {
+        return variant->pipeline.Get();
+    }
+    variants_.push_back(FormatVariant {
+        .color_formats = Vec<ResourceFormat>(color_formats.begin(), color_formats.begin() + num_colors),
+        .depth_stencil_format = depth_stencil_format,
+        .pipeline = pipeline,
+    });
+    return pipeline.Get();
+}
 
-        pipeline_desc.DepthStencilState = D3D12_DEPTH_STENCIL_DESC {
-            .DepthEnable = desc_.depth_stencil_state.format == ResourceFormat::eUndefined ? false
-                : desc_.depth_stencil_state.depth_test,
-            .DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL,
-            .DepthFunc = ToDxCompareFunc(desc_.depth_stencil_state.depth_compare_op),
-            .StencilEnable = desc_.depth_stencil_state.stencil_test,
-            .StencilReadMask = desc_.depth_stencil_state.stencil_compare_mask,
-            .StencilWriteMask = desc_.depth_stencil_state.stencil_write_mask,
-            .FrontFace = D3D12_DEPTH_STENCILOP_DESC {
-                .StencilFailOp = ToDxStencilOp(desc_.depth_stencil_state.stencil_front_face.fail_op),
-                .StencilDepthFailOp = ToDxStencilOp(desc_.depth_stencil_state.stencil_front_face.depth_fail_op),
-                .StencilPassOp = ToDxStencilOp(desc_.depth_stencil_state.stencil_front_face.pass_op),
-                .StencilFunc = ToDxCompareFunc(desc_.depth_stencil_state.stencil_front_face.compare_op),
-            },
-            .BackFace = D3D12_DEPTH_STENCILOP_DESC {
-                .StencilFailOp = ToDxStencilOp(desc_.depth_stencil_state.stencil_back_face.fail_op),
-                .StencilDepthFailOp = ToDxStencilOp(desc_.depth_stencil_state.stencil_back_face.depth_fail_op),
-                .StencilPassOp = ToDxStencilOp(desc_.depth_stencil_state.stencil_back_face.pass_op),
-                .StencilFunc = ToDxCompareFunc(desc_.depth_stencil_state.stencil_back_face.compare_op),
-            },
+ComPtr<ID3D12PipelineState> RenderPipelineD3D12::CreateRawPipeline(Span<ResourceFormat> color_formats,
+    ResourceFormat depth_stencil_format) const {
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC pipeline_desc {};
+
+    {
+        auto shader_vk = desc_.shaders.vertex.CastTo<ShaderModuleD3D12>();
+        pipeline_desc.VS = shader_vk->RawBytecode();
+    }
+    if (desc_.shaders.tessellation_control) {
+        auto shader_vk = static_cast<ShaderModuleD3D12 *>(desc_.shaders.tessellation_control);
+        pipeline_desc.DS = shader_vk->RawBytecode();
+    }
+    if (desc_.shaders.tessellation_evaluation) {
+        auto shader_vk = static_cast<ShaderModuleD3D12 *>(desc_.shaders.tessellation_evaluation);
+        pipeline_desc.HS = shader_vk->RawBytecode();
+    }
+    if (desc_.shaders.geometry) {
+        auto shader_vk = static_cast<ShaderModuleD3D12 *>(desc_.shaders.geometry);
+        pipeline_desc.GS = shader_vk->RawBytecode();
+    }
+    {
+        auto shader_vk = desc_.shaders.fragment.CastTo<ShaderModuleD3D12>();
+        pipeline_desc.PS = shader_vk->RawBytecode();
+    }
+
+    pipeline_desc.pRootSignature = root_signature_.Get();
+
+    pipeline_desc.NumRenderTargets = static_cast<UINT>(color_formats.Size());
+    for (size_t i = 0; i < color_formats.Size(); i++) {
+        const auto &attachment = desc_.color_target_state.attachments[i];
+        pipeline_desc.RTVFormats[i] = ToDxFormat(color_formats[i]);
+        pipeline_desc.BlendState.RenderTarget[i] = D3D12_RENDER_TARGET_BLEND_DESC {
+            .BlendEnable = attachment.blend_enable,
+            .LogicOpEnable = false,
+            .SrcBlend = ToDxBlendFactor(attachment.src_blend_factor),
+            .DestBlend = ToDxBlendFactor(attachment.dst_blend_factor),
+            .BlendOp = ToDxBlendOp(attachment.blend_op),
+            .SrcBlendAlpha = ToDxBlendFactor(attachment.src_alpha_blend_factor),
+            .DestBlendAlpha = ToDxBlendFactor(attachment.dst_alpha_blend_factor),
+            .BlendOpAlpha = ToDxBlendOp(attachment.alpha_blend_op),
+            .LogicOp = D3D12_LOGIC_OP_NOOP,
+            .RenderTargetWriteMask = attachment.color_write_mask.RawValue(),
         };
-        pipeline_desc.DSVFormat = ToDxFormat(desc_.depth_stencil_state.format);
-
-        Vec<D3D12_INPUT_ELEMENT_DESC> input_elements;
-        for (size_t i = 0; i < desc_.vertex_input_buffers.size(); i++) {
-            const auto &input_buffer = desc_.vertex_input_buffers[i];
-            for (const auto &attribute : input_buffer.attributes) {
-                uint32_t location = static_cast<uint32_t>(attribute.semantics);
-                input_elements.push_back(D3D12_INPUT_ELEMENT_DESC {
-                    .SemanticName = ToDxSemanticName(attribute.semantics),
-                    .SemanticIndex = ToDxSemanticIndex(attribute.semantics),
-                    .Format = ToDxFormat(attribute.format),
-                    .InputSlot = static_cast<UINT>(i),
-                    .AlignedByteOffset = attribute.offset,
-                    .InputSlotClass = input_buffer.per_instance
-                        ? D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA : D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
-                    .InstanceDataStepRate = input_buffer.per_instance ? 1u : 0u,
-                });
-            }
+    }
+
+    pipeline_desc.SampleMask = ~0u;
+
+    pipeline_desc.RasterizerState = D3D12_RASTERIZER_DESC {
+        .FillMode = ToDxFillMode(desc_.primitive_state.polygon_mode),
+        .CullMode = ToDxCullMode(desc_.primitive_state.cull_mode),
+        .FrontCounterClockwise = desc_.primitive_state.front_face == FrontFace::eCcw,
+        .DepthBias = 0,
+        .DepthBiasClamp = 0.0f,
+        .SlopeScaledDepthBias = 0.0f,
+        .DepthClipEnable = false,
+        .MultisampleEnable = false,
+        .AntialiasedLineEnable = false,
+        .ForcedSampleCount = 0,
+        .ConservativeRaster = desc_.primitive_state.conservative ? D3D12_CONSERVATIVE_RASTERIZATION_MODE_ON
+            : D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF,
+    };
+
+    pipeline_desc.DepthStencilState = D3D12_DEPTH_STENCIL_DESC {
+        .DepthEnable = depth_stencil_format == ResourceFormat::eUndefined ? false
+            : desc_.depth_stencil_state.depth_test,
+        .DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL,
+        .DepthFunc = ToDxCompareFunc(desc_.depth_stencil_state.depth_compare_op),
+        .StencilEnable = desc_.depth_stencil_state.stencil_test,
+        .StencilReadMask = desc_.depth_stencil_state.stencil_compare_mask,
+        .StencilWriteMask = desc_.depth_stencil_state.stencil_write_mask,
+        .FrontFace = D3D12_DEPTH_STENCILOP_DESC {
+            .StencilFailOp = ToDxStencilOp(desc_.depth_stencil_state.stencil_front_face.fail_op),
+            .StencilDepthFailOp = ToDxStencilOp(desc_.depth_stencil_state.stencil_front_face.depth_fail_op),
+            .StencilPassOp = ToDxStencilOp(desc_.depth_stencil_state.stencil_front_face.pass_op),
+            .StencilFunc = ToDxCompareFunc(desc_.depth_stencil_state.stencil_front_face.compare_op),
+        },
+        .BackFace = D3D12_DEPTH_STENCILOP_DESC {
+            .StencilFailOp = ToDxStencilOp(desc_.depth_stencil_state.stencil_back_face.fail_op),
+            .StencilDepthFailOp = ToDxStencilOp(desc_.depth_stencil_state.stencil_back_face.depth_fail_op),
+            .StencilPassOp = ToDxStencilOp(desc_.depth_stencil_state.stencil_back_face.pass_op),
+            .StencilFunc = ToDxCompareFunc(desc_.depth_stencil_state.stencil_back_face.compare_op),
+        },
+    };
+    pipeline_desc.DSVFormat = ToDxFormat(depth_stencil_format);
+
+    Vec<D3D12_INPUT_ELEMENT_DESC> input_elements;
+    for (size_t i = 0; i < desc_.vertex_input_buffers.size(); i++) {
+        const auto &input_buffer = desc_.vertex_input_buffers[i];
+        for (const auto &attribute : input_buffer.attributes) {
+            uint32_t location = static_cast<uint32_t>(attribute.semantics);
+            input_elements.push_back(D3D12_INPUT_ELEMENT_DESC {
+                .SemanticName = ToDxSemanticName(attribute.semantics),
+                .SemanticIndex = ToDxSemanticIndex(attribute.semantics),
+                .Format = ToDxFormat(attribute.format),
+                .InputSlot = static_cast<UINT>(i),
+                .AlignedByteOffset = attribute.offset,
+                .InputSlotClass = input_buffer.per_instance
+                    ? D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA : D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+                .InstanceDataStepRate = input_buffer.per_instance ? 1u : 0u,
+            });
         }
-        pipeline_desc.InputLayout = D3D12_INPUT_LAYOUT_DESC {
-            .pInputElementDescs = input_elements.data(),
-            .NumElements = static_cast<UINT>(input_elements.size()),
-        };
+    }
+    pipeline_desc.InputLayout = D3D12_INPUT_LAYOUT_DESC {
+        .pInputElementDescs = input_elements.data(),
+        .NumElements = static_cast<UINT>(input_elements.size()),
+    };
 
-        pipeline_desc.PrimitiveTopologyType = ToDxPrimitiveTopologyType(desc_.primitive_state.topology);
-        topology_ = ToDxPrimitiveTopology(desc_.primitive_state.topology);
+    pipeline_desc.PrimitiveTopologyType = ToDxPrimitiveTopologyType(desc_.primitive_state.topology);
 
-        pipeline_desc.SampleDesc = DXGI_SAMPLE_DESC { .Count = 1, .Quality = 0 };
+    pipeline_desc.SampleDesc = DXGI_SAMPLE_DESC { .Count = 1, .Quality = 0 };
 
-        pipeline_desc.NodeMask = 0;
+    pipeline_desc.NodeMask = 0;
 
-        pipeline_desc.CachedPSO = {};
+    pipeline_desc.CachedPSO = {};
 
-        pipeline_desc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+    pipeline_desc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
 
-        device_->Raw()->CreateGraphicsPipelineState(&pipeline_desc, IID_PPV_ARGS(&pipeline_));
+    ComPtr<ID3D12PipelineState> pipeline;
+    device_->Raw()->CreateGraphicsPipelineState(&pipeline_desc, IID_PPV_ARGS(&pipeline));
 
-        if (!desc_.name.empty()) {
-            pipeline_->SetPrivateData(WKPDID_D3DDebugObjectName, desc_.name.size(), desc_.name.data());
-        }
+    if (!desc_.name.empty()) {
+        pipeline->SetPrivateData(WKPDID_D3DDebugObjectName, desc_.name.size(), desc_.name.data());
     }
+    return pipeline;
 }
 
 RenderPipelineD3D12::~RenderPipelineD3D12() {}
 
 ComputePipelineD3D12::ComputePipelineD3D12(Ref<DeviceD3D12> device, const ComputePipelineDesc &desc)
     : device_(device), desc_(desc) {
+    BI_ASSERT_MSG(desc.specialization_constants.empty(), "specialization constants are not supported by D3D12");
     auto shader_dx = desc.compute.CastTo<ShaderModuleD3D12>();
 
     CreateSignature(desc.layout, device->Raw(), root_signature_, false);
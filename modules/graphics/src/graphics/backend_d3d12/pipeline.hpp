@@ -1,5 +1,7 @@
 #pragma once
 
+#include <mutex>
+
 #include "graphics/pipeline.hpp"
 #include "shader.hpp"
 
@@ -12,9 +14,9 @@ public:
     RenderPipelineD3D12(Ref<class DeviceD3D12> device, const RenderPipelineDesc &desc);
     ~RenderPipelineD3D12() override;
 
-    void SetTargetFormats(Span<ResourceFormat> color_formats, ResourceFormat depth_stencil_format);
-
-    ID3D12PipelineState *RawPipeline() const { return pipeline_.Get(); }
+    // pipeline of the target formats, created on first use, encoders on different threads may call it at the same
+    // time, so the desc is never changed
+    ID3D12PipelineState *RawPipeline(Span<ResourceFormat> color_formats, ResourceFormat depth_stencil_format);
 
     ID3D12RootSignature *RawRootSignature() const { return root_signature_.Get(); }
 
@@ -23,11 +25,22 @@ public:
     const RenderPipelineDesc &Desc() const { return desc_; }
 
 private:
+    ComPtr<ID3D12PipelineState> CreateRawPipeline(Span<ResourceFormat> color_formats,
+        ResourceFormat depth_stencil_format) const;
+
     Ref<DeviceD3D12> device_;
     RenderPipelineDesc desc_;
 
     ComPtr<ID3D12RootSignature> root_signature_;
-    ComPtr<ID3D12PipelineState> pipeline_;
+
+    struct FormatVariant {
+        Vec<ResourceFormat> color_formats;
+        ResourceFormat depth_stencil_format;
+        ComPtr<ID3D12PipelineState> pipeline;
+    };
+    // kept until this pipeline is destroyed since recorded commands may still use them
+    std::mutex variants_mutex_;
+    Vec<FormatVariant> variants_;
 
     D3D12_PRIMITIVE_TOPOLOGY topology_;
 };
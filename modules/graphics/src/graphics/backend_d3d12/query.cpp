@@ -0,0 +1,68 @@
+#include "query.hpp"
+
+#include <algorithm>
+
+#include "device.hpp"
+#include "resource.hpp"
+
+BISMUTH_NAMESPACE_BEGIN
+
+BISMUTH_GFX_NAMESPACE_BEGIN
+
+namespace {
+
+D3D12_QUERY_HEAP_TYPE ToDxQueryHeapType(QueryType type) {
+    switch (type) {
+        case QueryType::eTimestamp: return D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    }
+    Unreachable();
+}
+
+D3D12_QUERY_TYPE ToDxQueryType(QueryType type) {
+    switch (type) {
+        case QueryType::eTimestamp: return D3D12_QUERY_TYPE_TIMESTAMP;
+    }
+    Unreachable();
+}
+
+}
+
+QuerySetD3D12::QuerySetD3D12(Ref<DeviceD3D12> device, const QuerySetDesc &desc) : device_(device) {
+    desc_ = desc;
+    type_dx_ = ToDxQueryType(desc.type);
+
+    D3D12_QUERY_HEAP_DESC query_heap_desc {
+        .Type = ToDxQueryHeapType(desc.type),
+        .Count = desc.count,
+        .NodeMask = 0,
+    };
+    device_->Raw()->CreateQueryHeap(&query_heap_desc, IID_PPV_ARGS(&query_heap_));
+
+    readback_buffer_ = device_->CreateBuffer(BufferDesc {
+        .name = desc.name.empty() ? "" : desc.name + " readback",
+        .size = desc.count * sizeof(uint64_t),
+        .usages = BufferUsage::eNone,
+        .memory_property = BufferMemoryProperty::eGpuToCpu,
+        .persistently_mapped = true,
+    });
+
+    if (!desc.name.empty()) {
+        query_heap_->SetPrivateData(WKPDID_D3DDebugObjectName, desc.name.size(), desc.name.data());
+    }
+}
+
+QuerySetD3D12::~QuerySetD3D12() {}
+
+bool QuerySetD3D12::GetResults(uint32_t first_query, uint32_t num_queries, uint64_t *results) {
+    auto mapped = static_cast<const uint64_t *>(readback_buffer_->Map());
+    std::copy_n(mapped + first_query, num_queries, results);
+    return true;
+}
+
+ID3D12Resource *QuerySetD3D12::RawReadbackBuffer() const {
+    return readback_buffer_.AsRef().CastTo<BufferD3D12>()->Raw();
+}
+
+BISMUTH_GFX_NAMESPACE_END
+
+BISMUTH_NAMESPACE_END
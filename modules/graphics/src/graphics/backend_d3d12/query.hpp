@@ -0,0 +1,33 @@
+#pragma once
+
+#include "core/ptr.hpp"
+#include "utils.hpp"
+#include "graphics/query.hpp"
+#include "graphics/resource.hpp"
+
+BISMUTH_NAMESPACE_BEGIN
+
+BISMUTH_GFX_NAMESPACE_BEGIN
+
+// results are resolved to a readback buffer, timestamps on copy queues are not supported
+class QuerySetD3D12 final : public QuerySet {
+public:
+    QuerySetD3D12(Ref<class DeviceD3D12> device, const QuerySetDesc &desc);
+    ~QuerySetD3D12() override;
+
+    bool GetResults(uint32_t first_query, uint32_t num_queries, uint64_t *results) override;
+
+    ID3D12QueryHeap *Raw() const { return query_heap_.Get(); }
+    D3D12_QUERY_TYPE RawType() const { return type_dx_; }
+    ID3D12Resource *RawReadbackBuffer() const;
+
+private:
+    Ref<DeviceD3D12> device_;
+    ComPtr<ID3D12QueryHeap> query_heap_;
+    D3D12_QUERY_TYPE type_dx_;
+    Ptr<Buffer> readback_buffer_;
+};
+
+BISMUTH_GFX_NAMESPACE_END
+
+BISMUTH_NAMESPACE_END
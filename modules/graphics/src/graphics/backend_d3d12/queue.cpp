@@ -2,14 +2,16 @@
 
 #include "device.hpp"
 #include "command.hpp"
+#include "sync.hpp"
 
 BISMUTH_NAMESPACE_BEGIN
 
 BISMUTH_GFX_NAMESPACE_BEGIN
 
-QueueD3D12::QueueD3D12(Ref<DeviceD3D12> device, D3D12_COMMAND_LIST_TYPE type) : device_(device) {
+QueueD3D12::QueueD3D12(Ref<DeviceD3D12> device, QueueType type, D3D12_COMMAND_LIST_TYPE type_dx)
+    : device_(device), type_(type) {
     D3D12_COMMAND_QUEUE_DESC queue_desc {
-        .Type = type,
+        .Type = type_dx,
         .Priority = 0,
         .Flags = D3D12_COMMAND_QUEUE_FLAG_NONE,
         .NodeMask = 0,
@@ -22,6 +24,12 @@ QueueD3D12::QueueD3D12(Ref<DeviceD3D12> device, D3D12_COMMAND_LIST_TYPE type) :
 
 QueueD3D12::~QueueD3D12() {}
 
+uint64_t QueueD3D12::TimestampFrequency() const {
+    UINT64 frequency = 0;
+    queue_->GetTimestampFrequency(&frequency);
+    return frequency;
+}
+
 void QueueD3D12::WaitIdle() const {
     ++fence_value_;
     queue_->Signal(fence_.Get(), fence_value_);
@@ -39,7 +47,13 @@ void QueueD3D12::SubmitCommandBuffer(Span<Ptr<CommandBuffer>> &&cmd_buffers, Spa
     for (size_t i = 0; i < cmd_buffers.Size(); i++) {
         cmd_lists[i] = cmd_buffers[i].AsRef().CastTo<CommandBufferD3D12>()->Raw();
     }
+    for (const auto &semaphore : wait_semaphores) {
+        semaphore.CastTo<SemaphoreD3D12>()->WaitOn(this);
+    }
     queue_->ExecuteCommandLists(cmd_lists.size(), cmd_lists.data());
+    for (const auto &semaphore : signal_semaphores) {
+        semaphore.CastTo<SemaphoreD3D12>()->SignalOn(this);
+    }
 
     if (signal_fence) {
         signal_fence->SignalOn(this);
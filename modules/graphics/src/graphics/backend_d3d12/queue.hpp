@@ -9,9 +9,13 @@ BISMUTH_GFX_NAMESPACE_BEGIN
 
 class QueueD3D12 final : public Queue {
 public:
-    QueueD3D12(Ref<class DeviceD3D12> device, D3D12_COMMAND_LIST_TYPE type);
+    QueueD3D12(Ref<class DeviceD3D12> device, QueueType type, D3D12_COMMAND_LIST_TYPE type_dx);
     ~QueueD3D12() override;
 
+    QueueType Type() const override { return type_; }
+
+    uint64_t TimestampFrequency() const override;
+
     void WaitIdle() const override;
 
     void SubmitCommandBuffer(Span<Ptr<CommandBuffer>> &&cmd_buffers, Span<Ref<Semaphore>> wait_semaphores = {},
@@ -22,6 +26,7 @@ public:
 private:
     Ref<DeviceD3D12> device_;
     ComPtr<ID3D12CommandQueue> queue_;
+    QueueType type_;
 
     mutable UINT64 fence_value_ = 0;
     ComPtr<ID3D12Fence> fence_;
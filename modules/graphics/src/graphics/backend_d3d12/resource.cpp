@@ -55,17 +55,18 @@ D3D12_HEAP_TYPE ToDxHeapType(BufferMemoryProperty prop) {
     Unreachable();
 }
 
-}
-
-BufferD3D12::BufferD3D12(Ref<DeviceD3D12> device, const BufferDesc &desc) : device_(device), size_(desc.size) {
+uint64_t AlignedBufferSize(const BufferDesc &desc) {
     if (desc.usages.Contains(BufferUsage::eUniform)) {
-        size_ = (desc.size + 255) >> 8 << 8;
+        return (desc.size + 255) >> 8 << 8;
     }
+    return desc.size;
+}
 
-    D3D12_RESOURCE_DESC resource_desc {
+D3D12_RESOURCE_DESC ToDxResourceDesc(const BufferDesc &desc) {
+    return D3D12_RESOURCE_DESC {
         .Dimension = D3D12_RESOURCE_DIMENSION_BUFFER,
         .Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
-        .Width = size_,
+        .Width = AlignedBufferSize(desc),
         .Height = 1,
         .DepthOrArraySize = 1,
         .MipLevels = 1,
@@ -74,6 +75,76 @@ BufferD3D12::BufferD3D12(Ref<DeviceD3D12> device, const BufferDesc &desc) : devi
         .Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR,
         .Flags = ToDxResourceFlags(desc.usages),
     };
+}
+
+D3D12_RESOURCE_DESC ToDxResourceDesc(const TextureDesc &desc) {
+    return D3D12_RESOURCE_DESC {
+        .Dimension = ToDxDimension(desc.dim),
+        .Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
+        .Width = desc.extent.width,
+        .Height = desc.extent.height,
+        .DepthOrArraySize = static_cast<UINT16>(desc.extent.depth_or_layers),
+        .MipLevels = static_cast<UINT16>(desc.levels),
+        .Format = ToDxFormat(desc.format),
+        .SampleDesc = { .Count = 1, .Quality = 0 },
+        .Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN,
+        .Flags = ToDxResourceFlags(desc.usages),
+    };
+}
+
+// resource heap tier 1 can't mix these kinds of resources in one heap, so use one bit for each kind
+constexpr uint32_t kBufferMemoryTypeBit = 0x1;
+constexpr uint32_t kRtDsTextureMemoryTypeBit = 0x2;
+constexpr uint32_t kNonRtDsTextureMemoryTypeBit = 0x4;
+
+D3D12_HEAP_FLAGS ToDxHeapFlags(uint32_t memory_type_bits) {
+    if (memory_type_bits == kBufferMemoryTypeBit) {
+        return D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+    } else if (memory_type_bits == kRtDsTextureMemoryTypeBit) {
+        return D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+    } else if (memory_type_bits == kNonRtDsTextureMemoryTypeBit) {
+        return D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+    }
+    return D3D12_HEAP_FLAG_NONE;
+}
+
+ResourceMemoryRequirements GetDxMemoryRequirements(ID3D12Device2 *device, const D3D12_RESOURCE_DESC &resource_desc,
+    uint32_t memory_type_bits) {
+    D3D12_RESOURCE_ALLOCATION_INFO info = device->GetResourceAllocationInfo(0, 1, &resource_desc);
+    return ResourceMemoryRequirements {
+        .size = info.SizeInBytes,
+        .alignment = info.Alignment,
+        .memory_type_bits = memory_type_bits,
+    };
+}
+
+}
+
+MemoryHeapD3D12::MemoryHeapD3D12(Ref<DeviceD3D12> device, const MemoryHeapDesc &desc) : device_(device) {
+    desc_ = desc;
+
+    D3D12MA::ALLOCATION_DESC allocation_desc {
+        .HeapType = D3D12_HEAP_TYPE_DEFAULT,
+        .ExtraHeapFlags = ToDxHeapFlags(desc.memory_type_bits),
+    };
+    D3D12_RESOURCE_ALLOCATION_INFO allocation_info {
+        .SizeInBytes = desc.size,
+        .Alignment = std::max<uint64_t>(desc.alignment, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT),
+    };
+    device_->RawAllocator()->AllocateMemory(&allocation_desc, &allocation_info, &allocation_);
+}
+
+MemoryHeapD3D12::~MemoryHeapD3D12() {
+    if (allocation_) {
+        allocation_->Release();
+        allocation_ = nullptr;
+    }
+}
+
+BufferD3D12::BufferD3D12(Ref<DeviceD3D12> device, const BufferDesc &desc) : device_(device), size_(desc.size) {
+    size_ = AlignedBufferSize(desc);
+
+    D3D12_RESOURCE_DESC resource_desc = ToDxResourceDesc(desc);
     D3D12MA::ALLOCATION_DESC allocation_desc {
         .HeapType = ToDxHeapType(desc.memory_property),
     };
@@ -97,6 +168,23 @@ BufferD3D12::BufferD3D12(Ref<DeviceD3D12> device, const BufferDesc &desc) : devi
     }
 }
 
+BufferD3D12::BufferD3D12(Ref<DeviceD3D12> device, const BufferDesc &desc, Ref<MemoryHeapD3D12> heap,
+    uint64_t offset) : device_(device) {
+    size_ = AlignedBufferSize(desc);
+
+    D3D12_RESOURCE_DESC resource_desc = ToDxResourceDesc(desc);
+    device_->RawAllocator()->CreateAliasingResource(heap->RawAllocation(), offset, &resource_desc,
+        D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&resource_));
+
+    if (!desc.name.empty()) {
+        resource_->SetPrivateData(WKPDID_D3DDebugObjectName, desc.name.size(), desc.name.data());
+    }
+}
+
+ResourceMemoryRequirements BufferD3D12::GetMemoryRequirements(Ref<DeviceD3D12> device, const BufferDesc &desc) {
+    return GetDxMemoryRequirements(device->Raw(), ToDxResourceDesc(desc), kBufferMemoryTypeBit);
+}
+
 BufferD3D12::~BufferD3D12() {
     Unmap();
     if (allocation_) {
@@ -120,6 +208,7 @@ void BufferD3D12::Unmap() {
 }
 
 DescriptorHandle BufferD3D12::GetView(const BufferViewD3D12Desc &view_desc) const {
+    std::lock_guard lock(views_mutex_);
     if (auto it = cached_views_.find(view_desc); it != cached_views_.end()) {
         return it->second;
     }
@@ -174,18 +263,7 @@ DescriptorHandle BufferD3D12::GetView(const BufferViewD3D12Desc &view_desc) cons
 
 TextureD3D12::TextureD3D12(Ref<DeviceD3D12> device, const TextureDesc &desc) : device_(device) {
     desc_ = desc;
-    D3D12_RESOURCE_DESC resource_desc {
-        .Dimension = ToDxDimension(desc.dim),
-        .Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
-        .Width = desc.extent.width,
-        .Height = desc.extent.height,
-        .DepthOrArraySize = static_cast<UINT16>(desc.extent.depth_or_layers),
-        .MipLevels = static_cast<UINT16>(desc.levels),
-        .Format = ToDxFormat(desc.format),
-        .SampleDesc = { .Count = 1, .Quality = 0 },
-        .Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN,
-        .Flags = ToDxResourceFlags(desc.usages),
-    };
+    D3D12_RESOURCE_DESC resource_desc = ToDxResourceDesc(desc);
     D3D12MA::ALLOCATION_DESC allocation_desc {
         .HeapType = D3D12_HEAP_TYPE_DEFAULT,
     };
@@ -212,6 +290,25 @@ TextureD3D12::TextureD3D12(Ref<DeviceD3D12> device, ComPtr<ID3D12Resource> &&raw
     allocation_ = nullptr;
 }
 
+TextureD3D12::TextureD3D12(Ref<DeviceD3D12> device, const TextureDesc &desc, Ref<MemoryHeapD3D12> heap,
+    uint64_t offset) : device_(device) {
+    desc_ = desc;
+    D3D12_RESOURCE_DESC resource_desc = ToDxResourceDesc(desc);
+    device_->RawAllocator()->CreateAliasingResource(heap->RawAllocation(), offset, &resource_desc,
+        D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&resource_));
+
+    if (!desc.name.empty()) {
+        resource_->SetPrivateData(WKPDID_D3DDebugObjectName, desc.name.size(), desc.name.data());
+    }
+}
+
+ResourceMemoryRequirements TextureD3D12::GetMemoryRequirements(Ref<DeviceD3D12> device, const TextureDesc &desc) {
+    bool is_rt_ds = desc.usages.Contains(TextureUsage::eColorAttachment)
+        || desc.usages.Contains(TextureUsage::eDepthStencilAttachment);
+    return GetDxMemoryRequirements(device->Raw(), ToDxResourceDesc(desc),
+        is_rt_ds ? kRtDsTextureMemoryTypeBit : kNonRtDsTextureMemoryTypeBit);
+}
+
 TextureD3D12::~TextureD3D12() {
     if (allocation_) {
         allocation_->Release();
@@ -244,6 +341,7 @@ DXGI_FORMAT TextureD3D12::RawFormat() const {
 }
 
 DescriptorHandle TextureD3D12::GetView(const TextureViewD3D12Desc &view_desc) const {
+    std::lock_guard lock(views_mutex_);
     if (auto it = cached_views_.find(view_desc); it != cached_views_.end()) {
         return it->second;
     }
@@ -392,6 +490,7 @@ DescriptorHandle TextureD3D12::GetView(const TextureViewD3D12Desc &view_desc) co
 }
 
 DescriptorHandle TextureD3D12::GetView(const TextureRenderTargetViewD3D12Desc &view_desc) const {
+    std::lock_guard lock(views_mutex_);
     if (auto it = cached_render_target_views_.find(view_desc); it != cached_render_target_views_.end()) {
         return it->second;
     }
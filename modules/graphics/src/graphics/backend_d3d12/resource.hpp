@@ -1,5 +1,7 @@
 #pragma once
 
+#include <mutex>
+
 #include <D3D12MemAlloc.h>
 
 #include "core/container.hpp"
@@ -34,11 +36,27 @@ BISMUTH_NAMESPACE_BEGIN
 
 BISMUTH_GFX_NAMESPACE_BEGIN
 
+class MemoryHeapD3D12 final : public MemoryHeap {
+public:
+    MemoryHeapD3D12(Ref<class DeviceD3D12> device, const MemoryHeapDesc &desc);
+    ~MemoryHeapD3D12() override;
+
+    D3D12MA::Allocation *RawAllocation() const { return allocation_; }
+
+private:
+    Ref<DeviceD3D12> device_;
+    D3D12MA::Allocation *allocation_ = nullptr;
+};
+
 class BufferD3D12 final : public Buffer {
 public:
     BufferD3D12(Ref<class DeviceD3D12> device, const BufferDesc &desc);
+    // placed buffer
+    BufferD3D12(Ref<class DeviceD3D12> device, const BufferDesc &desc, Ref<MemoryHeapD3D12> heap, uint64_t offset);
     ~BufferD3D12() override;
 
+    static ResourceMemoryRequirements GetMemoryRequirements(Ref<DeviceD3D12> device, const BufferDesc &desc);
+
     void *Map() override;
 
     void Unmap() override;
@@ -60,6 +78,8 @@ private:
 
     void *mapped_ptr_ = nullptr;
 
+    // views may be requested by encoders recording on different threads
+    mutable std::mutex views_mutex_;
     mutable HashMap<BufferViewD3D12Desc, DescriptorHandle> cached_views_;
 };
 
@@ -111,8 +131,12 @@ public:
     TextureD3D12(Ref<class DeviceD3D12> device, const TextureDesc &desc);
     // external image
     TextureD3D12(Ref<class DeviceD3D12> device, ComPtr<ID3D12Resource> &&raw_resource, const TextureDesc &desc);
+    // placed texture
+    TextureD3D12(Ref<class DeviceD3D12> device, const TextureDesc &desc, Ref<MemoryHeapD3D12> heap, uint64_t offset);
     ~TextureD3D12() override;
 
+    static ResourceMemoryRequirements GetMemoryRequirements(Ref<DeviceD3D12> device, const TextureDesc &desc);
+
     void GetDepthAndLayer(uint32_t depth_or_layers, uint32_t &depth, uint32_t &layers, uint32_t another = 1) const;
     uint32_t Layers() const;
 
@@ -133,6 +157,7 @@ private:
     D3D12MA::Allocation *allocation_ = nullptr;
     bool state_restricted_ = false;
 
+    mutable std::mutex views_mutex_;
     mutable HashMap<TextureViewD3D12Desc, DescriptorHandle> cached_views_;
     mutable HashMap<TextureRenderTargetViewD3D12Desc, DescriptorHandle> cached_render_target_views_;
 };
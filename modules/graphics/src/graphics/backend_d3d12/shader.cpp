@@ -1,10 +1,11 @@
 #include "shader.hpp"
 
-#include <d3d12shader.h>
+#include <algorithm>
+
+#include <core/module_manager.hpp>
 
 #include "device.hpp"
 #include "dxc_helper.hpp"
-#include "graphics/pipeline.hpp"
 
 BISMUTH_NAMESPACE_BEGIN
 
@@ -12,158 +13,147 @@ BISMUTH_GFX_NAMESPACE_BEGIN
 
 namespace {
 
-ResourceFormat FromReflectInputFormat(D3D_REGISTER_COMPONENT_TYPE component_type, BYTE mask) {
-    int num_components = std::popcount(mask);
-    switch (component_type) {
-        case D3D_REGISTER_COMPONENT_UNKNOWN: return ResourceFormat::eUndefined;
-        case D3D_REGISTER_COMPONENT_UINT32: {
-            switch (num_components) {
-                case 1: return ResourceFormat::eR32UInt;
-                case 2: return ResourceFormat::eRg32UInt;
-                case 3: return ResourceFormat::eRgb32UInt;
-                case 4: return ResourceFormat::eRgba32UInt;
-                default: Unreachable();
-            }
-        }
-        case D3D_REGISTER_COMPONENT_SINT32: {
-            switch (num_components) {
-                case 1: return ResourceFormat::eR32SInt;
-                case 2: return ResourceFormat::eRg32SInt;
-                case 3: return ResourceFormat::eRgb32SInt;
-                case 4: return ResourceFormat::eRgba32SInt;
-                default: Unreachable();
-            }
-        }
-        case D3D_REGISTER_COMPONENT_FLOAT32: {
-            switch (num_components) {
-                case 1: return ResourceFormat::eR32SFloat;
-                case 2: return ResourceFormat::eRg32SFloat;
-                case 3: return ResourceFormat::eRgb32SFloat;
-                case 4: return ResourceFormat::eRgba32SFloat;
-                default: Unreachable();
-            }
-        }
-    }
-    Unreachable();
-}
-
-VertexSemantics FromReflectSemantics(LPCSTR semantic_name, UINT index) {
-    if (strcmp(semantic_name, "POSITION") == 0) {
-        return VertexSemantics::ePosition;
-    } else if (strcmp(semantic_name, "COLOR") == 0) {
-        return VertexSemantics::eColor;
-    } else if (strcmp(semantic_name, "NORMAL") == 0) {
-        return VertexSemantics::eNormal;
-    } else if (strcmp(semantic_name, "TANGENT") == 0) {
-        return VertexSemantics::eTangent;
-    } else if (strcmp(semantic_name, "BINORMAL") == 0) {
-        return VertexSemantics::eBitangent;
-    } else if (strcmp(semantic_name, "TEXCOORD") == 0) {
-        return static_cast<VertexSemantics>(static_cast<uint8_t>(VertexSemantics::eTexcoord0) + std::min(index, 7u));
+ShaderStage FromDxShaderVersion(UINT version) {
+    switch (static_cast<D3D12_SHADER_VERSION_TYPE>(D3D12_SHVER_GET_TYPE(version))) {
+        case D3D12_SHVER_VERTEX_SHADER: return ShaderStage::eVertex;
+        case D3D12_SHVER_HULL_SHADER: return ShaderStage::eTessellationControl;
+        case D3D12_SHVER_DOMAIN_SHADER: return ShaderStage::eTessellationEvaluation;
+        case D3D12_SHVER_GEOMETRY_SHADER: return ShaderStage::eGeometry;
+        case D3D12_SHVER_PIXEL_SHADER: return ShaderStage::eFragment;
+        case D3D12_SHVER_COMPUTE_SHADER: return ShaderStage::eCompute;
+        default: Unreachable();
     }
-    return VertexSemantics::eTexcoord7;
 }
 
-D3D12_DESCRIPTOR_RANGE_TYPE FromReflectBindType(D3D_SHADER_INPUT_TYPE type) {
+DescriptorType FromReflectBindType(D3D_SHADER_INPUT_TYPE type, D3D_SRV_DIMENSION dim) {
     switch (type) {
         case D3D_SIT_CBUFFER:
-            return D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
+            return DescriptorType::eUniformBuffer;
         case D3D_SIT_SAMPLER:
-            return D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER;
-        case D3D_SIT_TBUFFER:
+            return DescriptorType::eSampler;
         case D3D_SIT_TEXTURE:
+            // typed buffers are not supported
+            return dim == D3D_SRV_DIMENSION_BUFFER ? DescriptorType::eNone : DescriptorType::eSampledTexture;
         case D3D_SIT_STRUCTURED:
         case D3D_SIT_BYTEADDRESS:
-        case D3D_SIT_RTACCELERATIONSTRUCTURE:
-            return D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+            return DescriptorType::eStorageBuffer;
         case D3D_SIT_UAV_RWTYPED:
+            return dim == D3D_SRV_DIMENSION_BUFFER ? DescriptorType::eNone : DescriptorType::eRWStorageTexture;
         case D3D_SIT_UAV_RWSTRUCTURED:
         case D3D_SIT_UAV_RWBYTEADDRESS:
         case D3D_SIT_UAV_APPEND_STRUCTURED:
         case D3D_SIT_UAV_CONSUME_STRUCTURED:
         case D3D_SIT_UAV_RWSTRUCTURED_WITH_COUNTER:
-        case D3D_SIT_UAV_FEEDBACKTEXTURE:
-            return D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+            return DescriptorType::eRWStorageBuffer;
+        default:
+            return DescriptorType::eNone;
     }
-    Unreachable();
 }
 
+TextureViewDimension FromReflectDimension(D3D_SRV_DIMENSION dim) {
+    switch (dim) {
+        case D3D_SRV_DIMENSION_TEXTURE1D: return TextureViewDimension::e1D;
+        case D3D_SRV_DIMENSION_TEXTURE1DARRAY: return TextureViewDimension::e1DArray;
+        case D3D_SRV_DIMENSION_TEXTURE2D: return TextureViewDimension::e2D;
+        case D3D_SRV_DIMENSION_TEXTURE2DARRAY: return TextureViewDimension::e2DArray;
+        case D3D_SRV_DIMENSION_TEXTURE2DMS: return TextureViewDimension::e2D;
+        case D3D_SRV_DIMENSION_TEXTURE2DMSARRAY: return TextureViewDimension::e2DArray;
+        case D3D_SRV_DIMENSION_TEXTURE3D: return TextureViewDimension::e3D;
+        case D3D_SRV_DIMENSION_TEXTURECUBE: return TextureViewDimension::eCube;
+        case D3D_SRV_DIMENSION_TEXTURECUBEARRAY: return TextureViewDimension::eCubeArray;
+        default: Unreachable();
+    }
 }
 
-#define DXIL_FOURCC(ch0, ch1, ch2, ch3) (                            \
-    (uint32_t)(uint8_t)(ch0)        | (uint32_t)(uint8_t)(ch1) << 8  | \
-    (uint32_t)(uint8_t)(ch2) << 16  | (uint32_t)(uint8_t)(ch3) << 24   \
-)
-
-ShaderModuleD3D12::ShaderModuleD3D12(Ref<DeviceD3D12> device, const Vec<uint8_t> &src_bytes)
-    : device_(device), shader_bytes_(src_bytes) {
-    /*
-    ComPtr<IDxcBlobEncoding> shader_blob;
-    DxcHelper::Instance().Utils()->CreateBlob(src_bytes.data(), src_bytes.size(), DXC_CP_ACP, &shader_blob);
-
-    ComPtr<IDxcContainerReflection> container_reflection;
-    UINT32 shader_index;
-    DxcCreateInstance(CLSID_DxcContainerReflection, IID_PPV_ARGS(&container_reflection));
-    container_reflection->Load(shader_blob.Get());
-    container_reflection->FindFirstPartKind(DXIL_FOURCC('D', 'X', 'I', 'L'), &shader_index);
-    ComPtr<ID3D12ShaderReflection> reflection;
-    container_reflection->GetPartReflection(shader_index, IID_PPV_ARGS(&reflection));
+// size used by variables of constant buffer, without padding at the end
+uint32_t ConstantBufferSize(ID3D12ShaderReflection *dx_reflection, LPCSTR name) {
+    auto constant_buffer = dx_reflection->GetConstantBufferByName(name);
+    D3D12_SHADER_BUFFER_DESC buffer_desc;
+    constant_buffer->GetDesc(&buffer_desc);
+    uint32_t size = 0;
+    for (UINT i = 0; i < buffer_desc.Variables; i++) {
+        D3D12_SHADER_VARIABLE_DESC variable_desc;
+        constant_buffer->GetVariableByIndex(i)->GetDesc(&variable_desc);
+        size = std::max(size, variable_desc.StartOffset + variable_desc.Size);
+    }
+    return size;
+}
 
+}
+
+ShaderReflection ReflectDxil(ID3D12ShaderReflection *dx_reflection) {
     D3D12_SHADER_DESC shader_desc;
-    reflection->GetDesc(&shader_desc);
-
-    auto shader_stage = static_cast<D3D12_SHADER_VERSION_TYPE>((shader_desc.Version & 0xffff0000) >> 16);
-
-    if (shader_stage == D3D12_SHVER_VERTEX_SHADER) {
-        uint8_t max_location = 0;
-        Vec<VertexSemantics> semantics(shader_desc.InputParameters);
-        Vec<ResourceFormat> formats(shader_desc.InputParameters);
-        for (UINT i = 0; i < shader_desc.InputParameters; i++) {
-            D3D12_SIGNATURE_PARAMETER_DESC param_desc;
-            reflection->GetInputParameterDesc(i, &param_desc);
-            semantics[i] = FromReflectSemantics(param_desc.SemanticName, param_desc.SemanticIndex);
-            formats[i] = FromReflectInputFormat(param_desc.ComponentType, param_desc.Mask);
-            max_location = std::max(max_location, static_cast<uint8_t>(semantics[i]));
-        }
+    dx_reflection->GetDesc(&shader_desc);
 
-        info_.vertex_inputs.resize(max_location, ResourceFormat::eUndefined);
-        for (UINT i = 0; i < shader_desc.InputParameters; i++) {
-            info_.vertex_inputs[static_cast<size_t>(semantics[i])] = formats[i];
-        }
-    }
+    ShaderReflection reflection {
+        .stage = FromDxShaderVersion(shader_desc.Version),
+    };
 
-    if (shader_stage == D3D12_SHVER_COMPUTE_SHADER) {
-        reflection->GetThreadGroupSize(&info_.compute_local_size_x, &info_.compute_local_size_y,
-            &info_.compute_local_size_z);
+    if (reflection.stage == ShaderStage::eCompute) {
+        dx_reflection->GetThreadGroupSize(&reflection.thread_group_x, &reflection.thread_group_y,
+            &reflection.thread_group_z);
     }
 
-    Vec<D3D12_SHADER_INPUT_BIND_DESC> bindings(shader_desc.BoundResources);
-    info_.bindings.name_map.reserve(shader_desc.BoundResources);
-    uint32_t max_set = 0;
     for (UINT i = 0; i < shader_desc.BoundResources; i++) {
-        reflection->GetResourceBindingDesc(i, &bindings[i]);
-        max_set = std::max(max_set, bindings[i].Space);
-    }
-    info_.bindings.bindings.resize(max_set);
-    Vec<uint32_t> max_binding(max_set, 0);
-    for (auto binding : bindings) {
-        max_binding[binding.Space] = std::max(max_binding[binding.Space], binding.BindPoint);
+        D3D12_SHADER_INPUT_BIND_DESC binding;
+        dx_reflection->GetResourceBindingDesc(i, &binding);
+        const DescriptorType type = FromReflectBindType(binding.Type, binding.Dimension);
+        if (type == DescriptorType::eNone) {
+            continue;
+        }
+        // root constants are bound to b0 of space0 (see CreateSignature in pipeline.cpp)
+        if (type == DescriptorType::eUniformBuffer && binding.BindPoint == 0 && binding.Space == 0) {
+            reflection.push_constants_size = ConstantBufferSize(dx_reflection, binding.Name);
+            continue;
+        }
+
+        if (reflection.sets_layout.size() <= binding.Space) {
+            reflection.sets_layout.resize(binding.Space + 1);
+        }
+        auto &set_bindings = reflection.sets_layout[binding.Space].bindings;
+        if (set_bindings.size() <= binding.BindPoint) {
+            set_bindings.resize(binding.BindPoint + 1);
+        }
+        auto &rhi_binding = set_bindings[binding.BindPoint];
+        rhi_binding.type = type;
+        // unbounded arrays have no count and are only used by bindless set
+        rhi_binding.count = std::max(binding.BindCount, 1u);
+        if (IsDescriptorTypeTexture(type)) {
+            rhi_binding.tex_dim = FromReflectDimension(binding.Dimension);
+        } else if (type == DescriptorType::eUniformBuffer) {
+            rhi_binding.struct_stride = ConstantBufferSize(dx_reflection, binding.Name);
+        } else if (binding.Type == D3D_SIT_BYTEADDRESS || binding.Type == D3D_SIT_UAV_RWBYTEADDRESS) {
+            rhi_binding.struct_stride = 4;
+        } else {
+            // stride of structured buffer is reported as number of samples
+            rhi_binding.struct_stride = binding.NumSamples;
+        }
     }
-    for (uint32_t set = 0; set < max_set; set++) {
-        info_.bindings.bindings[set].resize(max_binding[set], D3D12_DESCRIPTOR_RANGE1 { .NumDescriptors = 0 });
+
+    return reflection;
+}
+
+ShaderModuleD3D12::ShaderModuleD3D12(Ref<DeviceD3D12> device, Span<uint8_t> src_bytes,
+    const ShaderReflection *reflection)
+    : device_(device), shader_bytes_(src_bytes.begin(), src_bytes.end()) {
+    content_hash_ = HashBytes(src_bytes.Data(), src_bytes.Size());
+    if (reflection) {
+        reflection_ = *reflection;
+        return;
     }
-    for (auto binding : bindings) {
-        info_.bindings.bindings[binding.Space][binding.BindPoint] = D3D12_DESCRIPTOR_RANGE1 {
-            .RangeType = FromReflectBindType(binding.Type),
-            .NumDescriptors = binding.BindCount,
-            .BaseShaderRegister = binding.BindPoint,
-            .RegisterSpace = binding.Space,
-            .Flags = D3D12_DESCRIPTOR_RANGE_FLAG_NONE,
-            .OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND,
-        };
-        info_.bindings.name_map[binding.Name] = { binding.Space, binding.BindPoint };
+
+    const DxcBuffer shader_buffer {
+        .Ptr = shader_bytes_.data(),
+        .Size = shader_bytes_.size(),
+        .Encoding = DXC_CP_ACP,
+    };
+    ComPtr<ID3D12ShaderReflection> dx_reflection;
+    if (FAILED(DxcHelper::Instance().Utils()->CreateReflection(&shader_buffer, IID_PPV_ARGS(&dx_reflection)))) {
+        BI_WARN(ModuleManager::Get<GraphicsModule>()->Lgr(),
+            "Failed to reflect shader module, reflection may be stripped from the binary");
+        return;
     }
-    */
+    reflection_ = ReflectDxil(dx_reflection.Get());
 }
 
 ShaderModuleD3D12::~ShaderModuleD3D12() {}
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <d3d12shader.h>
+
 #include "core/container.hpp"
 #include "core/ptr.hpp"
+#include "core/span.hpp"
 #include "utils.hpp"
 #include "graphics/shader.hpp"
 
@@ -9,16 +12,23 @@ BISMUTH_NAMESPACE_BEGIN
 
 BISMUTH_GFX_NAMESPACE_BEGIN
 
+// entry point of the result is empty since dxil reflection doesn't record it
+ShaderReflection ReflectDxil(ID3D12ShaderReflection *dx_reflection);
+
 class ShaderModuleD3D12 final : public ShaderModule {
 public:
-    ShaderModuleD3D12(Ref<class DeviceD3D12> device, const Vec<uint8_t> &src_bytes);
+    // 'src_bytes' is reflected if 'reflection' is null, reflection is empty if it's stripped from the binary
+    ShaderModuleD3D12(Ref<class DeviceD3D12> device, Span<uint8_t> src_bytes, const ShaderReflection *reflection);
     ~ShaderModuleD3D12() override;
 
+    const ShaderReflection &Reflection() const override { return reflection_; }
+
     D3D12_SHADER_BYTECODE RawBytecode() const;
 
 private:
     Ref<DeviceD3D12> device_;
     Vec<uint8_t> shader_bytes_;
+    ShaderReflection reflection_;
 };
 
 BISMUTH_GFX_NAMESPACE_END
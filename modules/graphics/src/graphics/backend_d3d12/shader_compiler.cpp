@@ -1,8 +1,11 @@
 #include "shader_compiler.hpp"
 
+#include <algorithm>
+
 #include <core/module_manager.hpp>
 
 #include "dxc_helper.hpp"
+#include "shader.hpp"
 
 BISMUTH_NAMESPACE_BEGIN
 
@@ -22,22 +25,82 @@ const wchar_t *ToDxShaderStage(ShaderStage stage) {
     Unreachable();
 }
 
+// dxc has no recipe optimizing for size
+const wchar_t *ToDxOptimizationLevel(ShaderOptimizationLevel level) {
+    switch (level) {
+        case ShaderOptimizationLevel::eNone: return L"-Od";
+        case ShaderOptimizationLevel::eSize: return L"-O3";
+        case ShaderOptimizationLevel::ePerformance: return L"-O3";
+    }
+    Unreachable();
 }
 
-ShaderCompilerD3D12::ShaderCompilerD3D12() {
-    DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&compiler_));
+// forwards to the default include handler and records included files
+class RecordingIncludeHandler : public IDxcIncludeHandler {
+public:
+    RecordingIncludeHandler(IDxcIncludeHandler *handler, Vec<fs::path> *dependencies)
+        : handler_(handler), dependencies_(dependencies) {}
+
+    HRESULT STDMETHODCALLTYPE LoadSource(LPCWSTR filename, IDxcBlob **include_source) override {
+        HRESULT result = handler_->LoadSource(filename, include_source);
+        if (SUCCEEDED(result) && dependencies_) {
+            fs::path path(filename);
+            if (std::find(dependencies_->begin(), dependencies_->end(), path) == dependencies_->end()) {
+                dependencies_->push_back(path);
+            }
+        }
+        return result;
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **object) override {
+        if (riid == __uuidof(IUnknown) || riid == __uuidof(IDxcIncludeHandler)) {
+            *object = this;
+            return S_OK;
+        }
+        *object = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    // lives on stack during compiling
+    ULONG STDMETHODCALLTYPE AddRef() override { return 1; }
+    ULONG STDMETHODCALLTYPE Release() override { return 1; }
+
+private:
+    IDxcIncludeHandler *handler_;
+    Vec<fs::path> *dependencies_;
+};
 
-    DxcHelper::Instance().Utils()->CreateDefaultIncludeHandler(&include_handler_);
+}
+
+ShaderCompilerD3D12::ShaderCompilerD3D12() {
+    ComPtr<IDxcCompiler3> compiler;
+    DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&compiler));
+
+    UINT32 major = 0;
+    UINT32 minor = 0;
+    ComPtr<IDxcVersionInfo> version_info;
+    if (SUCCEEDED(compiler.As(&version_info))) {
+        version_info->GetVersion(&major, &minor);
+    }
+    version_ = "dxc-" + std::to_string(major) + "." + std::to_string(minor) + "-sm6_5";
+#ifndef BI_DEBUG_MODE
+    version_ += "-strip";
+#endif
 }
 
 ShaderCompilerD3D12::~ShaderCompilerD3D12() {}
 
 Vec<uint8_t> ShaderCompilerD3D12::Compile(const fs::path &src_path, const std::string &entry, ShaderStage stage,
-    const HashMap<std::string, std::string> &defines, const Vec<fs::path> &include_dirs) const {
+    const HashMap<std::string, std::string> &defines, const Vec<fs::path> &include_dirs,
+    const ShaderCompileOptions &options, ShaderCompileInfo *info) const {
     std::string src_filename = src_path.string();
     if (!fs::exists(src_path)) {
         BI_CRTICAL(ModuleManager::Get<GraphicsModule>()->Lgr(), "Shader file '{}' doesn't exist", src_filename);
     }
+    Vec<fs::path> *dependencies = info ? &info->dependencies : nullptr;
+    if (dependencies) {
+        dependencies->push_back(src_path);
+    }
 
     std::wstring src_filename_w = CharsToWString(src_filename.c_str());
     std::wstring entry_w = CharsToWString(entry.c_str());
@@ -63,6 +126,7 @@ Vec<uint8_t> ShaderCompilerD3D12::Compile(const fs::path &src_path, const std::s
         src_filename_w.c_str(),
         L"-E", entry_w.c_str(),
         L"-T", ToDxShaderStage(stage),
+        ToDxOptimizationLevel(options.optimization),
 #ifndef BI_DEBUG_MODE
         L"-Qstrip_debug",
         L"-Qstrip_reflect",
@@ -86,8 +150,16 @@ Vec<uint8_t> ShaderCompilerD3D12::Compile(const fs::path &src_path, const std::s
         .Encoding = DXC_CP_ACP,
     };
 
+    // dxc objects are not thread-safe, they are created for each compiling so that Compile can be called from
+    // multiple threads
+    ComPtr<IDxcCompiler3> compiler;
+    DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&compiler));
+    ComPtr<IDxcIncludeHandler> default_include_handler;
+    DxcHelper::Instance().Utils()->CreateDefaultIncludeHandler(&default_include_handler);
+    RecordingIncludeHandler include_handler(default_include_handler.Get(), dependencies);
+
     ComPtr<IDxcResult> result;
-    compiler_->Compile(&shader_source_buf, args.data(), args.size(), include_handler_.Get(), IID_PPV_ARGS(&result));
+    compiler->Compile(&shader_source_buf, args.data(), args.size(), &include_handler, IID_PPV_ARGS(&result));
 
     ComPtr<IDxcBlobUtf8> errors;
     result->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&errors), nullptr);
@@ -104,6 +176,22 @@ Vec<uint8_t> ShaderCompilerD3D12::Compile(const fs::path &src_path, const std::s
 
     Vec<uint8_t> dxil_binary_bytes(dxil_binary->GetBufferSize());
     memcpy(dxil_binary_bytes.data(), dxil_binary->GetBufferPointer(), dxil_binary->GetBufferSize());
+
+    if (info) {
+        // reflection is still output separately when it's stripped from the binary
+        ComPtr<IDxcBlob> reflection_blob;
+        result->GetOutput(DXC_OUT_REFLECTION, IID_PPV_ARGS(&reflection_blob), nullptr);
+        const DxcBuffer reflection_buffer {
+            .Ptr = reflection_blob->GetBufferPointer(),
+            .Size = reflection_blob->GetBufferSize(),
+            .Encoding = DXC_CP_ACP,
+        };
+        ComPtr<ID3D12ShaderReflection> dx_reflection;
+        DxcHelper::Instance().Utils()->CreateReflection(&reflection_buffer, IID_PPV_ARGS(&dx_reflection));
+        info->reflection = ReflectDxil(dx_reflection.Get());
+        info->reflection.entry_point = entry;
+    }
+
     return dxil_binary_bytes;
 }
 
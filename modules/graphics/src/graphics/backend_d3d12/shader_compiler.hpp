@@ -15,13 +15,15 @@ public:
     ~ShaderCompilerD3D12() override;
 
     Vec<uint8_t> Compile(const fs::path &src_path, const std::string &entry, ShaderStage stage,
-        const HashMap<std::string, std::string> &defines = {}, const Vec<fs::path> &include_dirs = {}) const override;
+        const HashMap<std::string, std::string> &defines = {}, const Vec<fs::path> &include_dirs = {},
+        const ShaderCompileOptions &options = {}, ShaderCompileInfo *info = nullptr) const override;
 
     const char *BinarySuffix() const override { return ".dxil"; }
 
+    const std::string &Version() const override { return version_; }
+
 private:
-    ComPtr<IDxcCompiler3> compiler_;
-    ComPtr<IDxcIncludeHandler> include_handler_;
+    std::string version_;
 };
 
 BISMUTH_GFX_NAMESPACE_END
@@ -35,6 +35,24 @@ bool FenceD3D12::IsFinished() {
     return fence_->GetCompletedValue() >= fence_value_;
 }
 
+SemaphoreD3D12::SemaphoreD3D12(Ref<DeviceD3D12> device) : device_(device) {
+    fence_value_ = 0;
+    device_->Raw()->CreateFence(fence_value_, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence_));
+}
+
+SemaphoreD3D12::~SemaphoreD3D12() {}
+
+void SemaphoreD3D12::SignalOn(const Queue *queue) {
+    auto queue_dx = static_cast<const QueueD3D12 *>(queue);
+    ++fence_value_;
+    queue_dx->Raw()->Signal(fence_.Get(), fence_value_);
+}
+
+void SemaphoreD3D12::WaitOn(const Queue *queue) const {
+    auto queue_dx = static_cast<const QueueD3D12 *>(queue);
+    queue_dx->Raw()->Wait(fence_.Get(), fence_value_);
+}
+
 BISMUTH_GFX_NAMESPACE_END
 
 BISMUTH_NAMESPACE_END
@@ -29,7 +29,23 @@ private:
     UINT64 fence_value_;
 };
 
-class SemaphoreD3D12 final : public Semaphore {};
+// implemented by a fence, waiting on it waits for the value of last signal
+class SemaphoreD3D12 final : public Semaphore {
+public:
+    SemaphoreD3D12(Ref<class DeviceD3D12> device);
+    ~SemaphoreD3D12() override;
+
+    void SignalOn(const Queue *queue);
+
+    void WaitOn(const Queue *queue) const;
+
+    ID3D12Fence *Raw() const { return fence_.Get(); }
+
+private:
+    Ref<DeviceD3D12> device_;
+    ComPtr<ID3D12Fence> fence_;
+    UINT64 fence_value_;
+};
 
 BISMUTH_GFX_NAMESPACE_END
 
@@ -7,6 +7,8 @@
 #include "resource.hpp"
 #include "pipeline.hpp"
 #include "context.hpp"
+#include "queue.hpp"
+#include "query.hpp"
 
 BISMUTH_NAMESPACE_BEGIN
 
@@ -23,6 +25,34 @@ VkDebugUtilsLabelEXT ToVkDebugLabel(const CommandLabel &label) {
     };
 }
 
+// a queue family ownership transfer is recorded on both queues (release and acquire),
+// but when both queues are of the same family, the barrier is recorded only once on the destination queue
+bool SkipCrossQueueBarrier(const Queue *src_queue, const Queue *dst_queue, QueueType encoder_queue_type) {
+    if (src_queue == nullptr || dst_queue == nullptr || src_queue->Type() == dst_queue->Type()) {
+        return false;
+    }
+    return static_cast<const QueueVulkan *>(src_queue)->RawFamilyIndex()
+        == static_cast<const QueueVulkan *>(dst_queue)->RawFamilyIndex()
+        && encoder_queue_type != dst_queue->Type();
+}
+
+// the other side of a cross queue barrier is synchronized by semaphore,
+// and its masks may contain stages that are not supported by this queue
+template <typename BarrierVk>
+void MaskCrossQueueBarrier(const Queue *src_queue, const Queue *dst_queue, QueueType encoder_queue_type,
+    BarrierVk &barrier_vk) {
+    if (src_queue == nullptr || dst_queue == nullptr || src_queue->Type() == dst_queue->Type()) {
+        return;
+    }
+    if (encoder_queue_type == src_queue->Type()) {
+        barrier_vk.dstAccessMask = 0;
+        barrier_vk.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    } else {
+        barrier_vk.srcAccessMask = 0;
+        barrier_vk.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    }
+}
+
 Vec<VkBufferCopy> ToVkBufferCopy(Ref<BufferVulkan> src_buffer_vk, Ref<BufferVulkan> dst_buffer_vk,
     Span<BufferCopyDesc> regions) {
     Vec<VkBufferCopy> regions_vk(regions.size());
@@ -245,13 +275,116 @@ void ToVkImageAccessType(BitFlags<ResourceAccessType> type, bool is_depth_stenci
     }
 }
 
+void ToVkBarriers(Span<BufferBarrier> buffer_barriers, Span<TextureBarrier> texture_barriers,
+    QueueType encoder_queue_type, Vec<VkBufferMemoryBarrier2> &buffer_barriers_vk,
+    Vec<VkImageMemoryBarrier2> &texture_barriers_vk) {
+    buffer_barriers_vk.clear();
+    buffer_barriers_vk.reserve(buffer_barriers.Size());
+    for (const auto &barrier : buffer_barriers) {
+        if (SkipCrossQueueBarrier(barrier.src_queue, barrier.dst_queue, encoder_queue_type)) {
+            continue;
+        }
+        auto &barrier_vk = buffer_barriers_vk.emplace_back(VkBufferMemoryBarrier2 {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .pNext = nullptr,
+            .srcQueueFamilyIndex = barrier.src_queue ? static_cast<QueueVulkan *>(barrier.src_queue)->RawFamilyIndex()
+                : VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = barrier.dst_queue ? static_cast<QueueVulkan *>(barrier.dst_queue)->RawFamilyIndex()
+                : VK_QUEUE_FAMILY_IGNORED,
+            .buffer = barrier.buffer.CastTo<BufferVulkan>()->Raw(),
+            .offset = 0,
+            .size = VK_WHOLE_SIZE,
+        });
+        ToVkBufferAccessType(barrier.src_access_type, barrier_vk.srcAccessMask, barrier_vk.srcStageMask);
+        ToVkBufferAccessType(barrier.dst_access_type, barrier_vk.dstAccessMask, barrier_vk.dstStageMask);
+        if (barrier.discard) {
+            // wait for any access of other resources aliasing the same memory
+            barrier_vk.srcAccessMask |= VK_ACCESS_2_MEMORY_WRITE_BIT;
+            barrier_vk.srcStageMask |= VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        }
+        MaskCrossQueueBarrier(barrier.src_queue, barrier.dst_queue, encoder_queue_type, barrier_vk);
+    }
+    texture_barriers_vk.clear();
+    texture_barriers_vk.reserve(texture_barriers.Size());
+    for (const auto &barrier : texture_barriers) {
+        if (SkipCrossQueueBarrier(barrier.src_queue, barrier.dst_queue, encoder_queue_type)) {
+            continue;
+        }
+        const auto texture_vk = barrier.texture.texture.CastTo<TextureVulkan>();
+        auto &barrier_vk = texture_barriers_vk.emplace_back(VkImageMemoryBarrier2 {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .pNext = nullptr,
+            .srcQueueFamilyIndex = barrier.src_queue ? static_cast<QueueVulkan *>(barrier.src_queue)->RawFamilyIndex()
+                : VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = barrier.dst_queue ? static_cast<QueueVulkan *>(barrier.dst_queue)->RawFamilyIndex()
+                : VK_QUEUE_FAMILY_IGNORED,
+            .image = texture_vk->Raw(),
+            .subresourceRange = VkImageSubresourceRange {
+                .aspectMask = texture_vk->GetAspect(),
+                .baseMipLevel = barrier.texture.base_level,
+                .levelCount = barrier.texture.levels,
+                .baseArrayLayer = barrier.texture.base_layer,
+                .layerCount = barrier.texture.layers,
+            },
+        });
+        bool is_depth_stencil = IsDepthStencilFormat(texture_vk->Desc().format);
+        ToVkImageAccessType(barrier.src_access_type, is_depth_stencil, barrier_vk.srcAccessMask,
+            barrier_vk.srcStageMask, barrier_vk.oldLayout);
+        ToVkImageAccessType(barrier.dst_access_type, is_depth_stencil, barrier_vk.dstAccessMask,
+            barrier_vk.dstStageMask, barrier_vk.newLayout);
+        if (barrier.discard) {
+            barrier_vk.srcAccessMask |= VK_ACCESS_2_MEMORY_WRITE_BIT;
+            barrier_vk.srcStageMask |= VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+            barrier_vk.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        }
+        MaskCrossQueueBarrier(barrier.src_queue, barrier.dst_queue, encoder_queue_type, barrier_vk);
+    }
+}
+
 }
 
 CommandBufferVulkan::CommandBufferVulkan(Ref<DeviceVulkan> device, VkCommandBuffer cmd_buffer)
     : device_(device), cmd_buffer_(cmd_buffer) {}
 
+SplitBarrierVulkan::SplitBarrierVulkan(Ref<DeviceVulkan> device) : device_(device) {
+    VkEventCreateInfo event_ci {
+        .sType = VK_STRUCTURE_TYPE_EVENT_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = VK_EVENT_CREATE_DEVICE_ONLY_BIT,
+    };
+    vkCreateEvent(device_->Raw(), &event_ci, nullptr, &event_);
+}
+
+SplitBarrierVulkan::~SplitBarrierVulkan() {
+    vkDestroyEvent(device_->Raw(), event_, nullptr);
+}
+
+void SplitBarrierVulkan::SetBarriers(Span<BufferBarrier> buffer_barriers, Span<TextureBarrier> texture_barriers) {
+    // split barriers are never used for queue ownership transfer
+    ToVkBarriers(buffer_barriers, texture_barriers, QueueType::eGraphics, buffer_barriers_vk_, texture_barriers_vk_);
+    dep_info_ = VkDependencyInfo {
+        .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .pNext = nullptr,
+        .dependencyFlags = 0,
+        .memoryBarrierCount = 0,
+        .pMemoryBarriers = nullptr,
+        .bufferMemoryBarrierCount = static_cast<uint32_t>(buffer_barriers_vk_.size()),
+        .pBufferMemoryBarriers = buffer_barriers_vk_.data(),
+        .imageMemoryBarrierCount = static_cast<uint32_t>(texture_barriers_vk_.size()),
+        .pImageMemoryBarriers = texture_barriers_vk_.data(),
+    };
+    dst_stage_mask_ = 0;
+    for (const auto &barrier_vk : buffer_barriers_vk_) {
+        dst_stage_mask_ |= barrier_vk.dstStageMask;
+    }
+    for (const auto &barrier_vk : texture_barriers_vk_) {
+        dst_stage_mask_ |= barrier_vk.dstStageMask;
+    }
+}
+
 CommandEncoderVulkan::CommandEncoderVulkan(Ref<DeviceVulkan> device, Ref<FrameContextVulkan> context,
-    VkCommandBuffer cmd_buffer) : device_(device), context_(context), cmd_buffer_(cmd_buffer) {}
+    VkCommandBuffer cmd_buffer, QueueType queue_type)
+    : device_(device), context_(context), cmd_buffer_(cmd_buffer), queue_type_(queue_type) {}
 
 CommandEncoderVulkan::~CommandEncoderVulkan() {
     BI_ASSERT(cmd_buffer_ == VK_NULL_HANDLE);
@@ -309,51 +442,7 @@ void CommandEncoderVulkan::CopyTextureToBuffer(Ref<Texture> src_texture, Ref<Buf
 }
 
 void CommandEncoderVulkan::ResourceBarrier(Span<BufferBarrier> buffer_barriers, Span<TextureBarrier> texture_barriers) {
-    Vec<VkBufferMemoryBarrier2> buffer_barriers_vk(buffer_barriers.Size());
-    for (size_t i = 0; i < buffer_barriers.Size(); i++) {
-        const auto &barrier = buffer_barriers[i];
-        buffer_barriers_vk[i] = VkBufferMemoryBarrier2 {
-            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
-            .pNext = nullptr,
-            .srcQueueFamilyIndex = barrier.src_queue ? static_cast<QueueVulkan *>(barrier.src_queue)->RawFamilyIndex()
-                : VK_QUEUE_FAMILY_IGNORED,
-            .dstQueueFamilyIndex = barrier.dst_queue ? static_cast<QueueVulkan *>(barrier.dst_queue)->RawFamilyIndex()
-                : VK_QUEUE_FAMILY_IGNORED,
-            .buffer = barrier.buffer.CastTo<BufferVulkan>()->Raw(),
-            .offset = 0,
-            .size = VK_WHOLE_SIZE,
-        };
-        ToVkBufferAccessType(barrier.src_access_type,
-            buffer_barriers_vk[i].srcAccessMask, buffer_barriers_vk[i].srcStageMask);
-        ToVkBufferAccessType(barrier.dst_access_type,
-            buffer_barriers_vk[i].dstAccessMask, buffer_barriers_vk[i].dstStageMask);
-    }
-    Vec<VkImageMemoryBarrier2> texture_barriers_vk(texture_barriers.Size());
-    for (size_t i = 0; i < texture_barriers.Size(); i++) {
-        const auto &barrier = texture_barriers[i];
-        const auto texture_vk = barrier.texture.texture.CastTo<TextureVulkan>();
-        texture_barriers_vk[i] = VkImageMemoryBarrier2 {
-            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-            .pNext = nullptr,
-            .srcQueueFamilyIndex = barrier.src_queue ? static_cast<QueueVulkan *>(barrier.src_queue)->RawFamilyIndex()
-                : VK_QUEUE_FAMILY_IGNORED,
-            .dstQueueFamilyIndex = barrier.dst_queue ? static_cast<QueueVulkan *>(barrier.dst_queue)->RawFamilyIndex()
-                : VK_QUEUE_FAMILY_IGNORED,
-            .image = texture_vk->Raw(),
-            .subresourceRange = VkImageSubresourceRange {
-                .aspectMask = texture_vk->GetAspect(),
-                .baseMipLevel = barrier.texture.base_level,
-                .levelCount = barrier.texture.levels,
-                .baseArrayLayer = barrier.texture.base_layer,
-                .layerCount = barrier.texture.layers,
-            },
-        };
-        bool is_depth_stencil = IsDepthStencilFormat(texture_vk->Desc().format);
-        ToVkImageAccessType(barrier.src_access_type, is_depth_stencil, texture_barriers_vk[i].srcAccessMask,
-            texture_barriers_vk[i].srcStageMask, texture_barriers_vk[i].oldLayout);
-        ToVkImageAccessType(barrier.dst_access_type, is_depth_stencil, texture_barriers_vk[i].dstAccessMask,
-            texture_barriers_vk[i].dstStageMask, texture_barriers_vk[i].newLayout);
-    }
+    ToVkBarriers(buffer_barriers, texture_barriers, queue_type_, buffer_barriers_vk_, texture_barriers_vk_);
 
     VkDependencyInfo dep_info {
         .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
@@ -361,10 +450,10 @@ void CommandEncoderVulkan::ResourceBarrier(Span<BufferBarrier> buffer_barriers,
         .dependencyFlags = 0,
         .memoryBarrierCount = 0,
         .pMemoryBarriers = nullptr,
-        .bufferMemoryBarrierCount = static_cast<uint32_t>(buffer_barriers_vk.size()),
-        .pBufferMemoryBarriers = buffer_barriers_vk.data(),
-        .imageMemoryBarrierCount = static_cast<uint32_t>(texture_barriers_vk.size()),
-        .pImageMemoryBarriers = texture_barriers_vk.data(),
+        .bufferMemoryBarrierCount = static_cast<uint32_t>(buffer_barriers_vk_.size()),
+        .pBufferMemoryBarriers = buffer_barriers_vk_.data(),
+        .imageMemoryBarrierCount = static_cast<uint32_t>(texture_barriers_vk_.size()),
+        .pImageMemoryBarriers = texture_barriers_vk_.data(),
     };
 #if BISMUTH_VULKAN_VERSION_MINOR < 3
     vkCmdPipelineBarrier2KHR(cmd_buffer_, &dep_info);
@@ -373,6 +462,65 @@ void CommandEncoderVulkan::ResourceBarrier(Span<BufferBarrier> buffer_barriers,
 #endif
 }
 
+void CommandEncoderVulkan::BeginSplitBarrier(Span<Ref<SplitBarrier>> barriers) {
+    for (const auto &barrier : barriers) {
+        const auto barrier_vk = barrier.CastTo<SplitBarrierVulkan>();
+#if BISMUTH_VULKAN_VERSION_MINOR < 3
+        vkCmdSetEvent2KHR(cmd_buffer_, barrier_vk->RawEvent(), &barrier_vk->RawDependencyInfo());
+#else
+        vkCmdSetEvent2(cmd_buffer_, barrier_vk->RawEvent(), &barrier_vk->RawDependencyInfo());
+#endif
+    }
+}
+
+void CommandEncoderVulkan::EndSplitBarrier(Span<Ref<SplitBarrier>> barriers) {
+    if (barriers.Size() == 0) {
+        return;
+    }
+    events_.resize(barriers.Size());
+    dep_infos_.resize(barriers.Size());
+    for (size_t i = 0; i < barriers.Size(); i++) {
+        const auto barrier_vk = barriers[i].CastTo<SplitBarrierVulkan>();
+        events_[i] = barrier_vk->RawEvent();
+        dep_infos_[i] = barrier_vk->RawDependencyInfo();
+    }
+#if BISMUTH_VULKAN_VERSION_MINOR < 3
+    vkCmdWaitEvents2KHR(cmd_buffer_, static_cast<uint32_t>(events_.size()), events_.data(), dep_infos_.data());
+#else
+    vkCmdWaitEvents2(cmd_buffer_, static_cast<uint32_t>(events_.size()), events_.data(), dep_infos_.data());
+#endif
+    // events are reset on device after the wait so that they can be set again in later frames
+    for (const auto &barrier : barriers) {
+        const auto barrier_vk = barrier.CastTo<SplitBarrierVulkan>();
+        auto stage_mask = barrier_vk->RawDstStageMask();
+#if BISMUTH_VULKAN_VERSION_MINOR < 3
+        vkCmdResetEvent2KHR(cmd_buffer_, barrier_vk->RawEvent(),
+            stage_mask != 0 ? stage_mask : VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+#else
+        vkCmdResetEvent2(cmd_buffer_, barrier_vk->RawEvent(),
+            stage_mask != 0 ? stage_mask : VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+#endif
+    }
+}
+
+void CommandEncoderVulkan::ResetQueries(Ref<QuerySet> query_set, uint32_t first_query, uint32_t num_queries) {
+    vkCmdResetQueryPool(cmd_buffer_, query_set.CastTo<QuerySetVulkan>()->Raw(), first_query, num_queries);
+}
+
+void CommandEncoderVulkan::WriteTimestamp(Ref<QuerySet> query_set, uint32_t query) {
+#if BISMUTH_VULKAN_VERSION_MINOR < 3
+    vkCmdWriteTimestamp2KHR(cmd_buffer_, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        query_set.CastTo<QuerySetVulkan>()->Raw(), query);
+#else
+    vkCmdWriteTimestamp2(cmd_buffer_, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        query_set.CastTo<QuerySetVulkan>()->Raw(), query);
+#endif
+}
+
+void CommandEncoderVulkan::ResolveQueries(Ref<QuerySet> query_set, uint32_t first_query, uint32_t num_queries) {
+    // results are read from query pool directly
+}
+
 Ptr<RenderCommandEncoder> CommandEncoderVulkan::BeginRenderPass(const CommandLabel &label,
     const RenderTargetDesc &desc) {
     if (!label.label.empty()) {
@@ -527,15 +675,29 @@ void RenderCommandEncoderVulkan::PopLabel() {
 
 void RenderCommandEncoderVulkan::SetPipeline(Ref<RenderPipeline> pipeline) {
     curr_pipeline_ = pipeline.CastTo<RenderPipelineVulkan>().Get();
-    curr_pipeline_->SetTargetFormats(color_formats_, depth_stencil_format_);
-    vkCmdBindPipeline(cmd_buffer_, VK_PIPELINE_BIND_POINT_GRAPHICS, curr_pipeline_->RawPipeline());
+    vkCmdBindPipeline(cmd_buffer_, VK_PIPELINE_BIND_POINT_GRAPHICS,
+        curr_pipeline_->RawPipeline(color_formats_, depth_stencil_format_));
+
+    if (const uint32_t bindless_set = curr_pipeline_->Desc().layout.bindless_set; bindless_set != kNoBindlessSet) {
+        VkDescriptorSet descriptor_set = device_->BindlessSet()->Raw();
+        vkCmdBindDescriptorSets(cmd_buffer_, VK_PIPELINE_BIND_POINT_GRAPHICS, curr_pipeline_->RawPipelineLayout(),
+            bindless_set, 1, &descriptor_set, 0, nullptr);
+    }
 }
 
 void RenderCommandEncoderVulkan::BindShaderParams(uint32_t set_index, const ShaderParams &values) {
     BI_ASSERT_MSG(curr_pipeline_, "Call RenderCommandEncoder::BindShaderParams() without setting pipeline");
 
+    const auto &set_layout = curr_pipeline_->Desc().layout.sets_layout[set_index];
+    if (set_index == curr_pipeline_->PushDescriptorSet()) {
+        base_encoder_->context_->PushDescriptorSet(cmd_buffer_, VK_PIPELINE_BIND_POINT_GRAPHICS,
+            curr_pipeline_->RawPipelineLayout(), set_index, set_layout, values,
+            *curr_pipeline_->UpdateTemplate(set_index));
+        return;
+    }
+
     VkDescriptorSet descriptor_set = base_encoder_->context_->GetDescriptorSet(curr_pipeline_->RawSetLayout(set_index),
-        curr_pipeline_->Desc().layout.sets_layout[set_index], values);
+        set_layout, values, curr_pipeline_->UpdateTemplate(set_index));
 
     vkCmdBindDescriptorSets(cmd_buffer_, VK_PIPELINE_BIND_POINT_GRAPHICS, curr_pipeline_->RawPipelineLayout(),
         set_index, 1, &descriptor_set, 0, nullptr);
@@ -640,16 +802,30 @@ void ComputeCommandEncoderVulkan::PopLabel() {
 void ComputeCommandEncoderVulkan::SetPipeline(Ref<ComputePipeline> pipeline) {
     curr_pipeline_ = pipeline.CastTo<ComputePipelineVulkan>().Get();
     vkCmdBindPipeline(cmd_buffer_, VK_PIPELINE_BIND_POINT_COMPUTE, curr_pipeline_->RawPipeline());
+
+    if (const uint32_t bindless_set = curr_pipeline_->Desc().layout.bindless_set; bindless_set != kNoBindlessSet) {
+        VkDescriptorSet descriptor_set = device_->BindlessSet()->Raw();
+        vkCmdBindDescriptorSets(cmd_buffer_, VK_PIPELINE_BIND_POINT_COMPUTE, curr_pipeline_->RawPipelineLayout(),
+            bindless_set, 1, &descriptor_set, 0, nullptr);
+    }
 }
 
 void ComputeCommandEncoderVulkan::BindShaderParams(uint32_t set_index, const ShaderParams &values) {
     BI_ASSERT_MSG(curr_pipeline_, "Call ComputeCommandEncoder::BindShaderParams() without setting pipeline");
 
+    const auto &set_layout = curr_pipeline_->Desc().layout.sets_layout[set_index];
+    if (set_index == curr_pipeline_->PushDescriptorSet()) {
+        base_encoder_->context_->PushDescriptorSet(cmd_buffer_, VK_PIPELINE_BIND_POINT_COMPUTE,
+            curr_pipeline_->RawPipelineLayout(), set_index, set_layout, values,
+            *curr_pipeline_->UpdateTemplate(set_index));
+        return;
+    }
+
     VkDescriptorSet descriptor_set = base_encoder_->context_->GetDescriptorSet(curr_pipeline_->RawSetLayout(set_index),
-        curr_pipeline_->Desc().layout.sets_layout[set_index], values);
+        set_layout, values, curr_pipeline_->UpdateTemplate(set_index));
 
-    vkCmdBindDescriptorSets(cmd_buffer_, VK_PIPELINE_BIND_POINT_COMPUTE, curr_pipeline_->RawPipelineLayout(), 0,
-        1, &descriptor_set, 0, nullptr);
+    vkCmdBindDescriptorSets(cmd_buffer_, VK_PIPELINE_BIND_POINT_COMPUTE, curr_pipeline_->RawPipelineLayout(),
+        set_index, 1, &descriptor_set, 0, nullptr);
 }
 
 void ComputeCommandEncoderVulkan::PushConstants(const void *data, uint32_t size, uint32_t offset) {
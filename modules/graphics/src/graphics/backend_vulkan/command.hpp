@@ -22,12 +22,33 @@ private:
     VkCommandBuffer cmd_buffer_;
 };
 
+class SplitBarrierVulkan final : public SplitBarrier {
+public:
+    SplitBarrierVulkan(Ref<DeviceVulkan> device);
+    ~SplitBarrierVulkan() override;
+
+    void SetBarriers(Span<BufferBarrier> buffer_barriers, Span<TextureBarrier> texture_barriers);
+
+    VkEvent RawEvent() const { return event_; }
+    const VkDependencyInfo &RawDependencyInfo() const { return dep_info_; }
+    VkPipelineStageFlags2 RawDstStageMask() const { return dst_stage_mask_; }
+
+private:
+    Ref<DeviceVulkan> device_;
+    VkEvent event_;
+    Vec<VkBufferMemoryBarrier2> buffer_barriers_vk_;
+    Vec<VkImageMemoryBarrier2> texture_barriers_vk_;
+    VkDependencyInfo dep_info_;
+    VkPipelineStageFlags2 dst_stage_mask_ = 0;
+};
+
 class RenderCommandEncoderVulkan;
 class ComputeCommandEncoderVulkan;
 
 class CommandEncoderVulkan final : public CommandEncoder, public RefFromThis<CommandEncoderVulkan> {
 public:
-    CommandEncoderVulkan(Ref<DeviceVulkan> device, Ref<FrameContextVulkan> context, VkCommandBuffer cmd_buffer);
+    CommandEncoderVulkan(Ref<DeviceVulkan> device, Ref<FrameContextVulkan> context, VkCommandBuffer cmd_buffer,
+        QueueType queue_type);
     ~CommandEncoderVulkan();
 
     Ptr<CommandBuffer> Finish() override;
@@ -50,6 +71,13 @@ public:
 
     void ResourceBarrier(Span<BufferBarrier> buffer_barriers, Span<TextureBarrier> texture_barriers) override;
 
+    void BeginSplitBarrier(Span<Ref<SplitBarrier>> barriers) override;
+    void EndSplitBarrier(Span<Ref<SplitBarrier>> barriers) override;
+
+    void ResetQueries(Ref<QuerySet> query_set, uint32_t first_query, uint32_t num_queries) override;
+    void WriteTimestamp(Ref<QuerySet> query_set, uint32_t query) override;
+    void ResolveQueries(Ref<QuerySet> query_set, uint32_t first_query, uint32_t num_queries) override;
+
     Ptr<RenderCommandEncoder> BeginRenderPass(const CommandLabel &label, const RenderTargetDesc &desc) override;
 
     Ptr<ComputeCommandEncoder> BeginComputePass(const CommandLabel &label) override;
@@ -61,6 +89,13 @@ private:
     Ref<DeviceVulkan> device_;
     Ref<FrameContextVulkan> context_;
     VkCommandBuffer cmd_buffer_;
+    QueueType queue_type_;
+
+    // scratch storage reused by barrier commands so that they don't allocate once capacity is reached
+    Vec<VkBufferMemoryBarrier2> buffer_barriers_vk_;
+    Vec<VkImageMemoryBarrier2> texture_barriers_vk_;
+    Vec<VkEvent> events_;
+    Vec<VkDependencyInfo> dep_infos_;
 };
 
 class RenderCommandEncoderVulkan final : public RenderCommandEncoder {
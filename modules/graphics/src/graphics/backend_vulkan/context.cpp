@@ -7,45 +7,79 @@ BISMUTH_NAMESPACE_BEGIN
 
 BISMUTH_GFX_NAMESPACE_BEGIN
 
-FrameContextVulkan::FrameContextVulkan(Ref<DeviceVulkan> device) : device_(device) {
-    VkCommandPoolCreateInfo graphics_command_pool_ci {
+namespace {
+
+VkCommandPool CreateCommandPool(Ref<DeviceVulkan> device, QueueType queue) {
+    VkCommandPoolCreateInfo command_pool_ci {
         .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
         .pNext = nullptr,
         .flags = 0,
-        .queueFamilyIndex = device->GetQueue(QueueType::eGraphics).AsRef().CastTo<QueueVulkan>()->RawFamilyIndex(),
+        .queueFamilyIndex = device->QueueFamilyIndex(queue),
     };
-    vkCreateCommandPool(device->Raw(), &graphics_command_pool_ci, nullptr, &graphics_command_pool_);
-    available_command_buffer_index_ = 0;
+    VkCommandPool command_pool;
+    vkCreateCommandPool(device->Raw(), &command_pool_ci, nullptr, &command_pool);
+    return command_pool;
+}
+
+}
+
+FrameContextVulkan::FrameContextVulkan(Ref<DeviceVulkan> device) : device_(device), descriptor_writer_(device) {
+    command_pools_[static_cast<uint8_t>(QueueType::eGraphics)].pool = CreateCommandPool(device, QueueType::eGraphics);
 
     descriptor_pool_ = Ptr<DescriptorSetPoolVulkan>::Make(device, DescriptorPoolSizesVulkan::kDefault);
 }
 
 FrameContextVulkan::~FrameContextVulkan() {
-    vkDestroyCommandPool(device_->Raw(), graphics_command_pool_, nullptr);
+    for (const auto &command_pool : command_pools_) {
+        if (command_pool.pool != VK_NULL_HANDLE) {
+            vkDestroyCommandPool(device_->Raw(), command_pool.pool, nullptr);
+        }
+    }
 }
 
 void FrameContextVulkan::Reset() {
-    vkResetCommandPool(device_->Raw(), graphics_command_pool_, 0);
-    available_command_buffer_index_ = 0;
+    for (auto &command_pool : command_pools_) {
+        if (command_pool.pool != VK_NULL_HANDLE) {
+            vkResetCommandPool(device_->Raw(), command_pool.pool, 0);
+            command_pool.available_command_buffer_index = 0;
+        }
+    }
+    available_split_barrier_index_ = 0;
+
+    descriptor_pool_->Reset();
+    descriptor_sets_.clear();
+    num_descriptor_cache_hits_ = 0;
+    num_descriptor_cache_misses_ = 0;
+
+    for (auto &context : thread_contexts_) {
+        if (context.IsInitialized()) {
+            context->Reset();
+        }
+    }
 }
 
 Ptr<CommandEncoder> FrameContextVulkan::GetCommandEncoder(QueueType queue) {
+    auto &command_pool = command_pools_[static_cast<uint8_t>(queue)];
+    if (command_pool.pool == VK_NULL_HANDLE) {
+        command_pool.pool = CreateCommandPool(device_, queue);
+    }
+
     VkCommandBuffer command_buffer = VK_NULL_HANDLE;
-    if (available_command_buffer_index_ < allocated_command_buffers_.size()) {
-        command_buffer = allocated_command_buffers_[available_command_buffer_index_];
-        ++available_command_buffer_index_;
+    if (command_pool.available_command_buffer_index < command_pool.allocated_command_buffers.size()) {
+        command_buffer = command_pool.allocated_command_buffers[command_pool.available_command_buffer_index];
+        ++command_pool.available_command_buffer_index;
     } else {
         VkCommandBufferAllocateInfo command_buffer_ci {
             .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
             .pNext = nullptr,
-            .commandPool = graphics_command_pool_,
+            .commandPool = command_pool.pool,
             .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
             .commandBufferCount = 1,
         };
         vkAllocateCommandBuffers(device_->Raw(), &command_buffer_ci, &command_buffer);
 
-        allocated_command_buffers_.push_back(command_buffer);
-        ++available_command_buffer_index_;
+        command_pool.allocated_command_buffers.push_back(command_buffer);
+        ++command_pool.available_command_buffer_index;
     }
 
     VkCommandBufferBeginInfo begin_info {
@@ -56,20 +90,76 @@ Ptr<CommandEncoder> FrameContextVulkan::GetCommandEncoder(QueueType queue) {
     };
     vkBeginCommandBuffer(command_buffer, &begin_info);
 
-    return Ptr<CommandEncoderVulkan>::Make(device_, RefThis(), command_buffer);
+    return Ptr<CommandEncoderVulkan>::Make(device_, RefThis(), command_buffer, queue);
+}
+
+Ref<FrameContext> FrameContextVulkan::GetThreadContext(uint32_t thread_index) {
+    if (thread_index == 0) {
+        return RefThis();
+    }
+    if (thread_contexts_.size() < thread_index) {
+        thread_contexts_.resize(thread_index);
+    }
+    auto &context = thread_contexts_[thread_index - 1];
+    if (!context.IsInitialized()) {
+        context = Ptr<FrameContextVulkan>::Make(device_);
+    }
+    return context.AsRef();
+}
+
+Ref<SplitBarrier> FrameContextVulkan::CreateSplitBarrier(Span<BufferBarrier> buffer_barriers,
+    Span<TextureBarrier> texture_barriers) {
+    if (available_split_barrier_index_ == split_barriers_.size()) {
+        split_barriers_.emplace_back(Ptr<SplitBarrierVulkan>::Make(device_));
+    }
+    auto &split_barrier = split_barriers_[available_split_barrier_index_++];
+    split_barrier->SetBarriers(buffer_barriers, texture_barriers);
+    return split_barrier.AsRef();
+}
+
+DescriptorAllocationStats FrameContextVulkan::GetDescriptorStats() const {
+    DescriptorAllocationStats stats {
+        .num_cache_hits = num_descriptor_cache_hits_,
+        .num_cache_misses = num_descriptor_cache_misses_,
+        .num_allocated_sets = descriptor_pool_->NumAllocatedSets(),
+        .num_pools = descriptor_pool_->NumPools(),
+        .num_used_pools = descriptor_pool_->NumUsedPools(),
+    };
+    for (const auto &context : thread_contexts_) {
+        if (context.IsInitialized()) {
+            const auto thread_stats = context->GetDescriptorStats();
+            stats.num_cache_hits += thread_stats.num_cache_hits;
+            stats.num_cache_misses += thread_stats.num_cache_misses;
+            stats.num_allocated_sets += thread_stats.num_allocated_sets;
+            stats.num_pools += thread_stats.num_pools;
+            stats.num_used_pools += thread_stats.num_used_pools;
+        }
+    }
+    return stats;
 }
 
 VkDescriptorSet FrameContextVulkan::GetDescriptorSet(VkDescriptorSetLayout layout_vk, const DescriptorSetLayout &layout,
-    const ShaderParams &values) {
-    auto key = std::make_pair(layout, values);
-    if (auto it = descriptor_sets_.find(key); it != descriptor_sets_.end()) {
-        return it->second;
+    const ShaderParams &values, const DescriptorUpdateTemplateVulkan *update_template) {
+    auto &entries = descriptor_sets_[std::make_pair(layout_vk, values.Hash())];
+    for (const auto &[entry_values, entry_set] : entries) {
+        if (entry_values == values) {
+            ++num_descriptor_cache_hits_;
+            return entry_set;
+        }
     }
-    auto descriptor_set = descriptor_pool_->AllocateAndWriteSet(layout_vk, layout, values);
-    descriptor_sets_.insert({key, descriptor_set});
+    ++num_descriptor_cache_misses_;
+    auto descriptor_set = descriptor_pool_->AllocateSet(layout_vk);
+    descriptor_writer_.WriteSet(descriptor_set, layout, values, update_template);
+    entries.EmplaceBack(values, descriptor_set);
     return descriptor_set;
 }
 
+void FrameContextVulkan::PushDescriptorSet(VkCommandBuffer cmd_buffer, VkPipelineBindPoint bind_point,
+    VkPipelineLayout pipeline_layout, uint32_t set_index, const DescriptorSetLayout &layout,
+    const ShaderParams &values, const DescriptorUpdateTemplateVulkan &update_template) {
+    descriptor_writer_.PushSet(cmd_buffer, bind_point, pipeline_layout, set_index, layout, values, update_template);
+}
+
 BISMUTH_GFX_NAMESPACE_END
 
 BISMUTH_NAMESPACE_END
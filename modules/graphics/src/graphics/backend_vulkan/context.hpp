@@ -16,18 +16,45 @@ public:
 
     Ptr<class CommandEncoder> GetCommandEncoder(QueueType queue = QueueType::eGraphics) override;
 
+    Ref<FrameContext> GetThreadContext(uint32_t thread_index) override;
+
+    Ref<SplitBarrier> CreateSplitBarrier(Span<BufferBarrier> buffer_barriers,
+        Span<TextureBarrier> texture_barriers) override;
+
+    DescriptorAllocationStats GetDescriptorStats() const override;
+
+    // update template may be null
     VkDescriptorSet GetDescriptorSet(VkDescriptorSetLayout layout_vk, const DescriptorSetLayout &layout,
-        const ShaderParams &values);
+        const ShaderParams &values, const DescriptorUpdateTemplateVulkan *update_template);
+
+    void PushDescriptorSet(VkCommandBuffer cmd_buffer, VkPipelineBindPoint bind_point,
+        VkPipelineLayout pipeline_layout, uint32_t set_index, const DescriptorSetLayout &layout,
+        const ShaderParams &values, const DescriptorUpdateTemplateVulkan &update_template);
 
 private:
     Ref<DeviceVulkan> device_;
 
-    VkCommandPool graphics_command_pool_;
-    Vec<VkCommandBuffer> allocated_command_buffers_;
-    size_t available_command_buffer_index_;
+    struct CommandPool {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        Vec<VkCommandBuffer> allocated_command_buffers;
+        size_t available_command_buffer_index = 0;
+    };
+    // indexed by queue type, pools of other queues than graphics are created when first used
+    CommandPool command_pools_[3];
 
     Ptr<DescriptorSetPoolVulkan> descriptor_pool_;
-    HashMap<std::pair<DescriptorSetLayout, ShaderParams>, VkDescriptorSet> descriptor_sets_;
+    DescriptorWriterVulkan descriptor_writer_;
+    // sets are valid until descriptor pool is reset, found by set layout and hash of params without copying them,
+    // params with colliding hashes share the same entry
+    HashMap<std::pair<VkDescriptorSetLayout, size_t>, SmallVec<std::pair<ShaderParams, VkDescriptorSet>, 1>>
+        descriptor_sets_;
+    size_t num_descriptor_cache_hits_ = 0;
+    size_t num_descriptor_cache_misses_ = 0;
+
+    Vec<Ptr<FrameContextVulkan>> thread_contexts_;
+
+    Vec<Ptr<class SplitBarrierVulkan>> split_barriers_;
+    size_t available_split_barrier_index_ = 0;
 };
 
 BISMUTH_GFX_NAMESPACE_END
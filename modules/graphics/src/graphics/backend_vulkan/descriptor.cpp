@@ -1,7 +1,10 @@
 #include "descriptor.hpp"
 
+#include <algorithm>
 #include <format>
 
+#include <core/module_manager.hpp>
+
 #include "device.hpp"
 #include "utils.hpp"
 #include "resource.hpp"
@@ -84,6 +87,24 @@ VkDescriptorImageInfo ToVkImageInfo(Ref<Sampler> sampler) {
     };
 }
 
+VkDescriptorType ToVkDescriptorType(BindlessBinding binding) {
+    switch (binding) {
+        case BindlessBinding::eSampledTexture: return VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        case BindlessBinding::eStorageTexture: return VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        case BindlessBinding::eStorageBuffer: return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        case BindlessBinding::eSampler: return VK_DESCRIPTOR_TYPE_SAMPLER;
+    }
+    Unreachable();
+}
+
+// preferred array sizes of bindless set, clamped by device limits
+constexpr uint32_t kBindlessSampledTextures = 65536;
+constexpr uint32_t kBindlessStorageTextures = 16384;
+constexpr uint32_t kBindlessStorageBuffers = 65536;
+constexpr uint32_t kBindlessSamplers = 2048;
+// per-stage resources left to other sets of pipelines that also use bindless set
+constexpr uint32_t kNonBindlessStageResources = 1024;
+
 }
 
 constexpr DescriptorPoolSizesVulkan DescriptorPoolSizesVulkan::kDefault = {
@@ -101,34 +122,216 @@ constexpr DescriptorPoolSizesVulkan DescriptorPoolSizesVulkan::kDefault = {
 };
 
 DescriptorSetPoolVulkan::DescriptorSetPoolVulkan(Ref<DeviceVulkan> device, const DescriptorPoolSizesVulkan &max_sizes)
-    : device_(device) {
+    : device_(device), max_sizes_(max_sizes) {
+    pools_.push_back(CreatePool());
+}
+
+DescriptorSetPoolVulkan::~DescriptorSetPoolVulkan() {
+    for (auto pool : pools_) {
+        vkDestroyDescriptorPool(device_->Raw(), pool, nullptr);
+    }
+}
+
+VkDescriptorPool DescriptorSetPoolVulkan::CreatePool() const {
     VkDescriptorPoolCreateInfo pool_ci {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
         .pNext = nullptr,
         .flags = 0,
-        .maxSets = max_sizes.num_sets,
+        .maxSets = max_sizes_.num_sets,
         .poolSizeCount = static_cast<uint32_t>(DescriptorPoolSizesVulkan::kDescriptorSizesCount),
-        .pPoolSizes = max_sizes.sizes,
+        .pPoolSizes = max_sizes_.sizes,
     };
-    vkCreateDescriptorPool(device->Raw(), &pool_ci, nullptr, &pool_);
+    VkDescriptorPool pool;
+    vkCreateDescriptorPool(device_->Raw(), &pool_ci, nullptr, &pool);
+    return pool;
 }
 
-DescriptorSetPoolVulkan::~DescriptorSetPoolVulkan() {
-    vkDestroyDescriptorPool(device_->Raw(), pool_, nullptr);
+void DescriptorSetPoolVulkan::Reset() {
+    const size_t num_used_pools = NumUsedPools();
+    for (size_t i = 0; i < num_used_pools; i++) {
+        vkResetDescriptorPool(device_->Raw(), pools_[i], 0);
+    }
+    curr_pool_ = 0;
+    num_sets_in_curr_pool_ = 0;
+    num_allocated_sets_ = 0;
 }
 
-VkDescriptorSet DescriptorSetPoolVulkan::AllocateAndWriteSet(VkDescriptorSetLayout layout_vk,
-    const DescriptorSetLayout &layout, const ShaderParams &values) {
+VkDescriptorSet DescriptorSetPoolVulkan::AllocateSet(VkDescriptorSetLayout layout_vk) {
     VkDescriptorSetAllocateInfo set_ci {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
         .pNext = nullptr,
-        .descriptorPool = pool_,
+        .descriptorPool = VK_NULL_HANDLE,
         .descriptorSetCount = 1,
         .pSetLayouts = &layout_vk,
     };
-    VkDescriptorSet set;
-    vkAllocateDescriptorSets(device_->Raw(), &set_ci, &set);
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    while (true) {
+        set_ci.descriptorPool = pools_[curr_pool_];
+        const VkResult result = vkAllocateDescriptorSets(device_->Raw(), &set_ci, &set);
+        if (result == VK_SUCCESS) {
+            break;
+        }
+        BI_ASSERT_MSG(result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL,
+            "Failed to allocate descriptor set");
+        BI_ASSERT_MSG(num_sets_in_curr_pool_ > 0, "Descriptor set layout doesn't fit in an empty descriptor pool");
+
+        // current pool is full, move to next one
+        ++curr_pool_;
+        num_sets_in_curr_pool_ = 0;
+        if (curr_pool_ == pools_.size()) {
+            pools_.push_back(CreatePool());
+        }
+    }
+    ++num_sets_in_curr_pool_;
+    ++num_allocated_sets_;
+    return set;
+}
+
+uint32_t NumWrittenDescriptors(const DescriptorSetLayout &layout) {
+    uint32_t num_descriptors = 0;
+    for (const auto &binding : layout.bindings) {
+        if (binding.type != DescriptorType::eNone && binding.immutable_samplers.empty()) {
+            num_descriptors += binding.count;
+        }
+    }
+    return num_descriptors;
+}
+
+DescriptorUpdateTemplateVulkan::DescriptorUpdateTemplateVulkan(Ref<DeviceVulkan> device,
+    const DescriptorSetLayout &layout, VkDescriptorSetLayout layout_vk, bool push, VkPipelineBindPoint bind_point,
+    VkPipelineLayout pipeline_layout, uint32_t set_index) : device_(device) {
+    Vec<VkDescriptorUpdateTemplateEntry> entries;
+    entries.reserve(layout.bindings.size());
+    for (uint32_t binding = 0; binding < layout.bindings.size(); binding++) {
+        const auto &binding_info = layout.bindings[binding];
+        if (binding_info.type == DescriptorType::eNone || !binding_info.immutable_samplers.empty()) {
+            continue;
+        }
+        entries.push_back(VkDescriptorUpdateTemplateEntry {
+            .dstBinding = binding,
+            .dstArrayElement = 0,
+            .descriptorCount = binding_info.count,
+            .descriptorType = ToVkDescriptorType(binding_info.type),
+            .offset = num_descriptors_ * sizeof(DescriptorUpdateDataVulkan),
+            .stride = sizeof(DescriptorUpdateDataVulkan),
+        });
+        num_descriptors_ += binding_info.count;
+    }
+
+    VkDescriptorUpdateTemplateCreateInfo template_ci {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size()),
+        .pDescriptorUpdateEntries = entries.data(),
+        .templateType = push
+            ? VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR : VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET,
+        .descriptorSetLayout = layout_vk,
+        .pipelineBindPoint = bind_point,
+        .pipelineLayout = pipeline_layout,
+        .set = set_index,
+    };
+    vkCreateDescriptorUpdateTemplate(device->Raw(), &template_ci, nullptr, &template_);
+}
+
+DescriptorUpdateTemplateVulkan::~DescriptorUpdateTemplateVulkan() {
+    vkDestroyDescriptorUpdateTemplate(device_->Raw(), template_, nullptr);
+}
+
+bool DescriptorUpdateTemplateVulkan::FillData(const DescriptorSetLayout &layout, const ShaderParams &values,
+    Vec<DescriptorUpdateDataVulkan> &data) const {
+    data.resize(num_descriptors_);
+    DescriptorUpdateDataVulkan *p_data = data.data();
+    for (uint32_t binding = 0; binding < layout.bindings.size(); binding++) {
+        const auto &binding_info = layout.bindings[binding];
+        if (binding_info.type == DescriptorType::eNone || !binding_info.immutable_samplers.empty()) {
+            continue;
+        }
+        if (binding >= values.Resources().size()) {
+            return false;
+        }
+        const bool filled = values.Resources()[binding].Match(
+            [](std::monostate) {
+                return false;
+            },
+            [&binding_info, &p_data](const BufferRange &buffer) {
+                p_data->buffer = ToVkBufferInfo(buffer);
+                ++p_data;
+                return binding_info.count == 1;
+            },
+            [&binding_info, &p_data](const TextureView &texture) {
+                p_data->image = ToVkImageInfo(texture, binding_info);
+                ++p_data;
+                return binding_info.count == 1;
+            },
+            [&binding_info, &p_data](Ref<Sampler> sampler) {
+                p_data->image = ToVkImageInfo(sampler);
+                ++p_data;
+                return binding_info.count == 1;
+            },
+            [&binding_info, &p_data](const Vec<BufferRange> &buffers) {
+                if (buffers.size() != binding_info.count) {
+                    return false;
+                }
+                for (const auto &buffer : buffers) {
+                    p_data->buffer = ToVkBufferInfo(buffer);
+                    ++p_data;
+                }
+                return true;
+            },
+            [&binding_info, &p_data](const Vec<TextureView> &textures) {
+                if (textures.size() != binding_info.count) {
+                    return false;
+                }
+                for (const auto &texture : textures) {
+                    p_data->image = ToVkImageInfo(texture, binding_info);
+                    ++p_data;
+                }
+                return true;
+            },
+            [&binding_info, &p_data](const Vec<Ref<Sampler>> &samplers) {
+                if (samplers.size() != binding_info.count) {
+                    return false;
+                }
+                for (const auto &sampler : samplers) {
+                    p_data->image = ToVkImageInfo(sampler);
+                    ++p_data;
+                }
+                return true;
+            }
+        );
+        if (!filled) {
+            return false;
+        }
+    }
+    return true;
+}
 
+void DescriptorWriterVulkan::WriteSet(VkDescriptorSet set, const DescriptorSetLayout &layout,
+    const ShaderParams &values, const DescriptorUpdateTemplateVulkan *update_template) {
+    if (update_template && update_template->FillData(layout, values, template_data_)) {
+        vkUpdateDescriptorSetWithTemplate(device_->Raw(), set, update_template->Raw(), template_data_.data());
+        return;
+    }
+    BuildWrites(set, layout, values);
+    vkUpdateDescriptorSets(device_->Raw(), writes_.size(), writes_.data(), 0, nullptr);
+}
+
+void DescriptorWriterVulkan::PushSet(VkCommandBuffer cmd_buffer, VkPipelineBindPoint bind_point,
+    VkPipelineLayout pipeline_layout, uint32_t set_index, const DescriptorSetLayout &layout,
+    const ShaderParams &values, const DescriptorUpdateTemplateVulkan &update_template) {
+    if (update_template.FillData(layout, values, template_data_)) {
+        vkCmdPushDescriptorSetWithTemplateKHR(cmd_buffer, update_template.Raw(), pipeline_layout, set_index,
+            template_data_.data());
+        return;
+    }
+    // dstSet is ignored when pushing descriptors
+    BuildWrites(VK_NULL_HANDLE, layout, values);
+    vkCmdPushDescriptorSetKHR(cmd_buffer, bind_point, pipeline_layout, set_index, writes_.size(), writes_.data());
+}
+
+void DescriptorWriterVulkan::BuildWrites(VkDescriptorSet set, const DescriptorSetLayout &layout,
+    const ShaderParams &values) {
     uint32_t num_buffers = 0;
     uint32_t num_textures = 0;
     uint32_t num_samplers = 0;
@@ -141,22 +344,21 @@ VkDescriptorSet DescriptorSetPoolVulkan::AllocateAndWriteSet(VkDescriptorSetLayo
             num_textures += binding.count;
             ++num_bindings_to_write;
         } else if (IsDescriptorTypeSampler(binding.type)) {
-            if (binding.immutable_samplers.Empty()) {
+            if (binding.immutable_samplers.empty()) {
                 num_samplers += binding.count;
                 ++num_bindings_to_write;
             }
         }
     }
-    uint32_t total = num_buffers + num_textures + num_samplers;
-
-    Vec<VkDescriptorBufferInfo> buffer_infos(num_buffers);
-    VkDescriptorBufferInfo *p_buffer_info = buffer_infos.data();
-    Vec<VkDescriptorImageInfo> image_infos(num_textures + num_samplers);
-    VkDescriptorImageInfo *p_image_info = image_infos.data();
-    Vec<VkWriteDescriptorSet> writes(num_bindings_to_write);
-    VkWriteDescriptorSet *p_write = writes.data();
-    for (uint32_t binding = 0; binding < values.resources.size(); binding++) {
-        const auto &resource = values.resources[binding];
+    // scratch memory is reused, so there is no allocation once it is large enough
+    buffer_infos_.resize(num_buffers);
+    VkDescriptorBufferInfo *p_buffer_info = buffer_infos_.data();
+    image_infos_.resize(num_textures + num_samplers);
+    VkDescriptorImageInfo *p_image_info = image_infos_.data();
+    writes_.resize(num_bindings_to_write);
+    VkWriteDescriptorSet *p_write = writes_.data();
+    for (uint32_t binding = 0; binding < values.Resources().size(); binding++) {
+        const auto &resource = values.Resources()[binding];
         resource.Match(
             [](std::monostate) {},
             [set, binding, &layout, &p_write, &p_buffer_info](const BufferRange &buffer) {
@@ -273,9 +475,216 @@ VkDescriptorSet DescriptorSetPoolVulkan::AllocateAndWriteSet(VkDescriptorSetLayo
             }
         );
     }
-    vkUpdateDescriptorSets(device_->Raw(), writes.size(), writes.data(), 0, nullptr);
+    // unbound bindings are not written
+    writes_.resize(p_write - writes_.data());
+}
 
-    return set;
+BindlessDescriptorSetVulkan::BindlessDescriptorSetVulkan(Ref<DeviceVulkan> device) : device_(device) {
+    VkPhysicalDeviceDescriptorIndexingProperties indexing_props {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES,
+        .pNext = nullptr,
+    };
+    VkPhysicalDeviceProperties2 props {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = &indexing_props,
+    };
+    vkGetPhysicalDeviceProperties2(device->RawPhysicalDevice(), &props);
+
+    slots_[static_cast<uint32_t>(BindlessBinding::eSampledTexture)].capacity = std::min({
+        kBindlessSampledTextures,
+        indexing_props.maxDescriptorSetUpdateAfterBindSampledImages,
+        indexing_props.maxPerStageDescriptorUpdateAfterBindSampledImages,
+    });
+    slots_[static_cast<uint32_t>(BindlessBinding::eStorageTexture)].capacity = std::min({
+        kBindlessStorageTextures,
+        indexing_props.maxDescriptorSetUpdateAfterBindStorageImages,
+        indexing_props.maxPerStageDescriptorUpdateAfterBindStorageImages,
+    });
+    slots_[static_cast<uint32_t>(BindlessBinding::eStorageBuffer)].capacity = std::min({
+        kBindlessStorageBuffers,
+        indexing_props.maxDescriptorSetUpdateAfterBindStorageBuffers,
+        indexing_props.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+    });
+    slots_[static_cast<uint32_t>(BindlessBinding::eSampler)].capacity = std::min({
+        kBindlessSamplers,
+        indexing_props.maxDescriptorSetUpdateAfterBindSamplers,
+        indexing_props.maxPerStageDescriptorUpdateAfterBindSamplers,
+    });
+    // all bindings are visible to every stage, so together they count against the per-stage resource limit,
+    // capacities are scaled down evenly if they exceed it
+    const uint32_t max_stage_resources = indexing_props.maxPerStageUpdateAfterBindResources
+        - std::min(indexing_props.maxPerStageUpdateAfterBindResources / 2, kNonBindlessStageResources);
+    uint64_t total_capacity = 0;
+    for (const auto &slot : slots_) {
+        total_capacity += slot.capacity;
+    }
+    if (total_capacity > max_stage_resources) {
+        for (auto &slot : slots_) {
+            slot.capacity = static_cast<uint32_t>(slot.capacity * static_cast<uint64_t>(max_stage_resources)
+                / total_capacity);
+        }
+    }
+
+    VkDescriptorSetLayoutBinding bindings[kNumBindlessBindings];
+    VkDescriptorBindingFlags binding_flags[kNumBindlessBindings];
+    VkDescriptorPoolSize pool_sizes[kNumBindlessBindings];
+    for (uint32_t binding = 0; binding < kNumBindlessBindings; binding++) {
+        const auto type = ToVkDescriptorType(static_cast<BindlessBinding>(binding));
+        bindings[binding] = VkDescriptorSetLayoutBinding {
+            .binding = binding,
+            .descriptorType = type,
+            .descriptorCount = slots_[binding].capacity,
+            .stageFlags = VK_SHADER_STAGE_ALL,
+            .pImmutableSamplers = nullptr,
+        };
+        binding_flags[binding] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT
+            | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+            | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+        pool_sizes[binding] = VkDescriptorPoolSize {
+            .type = type,
+            .descriptorCount = slots_[binding].capacity,
+        };
+    }
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_ci {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .pNext = nullptr,
+        .bindingCount = kNumBindlessBindings,
+        .pBindingFlags = binding_flags,
+    };
+    VkDescriptorSetLayoutCreateInfo set_layout_ci {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = &binding_flags_ci,
+        .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+        .bindingCount = kNumBindlessBindings,
+        .pBindings = bindings,
+    };
+    vkCreateDescriptorSetLayout(device->Raw(), &set_layout_ci, nullptr, &layout_);
+
+    VkDescriptorPoolCreateInfo pool_ci {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+        .maxSets = 1,
+        .poolSizeCount = kNumBindlessBindings,
+        .pPoolSizes = pool_sizes,
+    };
+    vkCreateDescriptorPool(device->Raw(), &pool_ci, nullptr, &pool_);
+
+    VkDescriptorSetAllocateInfo set_ci {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .pNext = nullptr,
+        .descriptorPool = pool_,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &layout_,
+    };
+    vkAllocateDescriptorSets(device->Raw(), &set_ci, &set_);
+
+    BI_INFO(ModuleManager::Get<GraphicsModule>()->Lgr(),
+        "Bindless set: {} sampled textures, {} storage textures, {} storage buffers, {} samplers",
+        slots_[0].capacity, slots_[1].capacity, slots_[2].capacity, slots_[3].capacity);
+}
+
+BindlessDescriptorSetVulkan::~BindlessDescriptorSetVulkan() {
+    vkDestroyDescriptorPool(device_->Raw(), pool_, nullptr);
+    vkDestroyDescriptorSetLayout(device_->Raw(), layout_, nullptr);
+}
+
+uint32_t BindlessDescriptorSetVulkan::AllocateIndex(BindlessBinding binding) {
+    auto &slots = slots_[static_cast<uint32_t>(binding)];
+    if (!slots.free_indices.empty()) {
+        const uint32_t index = slots.free_indices.back();
+        slots.free_indices.pop_back();
+        return index;
+    }
+    if (slots.num_used == slots.capacity) {
+        BI_WARN(ModuleManager::Get<GraphicsModule>()->Lgr(), "Bindless array {} is full ({} descriptors)",
+            static_cast<uint32_t>(binding), slots.capacity);
+        return kInvalidBindlessIndex;
+    }
+    return slots.num_used++;
+}
+
+void BindlessDescriptorSetVulkan::Write(BindlessBinding binding, uint32_t index,
+    const VkDescriptorImageInfo *image_info, const VkDescriptorBufferInfo *buffer_info) {
+    VkWriteDescriptorSet write {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .pNext = nullptr,
+        .dstSet = set_,
+        .dstBinding = static_cast<uint32_t>(binding),
+        .dstArrayElement = index,
+        .descriptorCount = 1,
+        .descriptorType = ToVkDescriptorType(binding),
+        .pImageInfo = image_info,
+        .pBufferInfo = buffer_info,
+        .pTexelBufferView = nullptr,
+    };
+    vkUpdateDescriptorSets(device_->Raw(), 1, &write, 0, nullptr);
+}
+
+uint32_t BindlessDescriptorSetVulkan::AddSampledTexture(VkImageView view, VkImageLayout layout) {
+    std::lock_guard lock(mutex_);
+    const uint32_t index = AllocateIndex(BindlessBinding::eSampledTexture);
+    if (index != kInvalidBindlessIndex) {
+        VkDescriptorImageInfo image_info {
+            .sampler = VK_NULL_HANDLE,
+            .imageView = view,
+            .imageLayout = layout,
+        };
+        Write(BindlessBinding::eSampledTexture, index, &image_info, nullptr);
+    }
+    return index;
+}
+
+uint32_t BindlessDescriptorSetVulkan::AddStorageTexture(VkImageView view) {
+    std::lock_guard lock(mutex_);
+    const uint32_t index = AllocateIndex(BindlessBinding::eStorageTexture);
+    if (index != kInvalidBindlessIndex) {
+        VkDescriptorImageInfo image_info {
+            .sampler = VK_NULL_HANDLE,
+            .imageView = view,
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+        };
+        Write(BindlessBinding::eStorageTexture, index, &image_info, nullptr);
+    }
+    return index;
+}
+
+uint32_t BindlessDescriptorSetVulkan::AddStorageBuffer(VkBuffer buffer) {
+    std::lock_guard lock(mutex_);
+    const uint32_t index = AllocateIndex(BindlessBinding::eStorageBuffer);
+    if (index != kInvalidBindlessIndex) {
+        VkDescriptorBufferInfo buffer_info {
+            .buffer = buffer,
+            .offset = 0,
+            .range = VK_WHOLE_SIZE,
+        };
+        Write(BindlessBinding::eStorageBuffer, index, nullptr, &buffer_info);
+    }
+    return index;
+}
+
+uint32_t BindlessDescriptorSetVulkan::AddSampler(VkSampler sampler) {
+    std::lock_guard lock(mutex_);
+    const uint32_t index = AllocateIndex(BindlessBinding::eSampler);
+    if (index != kInvalidBindlessIndex) {
+        VkDescriptorImageInfo image_info {
+            .sampler = sampler,
+            .imageView = VK_NULL_HANDLE,
+            .imageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        };
+        Write(BindlessBinding::eSampler, index, &image_info, nullptr);
+    }
+    return index;
+}
+
+void BindlessDescriptorSetVulkan::Remove(BindlessBinding binding, uint32_t index) {
+    if (index == kInvalidBindlessIndex) {
+        return;
+    }
+    // descriptor is left as is, it is partially bound and won't be accessed until index is reused
+    std::lock_guard lock(mutex_);
+    slots_[static_cast<uint32_t>(binding)].free_indices.push_back(index);
 }
 
 BISMUTH_GFX_NAMESPACE_END
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <mutex>
+
 #include <volk.h>
 
 #include "graphics/descriptor.hpp"
@@ -17,18 +19,126 @@ struct DescriptorPoolSizesVulkan {
     uint32_t num_sets = 0;
 };
 
+// a chain of descriptor pools of the same sizes, a new pool is added when all existing ones are full
 class DescriptorSetPoolVulkan {
 public:
     DescriptorSetPoolVulkan(Ref<class DeviceVulkan> device,
         const DescriptorPoolSizesVulkan &max_sizes = DescriptorPoolSizesVulkan::kDefault);
     ~DescriptorSetPoolVulkan();
 
-    VkDescriptorSet AllocateAndWriteSet(VkDescriptorSetLayout layout_vk, const DescriptorSetLayout &layout,
-        const ShaderParams &values);
+    VkDescriptorSet AllocateSet(VkDescriptorSetLayout layout_vk);
+
+    // free all allocated sets, pools are kept to be reused
+    void Reset();
+
+    size_t NumPools() const { return pools_.size(); }
+    size_t NumUsedPools() const { return num_allocated_sets_ == 0 ? 0 : curr_pool_ + 1; }
+    size_t NumAllocatedSets() const { return num_allocated_sets_; }
+
+private:
+    VkDescriptorPool CreatePool() const;
+
+    Ref<DeviceVulkan> device_;
+    DescriptorPoolSizesVulkan max_sizes_;
+    Vec<VkDescriptorPool> pools_;
+    // pools before this one are full
+    size_t curr_pool_ = 0;
+    size_t num_sets_in_curr_pool_ = 0;
+    size_t num_allocated_sets_ = 0;
+};
+
+// element of descriptor update template data, each descriptor takes one element
+union DescriptorUpdateDataVulkan {
+    VkDescriptorBufferInfo buffer;
+    VkDescriptorImageInfo image;
+};
+
+// number of descriptors written for a set, immutable samplers are not counted
+uint32_t NumWrittenDescriptors(const DescriptorSetLayout &layout);
+
+// writes all descriptors of a set with a single call, created for each set layout of a pipeline
+class DescriptorUpdateTemplateVulkan {
+public:
+    // push descriptor templates are bound to the pipeline layout and set index
+    DescriptorUpdateTemplateVulkan(Ref<class DeviceVulkan> device, const DescriptorSetLayout &layout,
+        VkDescriptorSetLayout layout_vk, bool push, VkPipelineBindPoint bind_point, VkPipelineLayout pipeline_layout,
+        uint32_t set_index);
+    ~DescriptorUpdateTemplateVulkan();
+
+    // return false if some descriptor is not provided by values, template can't be used then
+    bool FillData(const DescriptorSetLayout &layout, const ShaderParams &values,
+        Vec<DescriptorUpdateDataVulkan> &data) const;
+
+    VkDescriptorUpdateTemplate Raw() const { return template_; }
 
 private:
     Ref<DeviceVulkan> device_;
+    VkDescriptorUpdateTemplate template_;
+    uint32_t num_descriptors_ = 0;
+};
+
+// writes descriptor sets or pushes descriptors, scratch memory is reused between calls
+// so a writer must be used by only one thread
+class DescriptorWriterVulkan {
+public:
+    DescriptorWriterVulkan(Ref<class DeviceVulkan> device) : device_(device) {}
+
+    // update template may be null
+    void WriteSet(VkDescriptorSet set, const DescriptorSetLayout &layout, const ShaderParams &values,
+        const DescriptorUpdateTemplateVulkan *update_template);
+
+    void PushSet(VkCommandBuffer cmd_buffer, VkPipelineBindPoint bind_point, VkPipelineLayout pipeline_layout,
+        uint32_t set_index, const DescriptorSetLayout &layout, const ShaderParams &values,
+        const DescriptorUpdateTemplateVulkan &update_template);
+
+private:
+    // fallback when template can't be used, writes are stored in writes_
+    void BuildWrites(VkDescriptorSet set, const DescriptorSetLayout &layout, const ShaderParams &values);
+
+    Ref<DeviceVulkan> device_;
+    Vec<VkDescriptorBufferInfo> buffer_infos_;
+    Vec<VkDescriptorImageInfo> image_infos_;
+    Vec<VkWriteDescriptorSet> writes_;
+    Vec<DescriptorUpdateDataVulkan> template_data_;
+};
+
+// global descriptor set of device with update-after-bind arrays, resources are written when they are created
+class BindlessDescriptorSetVulkan {
+public:
+    BindlessDescriptorSetVulkan(Ref<class DeviceVulkan> device);
+    ~BindlessDescriptorSetVulkan();
+
+    // return kInvalidBindlessIndex if the array is full
+    uint32_t AddSampledTexture(VkImageView view, VkImageLayout layout);
+    uint32_t AddStorageTexture(VkImageView view);
+    uint32_t AddStorageBuffer(VkBuffer buffer);
+    uint32_t AddSampler(VkSampler sampler);
+
+    // resource must no longer be used by gpu
+    void Remove(BindlessBinding binding, uint32_t index);
+
+    VkDescriptorSetLayout RawLayout() const { return layout_; }
+    VkDescriptorSet Raw() const { return set_; }
+
+private:
+    uint32_t AllocateIndex(BindlessBinding binding);
+    void Write(BindlessBinding binding, uint32_t index, const VkDescriptorImageInfo *image_info,
+        const VkDescriptorBufferInfo *buffer_info);
+
+    Ref<DeviceVulkan> device_;
+    VkDescriptorSetLayout layout_;
     VkDescriptorPool pool_;
+    VkDescriptorSet set_;
+
+    struct Slots {
+        uint32_t capacity = 0;
+        uint32_t num_used = 0;
+        // indices of removed resources, reused first
+        Vec<uint32_t> free_indices;
+    };
+    Slots slots_[kNumBindlessBindings];
+    // resources may be created on different threads
+    std::mutex mutex_;
 };
 
 BISMUTH_GFX_NAMESPACE_END
@@ -1,5 +1,6 @@
 #include "device.hpp"
 
+#include <cstring>
 #include <vector>
 #include <iostream>
 
@@ -10,11 +11,14 @@
 #include "utils.hpp"
 #include "swap_chain.hpp"
 #include "sync.hpp"
+#include "query.hpp"
 #include "resource.hpp"
 #include "sampler.hpp"
 #include "shader.hpp"
 #include "pipeline.hpp"
 #include "context.hpp"
+#include "descriptor.hpp"
+#include "pipeline_cache.hpp"
 #include "shader_compiler.hpp"
 
 BISMUTH_NAMESPACE_BEGIN
@@ -96,14 +100,44 @@ DeviceVulkan::DeviceVulkan(const DeviceDesc &desc) {
     glfwCreateWindowSurface(instance_, desc.window, nullptr, &surface_);
     surface_format_ = ToVkFormat(desc.surface_format);
 
-    PickDevice(desc);
+    const bool bindless_supported = PickDevice(desc);
 
     InitializeAllocator();
 
-    shader_compiler_ = Ptr<ShaderCompilerVulkan>::Make();
+    auto shader_cache_dir = desc.shader_cache_dir;
+    if (!shader_cache_dir.empty() && shader_cache_dir.is_relative()) {
+        shader_cache_dir = CurrentExecutablePath() / shader_cache_dir;
+    }
+    shader_compiler_ = Ptr<ShaderCompilerVulkan>::Make(shader_cache_dir);
+
+    auto pipeline_cache_file = desc.pipeline_cache_file;
+    if (!pipeline_cache_file.empty() && pipeline_cache_file.is_relative()) {
+        pipeline_cache_file = CurrentExecutablePath() / pipeline_cache_file;
+    }
+    pipeline_cache_ = Ptr<PipelineCacheVulkan>::Make(RefThis(), pipeline_cache_file);
+    pipeline_object_cache_ = Ptr<PipelineObjectCacheVulkan>::Make(RefThis());
+
+    if (desc.enable_bindless) {
+        if (bindless_supported) {
+            bindless_set_ = Ptr<BindlessDescriptorSetVulkan>::Make(RefThis());
+        } else {
+            BI_WARN(ModuleManager::Get<GraphicsModule>()->Lgr(), "Bindless is not supported by GPU, disabled");
+        }
+    }
 }
 
 DeviceVulkan::~DeviceVulkan() {
+    WaitPipelineCreation();
+
+    if (bindless_set_.IsInitialized()) {
+        // destroyed when going out of scope
+        auto bindless_set = std::move(bindless_set_);
+    }
+    if (pipeline_cache_.IsInitialized()) {
+        // cache is saved before device is destroyed
+        auto pipeline_cache = std::move(pipeline_cache_);
+    }
+
     vmaDestroyAllocator(allocator_);
 
     vkDestroyDevice(device_, nullptr);
@@ -116,7 +150,7 @@ DeviceVulkan::~DeviceVulkan() {
     vkDestroyInstance(instance_, nullptr);
 }
 
-void DeviceVulkan::PickDevice(const DeviceDesc &desc) {
+bool DeviceVulkan::PickDevice(const DeviceDesc &desc) {
     uint32_t num_physical_device;
     vkEnumeratePhysicalDevices(instance_, &num_physical_device, nullptr);
     Vec<VkPhysicalDevice> physical_devices(num_physical_device);
@@ -169,10 +203,11 @@ void DeviceVulkan::PickDevice(const DeviceDesc &desc) {
         const auto &props = queue_family_props[i];
         if ((props.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0) {
             graphics_queue_family = i;
-        } else if ((props.queueFlags & VK_QUEUE_TRANSFER_BIT) != 0) {
-            transfer_queue_family = i;
+        // dedicated compute families usually support transfer as well, so check compute first
         } else if ((props.queueFlags & VK_QUEUE_COMPUTE_BIT) != 0) {
             compute_queue_family = i;
+        } else if ((props.queueFlags & VK_QUEUE_TRANSFER_BIT) != 0) {
+            transfer_queue_family = i;
         }
     }
     queue_family_indices[static_cast<uint8_t>(QueueType::eGraphics)] = graphics_queue_family;
@@ -212,6 +247,40 @@ void DeviceVulkan::PickDevice(const DeviceDesc &desc) {
 #endif
     };
 
+    uint32_t num_device_extensions;
+    vkEnumerateDeviceExtensionProperties(physical_device_, nullptr, &num_device_extensions, nullptr);
+    Vec<VkExtensionProperties> device_extensions(num_device_extensions);
+    vkEnumerateDeviceExtensionProperties(physical_device_, nullptr, &num_device_extensions, device_extensions.data());
+    auto extension_supported = [&device_extensions](const char *name) {
+        return std::any_of(device_extensions.begin(), device_extensions.end(),
+            [name](const VkExtensionProperties &extension) {
+                return std::strcmp(extension.extensionName, name) == 0;
+            });
+    };
+#if BISMUTH_VULKAN_VERSION_MINOR < 2
+    // bindless is disabled if the extension is absent
+    const bool descriptor_indexing_supported = desc.enable_bindless
+        && extension_supported(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+    if (descriptor_indexing_supported) {
+        enabled_device_extensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+    }
+#endif
+    const bool push_descriptor_supported = extension_supported(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+    if (push_descriptor_supported) {
+        enabled_device_extensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+
+        VkPhysicalDevicePushDescriptorPropertiesKHR push_descriptor_props {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PUSH_DESCRIPTOR_PROPERTIES_KHR,
+            .pNext = nullptr,
+        };
+        VkPhysicalDeviceProperties2 props {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+            .pNext = &push_descriptor_props,
+        };
+        vkGetPhysicalDeviceProperties2(physical_device_, &props);
+        max_push_descriptors_ = push_descriptor_props.maxPushDescriptors;
+    }
+
     VkPhysicalDeviceFeatures2 device_features {
         .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
         .pNext = nullptr,
@@ -244,9 +313,28 @@ void DeviceVulkan::PickDevice(const DeviceDesc &desc) {
         .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR,
     };
     ConnectVkPNextChain(&device_features, &dynamic_rendering_features);
+#endif
+#if BISMUTH_VULKAN_VERSION_MINOR < 2
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptor_indexing_features {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT,
+    };
+    if (descriptor_indexing_supported) {
+        ConnectVkPNextChain(&device_features, &descriptor_indexing_features);
+    }
+#else
+    const bool descriptor_indexing_supported = true;
+    const auto &descriptor_indexing_features = vk12_features;
 #endif
     vkGetPhysicalDeviceFeatures2(physical_device_, &device_features);
 
+    const bool bindless_supported = descriptor_indexing_supported
+        && descriptor_indexing_features.runtimeDescriptorArray
+        && descriptor_indexing_features.descriptorBindingPartiallyBound
+        && descriptor_indexing_features.descriptorBindingUpdateUnusedWhilePending
+        && descriptor_indexing_features.descriptorBindingSampledImageUpdateAfterBind
+        && descriptor_indexing_features.descriptorBindingStorageImageUpdateAfterBind
+        && descriptor_indexing_features.descriptorBindingStorageBufferUpdateAfterBind;
+
     VkDeviceCreateInfo device_ci {
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
         .pNext = nullptr,
@@ -263,6 +351,8 @@ void DeviceVulkan::PickDevice(const DeviceDesc &desc) {
 
     vkCreateDevice(physical_device_, &device_ci, nullptr, &device_);
     volkLoadDevice(device_);
+
+    return bindless_supported;
 }
 
 void DeviceVulkan::InitializeAllocator() {
@@ -306,7 +396,7 @@ void DeviceVulkan::InitializeAllocator() {
 }
 
 Ptr<Queue> DeviceVulkan::GetQueue(QueueType type) {
-    return Ptr<QueueVulkan>::Make(RefThis(), queue_family_indices[static_cast<uint8_t>(type)]);
+    return Ptr<QueueVulkan>::Make(RefThis(), type, queue_family_indices[static_cast<uint8_t>(type)]);
 }
 
 Ptr<SwapChain> DeviceVulkan::CreateSwapChain(const SwapChainDesc &desc) {
@@ -321,6 +411,10 @@ Ptr<Semaphore> DeviceVulkan::CreateSemaphore() {
     return Ptr<SemaphoreVulkan>::Make(RefThis());
 }
 
+Ptr<QuerySet> DeviceVulkan::CreateQuerySet(const QuerySetDesc &desc) {
+    return Ptr<QuerySetVulkan>::Make(RefThis(), desc);
+}
+
 Ptr<Buffer> DeviceVulkan::CreateBuffer(const BufferDesc &desc) {
     return Ptr<BufferVulkan>::Make(RefThis(), desc);
 }
@@ -329,12 +423,32 @@ Ptr<Texture> DeviceVulkan::CreateTexture(const TextureDesc &desc) {
     return Ptr<TextureVulkan>::Make(RefThis(), desc);
 }
 
+ResourceMemoryRequirements DeviceVulkan::GetBufferMemoryRequirements(const BufferDesc &desc) {
+    return BufferVulkan::GetMemoryRequirements(RefThis(), desc);
+}
+
+ResourceMemoryRequirements DeviceVulkan::GetTextureMemoryRequirements(const TextureDesc &desc) {
+    return TextureVulkan::GetMemoryRequirements(RefThis(), desc);
+}
+
+Ptr<MemoryHeap> DeviceVulkan::CreateMemoryHeap(const MemoryHeapDesc &desc) {
+    return Ptr<MemoryHeapVulkan>::Make(RefThis(), desc);
+}
+
+Ptr<Buffer> DeviceVulkan::CreatePlacedBuffer(const BufferDesc &desc, Ref<MemoryHeap> heap, uint64_t offset) {
+    return Ptr<BufferVulkan>::Make(RefThis(), desc, heap.CastTo<MemoryHeapVulkan>(), offset);
+}
+
+Ptr<Texture> DeviceVulkan::CreatePlacedTexture(const TextureDesc &desc, Ref<MemoryHeap> heap, uint64_t offset) {
+    return Ptr<TextureVulkan>::Make(RefThis(), desc, heap.CastTo<MemoryHeapVulkan>(), offset);
+}
+
 Ptr<Sampler> DeviceVulkan::CreateSampler(const SamplerDesc &desc) {
     return Ptr<SamplerVulkan>::Make(RefThis(), desc);
 }
 
-Ptr<ShaderModule> DeviceVulkan::CreateShaderModule(const Vec<uint8_t> &src_bytes) {
-    return Ptr<ShaderModuleVulkan>::Make(RefThis(), src_bytes);
+Ptr<ShaderModule> DeviceVulkan::CreateShaderModule(Span<uint8_t> src_bytes, const ShaderReflection *reflection) {
+    return Ptr<ShaderModuleVulkan>::Make(RefThis(), src_bytes, reflection);
 }
 
 Ref<ShaderCompiler> DeviceVulkan::GetShaderCompiler() const {
@@ -353,6 +467,10 @@ Ptr<FrameContext> DeviceVulkan::CreateFrameContext() {
     return Ptr<FrameContextVulkan>::Make(RefThis());
 }
 
+PipelineCacheStats DeviceVulkan::GetPipelineCacheStats() const {
+    return pipeline_cache_->Stats();
+}
+
 BISMUTH_GFX_NAMESPACE_END
 
 BISMUTH_NAMESPACE_END
@@ -26,13 +26,24 @@ public:
 
     Ptr<Semaphore> CreateSemaphore() override;
 
+    Ptr<QuerySet> CreateQuerySet(const QuerySetDesc &desc) override;
+
     Ptr<Buffer> CreateBuffer(const BufferDesc &desc) override;
 
     Ptr<Texture> CreateTexture(const TextureDesc &desc) override;
 
+    ResourceMemoryRequirements GetBufferMemoryRequirements(const BufferDesc &desc) override;
+    ResourceMemoryRequirements GetTextureMemoryRequirements(const TextureDesc &desc) override;
+
+    Ptr<MemoryHeap> CreateMemoryHeap(const MemoryHeapDesc &desc) override;
+
+    Ptr<Buffer> CreatePlacedBuffer(const BufferDesc &desc, Ref<MemoryHeap> heap, uint64_t offset) override;
+    Ptr<Texture> CreatePlacedTexture(const TextureDesc &desc, Ref<MemoryHeap> heap, uint64_t offset) override;
+
     Ptr<Sampler> CreateSampler(const SamplerDesc &desc) override;
 
-    Ptr<ShaderModule> CreateShaderModule(const Vec<uint8_t> &src_bytes) override;
+    Ptr<ShaderModule> CreateShaderModule(Span<uint8_t> src_bytes,
+        const ShaderReflection *reflection = nullptr) override;
 
     Ref<ShaderCompiler> GetShaderCompiler() const override;
 
@@ -42,16 +53,36 @@ public:
 
     Ptr<FrameContext> CreateFrameContext() override;
 
+    bool BindlessEnabled() const override { return bindless_set_.IsInitialized(); }
+
+    bool SpecializationConstantsSupported() const override { return true; }
+
+    PipelineCacheStats GetPipelineCacheStats() const override;
+
+    // null if bindless is disabled
+    class BindlessDescriptorSetVulkan *BindlessSet() const { return bindless_set_.Get(); }
+
+    class PipelineCacheVulkan *PipelineCache() const { return pipeline_cache_.Get(); }
+
+    class PipelineObjectCacheVulkan *PipelineObjectCache() const { return pipeline_object_cache_.Get(); }
+
     VkDevice Raw() const { return device_; }
     VkPhysicalDevice RawPhysicalDevice() const { return physical_device_; }
+    const VkPhysicalDeviceProperties &RawPhysicalDeviceProperties() const { return physical_device_props_; }
 
     VmaAllocator Allocator() const { return allocator_; }
 
+    // 0 if VK_KHR_push_descriptor is not supported
+    uint32_t MaxPushDescriptors() const { return max_push_descriptors_; }
+
+    uint32_t QueueFamilyIndex(QueueType type) const { return queue_family_indices[static_cast<uint8_t>(type)]; }
+
     VkSurfaceKHR RawSurface() const { return surface_; }
     VkFormat RawSurfaceFormat() const { return surface_format_; }
 
 private:
-    void PickDevice(const DeviceDesc &desc);
+    // return whether bindless can be enabled
+    bool PickDevice(const DeviceDesc &desc);
     void InitializeAllocator();
 
     VkInstance instance_ = VK_NULL_HANDLE;
@@ -60,6 +91,8 @@ private:
     VkDevice device_ = VK_NULL_HANDLE;
     VmaAllocator allocator_;
 
+    uint32_t max_push_descriptors_ = 0;
+
     VkDebugUtilsMessengerEXT debug_utils_messenger_ = VK_NULL_HANDLE;
 
     uint32_t queue_family_indices[3];
@@ -68,6 +101,11 @@ private:
     VkFormat surface_format_ = VK_FORMAT_B8G8R8A8_SRGB;
 
     Ptr<class ShaderCompilerVulkan> shader_compiler_;
+
+    Ptr<class BindlessDescriptorSetVulkan> bindless_set_;
+
+    Ptr<class PipelineCacheVulkan> pipeline_cache_;
+    Ptr<class PipelineObjectCacheVulkan> pipeline_object_cache_;
 };
 
 BISMUTH_GFX_NAMESPACE_END
@@ -1,6 +1,12 @@
 #include "pipeline.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+
 #include "device.hpp"
+#include "descriptor.hpp"
+#include "pipeline_cache.hpp"
 #include "utils.hpp"
 
 BISMUTH_NAMESPACE_BEGIN
@@ -9,6 +15,59 @@ BISMUTH_GFX_NAMESPACE_BEGIN
 
 namespace {
 
+template <typename PipelineCreateInfo>
+void CreatePipeline(DeviceVulkan *device, PipelineCreateInfo &pipeline_ci, VkPipeline &pipeline) {
+    auto pipeline_cache = device->PipelineCache();
+
+#if BISMUTH_VULKAN_VERSION_MINOR >= 3
+    VkPipelineCreationFeedback creation_feedback {};
+    VkPipelineCreationFeedbackCreateInfo creation_feedback_ci {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO,
+        .pNext = nullptr,
+        .pPipelineCreationFeedback = &creation_feedback,
+        .pipelineStageCreationFeedbackCount = 0,
+        .pPipelineStageCreationFeedbacks = nullptr,
+    };
+    ConnectVkPNextChain(&pipeline_ci, &creation_feedback_ci);
+#endif
+
+    const auto start = std::chrono::steady_clock::now();
+    if constexpr (std::is_same_v<PipelineCreateInfo, VkGraphicsPipelineCreateInfo>) {
+        vkCreateGraphicsPipelines(device->Raw(), pipeline_cache->Raw(), 1, &pipeline_ci, nullptr, &pipeline);
+    } else {
+        vkCreateComputePipelines(device->Raw(), pipeline_cache->Raw(), 1, &pipeline_ci, nullptr, &pipeline);
+    }
+    const auto duration = std::chrono::steady_clock::now() - start;
+
+#if BISMUTH_VULKAN_VERSION_MINOR >= 3
+    const bool cache_hit = (creation_feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT)
+        && (creation_feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT);
+#else
+    const bool cache_hit = false;
+#endif
+    pipeline_cache->RecordCreation(duration, cache_hit);
+}
+
+// data points to 'constants' directly, constants that a stage doesn't declare are ignored by that stage
+VkSpecializationInfo ToVkSpecializationInfo(const Vec<SpecializationConstant> &constants,
+    Vec<VkSpecializationMapEntry> &map_entries) {
+    map_entries.resize(constants.size());
+    for (size_t i = 0; i < constants.size(); i++) {
+        const size_t offset = i * sizeof(SpecializationConstant) + offsetof(SpecializationConstant, value);
+        map_entries[i] = VkSpecializationMapEntry {
+            .constantID = constants[i].id,
+            .offset = static_cast<uint32_t>(offset),
+            .size = sizeof(uint32_t),
+        };
+    }
+    return VkSpecializationInfo {
+        .mapEntryCount = static_cast<uint32_t>(map_entries.size()),
+        .pMapEntries = map_entries.data(),
+        .dataSize = constants.size() * sizeof(SpecializationConstant),
+        .pData = constants.data(),
+    };
+}
+
 VkDescriptorType ToVkDescriptorType(DescriptorType type) {
     switch (type) {
         case DescriptorType::eNone:
@@ -29,67 +88,25 @@ VkDescriptorType ToVkDescriptorType(DescriptorType type) {
     Unreachable();
 }
 
-void CreateLayout(const PipelineLayout &rhi_layout, VkShaderStageFlags stage, VkDevice device,
-    Vec<VkDescriptorSetLayout> &set_layouts, VkPipelineLayout &pipeline_layout) {
-    set_layouts.resize(rhi_layout.sets_layout.size());
-    for (size_t set = 0; set < set_layouts.size(); set++) {
-        const auto &rhi_bindings = rhi_layout.sets_layout[set];
-        Vec<VkDescriptorSetLayoutBinding> bindings_info;
-        bindings_info.reserve(rhi_bindings.bindings.size());
-        uint32_t num_immutable_samplers = 0;
-        for (const auto &rhi_binding : rhi_bindings.bindings) {
-            num_immutable_samplers += rhi_binding.immutable_samplers.Size();
-        }
-        Vec<VkSampler> immutable_samplers(num_immutable_samplers, VK_NULL_HANDLE);
-        VkSampler *p_immutable_sampler = immutable_samplers.data();
+// larger sets are cached in frame context rather than pushed on every bind
+constexpr uint32_t kMaxPushDescriptors = 16;
 
-        for (size_t binding = 0; binding < rhi_bindings.bindings.size(); binding++) {
-            const auto &rhi_binding = rhi_bindings.bindings[binding];
-            if (rhi_binding.type == DescriptorType::eNone) {
-                continue;
-            }
-            VkDescriptorSetLayoutBinding binding_info {
-                .binding = static_cast<uint32_t>(binding),
-                .descriptorType = ToVkDescriptorType(rhi_binding.type),
-                .descriptorCount = rhi_binding.count,
-                .stageFlags = stage,
-                .pImmutableSamplers = nullptr,
-            };
-            if (!rhi_binding.immutable_samplers.Empty()) {
-                binding_info.pImmutableSamplers = p_immutable_sampler;
-                for (const auto &sampler : rhi_binding.immutable_samplers) {
-                    *p_immutable_sampler = sampler.CastTo<SamplerVulkan>()->Raw();
-                    ++p_immutable_sampler;
-                }
-            }
-            bindings_info.push_back(binding_info);
+uint32_t ChoosePushDescriptorSet(const PipelineLayout &rhi_layout, uint32_t max_push_descriptors) {
+    max_push_descriptors = std::min(max_push_descriptors, kMaxPushDescriptors);
+    // sets with larger indices are usually updated more frequently
+    for (size_t set = rhi_layout.sets_layout.size(); set-- > 0;) {
+        if (set == rhi_layout.bindless_set) {
+            continue;
+        }
+        uint32_t num_descriptors = 0;
+        for (const auto &binding : rhi_layout.sets_layout[set].bindings) {
+            num_descriptors += binding.type == DescriptorType::eNone ? 0 : binding.count;
+        }
+        if (NumWrittenDescriptors(rhi_layout.sets_layout[set]) > 0 && num_descriptors <= max_push_descriptors) {
+            return static_cast<uint32_t>(set);
         }
-
-        VkDescriptorSetLayoutCreateInfo set_layout_ci {
-            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .bindingCount = static_cast<uint32_t>(bindings_info.size()),
-            .pBindings = bindings_info.data(),
-        };
-        vkCreateDescriptorSetLayout(device, &set_layout_ci, nullptr, &set_layouts[set]);
     }
-
-    VkPushConstantRange push_constant {
-        .stageFlags = stage,
-        .offset = 0,
-        .size = rhi_layout.push_constants_size,
-    };
-    VkPipelineLayoutCreateInfo pipeline_layout_ci {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-        .pNext = nullptr,
-        .flags = 0,
-        .setLayoutCount = static_cast<uint32_t>(set_layouts.size()),
-        .pSetLayouts = set_layouts.data(),
-        .pushConstantRangeCount = rhi_layout.push_constants_size > 0 ? 1u : 0u,
-        .pPushConstantRanges = rhi_layout.push_constants_size > 0 ? &push_constant : nullptr,
-    };
-    vkCreatePipelineLayout(device, &pipeline_layout_ci, nullptr, &pipeline_layout);
+    return kNoPushDescriptorSet;
 }
 
 VkPrimitiveTopology ToVkPrimitiveTopology(PrimitiveTopology topo) {
@@ -170,6 +187,131 @@ VkColorComponentFlags ToVkColorWriteMask(BitFlags<ColorWriteComponent> mask) {
 
 }
 
+DescriptorSetLayoutVulkan::DescriptorSetLayoutVulkan(Ref<DeviceVulkan> device, const DescriptorSetLayout &layout,
+    VkShaderStageFlags stages, bool push) : device_(device) {
+    Vec<VkDescriptorSetLayoutBinding> bindings_info;
+    bindings_info.reserve(layout.bindings.size());
+    uint32_t num_immutable_samplers = 0;
+    for (const auto &rhi_binding : layout.bindings) {
+        num_immutable_samplers += rhi_binding.immutable_samplers.size();
+    }
+    Vec<VkSampler> immutable_samplers(num_immutable_samplers, VK_NULL_HANDLE);
+    VkSampler *p_immutable_sampler = immutable_samplers.data();
+
+    for (size_t binding = 0; binding < layout.bindings.size(); binding++) {
+        const auto &rhi_binding = layout.bindings[binding];
+        if (rhi_binding.type == DescriptorType::eNone) {
+            continue;
+        }
+        VkDescriptorSetLayoutBinding binding_info {
+            .binding = static_cast<uint32_t>(binding),
+            .descriptorType = ToVkDescriptorType(rhi_binding.type),
+            .descriptorCount = rhi_binding.count,
+            .stageFlags = stages,
+            .pImmutableSamplers = nullptr,
+        };
+        if (!rhi_binding.immutable_samplers.empty()) {
+            binding_info.pImmutableSamplers = p_immutable_sampler;
+            for (const auto &sampler : rhi_binding.immutable_samplers) {
+                *p_immutable_sampler = sampler.CastTo<SamplerVulkan>()->Raw();
+                ++p_immutable_sampler;
+            }
+        }
+        bindings_info.push_back(binding_info);
+    }
+
+    VkDescriptorSetLayoutCreateInfo set_layout_ci {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = push ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR : 0u,
+        .bindingCount = static_cast<uint32_t>(bindings_info.size()),
+        .pBindings = bindings_info.data(),
+    };
+    vkCreateDescriptorSetLayout(device_->Raw(), &set_layout_ci, nullptr, &set_layout_);
+}
+
+DescriptorSetLayoutVulkan::~DescriptorSetLayoutVulkan() {
+    vkDestroyDescriptorSetLayout(device_->Raw(), set_layout_, nullptr);
+}
+
+PipelineLayoutVulkan::PipelineLayoutVulkan(Ref<DeviceVulkan> device, const PipelineLayout &layout,
+    VkShaderStageFlags stages) : device_(device) {
+    static const DescriptorSetLayout kEmptySetLayout {};
+
+    const auto bindless_set = device->BindlessSet();
+    push_descriptor_set_ = ChoosePushDescriptorSet(layout, device->MaxPushDescriptors());
+
+    size_t num_sets = layout.sets_layout.size();
+    if (layout.bindless_set != kNoBindlessSet) {
+        BI_ASSERT_MSG(bindless_set, "Pipeline layout uses bindless set but bindless is not enabled");
+        num_sets = std::max<size_t>(num_sets, layout.bindless_set + 1);
+    }
+    set_layouts_.resize(num_sets);
+    raw_set_layouts_.resize(num_sets);
+    for (size_t set = 0; set < num_sets; set++) {
+        if (set == layout.bindless_set) {
+            raw_set_layouts_[set] = bindless_set->RawLayout();
+            continue;
+        }
+        // sets skipped before bindless set are empty
+        const auto &set_layout = set < layout.sets_layout.size() ? layout.sets_layout[set] : kEmptySetLayout;
+        set_layouts_[set] = device->PipelineObjectCache()->GetSetLayout(set_layout, stages,
+            set == push_descriptor_set_);
+        raw_set_layouts_[set] = set_layouts_[set]->Raw();
+    }
+
+    VkPushConstantRange push_constant {
+        .stageFlags = stages,
+        .offset = 0,
+        .size = layout.push_constants_size,
+    };
+    VkPipelineLayoutCreateInfo pipeline_layout_ci {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .setLayoutCount = static_cast<uint32_t>(raw_set_layouts_.size()),
+        .pSetLayouts = raw_set_layouts_.data(),
+        .pushConstantRangeCount = layout.push_constants_size > 0 ? 1u : 0u,
+        .pPushConstantRanges = layout.push_constants_size > 0 ? &push_constant : nullptr,
+    };
+    vkCreatePipelineLayout(device->Raw(), &pipeline_layout_ci, nullptr, &pipeline_layout_);
+
+    const VkPipelineBindPoint bind_point = (stages & VK_SHADER_STAGE_COMPUTE_BIT) != 0
+        ? VK_PIPELINE_BIND_POINT_COMPUTE : VK_PIPELINE_BIND_POINT_GRAPHICS;
+    update_templates_.resize(num_sets);
+    for (size_t set = 0; set < layout.sets_layout.size(); set++) {
+        if (set != layout.bindless_set && NumWrittenDescriptors(layout.sets_layout[set]) > 0) {
+            update_templates_[set] = Ptr<DescriptorUpdateTemplateVulkan>::Make(device, layout.sets_layout[set],
+                raw_set_layouts_[set], set == push_descriptor_set_, bind_point, pipeline_layout_,
+                static_cast<uint32_t>(set));
+        }
+    }
+}
+
+PipelineLayoutVulkan::~PipelineLayoutVulkan() {
+    // template of push descriptor set refers to pipeline layout
+    update_templates_.clear();
+    vkDestroyPipelineLayout(device_->Raw(), pipeline_layout_, nullptr);
+}
+
+SharedPipelineVulkan::~SharedPipelineVulkan() {
+    vkDestroyPipeline(device_->Raw(), pipeline_, nullptr);
+}
+
+Rc<DescriptorSetLayoutVulkan> PipelineObjectCacheVulkan::GetSetLayout(const DescriptorSetLayout &layout,
+    VkShaderStageFlags stages, bool push) {
+    return set_layouts_.GetOrCreate(std::make_pair(layout, std::make_pair(stages, push)), [&]() {
+        return std::make_shared<DescriptorSetLayoutVulkan>(device_, layout, stages, push);
+    });
+}
+
+Rc<PipelineLayoutVulkan> PipelineObjectCacheVulkan::GetPipelineLayout(const PipelineLayout &layout,
+    VkShaderStageFlags stages) {
+    return pipeline_layouts_.GetOrCreate(std::make_pair(layout, stages), [&]() {
+        return std::make_shared<PipelineLayoutVulkan>(device_, layout, stages);
+    });
+}
+
 RenderPipelineVulkan::RenderPipelineVulkan(Ref<DeviceVulkan> device, const RenderPipelineDesc &desc)
     : device_(device), desc_(desc) {
 
@@ -184,26 +326,65 @@ RenderPipelineVulkan::RenderPipelineVulkan(Ref<DeviceVulkan> device, const Rende
         stages_flag |= VK_SHADER_STAGE_GEOMETRY_BIT;
     }
 
-    CreateLayout(desc.layout, stages_flag, device->Raw(), set_layouts_, pipeline_layout_);
-    pipeline_ = VK_NULL_HANDLE;
-}
+    layout_ = device->PipelineObjectCache()->GetPipelineLayout(desc.layout, stages_flag);
 
-void RenderPipelineVulkan::SetTargetFormats(Span<ResourceFormat> color_formats, ResourceFormat depth_stencil_format) {
-    bool need_to_rebuild = pipeline_ == VK_NULL_HANDLE;
+    if (HasTargetFormats(desc_)) {
+        Vec<ResourceFormat> color_formats(desc_.color_target_state.attachments.size());
+        for (size_t i = 0; i < color_formats.size(); i++) {
+            color_formats[i] = desc_.color_target_state.attachments[i].format;
+        }
+        RawPipeline(color_formats, desc_.depth_stencil_state.format);
+    }
+}
 
-    for (size_t i = 0; i < std::min(color_formats.Size(), desc_.color_target_state.attachments.size()); i++) {
-        need_to_rebuild |= desc_.color_target_state.attachments[i].format != color_formats[i];
-        desc_.color_target_state.attachments[i].format = color_formats[i];
+VkPipeline RenderPipelineVulkan::RawPipeline(Span<ResourceFormat> color_formats,
+    ResourceFormat depth_stencil_format) {
+    // formats of attachments beyond those in desc are ignored
+    const size_t num_colors = std::min(color_formats.Size(), desc_.color_target_state.attachments.size());
+    auto find_variant = [&]() -> const FormatVariant * {
+        for (const auto &variant : variants_) {
+            if (variant.depth_stencil_format == depth_stencil_format
+                && std::equal(variant.color_formats.begin(), variant.color_formats.end(),
+                    color_formats.begin(), color_formats.begin() + num_colors)) {
+                return &variant;
+            }
+        }
+        return nullptr;
+    };
+    {
+        std::lock_guard lock(variants_mutex_);
+        if (const auto variant = find_variant(); variant) {
+            return variant->pipeline->Raw();
+        }
     }
-    need_to_rebuild |= desc_.depth_stencil_state.format != depth_stencil_format;
-    desc_.depth_stencil_state.format = depth_stencil_format;
 
-    if (!need_to_rebuild) {
-        return;
+    // pipelines with the same desc and target formats share the same VkPipeline
+    auto key = desc_;
+    for (size_t i = 0; i < num_colors; i++) {
+        key.color_target_state.attachments[i].format = color_formats[i];
     }
-    if (pipeline_ != VK_NULL_HANDLE) {
-        vkDestroyPipeline(device_->Raw(), pipeline_, nullptr);
+    key.depth_stencil_state.format = depth_stencil_format;
+    auto pipeline = device_->PipelineObjectCache()->GetRenderPipeline(key, [&]() {
+        return std::make_shared<SharedPipelineVulkan>(device_,
+            CreateRawPipeline(Span<ResourceFormat>(color_formats.Data(), num_colors), depth_stencil_format));
+    });
+
+    std::lock_guard lock(variants_mutex_);
+    if (const auto variant = find_variant(); variant) {
+        return variant->pipeline->Raw();
     }
+    variants_.push_back(FormatVariant {
+        .color_formats = Vec<ResourceFormat>(color_formats.begin(), color_formats.begin() + num_colors),
+        .depth_stencil_format = depth_stencil_format,
+        .pipeline = pipeline,
+    });
+    return pipeline->Raw();
+}
+
+VkPipeline RenderPipelineVulkan::CreateRawPipeline(Span<ResourceFormat> color_formats,
+    ResourceFormat depth_stencil_format) const {
+    Vec<VkSpecializationMapEntry> specialization_entries;
+    const auto specialization_info = ToVkSpecializationInfo(desc_.specialization_constants, specialization_entries);
 
     Vec<VkPipelineShaderStageCreateInfo> stages {};
     {
@@ -226,6 +407,11 @@ void RenderPipelineVulkan::SetTargetFormats(Span<ResourceFormat> color_formats,
         auto shader_vk = desc_.shaders.fragment.CastTo<ShaderModuleVulkan>();
         stages.push_back(shader_vk->RawPipelineShaderStage());
     }
+    if (!desc_.specialization_constants.empty()) {
+        for (auto &stage : stages) {
+            stage.pSpecializationInfo = &specialization_info;
+        }
+    }
 
     Vec<VkVertexInputAttributeDescription> vertex_input_attribute_descs;
     Vec<VkVertexInputBindingDescription> vertex_input_binding_descs(desc_.vertex_input_buffers.size());
@@ -400,7 +586,7 @@ void RenderPipelineVulkan::SetTargetFormats(Span<ResourceFormat> color_formats,
         .pDepthStencilState = &depth_stencil_state,
         .pColorBlendState = &color_blend_state,
         .pDynamicState = &dynamic_state,
-        .layout = pipeline_layout_,
+        .layout = layout_->Raw(),
         .renderPass = VK_NULL_HANDLE,
         .subpass = 0,
         .basePipelineHandle = VK_NULL_HANDLE,
@@ -428,65 +614,58 @@ void RenderPipelineVulkan::SetTargetFormats(Span<ResourceFormat> color_formats,
     };
     ConnectVkPNextChain(&pipeline_ci, &pipeline_rendering_ci);
 
-    vkCreateGraphicsPipelines(device_->Raw(), VK_NULL_HANDLE, 1, &pipeline_ci, nullptr, &pipeline_);
+    VkPipeline pipeline;
+    CreatePipeline(device_.Get(), pipeline_ci, pipeline);
 
     if (!desc_.name.empty()) {
         VkDebugUtilsObjectNameInfoEXT name_info {
             .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT,
             .pNext = nullptr,
             .objectType = VK_OBJECT_TYPE_PIPELINE,
-            .objectHandle = reinterpret_cast<uint64_t>(pipeline_),
+            .objectHandle = reinterpret_cast<uint64_t>(pipeline),
             .pObjectName = desc_.name.c_str(),
         };
         vkSetDebugUtilsObjectNameEXT(device_->Raw(), &name_info);
     }
-}
-
-RenderPipelineVulkan::~RenderPipelineVulkan() {
-    if (pipeline_ != VK_NULL_HANDLE) {
-        vkDestroyPipeline(device_->Raw(), pipeline_, nullptr);
-    }
-    for (auto &set_layout : set_layouts_) {
-        vkDestroyDescriptorSetLayout(device_->Raw(), set_layout, nullptr);
-    }
-    vkDestroyPipelineLayout(device_->Raw(), pipeline_layout_, nullptr);
+    return pipeline;
 }
 
 ComputePipelineVulkan::ComputePipelineVulkan(Ref<DeviceVulkan> device, const ComputePipelineDesc &desc)
     : device_(device), desc_(desc) {
-    auto shader_vk = desc.compute.CastTo<ShaderModuleVulkan>();
-
-    CreateLayout(desc.layout, VK_SHADER_STAGE_COMPUTE_BIT, device->Raw(), set_layouts_, pipeline_layout_);
-
-    VkComputePipelineCreateInfo pipeline_ci {
-        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
-        .pNext = nullptr,
-        .flags = 0,
-        .stage = shader_vk->RawPipelineShaderStage(),
-        .layout = pipeline_layout_,
-        .basePipelineHandle = VK_NULL_HANDLE,
-        .basePipelineIndex = 0,
-    };
-    vkCreateComputePipelines(device->Raw(), VK_NULL_HANDLE, 1, &pipeline_ci, nullptr, &pipeline_);
-
-    if (!desc.name.empty()) {
-        VkDebugUtilsObjectNameInfoEXT name_info {
-            .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT,
+    layout_ = device->PipelineObjectCache()->GetPipelineLayout(desc.layout, VK_SHADER_STAGE_COMPUTE_BIT);
+
+    pipeline_ = device->PipelineObjectCache()->GetComputePipeline(desc, [&]() {
+        auto shader_vk = desc.compute.CastTo<ShaderModuleVulkan>();
+        Vec<VkSpecializationMapEntry> specialization_entries;
+        const auto specialization_info =
+            ToVkSpecializationInfo(desc.specialization_constants, specialization_entries);
+        VkComputePipelineCreateInfo pipeline_ci {
+            .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
             .pNext = nullptr,
-            .objectType = VK_OBJECT_TYPE_PIPELINE,
-            .objectHandle = reinterpret_cast<uint64_t>(pipeline_),
-            .pObjectName = desc.name.c_str(),
+            .flags = 0,
+            .stage = shader_vk->RawPipelineShaderStage(),
+            .layout = layout_->Raw(),
+            .basePipelineHandle = VK_NULL_HANDLE,
+            .basePipelineIndex = 0,
         };
-        vkSetDebugUtilsObjectNameEXT(device_->Raw(), &name_info);
-    }
-}
-
-ComputePipelineVulkan::~ComputePipelineVulkan() {
-    vkDestroyPipeline(device_->Raw(), pipeline_, nullptr);
-    for (auto &set_layout : set_layouts_) {
-        vkDestroyDescriptorSetLayout(device_->Raw(), set_layout, nullptr);
-    }
-    vkDestroyPipelineLayout(device_->Raw(), pipeline_layout_, nullptr);
+        if (!desc.specialization_constants.empty()) {
+            pipeline_ci.stage.pSpecializationInfo = &specialization_info;
+        }
+        VkPipeline pipeline;
+        CreatePipeline(device.Get(), pipeline_ci, pipeline);
+
+        if (!desc.name.empty()) {
+            VkDebugUtilsObjectNameInfoEXT name_info {
+                .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT,
+                .pNext = nullptr,
+                .objectType = VK_OBJECT_TYPE_PIPELINE,
+                .objectHandle = reinterpret_cast<uint64_t>(pipeline),
+                .pObjectName = desc.name.c_str(),
+            };
+            vkSetDebugUtilsObjectNameEXT(device->Raw(), &name_info);
+        }
+        return std::make_shared<SharedPipelineVulkan>(device, pipeline);
+    });
 }
 
 BISMUTH_GFX_NAMESPACE_END
@@ -1,48 +1,198 @@
 #pragma once
 
+#include <mutex>
+
 #include "graphics/pipeline.hpp"
 #include "shader.hpp"
+#include "descriptor.hpp"
 
 BISMUTH_NAMESPACE_BEGIN
 
 BISMUTH_GFX_NAMESPACE_BEGIN
 
-class RenderPipelineVulkan final : public RenderPipeline {
+inline constexpr uint32_t kNoPushDescriptorSet = ~0u;
+
+class DescriptorSetLayoutVulkan final {
 public:
-    RenderPipelineVulkan(Ref<class DeviceVulkan> device, const RenderPipelineDesc &desc);
-    ~RenderPipelineVulkan() override;
+    DescriptorSetLayoutVulkan(Ref<class DeviceVulkan> device, const DescriptorSetLayout &layout,
+        VkShaderStageFlags stages, bool push);
+    ~DescriptorSetLayoutVulkan();
 
-    void SetTargetFormats(Span<ResourceFormat> color_formats, ResourceFormat depth_stencil_format);
+    VkDescriptorSetLayout Raw() const { return set_layout_; }
 
-    const RenderPipelineDesc &Desc() const { return desc_; }
+private:
+    Ref<DeviceVulkan> device_;
+    VkDescriptorSetLayout set_layout_;
+};
 
-    VkPipeline RawPipeline() const { return pipeline_; }
+class PipelineLayoutVulkan final {
+public:
+    PipelineLayoutVulkan(Ref<DeviceVulkan> device, const PipelineLayout &layout, VkShaderStageFlags stages);
+    ~PipelineLayoutVulkan();
 
-    VkPipelineLayout RawPipelineLayout() const { return pipeline_layout_; }
+    VkPipelineLayout Raw() const { return pipeline_layout_; }
 
-    VkDescriptorSetLayout RawSetLayout(uint32_t set_index) const { return set_layouts_[set_index]; }
+    VkDescriptorSetLayout RawSetLayout(uint32_t set_index) const { return raw_set_layouts_[set_index]; }
+
+    // null if the set has no descriptor to write
+    const DescriptorUpdateTemplateVulkan *UpdateTemplate(uint32_t set_index) const {
+        return update_templates_[set_index].Get();
+    }
+
+    // set whose descriptors are pushed to command buffer instead of being allocated
+    uint32_t PushDescriptorSet() const { return push_descriptor_set_; }
 
 private:
     Ref<DeviceVulkan> device_;
-    RenderPipelineDesc desc_;
 
-    Vec<VkDescriptorSetLayout> set_layouts_;
+    // null at bindless set, whose layout is owned by device
+    Vec<Rc<DescriptorSetLayoutVulkan>> set_layouts_;
+    Vec<VkDescriptorSetLayout> raw_set_layouts_;
+    Vec<Ptr<DescriptorUpdateTemplateVulkan>> update_templates_;
+    uint32_t push_descriptor_set_ = kNoPushDescriptorSet;
     VkPipelineLayout pipeline_layout_;
+};
+
+class SharedPipelineVulkan final {
+public:
+    SharedPipelineVulkan(Ref<DeviceVulkan> device, VkPipeline pipeline) : device_(device), pipeline_(pipeline) {}
+    ~SharedPipelineVulkan();
+
+    VkPipeline Raw() const { return pipeline_; }
+
+private:
+    Ref<DeviceVulkan> device_;
     VkPipeline pipeline_;
 };
 
+template <typename K, typename V>
+class SharedObjectCache final {
+public:
+    // create() is called without holding lock so that objects of different keys can be created in parallel,
+    // if another thread creates the same object meanwhile, the object created later is discarded
+    template <typename F>
+    Rc<V> GetOrCreate(const K &key, F &&create) {
+        {
+            std::lock_guard lock(mutex_);
+            if (auto it = objects_.find(key); it != objects_.end()) {
+                if (auto object = it->second.lock()) {
+                    return object;
+                }
+            }
+        }
+
+        Rc<V> object = create();
+
+        std::lock_guard lock(mutex_);
+        auto &entry = objects_[key];
+        if (auto existing = entry.lock()) {
+            return existing;
+        }
+        entry = object;
+        if (objects_.size() >= purge_threshold_) {
+            std::erase_if(objects_, [](const auto &item) { return item.second.expired(); });
+            purge_threshold_ = std::max<size_t>(kMinPurgeThreshold, 2 * objects_.size());
+        }
+        return object;
+    }
+
+private:
+    static constexpr size_t kMinPurgeThreshold = 64;
+
+    std::mutex mutex_;
+    // entries of destroyed objects are removed when map grows
+    HashMap<K, std::weak_ptr<V>> objects_;
+    size_t purge_threshold_ = kMinPurgeThreshold;
+};
+
+// objects are shared by all users with equal desc and destroyed when the last user releases them
+class PipelineObjectCacheVulkan final {
+public:
+    PipelineObjectCacheVulkan(Ref<DeviceVulkan> device) : device_(device) {}
+
+    Rc<DescriptorSetLayoutVulkan> GetSetLayout(const DescriptorSetLayout &layout, VkShaderStageFlags stages,
+        bool push);
+
+    Rc<PipelineLayoutVulkan> GetPipelineLayout(const PipelineLayout &layout, VkShaderStageFlags stages);
+
+    template <typename F>
+    Rc<SharedPipelineVulkan> GetRenderPipeline(const RenderPipelineDesc &desc, F &&create) {
+        return render_pipelines_.GetOrCreate(desc, std::forward<F>(create));
+    }
+
+    template <typename F>
+    Rc<SharedPipelineVulkan> GetComputePipeline(const ComputePipelineDesc &desc, F &&create) {
+        return compute_pipelines_.GetOrCreate(desc, std::forward<F>(create));
+    }
+
+private:
+    Ref<DeviceVulkan> device_;
+
+    // keys compare shader modules by content and immutable samplers by unique ids, never by address, so an entry
+    // can't be hit by a new object that reuses the address of a destroyed one, samplers themselves must outlive
+    // pipelines using them since their handles are baked into set layouts
+    SharedObjectCache<std::pair<DescriptorSetLayout, std::pair<VkShaderStageFlags, bool>>,
+        DescriptorSetLayoutVulkan> set_layouts_;
+    SharedObjectCache<std::pair<PipelineLayout, VkShaderStageFlags>, PipelineLayoutVulkan> pipeline_layouts_;
+    SharedObjectCache<RenderPipelineDesc, SharedPipelineVulkan> render_pipelines_;
+    SharedObjectCache<ComputePipelineDesc, SharedPipelineVulkan> compute_pipelines_;
+};
+
+class RenderPipelineVulkan final : public RenderPipeline {
+public:
+    RenderPipelineVulkan(Ref<DeviceVulkan> device, const RenderPipelineDesc &desc);
+
+    const RenderPipelineDesc &Desc() const { return desc_; }
+
+    // pipeline of the target formats, created on first use, encoders on different threads may call it at the same
+    // time, so the desc is never changed
+    VkPipeline RawPipeline(Span<ResourceFormat> color_formats, ResourceFormat depth_stencil_format);
+
+    VkPipelineLayout RawPipelineLayout() const { return layout_->Raw(); }
+
+    VkDescriptorSetLayout RawSetLayout(uint32_t set_index) const { return layout_->RawSetLayout(set_index); }
+
+    const DescriptorUpdateTemplateVulkan *UpdateTemplate(uint32_t set_index) const {
+        return layout_->UpdateTemplate(set_index);
+    }
+
+    uint32_t PushDescriptorSet() const { return layout_->PushDescriptorSet(); }
+
+private:
+    VkPipeline CreateRawPipeline(Span<ResourceFormat> color_formats, ResourceFormat depth_stencil_format) const;
+
+    Ref<DeviceVulkan> device_;
+    RenderPipelineDesc desc_;
+
+    Rc<PipelineLayoutVulkan> layout_;
+
+    struct FormatVariant {
+        Vec<ResourceFormat> color_formats;
+        ResourceFormat depth_stencil_format;
+        Rc<SharedPipelineVulkan> pipeline;
+    };
+    // kept until this pipeline is destroyed since recorded commands may still use them
+    std::mutex variants_mutex_;
+    Vec<FormatVariant> variants_;
+};
+
 class ComputePipelineVulkan final : public ComputePipeline {
 public:
-    ComputePipelineVulkan(Ref<class DeviceVulkan> device, const ComputePipelineDesc &desc);
-    ~ComputePipelineVulkan() override;
+    ComputePipelineVulkan(Ref<DeviceVulkan> device, const ComputePipelineDesc &desc);
 
     const ComputePipelineDesc &Desc() const { return desc_; }
 
-    VkPipeline RawPipeline() const { return pipeline_; }
+    VkPipeline RawPipeline() const { return pipeline_->Raw(); }
+
+    VkPipelineLayout RawPipelineLayout() const { return layout_->Raw(); }
 
-    VkPipelineLayout RawPipelineLayout() const { return pipeline_layout_; }
+    VkDescriptorSetLayout RawSetLayout(uint32_t set_index) const { return layout_->RawSetLayout(set_index); }
 
-    VkDescriptorSetLayout RawSetLayout(uint32_t set_index) const { return set_layouts_[set_index]; }
+    const DescriptorUpdateTemplateVulkan *UpdateTemplate(uint32_t set_index) const {
+        return layout_->UpdateTemplate(set_index);
+    }
+
+    uint32_t PushDescriptorSet() const { return layout_->PushDescriptorSet(); }
 
     uint32_t LocalSizeX() const { return desc_.thread_group.x; }
     uint32_t LocalSizeY() const { return desc_.thread_group.y; }
@@ -52,9 +202,8 @@ private:
     Ref<DeviceVulkan> device_;
     ComputePipelineDesc desc_;
 
-    Vec<VkDescriptorSetLayout> set_layouts_;
-    VkPipelineLayout pipeline_layout_;
-    VkPipeline pipeline_;
+    Rc<PipelineLayoutVulkan> layout_;
+    Rc<SharedPipelineVulkan> pipeline_;
 };
 
 BISMUTH_GFX_NAMESPACE_END
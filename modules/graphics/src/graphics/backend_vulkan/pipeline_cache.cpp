@@ -0,0 +1,144 @@
+#include "pipeline_cache.hpp"
+
+#include <cstring>
+#include <fstream>
+
+#include <core/module_manager.hpp>
+
+#include "device.hpp"
+
+BISMUTH_NAMESPACE_BEGIN
+
+BISMUTH_GFX_NAMESPACE_BEGIN
+
+namespace {
+
+// layout of VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+struct PipelineCacheHeader {
+    uint32_t header_size;
+    uint32_t header_version;
+    uint32_t vendor_id;
+    uint32_t device_id;
+    uint8_t cache_uuid[VK_UUID_SIZE];
+};
+
+bool IsCacheDataCompatible(const Vec<uint8_t> &data, const VkPhysicalDeviceProperties &props) {
+    PipelineCacheHeader header;
+    if (data.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    return header.header_size >= sizeof(header)
+        && header.header_version == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+        && header.vendor_id == props.vendorID
+        && header.device_id == props.deviceID
+        && std::memcmp(header.cache_uuid, props.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+double ToMilliseconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+}
+
+PipelineCacheVulkan::PipelineCacheVulkan(Ref<DeviceVulkan> device, const std::filesystem::path &path)
+    : device_(device), path_(path) {
+    const auto start = std::chrono::steady_clock::now();
+
+    Vec<uint8_t> data;
+    if (!path_.empty() && std::filesystem::exists(path_)) {
+        std::ifstream fin(path_, std::ios::binary);
+        fin.seekg(0, std::ios::end);
+        size_t length = fin.tellg();
+        fin.seekg(0, std::ios::beg);
+        data.resize(length);
+        fin.read(reinterpret_cast<char *>(data.data()), length);
+
+        if (!IsCacheDataCompatible(data, device_->RawPhysicalDeviceProperties())) {
+            BI_WARN(ModuleManager::Get<GraphicsModule>()->Lgr(),
+                "Pipeline cache '{}' is created by another device or driver, discarded", path_.string());
+            data.clear();
+        }
+    }
+
+    VkPipelineCacheCreateInfo cache_ci {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .initialDataSize = data.size(),
+        .pInitialData = data.empty() ? nullptr : data.data(),
+    };
+    vkCreatePipelineCache(device_->Raw(), &cache_ci, nullptr, &cache_);
+
+    stats_.loaded_size = data.size();
+    stats_.load_time_ms = ToMilliseconds(std::chrono::steady_clock::now() - start);
+    if (!data.empty()) {
+        BI_INFO(ModuleManager::Get<GraphicsModule>()->Lgr(), "Load pipeline cache '{}': {} bytes in {:.2f} ms",
+            path_.string(), stats_.loaded_size, stats_.load_time_ms);
+    }
+}
+
+PipelineCacheVulkan::~PipelineCacheVulkan() {
+    Save();
+    vkDestroyPipelineCache(device_->Raw(), cache_, nullptr);
+}
+
+void PipelineCacheVulkan::Save() {
+    if (path_.empty()) {
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    size_t size = 0;
+    vkGetPipelineCacheData(device_->Raw(), cache_, &size, nullptr);
+    Vec<uint8_t> data(size);
+    vkGetPipelineCacheData(device_->Raw(), cache_, &size, data.data());
+
+    // write to a temporary file first so that other processes never read a partially written cache
+    const auto temp_path = UniqueTempPath(path_);
+    std::error_code error;
+    {
+        std::ofstream fout(temp_path, std::ios::binary);
+        fout.write(reinterpret_cast<const char *>(data.data()), size);
+        const bool written = static_cast<bool>(fout);
+        fout.close();
+        if (!written || !fout) {
+            BI_WARN(ModuleManager::Get<GraphicsModule>()->Lgr(), "Failed to write pipeline cache '{}'",
+                temp_path.string());
+            std::filesystem::remove(temp_path, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temp_path, path_, error);
+    if (error) {
+        BI_WARN(ModuleManager::Get<GraphicsModule>()->Lgr(), "Failed to save pipeline cache '{}': {}",
+            path_.string(), error.message());
+        std::filesystem::remove(temp_path, error);
+        return;
+    }
+
+    std::lock_guard lock(mutex_);
+    stats_.saved_size = size;
+    stats_.save_time_ms = ToMilliseconds(std::chrono::steady_clock::now() - start);
+    BI_INFO(ModuleManager::Get<GraphicsModule>()->Lgr(),
+        "Save pipeline cache '{}': {} bytes in {:.2f} ms, {}/{} pipelines hit cache, creation takes {:.2f} ms",
+        path_.string(), stats_.saved_size, stats_.save_time_ms, stats_.num_cache_hits,
+        stats_.num_created_pipelines, stats_.creation_time_ms);
+}
+
+void PipelineCacheVulkan::RecordCreation(std::chrono::steady_clock::duration duration, bool cache_hit) {
+    std::lock_guard lock(mutex_);
+    ++stats_.num_created_pipelines;
+    stats_.num_cache_hits += cache_hit ? 1 : 0;
+    stats_.creation_time_ms += ToMilliseconds(duration);
+}
+
+PipelineCacheStats PipelineCacheVulkan::Stats() const {
+    std::lock_guard lock(mutex_);
+    return stats_;
+}
+
+BISMUTH_GFX_NAMESPACE_END
+
+BISMUTH_NAMESPACE_END
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+
+#include <volk.h>
+
+#include "core/ptr.hpp"
+#include "graphics/pipeline.hpp"
+
+BISMUTH_NAMESPACE_BEGIN
+
+BISMUTH_GFX_NAMESPACE_BEGIN
+
+class PipelineCacheVulkan {
+public:
+    // load cache data from file if it exists and is created by the same device and driver,
+    // cache is only kept in memory if path is empty
+    PipelineCacheVulkan(Ref<class DeviceVulkan> device, const std::filesystem::path &path);
+    // save cache data to file
+    ~PipelineCacheVulkan();
+
+    VkPipelineCache Raw() const { return cache_; }
+
+    void Save();
+
+    void RecordCreation(std::chrono::steady_clock::duration duration, bool cache_hit);
+
+    PipelineCacheStats Stats() const;
+
+private:
+    Ref<DeviceVulkan> device_;
+    VkPipelineCache cache_ = VK_NULL_HANDLE;
+    std::filesystem::path path_;
+
+    mutable std::mutex mutex_;
+    PipelineCacheStats stats_;
+};
+
+BISMUTH_GFX_NAMESPACE_END
+
+BISMUTH_NAMESPACE_END
@@ -0,0 +1,58 @@
+#include "query.hpp"
+
+#include "device.hpp"
+
+BISMUTH_NAMESPACE_BEGIN
+
+BISMUTH_GFX_NAMESPACE_BEGIN
+
+namespace {
+
+VkQueryType ToVkQueryType(QueryType type) {
+    switch (type) {
+        case QueryType::eTimestamp: return VK_QUERY_TYPE_TIMESTAMP;
+    }
+    Unreachable();
+}
+
+}
+
+QuerySetVulkan::QuerySetVulkan(Ref<DeviceVulkan> device, const QuerySetDesc &desc) : device_(device) {
+    desc_ = desc;
+
+    VkQueryPoolCreateInfo query_pool_ci {
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .queryType = ToVkQueryType(desc.type),
+        .queryCount = desc.count,
+        .pipelineStatistics = 0,
+    };
+    vkCreateQueryPool(device_->Raw(), &query_pool_ci, nullptr, &query_pool_);
+
+    if (!desc.name.empty()) {
+        VkDebugUtilsObjectNameInfoEXT name_info {
+            .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT,
+            .pNext = nullptr,
+            .objectType = VK_OBJECT_TYPE_QUERY_POOL,
+            .objectHandle = reinterpret_cast<uint64_t>(query_pool_),
+            .pObjectName = desc.name.c_str(),
+        };
+        vkSetDebugUtilsObjectNameEXT(device_->Raw(), &name_info);
+    }
+}
+
+QuerySetVulkan::~QuerySetVulkan() {
+    vkDestroyQueryPool(device_->Raw(), query_pool_, nullptr);
+}
+
+bool QuerySetVulkan::GetResults(uint32_t first_query, uint32_t num_queries, uint64_t *results) {
+    // results are read from query pool directly, resolving is not needed
+    auto result = vkGetQueryPoolResults(device_->Raw(), query_pool_, first_query, num_queries,
+        num_queries * sizeof(uint64_t), results, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    return result == VK_SUCCESS;
+}
+
+BISMUTH_GFX_NAMESPACE_END
+
+BISMUTH_NAMESPACE_END
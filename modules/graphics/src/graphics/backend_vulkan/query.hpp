@@ -0,0 +1,28 @@
+#pragma once
+
+#include <volk.h>
+
+#include "core/ptr.hpp"
+#include "graphics/query.hpp"
+
+BISMUTH_NAMESPACE_BEGIN
+
+BISMUTH_GFX_NAMESPACE_BEGIN
+
+class QuerySetVulkan final : public QuerySet {
+public:
+    QuerySetVulkan(Ref<class DeviceVulkan> device, const QuerySetDesc &desc);
+    ~QuerySetVulkan() override;
+
+    bool GetResults(uint32_t first_query, uint32_t num_queries, uint64_t *results) override;
+
+    VkQueryPool Raw() const { return query_pool_; }
+
+private:
+    Ref<DeviceVulkan> device_;
+    VkQueryPool query_pool_;
+};
+
+BISMUTH_GFX_NAMESPACE_END
+
+BISMUTH_NAMESPACE_END
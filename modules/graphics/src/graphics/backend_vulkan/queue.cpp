@@ -8,7 +8,8 @@ BISMUTH_NAMESPACE_BEGIN
 
 BISMUTH_GFX_NAMESPACE_BEGIN
 
-QueueVulkan::QueueVulkan(Ref<DeviceVulkan> device, uint32_t family_index) : device_(device) {
+QueueVulkan::QueueVulkan(Ref<DeviceVulkan> device, QueueType type, uint32_t family_index) : device_(device) {
+    type_ = type;
     family_index_ = family_index;
     vkGetDeviceQueue(device_->Raw(), family_index, 0, &queue_);
 }
@@ -16,6 +17,11 @@ QueueVulkan::QueueVulkan(Ref<DeviceVulkan> device, uint32_t family_index) : devi
 QueueVulkan::~QueueVulkan() {
 }
 
+uint64_t QueueVulkan::TimestampFrequency() const {
+    // timestamp period is nanoseconds per tick
+    return static_cast<uint64_t>(1e9 / device_->RawPhysicalDeviceProperties().limits.timestampPeriod);
+}
+
 void QueueVulkan::WaitIdle() const {
     vkQueueWaitIdle(queue_);
 }
@@ -33,7 +39,7 @@ void QueueVulkan::SubmitCommandBuffer(Span<Ptr<CommandBuffer>> &&cmd_buffers, Sp
         wait_semaphores_vk[i] = wait_semaphores[i].CastTo<SemaphoreVulkan>()->Raw();
         wait_stages[i] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
     }
-    Vec<VkSemaphore> signal_semaphores_vk(wait_semaphores.Size());
+    Vec<VkSemaphore> signal_semaphores_vk(signal_semaphores.Size());
     for (size_t i = 0; i < signal_semaphores.Size(); i++) {
         signal_semaphores_vk[i] = signal_semaphores[i].CastTo<SemaphoreVulkan>()->Raw();
     }
@@ -10,9 +10,13 @@ BISMUTH_GFX_NAMESPACE_BEGIN
 
 class QueueVulkan final : public Queue {
 public:
-    QueueVulkan(Ref<class DeviceVulkan> device, uint32_t family_index);
+    QueueVulkan(Ref<class DeviceVulkan> device, QueueType type, uint32_t family_index);
     ~QueueVulkan() override;
 
+    QueueType Type() const override { return type_; }
+
+    uint64_t TimestampFrequency() const override;
+
     void WaitIdle() const override;
 
     void SubmitCommandBuffer(Span<Ptr<CommandBuffer>> &&cmd_buffers, Span<Ref<Semaphore>> wait_semaphores = {},
@@ -25,6 +29,7 @@ public:
 private:
     Ref<DeviceVulkan> device_;
     VkQueue queue_;
+    QueueType type_;
     uint32_t family_index_;
 };
 
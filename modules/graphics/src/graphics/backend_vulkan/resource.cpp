@@ -1,6 +1,7 @@
 #include "resource.hpp"
 
 #include "device.hpp"
+#include "descriptor.hpp"
 #include "utils.hpp"
 
 BISMUTH_NAMESPACE_BEGIN
@@ -75,10 +76,8 @@ VkImageAspectFlags ToVkImageAspect(ResourceFormat format) {
         : (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT);
 }
 
-}
-
-BufferVulkan::BufferVulkan(Ref<DeviceVulkan> device, const BufferDesc &desc) : device_(device), size_(desc.size) {
-    VkBufferCreateInfo buffer_ci {
+VkBufferCreateInfo ToVkBufferCreateInfo(const BufferDesc &desc) {
+    return VkBufferCreateInfo {
         .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
         .pNext = nullptr,
         .flags = 0,
@@ -88,6 +87,61 @@ BufferVulkan::BufferVulkan(Ref<DeviceVulkan> device, const BufferDesc &desc) : d
         .queueFamilyIndexCount = 0,
         .pQueueFamilyIndices = nullptr,
     };
+}
+
+VkImageCreateInfo ToVkImageCreateInfo(const TextureDesc &desc) {
+    return VkImageCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .imageType = ToVkImageType(desc.dim),
+        .format = ToVkFormat(desc.format),
+        .extent = {
+            desc.extent.width,
+            desc.extent.height,
+            desc.dim == TextureDimension::e3D ? desc.extent.depth_or_layers : 1,
+        },
+        .mipLevels = desc.levels,
+        .arrayLayers = desc.dim == TextureDimension::e3D ? 1 : desc.extent.depth_or_layers,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = ToVkImageUsage(desc.usages),
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = 0,
+        .pQueueFamilyIndices = nullptr,
+        .initialLayout = VK_IMAGE_LAYOUT_PREINITIALIZED,
+    };
+}
+
+}
+
+MemoryHeapVulkan::MemoryHeapVulkan(Ref<DeviceVulkan> device, const MemoryHeapDesc &desc) : device_(device) {
+    desc_ = desc;
+
+    VkMemoryRequirements requirements {
+        .size = desc.size,
+        .alignment = desc.alignment,
+        .memoryTypeBits = desc.memory_type_bits,
+    };
+    VmaAllocationCreateInfo allocation_ci {
+        .flags = 0,
+        .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+    };
+    vmaAllocateMemory(device_->Allocator(), &requirements, &allocation_ci, &allocation_, nullptr);
+
+    if (!desc.name.empty()) {
+        vmaSetAllocationName(device_->Allocator(), allocation_, desc.name.c_str());
+    }
+}
+
+MemoryHeapVulkan::~MemoryHeapVulkan() {
+    vmaFreeMemory(device_->Allocator(), allocation_);
+}
+
+BufferVulkan::BufferVulkan(Ref<DeviceVulkan> device, const BufferDesc &desc) : device_(device), size_(desc.size) {
+    desc_ = desc;
+
+    VkBufferCreateInfo buffer_ci = ToVkBufferCreateInfo(desc);
 
     VmaAllocationCreateInfo allocation_ci {
         .flags = desc.persistently_mapped ? VMA_ALLOCATION_CREATE_MAPPED_BIT : 0u,
@@ -99,24 +153,88 @@ BufferVulkan::BufferVulkan(Ref<DeviceVulkan> device, const BufferDesc &desc) : d
     mapped_ptr_ = allocation_info.pMappedData;
     persistently_mapped_ = desc.persistently_mapped;
 
-    if (!desc.name.empty()) {
+    SetDebugName(desc.name);
+    AddToBindlessSet();
+}
+
+BufferVulkan::BufferVulkan(Ref<DeviceVulkan> device, const BufferDesc &desc, Ref<MemoryHeapVulkan> heap,
+    uint64_t offset) : device_(device), size_(desc.size) {
+    desc_ = desc;
+
+    VkBufferCreateInfo buffer_ci = ToVkBufferCreateInfo(desc);
+    vkCreateBuffer(device_->Raw(), &buffer_ci, nullptr, &buffer_);
+    vmaBindBufferMemory2(device_->Allocator(), heap->RawAllocation(), offset, buffer_, nullptr);
+
+    SetDebugName(desc.name);
+    AddToBindlessSet();
+}
+
+BufferVulkan::~BufferVulkan() {
+    if (auto bindless_set = device_->BindlessSet(); bindless_set) {
+        bindless_set->Remove(BindlessBinding::eStorageBuffer, bindless_index_);
+    }
+
+    Unmap();
+    if (allocation_) {
+        vmaDestroyBuffer(device_->Allocator(), buffer_, allocation_);
+    } else {
+        vkDestroyBuffer(device_->Raw(), buffer_, nullptr);
+    }
+}
+
+ResourceMemoryRequirements BufferVulkan::GetMemoryRequirements(Ref<DeviceVulkan> device, const BufferDesc &desc) {
+    VkBufferCreateInfo buffer_ci = ToVkBufferCreateInfo(desc);
+    VkMemoryRequirements requirements {};
+#if BISMUTH_VULKAN_VERSION_MINOR >= 3
+    VkDeviceBufferMemoryRequirements requirements_info {
+        .sType = VK_STRUCTURE_TYPE_DEVICE_BUFFER_MEMORY_REQUIREMENTS,
+        .pNext = nullptr,
+        .pCreateInfo = &buffer_ci,
+    };
+    VkMemoryRequirements2 requirements2 {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2,
+        .pNext = nullptr,
+    };
+    vkGetDeviceBufferMemoryRequirements(device->Raw(), &requirements_info, &requirements2);
+    requirements = requirements2.memoryRequirements;
+#else
+    VkBuffer buffer;
+    vkCreateBuffer(device->Raw(), &buffer_ci, nullptr, &buffer);
+    vkGetBufferMemoryRequirements(device->Raw(), buffer, &requirements);
+    vkDestroyBuffer(device->Raw(), buffer, nullptr);
+#endif
+    return ResourceMemoryRequirements {
+        .size = requirements.size,
+        .alignment = requirements.alignment,
+        .memory_type_bits = requirements.memoryTypeBits,
+    };
+}
+
+void BufferVulkan::SetDebugName(const std::string &name) {
+    if (!name.empty()) {
         VkDebugUtilsObjectNameInfoEXT name_info {
             .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT,
             .pNext = nullptr,
             .objectType = VK_OBJECT_TYPE_BUFFER,
             .objectHandle = reinterpret_cast<uint64_t>(buffer_),
-            .pObjectName = desc.name.c_str(),
+            .pObjectName = name.c_str(),
         };
         vkSetDebugUtilsObjectNameEXT(device_->Raw(), &name_info);
     }
 }
 
-BufferVulkan::~BufferVulkan() {
-    Unmap();
-    vmaDestroyBuffer(device_->Allocator(), buffer_, allocation_);
+void BufferVulkan::AddToBindlessSet() {
+    auto bindless_set = device_->BindlessSet();
+    if (bindless_set && desc_.usages.Contains(BufferUsage::eStorage)) {
+        bindless_index_ = bindless_set->AddStorageBuffer(buffer_);
+    }
 }
 
 void *BufferVulkan::Map() {
+    // placed buffers live in gpu only memory
+    if (allocation_ == nullptr) {
+        return nullptr;
+    }
     if (mapped_ptr_ == nullptr) {
         vmaMapMemory(device_->Allocator(), allocation_, &mapped_ptr_);
     }
@@ -133,27 +251,7 @@ void BufferVulkan::Unmap() {
 TextureVulkan::TextureVulkan(Ref<DeviceVulkan> device, const TextureDesc &desc) : device_(device) {
     desc_ = desc;
 
-    VkImageCreateInfo image_ci {
-        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-        .pNext = nullptr,
-        .flags = 0,
-        .imageType = ToVkImageType(desc.dim),
-        .format = ToVkFormat(desc.format),
-        .extent = {
-            desc.extent.width,
-            desc.extent.height,
-            desc.dim == TextureDimension::e3D ? desc.extent.depth_or_layers : 1,
-        },
-        .mipLevels = desc.levels,
-        .arrayLayers = desc.dim == TextureDimension::e3D ? 1 : desc.extent.depth_or_layers,
-        .samples = VK_SAMPLE_COUNT_1_BIT,
-        .tiling = VK_IMAGE_TILING_OPTIMAL,
-        .usage = ToVkImageUsage(desc.usages),
-        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-        .queueFamilyIndexCount = 0,
-        .pQueueFamilyIndices = nullptr,
-        .initialLayout = VK_IMAGE_LAYOUT_PREINITIALIZED,
-    };
+    VkImageCreateInfo image_ci = ToVkImageCreateInfo(desc);
 
     VmaAllocationCreateInfo allocation_ci {
         .flags = 0,
@@ -162,36 +260,126 @@ TextureVulkan::TextureVulkan(Ref<DeviceVulkan> device, const TextureDesc &desc)
 
     vmaCreateImage(device_->Allocator(), &image_ci, &allocation_ci, &image_, &allocation_, nullptr);
 
-    if (!desc.name.empty()) {
-        VkDebugUtilsObjectNameInfoEXT name_info {
-            .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT,
-            .pNext = nullptr,
-            .objectType = VK_OBJECT_TYPE_IMAGE,
-            .objectHandle = reinterpret_cast<uint64_t>(image_),
-            .pObjectName = desc.name.c_str(),
-        };
-        vkSetDebugUtilsObjectNameEXT(device_->Raw(), &name_info);
-    }
+    SetDebugName(desc.name);
+    AddToBindlessSet();
 }
 
 TextureVulkan::TextureVulkan(Ref<DeviceVulkan> device, VkImage raw_image, const TextureDesc &desc)
     : device_(device) {
     image_ = raw_image;
     allocation_ = nullptr;
+    owns_image_ = false;
     desc_ = desc;
+
+    AddToBindlessSet();
+}
+
+TextureVulkan::TextureVulkan(Ref<DeviceVulkan> device, const TextureDesc &desc, Ref<MemoryHeapVulkan> heap,
+    uint64_t offset) : device_(device) {
+    desc_ = desc;
+    allocation_ = nullptr;
+
+    VkImageCreateInfo image_ci = ToVkImageCreateInfo(desc);
+    vkCreateImage(device_->Raw(), &image_ci, nullptr, &image_);
+    vmaBindImageMemory2(device_->Allocator(), heap->RawAllocation(), offset, image_, nullptr);
+
+    SetDebugName(desc.name);
+    AddToBindlessSet();
 }
 
 TextureVulkan::~TextureVulkan() {
+    if (auto bindless_set = device_->BindlessSet(); bindless_set) {
+        bindless_set->Remove(BindlessBinding::eSampledTexture, bindless_sampled_index_);
+        bindless_set->Remove(BindlessBinding::eStorageTexture, bindless_storage_index_);
+    }
+
     for (const auto &[_, image_view] : cached_views_) {
         vkDestroyImageView(device_->Raw(), image_view, nullptr);
     }
 
     if (allocation_) {
         vmaDestroyImage(device_->Allocator(), image_, allocation_);
+    } else if (owns_image_) {
+        vkDestroyImage(device_->Raw(), image_, nullptr);
+    }
+}
+
+ResourceMemoryRequirements TextureVulkan::GetMemoryRequirements(Ref<DeviceVulkan> device, const TextureDesc &desc) {
+    VkImageCreateInfo image_ci = ToVkImageCreateInfo(desc);
+    VkMemoryRequirements requirements {};
+#if BISMUTH_VULKAN_VERSION_MINOR >= 3
+    VkDeviceImageMemoryRequirements requirements_info {
+        .sType = VK_STRUCTURE_TYPE_DEVICE_IMAGE_MEMORY_REQUIREMENTS,
+        .pNext = nullptr,
+        .pCreateInfo = &image_ci,
+        .planeAspect = VK_IMAGE_ASPECT_NONE,
+    };
+    VkMemoryRequirements2 requirements2 {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2,
+        .pNext = nullptr,
+    };
+    vkGetDeviceImageMemoryRequirements(device->Raw(), &requirements_info, &requirements2);
+    requirements = requirements2.memoryRequirements;
+#else
+    VkImage image;
+    vkCreateImage(device->Raw(), &image_ci, nullptr, &image);
+    vkGetImageMemoryRequirements(device->Raw(), image, &requirements);
+    vkDestroyImage(device->Raw(), image, nullptr);
+#endif
+    return ResourceMemoryRequirements {
+        .size = requirements.size,
+        .alignment = requirements.alignment,
+        .memory_type_bits = requirements.memoryTypeBits,
+    };
+}
+
+void TextureVulkan::SetDebugName(const std::string &name) {
+    if (!name.empty()) {
+        VkDebugUtilsObjectNameInfoEXT name_info {
+            .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT,
+            .pNext = nullptr,
+            .objectType = VK_OBJECT_TYPE_IMAGE,
+            .objectHandle = reinterpret_cast<uint64_t>(image_),
+            .pObjectName = name.c_str(),
+        };
+        vkSetDebugUtilsObjectNameEXT(device_->Raw(), &name_info);
+    }
+}
+
+void TextureVulkan::AddToBindlessSet() {
+    auto bindless_set = device_->BindlessSet();
+    if (bindless_set == nullptr) {
+        return;
+    }
+
+    const bool is_array = desc_.dim != TextureDimension::e3D && desc_.extent.depth_or_layers > 1;
+    VkImageViewType view_type = VK_IMAGE_VIEW_TYPE_3D;
+    if (desc_.dim == TextureDimension::e1D) {
+        view_type = is_array ? VK_IMAGE_VIEW_TYPE_1D_ARRAY : VK_IMAGE_VIEW_TYPE_1D;
+    } else if (desc_.dim == TextureDimension::e2D) {
+        view_type = is_array ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+    }
+    TextureViewVulkanDesc view_desc {
+        .type = view_type,
+        .format = RawFormat(),
+        .base_layer = 0,
+        .layers = VK_REMAINING_ARRAY_LAYERS,
+        .base_level = 0,
+        .levels = VK_REMAINING_MIP_LEVELS,
+    };
+
+    if (desc_.usages.Contains(TextureUsage::eSampled)) {
+        bindless_sampled_index_ = bindless_set->AddSampledTexture(GetView(view_desc),
+            IsDepthStencilFormat(desc_.format)
+                ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+    if (desc_.usages.Contains(TextureUsage::eStorage)) {
+        bindless_storage_index_ = bindless_set->AddStorageTexture(GetView(view_desc));
     }
 }
 
 VkImageView TextureVulkan::GetView(const TextureViewVulkanDesc &view_desc) const {
+    std::lock_guard lock(views_mutex_);
     if (auto it = cached_views_.find(view_desc); it != cached_views_.end()) {
         return it->second;
     }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <mutex>
+
 #include <volk.h>
 #include <vk_mem_alloc.h>
 
@@ -10,11 +12,27 @@ BISMUTH_NAMESPACE_BEGIN
 
 BISMUTH_GFX_NAMESPACE_BEGIN
 
+class MemoryHeapVulkan final : public MemoryHeap {
+public:
+    MemoryHeapVulkan(Ref<class DeviceVulkan> device, const MemoryHeapDesc &desc);
+    ~MemoryHeapVulkan() override;
+
+    VmaAllocation RawAllocation() const { return allocation_; }
+
+private:
+    Ref<DeviceVulkan> device_;
+    VmaAllocation allocation_;
+};
+
 class BufferVulkan final : public Buffer {
 public:
     BufferVulkan(Ref<class DeviceVulkan> device, const BufferDesc &desc);
+    // placed buffer
+    BufferVulkan(Ref<class DeviceVulkan> device, const BufferDesc &desc, Ref<MemoryHeapVulkan> heap, uint64_t offset);
     ~BufferVulkan() override;
 
+    static ResourceMemoryRequirements GetMemoryRequirements(Ref<DeviceVulkan> device, const BufferDesc &desc);
+
     void *Map() override;
 
     void Unmap() override;
@@ -24,9 +42,12 @@ public:
     VkBuffer Raw() const { return buffer_; }
 
 private:
+    void SetDebugName(const std::string &name);
+    void AddToBindlessSet();
+
     Ref<DeviceVulkan> device_;
     VkBuffer buffer_;
-    VmaAllocation allocation_;
+    VmaAllocation allocation_ = nullptr;
     uint64_t size_;
 
     void *mapped_ptr_ = nullptr;
@@ -64,8 +85,13 @@ public:
     TextureVulkan(Ref<class DeviceVulkan> device, const TextureDesc &desc);
     // external image
     TextureVulkan(Ref<class DeviceVulkan> device, VkImage raw_image, const TextureDesc &desc);
+    // placed image
+    TextureVulkan(Ref<class DeviceVulkan> device, const TextureDesc &desc, Ref<MemoryHeapVulkan> heap,
+        uint64_t offset);
     ~TextureVulkan() override;
 
+    static ResourceMemoryRequirements GetMemoryRequirements(Ref<DeviceVulkan> device, const TextureDesc &desc);
+
     VkImage Raw() const { return image_; }
 
     VkImageView GetView(const TextureViewVulkanDesc &view_desc) const;
@@ -77,10 +103,16 @@ public:
     void GetDepthAndLayer(uint32_t depth_or_layers, uint32_t &depth, uint32_t &layers, uint32_t another = 1) const;
 
 private:
+    void SetDebugName(const std::string &name);
+    void AddToBindlessSet();
+
     Ref<DeviceVulkan> device_;
     VkImage image_;
     VmaAllocation allocation_;
+    bool owns_image_ = true;
 
+    // views may be requested by encoders recording on different threads
+    mutable std::mutex views_mutex_;
     mutable HashMap<TextureViewVulkanDesc, VkImageView> cached_views_;
 };
 
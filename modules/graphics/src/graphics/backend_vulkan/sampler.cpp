@@ -2,6 +2,7 @@
 
 #include "utils.hpp"
 #include "device.hpp"
+#include "descriptor.hpp"
 
 BISMUTH_NAMESPACE_BEGIN
 
@@ -50,9 +51,16 @@ SamplerVulkan::SamplerVulkan(Ref<DeviceVulkan> device, const SamplerDesc &desc)
     };
 
     vkCreateSampler(device_->Raw(), &sampler_ci, nullptr, &sampler_);
+
+    if (auto bindless_set = device_->BindlessSet(); bindless_set) {
+        bindless_index_ = bindless_set->AddSampler(sampler_);
+    }
 }
 
 SamplerVulkan::~SamplerVulkan() {
+    if (auto bindless_set = device_->BindlessSet(); bindless_set) {
+        bindless_set->Remove(BindlessBinding::eSampler, bindless_index_);
+    }
     vkDestroySampler(device_->Raw(), sampler_, nullptr);
 }
 
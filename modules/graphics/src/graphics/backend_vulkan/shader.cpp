@@ -1,5 +1,7 @@
 #include "shader.hpp"
 
+#include <algorithm>
+
 #include <spirv_reflect.h>
 
 #include "device.hpp"
@@ -11,152 +13,144 @@ BISMUTH_GFX_NAMESPACE_BEGIN
 
 namespace {
 
-VkShaderStageFlagBits FromSpvShaderStageBits(SpvReflectShaderStageFlagBits stage) {
-    return static_cast<VkShaderStageFlagBits>(stage);
-}
-VkShaderStageFlags FromSpvShaderStage(SpvReflectShaderStageFlagBits stage) {
-    return static_cast<VkShaderStageFlags>(stage);
+ShaderStage FromSpvShaderStage(SpvReflectShaderStageFlagBits stage) {
+    switch (stage) {
+        case SPV_REFLECT_SHADER_STAGE_VERTEX_BIT: return ShaderStage::eVertex;
+        case SPV_REFLECT_SHADER_STAGE_TESSELLATION_CONTROL_BIT: return ShaderStage::eTessellationControl;
+        case SPV_REFLECT_SHADER_STAGE_TESSELLATION_EVALUATION_BIT: return ShaderStage::eTessellationEvaluation;
+        case SPV_REFLECT_SHADER_STAGE_GEOMETRY_BIT: return ShaderStage::eGeometry;
+        case SPV_REFLECT_SHADER_STAGE_FRAGMENT_BIT: return ShaderStage::eFragment;
+        case SPV_REFLECT_SHADER_STAGE_COMPUTE_BIT: return ShaderStage::eCompute;
+        default: Unreachable();
+    }
 }
 
-ResourceFormat FromSpvReflectFormat(SpvReflectFormat format) {
-    switch (format) {
-        case SPV_REFLECT_FORMAT_UNDEFINED: return ResourceFormat::eUndefined;
-        case SPV_REFLECT_FORMAT_R32_UINT: return ResourceFormat::eR32UInt;
-        case SPV_REFLECT_FORMAT_R32_SINT: return ResourceFormat::eR32SInt;
-        case SPV_REFLECT_FORMAT_R32_SFLOAT: return ResourceFormat::eR32SFloat;
-        case SPV_REFLECT_FORMAT_R32G32_UINT: return ResourceFormat::eRg32UInt;
-        case SPV_REFLECT_FORMAT_R32G32_SINT: return ResourceFormat::eRg32SInt;
-        case SPV_REFLECT_FORMAT_R32G32_SFLOAT: return ResourceFormat::eRg32SFloat;
-        case SPV_REFLECT_FORMAT_R32G32B32_UINT: return ResourceFormat::eRgb32UInt;
-        case SPV_REFLECT_FORMAT_R32G32B32_SINT: return ResourceFormat::eRgb32SInt;
-        case SPV_REFLECT_FORMAT_R32G32B32_SFLOAT: return ResourceFormat::eRgb32SFloat;
-        case SPV_REFLECT_FORMAT_R32G32B32A32_UINT: return ResourceFormat::eRgba32UInt;
-        case SPV_REFLECT_FORMAT_R32G32B32A32_SINT: return ResourceFormat::eRgba32SInt;
-        case SPV_REFLECT_FORMAT_R32G32B32A32_SFLOAT: return ResourceFormat::eRgba32SFloat;
-        default: return ResourceFormat::eUndefined;
+VkShaderStageFlagBits ToVkShaderStage(ShaderStage stage) {
+    switch (stage) {
+        case ShaderStage::eVertex: return VK_SHADER_STAGE_VERTEX_BIT;
+        case ShaderStage::eTessellationControl: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+        case ShaderStage::eTessellationEvaluation: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+        case ShaderStage::eGeometry: return VK_SHADER_STAGE_GEOMETRY_BIT;
+        case ShaderStage::eFragment: return VK_SHADER_STAGE_FRAGMENT_BIT;
+        case ShaderStage::eCompute: return VK_SHADER_STAGE_COMPUTE_BIT;
     }
+    Unreachable();
 }
 
-VkDescriptorType FromSpvDescriptorType(SpvReflectDescriptorType type) {
-    switch (type) {
-        case SPV_REFLECT_DESCRIPTOR_TYPE_SAMPLER: return VK_DESCRIPTOR_TYPE_SAMPLER;
-        case SPV_REFLECT_DESCRIPTOR_TYPE_SAMPLED_IMAGE: return VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-        case SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_IMAGE: return VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        case SPV_REFLECT_DESCRIPTOR_TYPE_UNIFORM_BUFFER: return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        case SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_BUFFER: return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        case SPV_REFLECT_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR:
-            return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
-        default: return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+// read-only storage buffers and textures of hlsl are reported as SRV
+DescriptorType FromSpvDescriptorType(const SpvReflectDescriptorBinding &binding) {
+    const bool read_only = binding.resource_type == SPV_REFLECT_RESOURCE_FLAG_SRV;
+    switch (binding.descriptor_type) {
+        case SPV_REFLECT_DESCRIPTOR_TYPE_SAMPLER: return DescriptorType::eSampler;
+        case SPV_REFLECT_DESCRIPTOR_TYPE_SAMPLED_IMAGE: return DescriptorType::eSampledTexture;
+        case SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+            return read_only ? DescriptorType::eStorageTexture : DescriptorType::eRWStorageTexture;
+        case SPV_REFLECT_DESCRIPTOR_TYPE_UNIFORM_BUFFER: return DescriptorType::eUniformBuffer;
+        case SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+            return read_only ? DescriptorType::eStorageBuffer : DescriptorType::eRWStorageBuffer;
+        default: return DescriptorType::eNone;
     }
 }
 
-VkImageViewType FromSpvDim(SpvDim dim, bool is_array) {
+TextureViewDimension FromSpvDim(SpvDim dim, bool is_array) {
     switch (dim) {
-        case SpvDim1D: return is_array ? VK_IMAGE_VIEW_TYPE_1D_ARRAY : VK_IMAGE_VIEW_TYPE_1D;
-        case SpvDim2D: return is_array ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
-        case SpvDim3D: return VK_IMAGE_VIEW_TYPE_3D;
-        case SpvDimCube: return is_array ? VK_IMAGE_VIEW_TYPE_CUBE_ARRAY : VK_IMAGE_VIEW_TYPE_CUBE;
+        case SpvDim1D: return is_array ? TextureViewDimension::e1DArray : TextureViewDimension::e1D;
+        case SpvDim2D: return is_array ? TextureViewDimension::e2DArray : TextureViewDimension::e2D;
+        case SpvDim3D: return TextureViewDimension::e3D;
+        case SpvDimCube: return is_array ? TextureViewDimension::eCubeArray : TextureViewDimension::eCube;
         default: Unreachable();
     }
 }
 
+// size of uniform buffer, or element size of structured buffer (a runtime array is its only member)
+uint32_t SpvBufferStride(const SpvReflectDescriptorBinding &binding) {
+    const auto &block = binding.block;
+    if (binding.descriptor_type == SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_BUFFER && block.member_count > 0
+        && block.members[0].array.dims_count > 0) {
+        return block.members[0].array.stride;
+    }
+    return block.size;
+}
+
 }
 
-ShaderModuleVulkan::ShaderModuleVulkan(Ref<DeviceVulkan> device, const Vec<uint8_t> &src_bytes)
-    : device_(device) {
+ShaderReflection ReflectSpirv(Span<uint8_t> spv_bytes) {
+    // reflection is only used here, bytes needn't be copied
+    spv_reflect::ShaderModule reflect_module(spv_bytes.Size(), spv_bytes.Data(), SPV_REFLECT_MODULE_FLAG_NO_COPY);
+
+    ShaderReflection reflection {
+        .stage = FromSpvShaderStage(reflect_module.GetShaderStage()),
+        .entry_point = reflect_module.GetEntryPointName(),
+    };
+    const char *entry_point = reflection.entry_point.c_str();
+
+    if (reflection.stage == ShaderStage::eCompute) {
+        const auto entry_point_info = spvReflectGetEntryPoint(&reflect_module.GetShaderModule(), entry_point);
+        reflection.thread_group_x = entry_point_info->local_size.x;
+        reflection.thread_group_y = entry_point_info->local_size.y;
+        reflection.thread_group_z = entry_point_info->local_size.z;
+    }
+
+    uint32_t num_bindings = 0;
+    reflect_module.EnumerateEntryPointDescriptorBindings(entry_point, &num_bindings, nullptr);
+    Vec<SpvReflectDescriptorBinding *> bindings(num_bindings);
+    reflect_module.EnumerateEntryPointDescriptorBindings(entry_point, &num_bindings, bindings.data());
+    for (const auto binding : bindings) {
+        const DescriptorType type = FromSpvDescriptorType(*binding);
+        if (type == DescriptorType::eNone) {
+            continue;
+        }
+        if (reflection.sets_layout.size() <= binding->set) {
+            reflection.sets_layout.resize(binding->set + 1);
+        }
+        auto &set_bindings = reflection.sets_layout[binding->set].bindings;
+        if (set_bindings.size() <= binding->binding) {
+            set_bindings.resize(binding->binding + 1);
+        }
+        auto &rhi_binding = set_bindings[binding->binding];
+        rhi_binding.type = type;
+        // runtime arrays have no count and are only used by bindless set
+        rhi_binding.count = std::max(binding->count, 1u);
+        if (IsDescriptorTypeTexture(type)) {
+            rhi_binding.tex_dim = FromSpvDim(binding->image.dim, binding->image.arrayed != 0);
+        } else if (IsDescriptorTypeBuffer(type)) {
+            rhi_binding.struct_stride = SpvBufferStride(*binding);
+        }
+    }
+
+    uint32_t num_push_constants = 0;
+    reflect_module.EnumerateEntryPointPushConstantBlocks(entry_point, &num_push_constants, nullptr);
+    Vec<SpvReflectBlockVariable *> push_constants(num_push_constants);
+    reflect_module.EnumerateEntryPointPushConstantBlocks(entry_point, &num_push_constants, push_constants.data());
+    for (const auto push_c : push_constants) {
+        reflection.push_constants_size = std::max(reflection.push_constants_size, push_c->offset + push_c->size);
+    }
+
+    return reflection;
+}
+
+ShaderModuleVulkan::ShaderModuleVulkan(Ref<DeviceVulkan> device, Span<uint8_t> src_bytes,
+    const ShaderReflection *reflection)
+    : device_(device), reflection_(reflection ? *reflection : ReflectSpirv(src_bytes)) {
     VkShaderModuleCreateInfo shader_module_ci {
         .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
         .pNext = nullptr,
         .flags = 0,
-        .codeSize = src_bytes.size(),
-        .pCode = reinterpret_cast<const uint32_t *>(src_bytes.data()),
+        .codeSize = src_bytes.Size(),
+        .pCode = reinterpret_cast<const uint32_t *>(src_bytes.Data()),
     };
     vkCreateShaderModule(device_->Raw(), &shader_module_ci, nullptr, &shader_module_);
+    content_hash_ = HashBytes(src_bytes.Data(), src_bytes.Size(), Hash(reflection_.entry_point));
 
-    spv_reflect::ShaderModule reflect_module(src_bytes);
-
-    entry_point_ = reflect_module.GetEntryPointName();
     pipeline_shader_stage_ = VkPipelineShaderStageCreateInfo {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
         .pNext = nullptr,
         .flags = 0,
-        .stage = FromSpvShaderStageBits(reflect_module.GetShaderStage()),
+        .stage = ToVkShaderStage(reflection_.stage),
         .module = shader_module_,
-        .pName = entry_point_.c_str(),
+        .pName = reflection_.entry_point.c_str(),
         .pSpecializationInfo = nullptr,
     };
-
-    /*
-    if (reflect_module.GetShaderStage() == SPV_REFLECT_SHADER_STAGE_VERTEX_BIT) {
-        uint32_t num_inputs = 0;
-        reflect_module.EnumerateInputVariables(&num_inputs, nullptr);
-        Vec<SpvReflectInterfaceVariable *> inputs(num_inputs);
-        reflect_module.EnumerateInputVariables(&num_inputs, inputs.data());
-
-        uint32_t max_location = 0;
-        for (auto input : inputs) {
-            max_location = std::max(max_location, input->location);
-        }
-        info_.vertex_inputs.resize(max_location, ResourceFormat::eUndefined);
-        for (auto input : inputs) {
-            info_.vertex_inputs[input->location] = FromSpvReflectFormat(input->format);
-        }
-    }
-
-    if (reflect_module.GetShaderStage() == SPV_REFLECT_SHADER_STAGE_COMPUTE_BIT) {
-        const auto entry_point_info = spvReflectGetEntryPoint(&reflect_module.GetShaderModule(), entry_point_.c_str());
-        info_.compute_local_size_x = entry_point_info->local_size.x;
-        info_.compute_local_size_y = entry_point_info->local_size.y;
-        info_.compute_local_size_z = entry_point_info->local_size.z;
-    }
-
-    uint32_t num_bindings = 0;
-    reflect_module.EnumerateDescriptorBindings(&num_bindings, nullptr);
-    Vec<SpvReflectDescriptorBinding *> bindings(num_bindings);
-    reflect_module.EnumerateDescriptorBindings(&num_bindings, bindings.data());
-
-    info_.bindings.name_map.reserve(num_bindings);
-    uint32_t max_set = 0;
-    for (auto binding : bindings) {
-        max_set = std::max(max_set, binding->set);
-    }
-    info_.bindings.bindings.resize(max_set);
-    Vec<uint32_t> max_binding(max_set, 0);
-    for (auto binding : bindings) {
-        max_binding[binding->set] = std::max(max_binding[binding->set], binding->binding);
-    }
-    for (uint32_t set = 0; set < max_set; set++) {
-        info_.bindings.bindings[set].resize(max_binding[set],
-            VkDescriptorSetLayoutBinding { .descriptorType = VK_DESCRIPTOR_TYPE_MAX_ENUM });
-    }
-    for (auto binding : bindings) {
-        info_.bindings.bindings[binding->set][binding->binding] = VkDescriptorSetLayoutBinding {
-            .binding = binding->binding,
-            .descriptorType = FromSpvDescriptorType(binding->descriptor_type),
-            .descriptorCount = binding->array.dims_count > 0 ? binding->array.dims[0] : 1,
-            .stageFlags = FromSpvShaderStage(reflect_module.GetShaderStage()),
-            .pImmutableSamplers = nullptr,
-        };
-        info_.bindings.name_map[binding->name] = { binding->set, binding->binding };
-
-        if (binding->descriptor_type == SPV_REFLECT_DESCRIPTOR_TYPE_SAMPLED_IMAGE
-            || binding->descriptor_type == SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_IMAGE) {
-            info_.bindings.bindings_view_info[binding->set][binding->binding] = ShaderBindingsVulkan::ViewInfo {
-                .image_view_type = FromSpvDim(binding->image.dim, binding->image.arrayed),
-            };
-        }
-    }
-
-    uint32_t num_push_constants;
-    reflect_module.EnumeratePushConstantBlocks(&num_push_constants, nullptr);
-    Vec<SpvReflectBlockVariable *> push_constants(num_push_constants);
-    reflect_module.EnumeratePushConstantBlocks(&num_push_constants, push_constants.data());
-    info_.bindings.push_constant_size = 0;
-    for (auto push_c : push_constants) {
-        info_.bindings.push_constant_size =
-            std::max(info_.bindings.push_constant_size, push_c->offset + push_c->size);
-    }
-    */
 }
 
 ShaderModuleVulkan::~ShaderModuleVulkan() {
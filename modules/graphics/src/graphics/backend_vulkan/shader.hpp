@@ -4,6 +4,7 @@
 
 #include "core/container.hpp"
 #include "core/ptr.hpp"
+#include "core/span.hpp"
 #include "graphics/defines.hpp"
 #include "graphics/shader.hpp"
 
@@ -11,11 +12,17 @@ BISMUTH_NAMESPACE_BEGIN
 
 BISMUTH_GFX_NAMESPACE_BEGIN
 
+// reflect resources used by the entry point of a SPIR-V binary
+ShaderReflection ReflectSpirv(Span<uint8_t> spv_bytes);
+
 class ShaderModuleVulkan final : public ShaderModule {
 public:
-    ShaderModuleVulkan(Ref<class DeviceVulkan> device, const Vec<uint8_t> &src_bytes);
+    // 'src_bytes' is reflected if 'reflection' is null
+    ShaderModuleVulkan(Ref<class DeviceVulkan> device, Span<uint8_t> src_bytes, const ShaderReflection *reflection);
     ~ShaderModuleVulkan() override;
 
+    const ShaderReflection &Reflection() const override { return reflection_; }
+
     VkShaderModule Raw() const { return shader_module_; }
 
     const VkPipelineShaderStageCreateInfo &RawPipelineShaderStage() const { return pipeline_shader_stage_; }
@@ -23,7 +30,8 @@ public:
 private:
     Ref<DeviceVulkan> device_;
     VkShaderModule shader_module_;
-    std::string entry_point_;
+    // entry point name of pipeline_shader_stage_ points to reflection_
+    ShaderReflection reflection_;
     VkPipelineShaderStageCreateInfo pipeline_shader_stage_;
 };
 
@@ -1,11 +1,23 @@
 #include "shader_compiler.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <fstream>
+#include <sstream>
 
+#include <glslang/build_info.h>
 #include <glslang/Public/ShaderLang.h>
 #include <glslang/SPIRV/GlslangToSpv.h>
 #include <spirv_cross/spirv_glsl.hpp>
+#include <spirv-tools/libspirv.h>
+#include <spirv-tools/libspirv.hpp>
+#include <spirv-tools/optimizer.hpp>
 #include <core/module_manager.hpp>
+#include <core/utils.hpp>
+
+#include "shader_manager/shader_archive.hpp"
+#include "shader.hpp"
 
 BISMUTH_NAMESPACE_BEGIN
 
@@ -49,6 +61,85 @@ constexpr glslang::EShTargetLanguageVersion ToGlslangSpvVersion() {
 #endif
 }
 
+// glslang may generate invalid SPIR-V 1.5/1.6 codes from hlsl (see https://github.com/KhronosGroup/glslang/issues/2411),
+// so hlsl is compiled directly to at most SPIR-V 1.4, which Vulkan 1.2/1.3 also accept,
+// hlsl -> spir-v 1.3 -> glsl -> target spir-v is only used when the direct codes fail validation
+constexpr glslang::EShTargetLanguageVersion kDirectSpvVersion =
+    std::min(ToGlslangSpvVersion(), glslang::EShTargetSpv_1_4);
+
+constexpr spv_target_env ToSpvTargetEnv() {
+#if BISMUTH_VULKAN_VERSION_MINOR == 3
+    return SPV_ENV_VULKAN_1_3;
+#elif BISMUTH_VULKAN_VERSION_MINOR == 2
+    return SPV_ENV_VULKAN_1_2;
+#elif BISMUTH_VULKAN_VERSION_MINOR == 1
+    return SPV_ENV_VULKAN_1_1;
+#else
+    return SPV_ENV_VULKAN_1_0;
+#endif
+}
+
+// bump when the compile pipeline changes in a way that changes the generated codes
+constexpr size_t kCacheVersion = 3;
+
+// glslang process state is shared by all compilers (one per device), parsing state is per thread after that,
+// so Compile can be called from multiple threads
+std::mutex glslang_process_mutex;
+uint32_t glslang_process_clients = 0;
+
+std::string ReadFile(const fs::path &path) {
+    std::string content;
+    std::ifstream fin(path, std::ios::binary);
+    fin.seekg(0, std::ios::end);
+    size_t size = fin.tellg();
+    content.resize(size);
+    fin.seekg(0, std::ios::beg);
+    fin.read(content.data(), size);
+    return content;
+}
+
+uint32_t CountSpirvInstructions(const uint32_t *words, size_t num_words) {
+    // 5 words of header, then each instruction begins with its word count in the high 16 bits
+    uint32_t count = 0;
+    for (size_t i = 5; i < num_words; ++count) {
+        const uint32_t instruction_words = words[i] >> 16;
+        if (instruction_words == 0) {
+            break;
+        }
+        i += instruction_words;
+    }
+    return count;
+}
+
+bool ValidateSpirv(const Vec<uint32_t> &spv) {
+    spvtools::SpirvTools tools(ToSpvTargetEnv());
+    return tools.Validate(spv);
+}
+
+// return the input binary if optimization fails
+Vec<uint32_t> OptimizeSpirv(const Vec<uint32_t> &spv, ShaderOptimizationLevel level, const std::string &src_filename) {
+    spvtools::Optimizer optimizer(ToSpvTargetEnv());
+    optimizer.SetMessageConsumer([&src_filename](spv_message_level_t message_level, const char *,
+        const spv_position_t &, const char *message) {
+        if (message_level <= SPV_MSG_WARNING) {
+            BI_WARN(ModuleManager::Get<GraphicsModule>()->Lgr(), "SPIR-V optimizer message of '{}': {}",
+                src_filename, message);
+        }
+    });
+    if (level == ShaderOptimizationLevel::eSize) {
+        optimizer.RegisterSizePasses();
+    } else {
+        optimizer.RegisterPerformancePasses();
+    }
+
+    Vec<uint32_t> optimized;
+    if (!optimizer.Run(spv.data(), spv.size(), &optimized)) {
+        BI_WARN(ModuleManager::Get<GraphicsModule>()->Lgr(), "Failed to optimize SPIR-V of '{}'", src_filename);
+        return spv;
+    }
+    return optimized;
+}
+
 const TBuiltInResource kDefaultTBuiltInResource = {
     .maxLights = 32,
     .maxClipPlanes = 6,
@@ -158,8 +249,9 @@ const TBuiltInResource kDefaultTBuiltInResource = {
 
 class GlslangIncluder : public glslang::TShader::Includer {
 public:
-    GlslangIncluder(const Vec<fs::path> &include_dirs)
-        : include_dirs_stack_(include_dirs), input_include_dirs_size_(include_dirs.size()) {}
+    GlslangIncluder(const Vec<fs::path> &include_dirs, Vec<fs::path> *dependencies)
+        : include_dirs_stack_(include_dirs), input_include_dirs_size_(include_dirs.size()),
+        dependencies_(dependencies) {}
 
     IncludeResult* includeLocal(const char* headerName, const char* includerName, size_t inclusionDepth) override {
         include_dirs_stack_.resize(inclusionDepth + input_include_dirs_size_);
@@ -171,6 +263,10 @@ public:
             fs::path path = *it / headerName;
             if (fs::exists(path)) {
                 include_dirs_stack_.push_back(path.parent_path());
+                if (dependencies_ && std::find(dependencies_->begin(), dependencies_->end(), path)
+                    == dependencies_->end()) {
+                    dependencies_->push_back(path);
+                }
                 std::ifstream fin(path);
                 fin.seekg(0, std::ios::end);
                 size_t length = fin.tellg();
@@ -198,50 +294,125 @@ public:
 protected:
     size_t input_include_dirs_size_;
     Vec<fs::path> include_dirs_stack_;
+    Vec<fs::path> *dependencies_;
 };
 
 }
 
-ShaderCompilerVulkan::ShaderCompilerVulkan() {
-    glslang::InitializeProcess();
+ShaderCompilerVulkan::ShaderCompilerVulkan(const fs::path &cache_dir) {
+    {
+        std::lock_guard lock(glslang_process_mutex);
+        if (glslang_process_clients++ == 0) {
+            glslang::InitializeProcess();
+        }
+    }
+    version_ = "glslang-" + std::to_string(GLSLANG_VERSION_MAJOR) + "." + std::to_string(GLSLANG_VERSION_MINOR)
+        + "." + std::to_string(GLSLANG_VERSION_PATCH) + "-vk1." + std::to_string(BISMUTH_VULKAN_VERSION_MINOR)
+        + "-spirv-tools-" + spvSoftwareVersionString()
+        + "-" + std::to_string(kCacheVersion);
+    if (!cache_dir.empty()) {
+        std::error_code error;
+        fs::create_directories(cache_dir, error);
+        if (error) {
+            BI_WARN(ModuleManager::Get<GraphicsModule>()->Lgr(), "Failed to create shader cache directory '{}': {}",
+                cache_dir.string(), error.message());
+        } else {
+            archive_ = ShaderArchive::Open(cache_dir / "spirv_cache.spv");
+        }
+    }
 }
 
 ShaderCompilerVulkan::~ShaderCompilerVulkan() {
-    glslang::FinalizeProcess();
+    FlushCache();
+
+    std::lock_guard lock(glslang_process_mutex);
+    if (--glslang_process_clients == 0) {
+        glslang::FinalizeProcess();
+    }
 }
 
 Vec<uint8_t> ShaderCompilerVulkan::Compile(const fs::path &src_path, const std::string &entry, ShaderStage stage,
-    const HashMap<std::string, std::string> &defines, const Vec<fs::path> &include_dirs) const {
+    const HashMap<std::string, std::string> &defines, const Vec<fs::path> &include_dirs,
+    const ShaderCompileOptions &options, ShaderCompileInfo *info) const {
     std::string src_filename = src_path.string();
     if (!fs::exists(src_path)) {
         BI_CRTICAL(ModuleManager::Get<GraphicsModule>()->Lgr(), "Shader file '{}' doesn't exist", src_filename);
     }
 
-    // glslang may generate invalid SPIR-V 1.5/1.6 codes (see https://github.com/KhronosGroup/glslang/issues/2411)
-    // hlsl -> spir-v 1.3 -> glsl -> spir-v 1.5/1.6 is used
+    // includes and defines are expanded, so the preprocessed source identifies the shader content
+    Vec<fs::path> *dependencies = info ? &info->dependencies : nullptr;
+    if (dependencies) {
+        dependencies->push_back(src_path);
+    }
+    std::string preprocessed_src = Preprocess(src_filename, entry, stage, defines, include_dirs, dependencies);
+
+    const uint32_t key_options[] = {
+        static_cast<uint32_t>(stage),
+        static_cast<uint32_t>(ToGlslangVulkanVersion()),
+        static_cast<uint32_t>(ToGlslangSpvVersion()),
+        static_cast<uint32_t>(options.optimization),
+    };
+    // compiler version covers toolchain versions, so cached codes of an older toolchain are not reused
+    size_t key = HashBytes(version_.data(), version_.size());
+    key = HashBytes(preprocessed_src.data(), preprocessed_src.size(), key);
+    key = HashBytes(entry.data(), entry.size(), key);
+    key = HashBytes(key_options, sizeof(key_options), key);
+
+    CacheEntry cached;
+    if (LoadCached(key, cached)) {
+        if (info) {
+            info->num_instructions_unoptimized = cached.num_instructions_unoptimized;
+            info->num_instructions = CountSpirvInstructions(
+                reinterpret_cast<const uint32_t *>(cached.spv_bytes.data()), cached.spv_bytes.size() / 4);
+            info->optimization_time_ms = cached.optimization_time_ms;
+            if (!cached.reflection) {
+                cached.reflection = ReflectSpirv(cached.spv_bytes);
+                StoreCachedReflection(key, *cached.reflection);
+            }
+            info->reflection = std::move(*cached.reflection);
+        }
+        return std::move(cached.spv_bytes);
+    }
 
-    Vec<uint32_t> spv_temp = HlslToSpirv(src_filename, entry, stage, defines, include_dirs);
+    Vec<uint32_t> spv_binary = HlslToSpirv(preprocessed_src, src_filename, entry, stage, true);
+    if (!ValidateSpirv(spv_binary)) {
+        BI_WARN(ModuleManager::Get<GraphicsModule>()->Lgr(),
+            "Invalid SPIR-V generated from shader '{}' (entry point: '{}'), compile it again through glsl",
+            src_filename, entry);
+        Vec<uint32_t> spv_temp = HlslToSpirv(preprocessed_src, src_filename, entry, stage, false);
+        std::string glsl_temp = SpirvToGlsl(spv_temp);
+        spv_binary = GlslToSpirv(glsl_temp, entry, stage);
+    }
 
-    std::string glsl_temp = SpirvToGlsl(spv_temp);
+    cached.num_instructions_unoptimized = CountSpirvInstructions(spv_binary.data(), spv_binary.size());
+    if (options.optimization != ShaderOptimizationLevel::eNone) {
+        const auto start = std::chrono::steady_clock::now();
+        spv_binary = OptimizeSpirv(spv_binary, options.optimization, src_filename);
+        cached.optimization_time_ms =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    if (info) {
+        info->num_instructions_unoptimized = cached.num_instructions_unoptimized;
+        info->num_instructions = CountSpirvInstructions(spv_binary.data(), spv_binary.size());
+        info->optimization_time_ms = cached.optimization_time_ms;
+    }
 
-    Vec<uint32_t> spv_binary = GlslToSpirv(glsl_temp, entry, stage);
-    Vec<uint8_t> spv_binary_bytes(spv_binary.size() * 4);
-    memcpy(spv_binary_bytes.data(), spv_binary.data(), spv_binary.size() * 4);
+    cached.spv_bytes.resize(spv_binary.size() * 4);
+    memcpy(cached.spv_bytes.data(), spv_binary.data(), spv_binary.size() * 4);
+    if (info) {
+        cached.reflection = ReflectSpirv(cached.spv_bytes);
+        info->reflection = *cached.reflection;
+    }
+
+    StoreCached(key, cached);
 
-    return spv_binary_bytes;
+    return std::move(cached.spv_bytes);
 }
 
-Vec<uint32_t> ShaderCompilerVulkan::HlslToSpirv(const std::string &src_filename, const std::string &entry,
-    ShaderStage stage, const HashMap<std::string, std::string> &defines, const Vec<fs::path> &include_dirs) const {
-    std::string shader_source;
-    {
-        std::ifstream fin(src_filename);
-        fin.seekg(0, std::ios::end);
-        size_t size = fin.tellg();
-        shader_source.resize(size);
-        fin.seekg(0, std::ios::beg);
-        fin.read(shader_source.data(), size);
-    }
+std::string ShaderCompilerVulkan::Preprocess(const std::string &src_filename, const std::string &entry,
+    ShaderStage stage, const HashMap<std::string, std::string> &defines, const Vec<fs::path> &include_dirs,
+    Vec<fs::path> *dependencies) const {
+    std::string shader_source = ReadFile(src_filename);
 
     auto glslang_stage = ToGlslangStage(stage);
     glslang::TShader shader(glslang_stage);
@@ -252,15 +423,46 @@ Vec<uint32_t> ShaderCompilerVulkan::HlslToSpirv(const std::string &src_filename,
     shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_3);
     shader.setEntryPoint(entry.c_str());
 
+    // sorted so that the preprocessed source doesn't depend on hash map order
+    Vec<std::pair<std::string, std::string>> sorted_defines(defines.begin(), defines.end());
+    std::sort(sorted_defines.begin(), sorted_defines.end());
     std::string preamble;
-    for (const auto &[key, value] : defines) {
+    for (const auto &[key, value] : sorted_defines) {
         preamble += "#define " + key + " " + value + "\n";
     }
     shader.setPreamble(preamble.c_str());
 
-    GlslangIncluder includer(include_dirs);
+    GlslangIncluder includer(include_dirs, dependencies);
+
+    std::string preprocessed_src;
+    if (!shader.preprocess(&kDefaultTBuiltInResource, 100, ENoProfile, false, false, EShMsgHlslLegalization,
+        &preprocessed_src, includer)) {
+        const std::string log(shader.getInfoLog());
+        const std::string debug_log(shader.getInfoDebugLog());
+        BI_CRTICAL(ModuleManager::Get<GraphicsModule>()->Lgr(),
+            "Failed to preprocess shader '{}' (entry point: '{}'), info:\n{}\n{}",
+            src_filename, entry, log, debug_log);
+    }
+
+    return preprocessed_src;
+}
+
+Vec<uint32_t> ShaderCompilerVulkan::HlslToSpirv(const std::string &preprocessed_src, const std::string &src_filename,
+    const std::string &entry, ShaderStage stage, bool final_target) const {
+    // spir-v 1.3 is used as intermediate codes of the round-trip path
+    const auto vulkan_version = final_target ? ToGlslangVulkanVersion() : glslang::EShTargetVulkan_1_1;
+    const auto spv_version = final_target ? kDirectSpvVersion : glslang::EShTargetSpv_1_3;
+
+    auto glslang_stage = ToGlslangStage(stage);
+    glslang::TShader shader(glslang_stage);
+    const char *shader_source_str = preprocessed_src.c_str();
+    shader.setStrings(&shader_source_str, 1);
+    shader.setEnvInput(glslang::EShSourceHlsl, glslang_stage, glslang::EShClientVulkan, vulkan_version);
+    shader.setEnvClient(glslang::EShClientVulkan, vulkan_version);
+    shader.setEnvTarget(glslang::EShTargetSpv, spv_version);
+    shader.setEntryPoint(entry.c_str());
 
-    if (!shader.parse(&kDefaultTBuiltInResource, 100, false, EShMsgHlslLegalization, includer)) {
+    if (!shader.parse(&kDefaultTBuiltInResource, 100, false, EShMsgHlslLegalization)) {
         const std::string log(shader.getInfoLog());
         const std::string debug_log(shader.getInfoDebugLog());
         BI_CRTICAL(ModuleManager::Get<GraphicsModule>()->Lgr(),
@@ -327,6 +529,69 @@ Vec<uint32_t> ShaderCompilerVulkan::GlslToSpirv(const std::string &glsl_src, con
     return spv_binary;
 }
 
+bool ShaderCompilerVulkan::LoadCached(size_t key, CacheEntry &entry) const {
+    std::lock_guard lock(cache_mutex_);
+    if (auto it = cache_.find(key); it != cache_.end()) {
+        entry = it->second;
+        return true;
+    }
+
+    if (!archive_) {
+        return false;
+    }
+    const std::string name = CacheEntryName(key);
+    const bool found = archive_->Read(name, [&entry](Span<uint8_t> bytes) {
+        entry.spv_bytes.assign(bytes.begin(), bytes.end());
+    });
+    if (found) {
+        // metadata is '<unoptimized instructions> <optimization time>'
+        std::string metadata;
+        archive_->FindMetadata(name, metadata);
+        std::istringstream(metadata) >> entry.num_instructions_unoptimized >> entry.optimization_time_ms;
+        cache_.insert({key, entry});
+    }
+    return found;
+}
+
+void ShaderCompilerVulkan::StoreCached(size_t key, const CacheEntry &entry) const {
+    std::lock_guard lock(cache_mutex_);
+    if (cache_.insert({key, entry}).second && archive_) {
+        pending_keys_.push_back(key);
+    }
+}
+
+void ShaderCompilerVulkan::StoreCachedReflection(size_t key, const ShaderReflection &reflection) const {
+    std::lock_guard lock(cache_mutex_);
+    if (auto it = cache_.find(key); it != cache_.end() && !it->second.reflection) {
+        it->second.reflection = reflection;
+    }
+}
+
+void ShaderCompilerVulkan::FlushCache() {
+    if (!archive_ || pending_keys_.empty()) {
+        return;
+    }
+    Vec<ShaderArchive::Entry> entries;
+    entries.reserve(pending_keys_.size());
+    for (size_t key : pending_keys_) {
+        const CacheEntry &entry = cache_.at(key);
+        entries.push_back(ShaderArchive::Entry {
+            .name = CacheEntryName(key),
+            .metadata = std::to_string(entry.num_instructions_unoptimized) + " "
+                + std::to_string(entry.optimization_time_ms),
+            .data = entry.spv_bytes,
+        });
+    }
+    archive_->Append(entries);
+    pending_keys_.clear();
+}
+
+std::string ShaderCompilerVulkan::CacheEntryName(size_t key) {
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+    return name;
+}
+
 BISMUTH_GFX_NAMESPACE_END
 
 BISMUTH_NAMESPACE_END
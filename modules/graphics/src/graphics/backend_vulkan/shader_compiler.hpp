@@ -1,5 +1,8 @@
 #pragma once
 
+#include <mutex>
+#include <optional>
+
 #include "graphics/shader_compiler.hpp"
 
 BISMUTH_NAMESPACE_BEGIN
@@ -8,21 +11,55 @@ BISMUTH_GFX_NAMESPACE_BEGIN
 
 class ShaderCompilerVulkan final : public ShaderCompiler {
 public:
-    ShaderCompilerVulkan();
+    // compiled SPIR-V is also cached in 'cache_dir' if it's not empty
+    ShaderCompilerVulkan(const fs::path &cache_dir = {});
     ~ShaderCompilerVulkan() override;
 
     Vec<uint8_t> Compile(const fs::path &src_path, const std::string &entry, ShaderStage stage,
-        const HashMap<std::string, std::string> &defines = {}, const Vec<fs::path> &include_dirs = {}) const override;
+        const HashMap<std::string, std::string> &defines = {}, const Vec<fs::path> &include_dirs = {},
+        const ShaderCompileOptions &options = {}, ShaderCompileInfo *info = nullptr) const override;
 
     const char *BinarySuffix() const override { return ".spv"; }
 
+    const std::string &Version() const override { return version_; }
+
 private:
-    Vec<uint32_t> HlslToSpirv(const std::string &src_filename, const std::string &entry, ShaderStage stage,
-        const HashMap<std::string, std::string> &defines, const Vec<fs::path> &include_dirs) const;
+    // expand includes and defines
+    std::string Preprocess(const std::string &src_filename, const std::string &entry, ShaderStage stage,
+        const HashMap<std::string, std::string> &defines, const Vec<fs::path> &include_dirs,
+        Vec<fs::path> *dependencies) const;
+
+    Vec<uint32_t> HlslToSpirv(const std::string &preprocessed_src, const std::string &src_filename,
+        const std::string &entry, ShaderStage stage, bool final_target) const;
 
     std::string SpirvToGlsl(const Vec<uint32_t> &spv) const;
 
     Vec<uint32_t> GlslToSpirv(const std::string &glsl_src, const std::string &entry, ShaderStage stage) const;
+
+    struct CacheEntry {
+        Vec<uint8_t> spv_bytes;
+        uint32_t num_instructions_unoptimized = 0;
+        double optimization_time_ms = 0.0;
+        // reflected when first requested, entries loaded from archive don't have it
+        std::optional<ShaderReflection> reflection;
+    };
+
+    bool LoadCached(size_t key, CacheEntry &entry) const;
+    void StoreCached(size_t key, const CacheEntry &entry) const;
+    void StoreCachedReflection(size_t key, const ShaderReflection &reflection) const;
+    // append newly compiled binaries to archive
+    void FlushCache();
+
+    static std::string CacheEntryName(size_t key);
+
+    std::string version_;
+
+    // content-addressed, keyed by preprocessed source and compile options
+    mutable std::mutex cache_mutex_;
+    mutable HashMap<size_t, CacheEntry> cache_;
+    mutable Vec<size_t> pending_keys_;
+    // null if binaries are only cached in memory
+    Rc<class ShaderArchive> archive_;
 };
 
 BISMUTH_GFX_NAMESPACE_END
@@ -24,6 +24,39 @@ Ptr<Device> Device::Create(const DeviceDesc &desc) {
     Unreachable();
 }
 
+Vec<AsyncPipeline<RenderPipeline>> Device::CreateRenderPipelinesAsync(Span<RenderPipelineDesc> descs) {
+    auto &thread_pool = PipelineThreadPool();
+    Vec<AsyncPipeline<RenderPipeline>> pipelines;
+    pipelines.reserve(descs.Size());
+    for (const auto &desc : descs) {
+        BI_ASSERT_MSG(HasTargetFormats(desc), "render pipeline created asynchronously has no target formats");
+        pipelines.emplace_back(thread_pool.Submit([this, desc]() { return CreateRenderPipeline(desc); }));
+    }
+    return pipelines;
+}
+
+Vec<AsyncPipeline<ComputePipeline>> Device::CreateComputePipelinesAsync(Span<ComputePipelineDesc> descs) {
+    auto &thread_pool = PipelineThreadPool();
+    Vec<AsyncPipeline<ComputePipeline>> pipelines;
+    pipelines.reserve(descs.Size());
+    for (const auto &desc : descs) {
+        pipelines.emplace_back(thread_pool.Submit([this, desc]() { return CreateComputePipeline(desc); }));
+    }
+    return pipelines;
+}
+
+void Device::WaitPipelineCreation() {
+    if (pipeline_thread_pool_.IsInitialized()) {
+        // remaining tasks are finished when thread pool is destroyed
+        auto thread_pool = std::move(pipeline_thread_pool_);
+    }
+}
+
+ThreadPool &Device::PipelineThreadPool() {
+    std::call_once(pipeline_thread_pool_flag_, [this]() { pipeline_thread_pool_ = Ptr<ThreadPool>::Make(); });
+    return *pipeline_thread_pool_;
+}
+
 BISMUTH_GFX_NAMESPACE_END
 
 BISMUTH_NAMESPACE_END
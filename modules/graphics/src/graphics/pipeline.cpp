@@ -0,0 +1,64 @@
+#include "graphics/pipeline.hpp"
+
+#include <algorithm>
+
+#include <core/logger.hpp>
+
+BISMUTH_NAMESPACE_BEGIN
+
+BISMUTH_GFX_NAMESPACE_BEGIN
+
+namespace {
+
+void MergeReflection(PipelineLayout &layout, const ShaderReflection &reflection) {
+    if (layout.sets_layout.size() < reflection.sets_layout.size()) {
+        layout.sets_layout.resize(reflection.sets_layout.size());
+    }
+    for (size_t set = 0; set < reflection.sets_layout.size(); set++) {
+        auto &bindings = layout.sets_layout[set].bindings;
+        const auto &stage_bindings = reflection.sets_layout[set].bindings;
+        if (bindings.size() < stage_bindings.size()) {
+            bindings.resize(stage_bindings.size());
+        }
+        for (size_t binding = 0; binding < stage_bindings.size(); binding++) {
+            if (stage_bindings[binding].type == DescriptorType::eNone) {
+                continue;
+            }
+            if (bindings[binding].type == DescriptorType::eNone) {
+                bindings[binding] = stage_bindings[binding];
+            } else {
+                BI_ASSERT_MSG(bindings[binding] == stage_bindings[binding],
+                    "shader stages declare different resources at the same binding");
+            }
+        }
+    }
+    layout.push_constants_size = std::max(layout.push_constants_size, reflection.push_constants_size);
+}
+
+}
+
+PipelineLayout ReflectPipelineLayout(const RenderPipelineDesc::Shaders &shaders) {
+    PipelineLayout layout {
+        .push_constants_size = 0,
+    };
+    MergeReflection(layout, shaders.vertex->Reflection());
+    for (const auto shader : { shaders.tessellation_control, shaders.tessellation_evaluation, shaders.geometry }) {
+        if (shader) {
+            MergeReflection(layout, shader->Reflection());
+        }
+    }
+    MergeReflection(layout, shaders.fragment->Reflection());
+    return layout;
+}
+
+PipelineLayout ReflectPipelineLayout(const ShaderModule &compute) {
+    PipelineLayout layout {
+        .push_constants_size = 0,
+    };
+    MergeReflection(layout, compute.Reflection());
+    return layout;
+}
+
+BISMUTH_GFX_NAMESPACE_END
+
+BISMUTH_NAMESPACE_END
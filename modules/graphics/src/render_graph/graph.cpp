@@ -14,41 +14,65 @@ RenderGraph::RenderGraph(Ref<gfx::Device> device, Ref<gfx::Queue> queue, uint32_
         contexts_.emplace_back(std::move(device->CreateFrameContext()));
         resource_pools_.emplace_back(Ptr<ResourcePool>::Make(device));
     }
+    semaphores_.resize(num_frames);
 
     helper_pipelines_ = Ptr<HelperPipelines>::Make(device);
 }
 
+namespace {
+
+enum class NodeKind : uint8_t {
+    eBuffer,
+    eImportedBuffer,
+    eTexture,
+    eImportedTexture,
+    eRenderPass,
+    eComputePass,
+    ePresentPass,
+    eBlitPass,
+};
+
+}
+
 BufferHandle RenderGraph::AddBuffer(const std::string &name, const std::function<void(BufferBuilder &)> &setup_func) {
     BufferBuilder builder {};
     setup_func(builder);
     gfx::BufferDesc desc = builder;
     desc.name = name;
 
-    auto node = Ptr<BufferNode>::Make();
-    node->index = graph_nodes_.size();
-    node->name = name;
-    node->desc = desc;
-    graph_nodes_.emplace_back(std::move(node));
+    size_t node_hash = Hash(NodeKind::eBuffer, name, desc.size, desc.usages, desc.memory_property,
+        desc.persistently_mapped);
+    if (!MatchCachedNode(node_hash)) {
+        auto node = Ptr<BufferNode>::Make();
+        node->name = name;
+        node->desc = desc;
+        PushNode(std::move(node), node_hash);
+    }
 
     BufferHandle handle;
-    handle.node_index_ = graph_nodes_.size() - 1;
+    handle.node_index_ = num_declared_nodes_ - 1;
     return handle;
 }
 
 BufferHandle RenderGraph::ImportBuffer(const std::string &name, Ref<gfx::Buffer> buffer) {
-    auto node = Ptr<BufferNode>::Make();
-    node->index = graph_nodes_.size();
-    node->name = name;
+    size_t node_hash = Hash(NodeKind::eImportedBuffer, name);
+    if (!MatchCachedNode(node_hash)) {
+        auto node = Ptr<BufferNode>::Make();
+        node->name = name;
+        node->imported = true;
+        PushNode(std::move(node), node_hash);
+    }
+
+    // imported buffer may change between frames, always rebind it
+    auto node = graph_nodes_[num_declared_nodes_ - 1].AsRef().CastTo<BufferNode>();
     node->buffer = ResourcePool::Buffer {
         .buffer = buffer,
         .index = static_cast<size_t>(-1),
         .access_type = gfx::ResourceAccessType::eNone,
     };
-    node->imported = true;
-    graph_nodes_.emplace_back(std::move(node));
 
     BufferHandle handle;
-    handle.node_index_ = graph_nodes_.size() - 1;
+    handle.node_index_ = num_declared_nodes_ - 1;
     return handle;
 }
 
@@ -58,40 +82,86 @@ TextureHandle RenderGraph::AddTexture(const std::string &name, const std::functi
     gfx::TextureDesc desc = builder;
     desc.name = name;
 
-    auto node = Ptr<TextureNode>::Make();
-    node->index = graph_nodes_.size();
-    node->name = name;
-    node->desc = desc;
-    graph_nodes_.emplace_back(std::move(node));
+    size_t node_hash = Hash(NodeKind::eTexture, name, desc.extent.width, desc.extent.height,
+        desc.extent.depth_or_layers, desc.levels, desc.format, desc.dim, desc.usages);
+    if (!MatchCachedNode(node_hash)) {
+        auto node = Ptr<TextureNode>::Make();
+        node->name = name;
+        node->desc = desc;
+        PushNode(std::move(node), node_hash);
+    }
 
     TextureHandle handle;
-    handle.node_index_ = graph_nodes_.size() - 1;
+    handle.node_index_ = num_declared_nodes_ - 1;
     return handle;
 }
 
 TextureHandle RenderGraph::ImportTexture(const std::string &name, Ref<gfx::Texture> texture) {
-    auto node = Ptr<TextureNode>::Make();
-    node->index = graph_nodes_.size();
-    node->name = name;
+    size_t node_hash = Hash(NodeKind::eImportedTexture, name);
+    if (!MatchCachedNode(node_hash)) {
+        auto node = Ptr<TextureNode>::Make();
+        node->name = name;
+        node->imported = true;
+        PushNode(std::move(node), node_hash);
+    }
+
+    // imported texture may change between frames (e.g. swap chain texture), always rebind it
+    auto node = graph_nodes_[num_declared_nodes_ - 1].AsRef().CastTo<TextureNode>();
     node->texture = ResourcePool::Texture {
         .texture = texture,
         .index = static_cast<size_t>(-1),
         .access_type = gfx::ResourceAccessType::eNone,
     };
-    node->imported = true;
-    graph_nodes_.emplace_back(std::move(node));
 
     TextureHandle handle;
-    handle.node_index_ = graph_nodes_.size() - 1;
+    handle.node_index_ = num_declared_nodes_ - 1;
     return handle;
 }
 
+template <typename Builder>
+size_t RenderGraph::HashPassAccesses(const Builder &builder) {
+    // entries are summed up so that the result doesn't depend on declaration order
+    size_t hash = 0;
+    for (const auto &[id, handle] : builder.read_buffers_) {
+        hash += Hash(id.value, handle.handle.node_index_, handle.type);
+    }
+    for (const auto &[id, handle] : builder.write_buffers_) {
+        hash += Hash(id.value, handle.handle.node_index_);
+    }
+    for (const auto &[id, handle] : builder.read_textures_) {
+        hash += Hash(id.value, handle.handle.node_index_);
+    }
+    for (const auto &[id, handle] : builder.write_textures_) {
+        hash += Hash(id.value, handle.handle.node_index_, handle.generate_mipmaps);
+    }
+    return hash;
+}
+
 void RenderGraph::AddRenderPass(const std::string &name,
     const std::function<void(struct RenderPassBuilder &)> &setup_func,
     const std::function<void(Ref<gfx::RenderCommandEncoder>, const PassResource &)> &execute_func) {
     RenderPassBuilder builder {};
     setup_func(builder);
 
+    size_t node_hash = Hash(NodeKind::eRenderPass, name, HashPassAccesses(builder));
+    for (size_t i = 0; i < gfx::kMaxRenderTargetsCount; i++) {
+        const auto &target_opt = builder.color_targets_[i];
+        node_hash = HashCombine(node_hash, target_opt.has_value()
+            ? Hash(i, target_opt.value().handle.node_index_) : static_cast<size_t>(-1));
+    }
+    if (builder.depth_stencil_target_.has_value()) {
+        node_hash = HashCombine(node_hash, builder.depth_stencil_target_.value().handle.node_index_);
+    }
+
+    if (MatchCachedNode(node_hash)) {
+        // structure is unchanged, only rebind execution function and target parameters
+        auto node = graph_nodes_[num_declared_nodes_ - 1].AsRef().CastTo<RenderPassNode>();
+        node->execute_func = execute_func;
+        std::copy_n(builder.color_targets_, gfx::kMaxRenderTargetsCount, node->color_targets);
+        node->depth_stencil_target = builder.depth_stencil_target_;
+        return;
+    }
+
     auto node = Ptr<RenderPassNode>::Make();
     node->index = graph_nodes_.size();
     node->name = name;
@@ -101,6 +171,18 @@ void RenderGraph::AddRenderPass(const std::string &name,
     node->resource.write_buffers_ = std::move(builder.write_buffers_);
     node->resource.read_textures_ = std::move(builder.read_textures_);
     node->resource.write_textures_ = std::move(builder.write_textures_);
+    {
+        Vec<TextureHandle> target_handles;
+        for (const auto &target_opt : builder.color_targets_) {
+            if (target_opt.has_value()) {
+                target_handles.push_back(target_opt.value().handle);
+            }
+        }
+        if (builder.depth_stencil_target_.has_value()) {
+            target_handles.push_back(builder.depth_stencil_target_.value().handle);
+        }
+        node->resource.ResolveSlots(target_handles);
+    }
     std::copy_n(builder.color_targets_, gfx::kMaxRenderTargetsCount, node->color_targets);
     node->num_color_targets = gfx::kMaxRenderTargetsCount;
     while (node->num_color_targets > 0) {
@@ -135,7 +217,7 @@ void RenderGraph::AddRenderPass(const std::string &name,
         AddEdge(node.AsRef(), graph_nodes_[target.handle.node_index_]);
     }
 
-    graph_nodes_.emplace_back(std::move(node));
+    PushNode(std::move(node), node_hash);
 }
 
 void RenderGraph::AddComputePass(const std::string &name,
@@ -144,15 +226,24 @@ void RenderGraph::AddComputePass(const std::string &name,
     ComputePassBuilder builder {};
     setup_func(builder);
 
+    size_t node_hash = Hash(NodeKind::eComputePass, name, HashPassAccesses(builder), builder.async_compute_);
+    if (MatchCachedNode(node_hash)) {
+        auto node = graph_nodes_[num_declared_nodes_ - 1].AsRef().CastTo<ComputePassNode>();
+        node->execute_func = execute_func;
+        return;
+    }
+
     auto node = Ptr<ComputePassNode>::Make();
     node->index = graph_nodes_.size();
     node->name = name;
     node->execute_func = execute_func;
+    node->prefer_async_compute = builder.async_compute_;
     node->resource.graph_ = this;
     node->resource.read_buffers_ = std::move(builder.read_buffers_);
     node->resource.write_buffers_ = std::move(builder.write_buffers_);
     node->resource.read_textures_ = std::move(builder.read_textures_);
     node->resource.write_textures_ = std::move(builder.write_textures_);
+    node->resource.ResolveSlots({});
 
     for (const auto &[_, handle] : node->resource.read_buffers_) {
         AddEdge(graph_nodes_[handle.handle.node_index_], node.AsRef());
@@ -167,24 +258,42 @@ void RenderGraph::AddComputePass(const std::string &name,
         AddEdge(node.AsRef(), graph_nodes_[handle.handle.node_index_]);
     }
 
-    graph_nodes_.emplace_back(std::move(node));
+    PushNode(std::move(node), node_hash);
 }
 
 void RenderGraph::AddPresentPass(TextureHandle texture) {
+    size_t node_hash = Hash(NodeKind::ePresentPass, texture.node_index_);
+    if (MatchCachedNode(node_hash)) {
+        return;
+    }
+
     auto node = Ptr<PresentPassNode>::Make();
     node->index = graph_nodes_.size();
     node->name = "present pass";
     node->texture = texture;
     AddEdge(graph_nodes_[texture.node_index_], node.AsRef());
     present_pass_index_ = graph_nodes_.size();
-    graph_nodes_.emplace_back(std::move(node));
+    PushNode(std::move(node), node_hash);
 }
 
 void RenderGraph::AddBlitPass(const std::string &name, const std::function<void(BlitPassBuilder &)> &setup_func) {
     BlitPassBuilder builder {};
     setup_func(builder);
 
+    size_t node_hash = Hash(NodeKind::eBlitPass, name, builder.src_handle_.node_index_,
+        builder.dst_handle_.node_index_);
+    if (MatchCachedNode(node_hash)) {
+        auto node = graph_nodes_[num_declared_nodes_ - 1].AsRef().CastTo<BlitPassNode>();
+        node->src_level = builder.src_level_;
+        node->src_layer = builder.src_layer_;
+        node->dst_level = builder.dst_level_;
+        node->dst_layer = builder.dst_layer_;
+        return;
+    }
+
     auto node = Ptr<BlitPassNode>::Make();
+    node->index = graph_nodes_.size();
+    node->name = name;
     node->src_handle = builder.src_handle_;
     node->src_level = builder.src_level_;
     node->src_layer = builder.src_layer_;
@@ -195,7 +304,7 @@ void RenderGraph::AddBlitPass(const std::string &name, const std::function<void(
     AddEdge(graph_nodes_[builder.src_handle_.node_index_], node.AsRef());
     AddEdge(node.AsRef(), graph_nodes_[builder.dst_handle_.node_index_]);
 
-    graph_nodes_.emplace_back(std::move(node));
+    PushNode(std::move(node), node_hash);
 }
 
 void RenderGraph::AddEdge(Ref<Node> from, Ref<Node> to) {
@@ -203,7 +312,48 @@ void RenderGraph::AddEdge(Ref<Node> from, Ref<Node> to) {
     to->in_nodes.push_back(from);
 }
 
+bool RenderGraph::MatchCachedNode(size_t node_hash) {
+    if (num_declared_nodes_ < graph_nodes_.size()) {
+        if (node_hashes_[num_declared_nodes_] == node_hash) {
+            ++num_declared_nodes_;
+            return true;
+        }
+        DropCachedNodes(num_declared_nodes_);
+    }
+    return false;
+}
+
+void RenderGraph::PushNode(Ptr<Node> &&node, size_t node_hash) {
+    node->index = graph_nodes_.size();
+    graph_nodes_.emplace_back(std::move(node));
+    node_hashes_.push_back(node_hash);
+    num_declared_nodes_ = graph_nodes_.size();
+    compiled_ = false;
+}
+
+void RenderGraph::DropCachedNodes(size_t from) {
+    graph_nodes_.resize(from);
+    node_hashes_.resize(from);
+    auto is_dropped = [from](const Ref<Node> &v) { return v->index >= from; };
+    for (auto &node : graph_nodes_) {
+        std::erase_if(node->in_nodes, is_dropped);
+        std::erase_if(node->out_nodes, is_dropped);
+    }
+    if (present_pass_index_ >= from) {
+        present_pass_index_ = static_cast<size_t>(-1);
+    }
+    compiled_ = false;
+}
+
 void RenderGraph::Compile() {
+    // passes or resources declared last frame but not in this frame
+    if (num_declared_nodes_ < graph_nodes_.size()) {
+        DropCachedNodes(num_declared_nodes_);
+    }
+    if (compiled_) {
+        return;
+    }
+
     // cull unused passes using prsent pass node
     Vec<bool> used(graph_nodes_.size(), false);
     Vec<size_t> queue(graph_nodes_.size(), 0);
@@ -234,126 +384,779 @@ void RenderGraph::Compile() {
     // toposort
     graph_order_.clear();
     graph_order_.reserve(graph_nodes_.size());
-    resources_to_create_.resize(graph_nodes_.size(), {});
-    resources_to_destroy_.resize(graph_nodes_.size(), {});
+    resources_to_create_.assign(graph_nodes_.size(), {});
+    resources_to_destroy_.assign(graph_nodes_.size(), {});
 
-    queue.resize(graph_nodes_.size(), 0);
-    ql = 0;
-    qr = 0;
-    Vec<size_t> in_degs(graph_nodes_.size(), 0);
-    for (size_t i = 0; i < graph_nodes_.size(); i++) {
-        if (!used[i]) {
-            continue;
-        }
-        in_degs[i] = graph_nodes_[i]->in_nodes.size();
-        if (in_degs[i] == 0) {
-            queue[qr++] = i;
+    if (pass_ordering_ == PassOrdering::eOptimized) {
+        SchedulePasses(used);
+    } else {
+        queue.resize(graph_nodes_.size(), 0);
+        ql = 0;
+        qr = 0;
+        Vec<size_t> in_degs(graph_nodes_.size(), 0);
+        for (size_t i = 0; i < graph_nodes_.size(); i++) {
+            if (!used[i]) {
+                continue;
+            }
+            in_degs[i] = graph_nodes_[i]->in_nodes.size();
+            if (in_degs[i] == 0) {
+                queue[qr++] = i;
+            }
         }
-    }
 
-    Vec<size_t> order_of(graph_nodes_.size(), 0);
-    while (ql < qr) {
-        size_t index = queue[ql++];
-        order_of[index] = graph_order_.size();
-        graph_order_.push_back(index);
+        while (ql < qr) {
+            size_t index = queue[ql++];
+            graph_order_.push_back(index);
 
-        for (const auto &v : graph_nodes_[index]->out_nodes) {
-            if (used[v->index] && --in_degs[v->index] == 0) {
-                queue[qr++] = v->index;
+            for (const auto &v : graph_nodes_[index]->out_nodes) {
+                if (used[v->index] && --in_degs[v->index] == 0) {
+                    queue[qr++] = v->index;
+                }
             }
         }
     }
 
+    Vec<size_t> order_of(graph_nodes_.size(), 0);
+    for (size_t order = 0; order < graph_order_.size(); order++) {
+        order_of[graph_order_[order]] = order;
+    }
+
+    Vec<size_t> lifetime_start(graph_nodes_.size(), 0);
+    Vec<size_t> lifetime_end(graph_nodes_.size(), 0);
     for (const auto &node : graph_nodes_) {
-        if (node->IsResource()) {
-            size_t start = graph_nodes_.size();
+        if (node->IsResource() && used[node->index]) {
+            size_t start = order_of[node->index];
             for (const auto &v : node->in_nodes) {
                 start = std::min(start, order_of[v->index]);
             }
             resources_to_create_[start].push_back(node->index);
+            lifetime_start[node->index] = start;
 
-            size_t end = 0;
+            size_t end = order_of[node->index];
             for (const auto &v : node->out_nodes) {
-                end = std::max(end, order_of[v->index]);
+                if (used[v->index]) {
+                    end = std::max(end, order_of[v->index]);
+                }
             }
             resources_to_destroy_[end].push_back(node->index);
+            lifetime_end[node->index] = end;
+        }
+    }
+
+    AssignAsyncCompute(used);
+
+    PlanBarriers();
+
+    PlanTransientMemory(used, lifetime_start, lifetime_end);
+
+    PlanBarrierBatches();
+
+    Vec<uint64_t> live_size_delta(graph_order_.size() + 1, 0);
+    Vec<uint64_t> dead_size_delta(graph_order_.size() + 1, 0);
+    for (const size_t index : graph_order_) {
+        if (graph_nodes_[index]->IsResource()) {
+            uint64_t size = TransientSize(*graph_nodes_[index]);
+            live_size_delta[lifetime_start[index]] += size;
+            dead_size_delta[lifetime_end[index] + 1] += size;
         }
     }
+    uint64_t live_size = 0;
+    for (size_t order = 0; order < graph_order_.size(); order++) {
+        live_size = live_size + live_size_delta[order] - dead_size_delta[order];
+        transient_memory_stats_.peak_live_size = std::max(transient_memory_stats_.peak_live_size, live_size);
+    }
+
+    BuildCompileReport(used, lifetime_start, lifetime_end);
 
     // check
+    if (graph_order_.size() < static_cast<size_t>(std::count(used.begin(), used.end(), true))) {
+        BI_WARN(ModuleManager::Get<GraphicsModule>()->Lgr(), "Cycle has been found in render graph.");
+    }
+
+    compiled_ = true;
+}
+
+void RenderGraph::BuildCompileReport(const Vec<bool> &used, const Vec<size_t> &lifetime_start,
+    const Vec<size_t> &lifetime_end) {
+    auto &report = compile_report_;
+    report = CompileReport {
+        .unaliased_size = transient_memory_stats_.unaliased_size,
+        .aliased_size = transient_memory_stats_.aliased_size,
+        .peak_live_size = transient_memory_stats_.peak_live_size,
+    };
+    report.nodes.resize(graph_nodes_.size());
     for (const auto &node : graph_nodes_) {
-        if (used[node->index] && in_degs[node->index] > 0) {
-            BI_WARN(ModuleManager::Get<GraphicsModule>()->Lgr(), "Cycle has been found in render graph.");
-            break;
+        auto &report_node = report.nodes[node->index];
+        report_node.name = node->name;
+        report_node.is_resource = node->IsResource();
+        report_node.culled = !used[node->index];
+        for (const auto &v : node->out_nodes) {
+            report_node.out_nodes.push_back(v->index);
+        }
+
+        if (node->IsResource()) {
+            ++report.num_resources;
+            report.num_culled_resources += report_node.culled ? 1 : 0;
+            if (auto buffer_node = dynamic_cast<const BufferNode *>(node.Get()); buffer_node) {
+                report_node.imported = buffer_node->imported;
+            } else {
+                report_node.imported = dynamic_cast<const TextureNode *>(node.Get())->imported;
+            }
+            report_node.size = TransientSize(*node);
+            report_node.lifetime_start = lifetime_start[node->index];
+            report_node.lifetime_end = lifetime_end[node->index];
+            const auto &placement = transient_placements_[node->index];
+            if (placement.heap != static_cast<size_t>(-1)) {
+                report_node.placed = true;
+                report_node.heap = placement.heap;
+                report_node.offset = placement.offset;
+            }
+        } else {
+            ++report.num_passes;
+            report.num_culled_passes += report_node.culled ? 1 : 0;
+            report_node.async_compute = node->async_compute;
+            report_node.num_planned_split_barriers = node->split_barrier_plans.size();
+        }
+    }
+    for (size_t order = 0; order < graph_order_.size(); order++) {
+        report.nodes[graph_order_[order]].order = order;
+    }
+}
+
+void RenderGraph::UpdateCompileReport() {
+    auto &report = compile_report_;
+    report.num_barriers = 0;
+    for (const size_t index : graph_order_) {
+        const auto &node = graph_nodes_[index];
+        if (!node->IsResource()) {
+            auto &report_node = report.nodes[index];
+            report_node.num_barriers = node->num_barriers;
+            report_node.num_split_barriers = node->end_split_barriers.size();
+            report.num_barriers += report_node.num_barriers;
         }
     }
+    report.num_barrier_batches = std::count_if(graph_order_.begin(), graph_order_.end(), [this](size_t index) {
+        return !graph_nodes_[index]->buffer_barriers.empty() || !graph_nodes_[index]->texture_barriers.empty();
+    });
+    const auto &pool_stats = resource_pools_[curr_frame_]->GetStats();
+    report.num_pool_hits = pool_stats.num_hits;
+    report.num_pool_misses = pool_stats.num_misses;
+}
+
+uint64_t RenderGraph::TransientSize(const Node &node) const {
+    if (auto buffer_node = dynamic_cast<const BufferNode *>(&node); buffer_node) {
+        return buffer_node->imported ? 0 : device_->GetBufferMemoryRequirements(buffer_node->desc).size;
+    } else if (auto texture_node = dynamic_cast<const TextureNode *>(&node); texture_node) {
+        return texture_node->imported ? 0 : device_->GetTextureMemoryRequirements(texture_node->desc).size;
+    }
+    return 0;
+}
+
+void RenderGraph::SchedulePasses(const Vec<bool> &used) {
+    // for resources, number of writers not scheduled yet; for passes, number of inputs not completely written yet
+    Vec<size_t> pending(graph_nodes_.size(), 0);
+    Vec<size_t> num_users(graph_nodes_.size(), 0);
+    Vec<size_t> remaining_users(graph_nodes_.size(), 0);
+    Vec<uint64_t> sizes(graph_nodes_.size(), 0);
+    Vec<gfx::ResourceAccessType> access_types(graph_nodes_.size(), gfx::ResourceAccessType::eNone);
+    Vec<bool> scheduled(graph_nodes_.size(), false);
+    auto count_used = [&used](const Vec<Ref<Node>> &nodes) {
+        return static_cast<size_t>(std::count_if(nodes.begin(), nodes.end(),
+            [&used](const Ref<Node> &v) { return used[v->index]; }));
+    };
+    for (const auto &node : graph_nodes_) {
+        if (used[node->index] && node->IsResource()) {
+            pending[node->index] = count_used(node->in_nodes);
+            num_users[node->index] = pending[node->index] + count_used(node->out_nodes);
+            remaining_users[node->index] = num_users[node->index];
+            sizes[node->index] = TransientSize(*node);
+        }
+    }
+    Vec<size_t> ready;
+    for (const auto &node : graph_nodes_) {
+        if (used[node->index] && !node->IsResource()) {
+            pending[node->index] = std::count_if(node->in_nodes.begin(), node->in_nodes.end(),
+                [&pending](const Ref<Node> &v) { return pending[v->index] > 0; });
+            if (pending[node->index] == 0) {
+                ready.push_back(node->index);
+            }
+        }
+    }
+
+    Vec<ResourceAccess> accesses;
+    while (!ready.empty()) {
+        // pick pass with least transient memory growth, then least state changes, then earliest declared
+        size_t best = 0;
+        int64_t best_memory_delta = 0;
+        size_t best_state_changes = 0;
+        for (size_t i = 0; i < ready.size(); i++) {
+            const auto &node = graph_nodes_[ready[i]];
+            int64_t memory_delta = 0;
+            auto add_memory_delta = [&](const Ref<Node> &v) {
+                // allocated by first user and released after last user
+                if (remaining_users[v->index] == num_users[v->index]) {
+                    memory_delta += static_cast<int64_t>(sizes[v->index]);
+                }
+                if (remaining_users[v->index] == 1) {
+                    memory_delta -= static_cast<int64_t>(sizes[v->index]);
+                }
+            };
+            std::for_each(node->in_nodes.begin(), node->in_nodes.end(), add_memory_delta);
+            std::for_each(node->out_nodes.begin(), node->out_nodes.end(), add_memory_delta);
+
+            accesses.clear();
+            node->GetAccesses(accesses);
+            size_t state_changes = std::count_if(accesses.begin(), accesses.end(),
+                [&access_types](const ResourceAccess &v) { return access_types[v.index] != v.access_type; });
+
+            if (i == 0 || std::tie(memory_delta, state_changes, node->index)
+                < std::tie(best_memory_delta, best_state_changes, graph_nodes_[ready[best]]->index)) {
+                best = i;
+                best_memory_delta = memory_delta;
+                best_state_changes = state_changes;
+            }
+        }
+        size_t index = ready[best];
+        ready.erase(ready.begin() + best);
+        const auto &node = graph_nodes_[index];
+
+        // resources without writers are put right before their first user
+        for (const auto &v : node->in_nodes) {
+            if (!scheduled[v->index]) {
+                scheduled[v->index] = true;
+                graph_order_.push_back(v->index);
+            }
+            --remaining_users[v->index];
+        }
+        scheduled[index] = true;
+        graph_order_.push_back(index);
+
+        accesses.clear();
+        node->GetAccesses(accesses);
+        for (const auto &access : accesses) {
+            access_types[access.index] = access.access_type;
+        }
+
+        for (const auto &v : node->out_nodes) {
+            --remaining_users[v->index];
+            if (--pending[v->index] > 0) {
+                continue;
+            }
+            scheduled[v->index] = true;
+            graph_order_.push_back(v->index);
+            for (const auto &reader : v->out_nodes) {
+                if (used[reader->index] && --pending[reader->index] == 0) {
+                    ready.push_back(reader->index);
+                }
+            }
+        }
+    }
+
+    // resources not used by any pass
+    for (size_t i = 0; i < graph_nodes_.size(); i++) {
+        if (used[i] && !scheduled[i] && graph_nodes_[i]->IsResource() && pending[i] == 0) {
+            graph_order_.push_back(i);
+        }
+    }
+}
+
+void RenderGraph::AssignAsyncCompute(const Vec<bool> &used) {
+    async_compute_stats_ = {};
+    for (auto &node : graph_nodes_) {
+        node->async_compute = false;
+    }
+    if (async_compute_queue_ == nullptr) {
+        return;
+    }
+
+    // mark ancestors or descendants of a pass, passes not marked may run at the same time as it
+    Vec<bool> related(graph_nodes_.size(), false);
+    Vec<size_t> queue(graph_nodes_.size(), 0);
+    auto mark_related = [&](size_t index, bool forward) {
+        size_t ql = 0, qr = 0;
+        queue[qr++] = index;
+        while (ql < qr) {
+            const auto &node = graph_nodes_[queue[ql++]];
+            for (const auto &v : forward ? node->out_nodes : node->in_nodes) {
+                if (used[v->index] && !related[v->index]) {
+                    related[v->index] = true;
+                    queue[qr++] = v->index;
+                }
+            }
+        }
+    };
+
+    for (const size_t index : graph_order_) {
+        auto compute_node = dynamic_cast<ComputePassNode *>(graph_nodes_[index].Get());
+        if (compute_node == nullptr) {
+            continue;
+        }
+        // mipmaps are generated by graphics pipelines
+        bool generate_mipmaps = std::any_of(compute_node->resource.write_textures_.begin(),
+            compute_node->resource.write_textures_.end(), [](const auto &v) { return v.second.generate_mipmaps; });
+        if (generate_mipmaps) {
+            continue;
+        }
+
+        bool async_compute = compute_node->prefer_async_compute;
+        if (!async_compute && async_compute_auto_select_) {
+            std::fill(related.begin(), related.end(), false);
+            related[index] = true;
+            mark_related(index, true);
+            mark_related(index, false);
+            async_compute = std::any_of(graph_order_.begin(), graph_order_.end(), [&](size_t v) {
+                return !related[v] && dynamic_cast<const RenderPassNode *>(graph_nodes_[v].Get()) != nullptr;
+            });
+        }
+        compute_node->async_compute = async_compute;
+        if (async_compute) {
+            ++async_compute_stats_.num_async_passes;
+        }
+    }
+}
+
+void RenderGraph::GetShaderAccesses(const PassResource &resource, bool is_render_pass,
+    Vec<ResourceAccess> &accesses) {
+    for (const auto &[_, handle] : resource.read_buffers_) {
+        accesses.push_back({ handle.handle.node_index_, PassResource::ReadBufferAccessType(handle.type, is_render_pass) });
+    }
+    for (const auto &[_, handle] : resource.read_textures_) {
+        accesses.push_back({ handle.handle.node_index_, PassResource::ReadTextureAccessType(is_render_pass) });
+    }
+    for (const auto &[_, handle] : resource.write_buffers_) {
+        accesses.push_back({ handle.handle.node_index_, PassResource::WriteAccessType(is_render_pass) });
+    }
+    for (const auto &[_, handle] : resource.write_textures_) {
+        accesses.push_back({ handle.handle.node_index_, PassResource::WriteAccessType(is_render_pass) });
+    }
+}
+
+void RenderGraph::PlanBarriers() {
+    constexpr size_t kNone = static_cast<size_t>(-1);
+    // order and pass count of the last pass accessing each resource
+    Vec<size_t> last_order(graph_nodes_.size(), kNone);
+    Vec<size_t> last_pass(graph_nodes_.size(), kNone);
+    Vec<ResourceAccess> accesses;
+    size_t num_passes = 0;
+
+    for (auto &node : graph_nodes_) {
+        node->barrier_plans.clear();
+        node->split_barrier_plans.clear();
+    }
+    for (size_t order = 0; order < graph_order_.size(); order++) {
+        const auto &node = graph_nodes_[graph_order_[order]];
+        if (node->IsResource()) {
+            continue;
+        }
+
+        accesses.clear();
+        node->GetAccesses(accesses);
+        for (const auto &access : accesses) {
+            bool is_buffer = dynamic_cast<const BufferNode *>(graph_nodes_[access.index].Get()) != nullptr;
+            node->barrier_plans.push_back({ access.index, access.access_type, is_buffer });
+        }
+        for (const auto &access : accesses) {
+            size_t producer_order = last_order[access.index];
+            // transition can overlap passes between the previous user and this one, if there is any
+            if (producer_order == kNone || num_passes - last_pass[access.index] < 2) {
+                continue;
+            }
+            // resources accessed more than once in a pass keep regular barriers
+            auto num_accesses = std::count_if(accesses.begin(), accesses.end(),
+                [&access](const ResourceAccess &v) { return v.index == access.index; });
+            const auto &producer = graph_nodes_[graph_order_[producer_order]];
+            if (num_accesses > 1 || producer->async_compute || node->async_compute) {
+                continue;
+            }
+            producer->split_barrier_plans.push_back({ access.index, order, access.access_type });
+        }
+
+        for (const auto &v : node->in_nodes) {
+            last_order[v->index] = order;
+            last_pass[v->index] = num_passes;
+        }
+        for (const auto &v : node->out_nodes) {
+            last_order[v->index] = order;
+            last_pass[v->index] = num_passes;
+        }
+        ++num_passes;
+    }
+}
+
+void RenderGraph::PlanTransientMemory(const Vec<bool> &used, const Vec<size_t> &lifetime_start,
+    const Vec<size_t> &lifetime_end) {
+    auto last_placements = std::move(transient_placements_);
+    auto last_heaps = std::move(transient_heaps_);
+    transient_placements_.assign(graph_nodes_.size(), {});
+    transient_heaps_.clear();
+    transient_memory_stats_ = {};
+    auto update_version = [&]() {
+        const bool changed = transient_heaps_ != last_heaps || transient_placements_ != last_placements;
+        if (changed) {
+            ++transient_heaps_version_;
+        }
+        return changed;
+    };
+    if (!memory_aliasing_) {
+        update_version();
+        return;
+    }
+
+    struct Candidate {
+        size_t index;
+        bool is_buffer;
+        gfx::ResourceMemoryRequirements requirements;
+    };
+    Vec<Candidate> candidates;
+    auto is_async_compute = [](const Ref<Node> &v) { return v->async_compute; };
+    for (const auto &node : graph_nodes_) {
+        if (!used[node->index]) {
+            continue;
+        }
+        // memory reuse across queues can't be ordered by barriers, resources used on async compute queue are not aliased
+        if (std::any_of(node->in_nodes.begin(), node->in_nodes.end(), is_async_compute)
+            || std::any_of(node->out_nodes.begin(), node->out_nodes.end(), is_async_compute)) {
+            continue;
+        }
+        if (auto buffer_node = dynamic_cast<const BufferNode *>(node.Get()); buffer_node) {
+            // cpu visible buffers keep their own allocation
+            if (buffer_node->imported || buffer_node->desc.memory_property != gfx::BufferMemoryProperty::eGpuOnly
+                || buffer_node->desc.persistently_mapped) {
+                continue;
+            }
+            candidates.push_back({ node->index, true, device_->GetBufferMemoryRequirements(buffer_node->desc) });
+        } else if (auto texture_node = dynamic_cast<const TextureNode *>(node.Get()); texture_node) {
+            if (texture_node->imported) {
+                continue;
+            }
+            candidates.push_back({ node->index, false, device_->GetTextureMemoryRequirements(texture_node->desc) });
+        } else {
+            continue;
+        }
+        transient_memory_stats_.unaliased_size += candidates.back().requirements.size;
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+        return a.requirements.size > b.requirements.size;
+    });
+
+    // greedy first fit, resources whose lifetimes don't overlap may share memory
+    struct PlacedRange {
+        size_t index;
+        uint64_t offset;
+        uint64_t size;
+    };
+    Vec<Vec<PlacedRange>> heap_ranges;
+    Vec<bool> heap_for_buffers;
+    Vec<PlacedRange> overlapped;
+    for (const auto &candidate : candidates) {
+        const auto &requirements = candidate.requirements;
+        // buffers and textures are kept in different heaps to avoid buffer-image granularity issues
+        size_t heap = 0;
+        while (heap < transient_heaps_.size()) {
+            if (heap_for_buffers[heap] == candidate.is_buffer
+                && (transient_heaps_[heap].memory_type_bits & requirements.memory_type_bits) != 0) {
+                break;
+            }
+            ++heap;
+        }
+        if (heap == transient_heaps_.size()) {
+            transient_heaps_.push_back(gfx::MemoryHeapDesc {
+                .name = "transient heap " + std::to_string(heap),
+                .memory_type_bits = requirements.memory_type_bits,
+            });
+            heap_ranges.emplace_back();
+            heap_for_buffers.push_back(candidate.is_buffer);
+        }
+
+        overlapped.clear();
+        for (const auto &range : heap_ranges[heap]) {
+            if (lifetime_start[range.index] <= lifetime_end[candidate.index]
+                && lifetime_start[candidate.index] <= lifetime_end[range.index]) {
+                overlapped.push_back(range);
+            }
+        }
+        std::sort(overlapped.begin(), overlapped.end(), [](const PlacedRange &a, const PlacedRange &b) {
+            return a.offset < b.offset;
+        });
+        uint64_t offset = 0;
+        for (const auto &range : overlapped) {
+            if (offset + requirements.size <= range.offset) {
+                break;
+            }
+            uint64_t range_end = range.offset + range.size;
+            offset = std::max(offset, (range_end + requirements.alignment - 1) / requirements.alignment
+                * requirements.alignment);
+        }
+
+        heap_ranges[heap].push_back({ candidate.index, offset, requirements.size });
+        transient_placements_[candidate.index] = { heap, offset };
+        auto &heap_desc = transient_heaps_[heap];
+        heap_desc.size = std::max(heap_desc.size, offset + requirements.size);
+        heap_desc.alignment = std::max(heap_desc.alignment, requirements.alignment);
+        heap_desc.memory_type_bits &= requirements.memory_type_bits;
+    }
+
+    for (const auto &heap_desc : transient_heaps_) {
+        transient_memory_stats_.aliased_size += heap_desc.size;
+    }
+    // only logged when plan changes, graphs that are not persistent are compiled every frame
+    if (update_version() && !candidates.empty()) {
+        BI_INFO(ModuleManager::Get<GraphicsModule>()->Lgr(),
+            "Render graph transient memory: {} bytes without aliasing, {} bytes in {} heaps with aliasing.",
+            transient_memory_stats_.unaliased_size, transient_memory_stats_.aliased_size, transient_heaps_.size());
+    }
 }
 
 void RenderGraph::BufferNode::Create(RenderGraph &rg) {
     if (!buffer.has_value()) {
-        buffer = rg.resource_pools_[rg.curr_frame_]->GetBuffer(desc);
+        const auto &placement = rg.transient_placements_[index];
+        if (placement.heap < rg.transient_heaps_.size()) {
+            buffer = rg.resource_pools_[rg.curr_frame_]->GetPlacedBuffer(desc, placement.heap, placement.offset);
+        } else {
+            buffer = rg.resource_pools_[rg.curr_frame_]->GetBuffer(desc);
+        }
     }
 }
 
 void RenderGraph::BufferNode::Destroy(RenderGraph &rg) {
     if (!imported && buffer.has_value()) {
-        rg.resource_pools_[rg.curr_frame_]->RemoveBuffer(desc, buffer.value());
+        if (rg.transient_placements_[index].heap < rg.transient_heaps_.size()) {
+            rg.resource_pools_[rg.curr_frame_]->RemovePlacedBuffer(buffer.value());
+        } else {
+            rg.resource_pools_[rg.curr_frame_]->RemoveBuffer(desc, buffer.value());
+        }
         buffer = std::nullopt;
     }
 }
 
 void RenderGraph::TextureNode::Create(RenderGraph &rg) {
     if (!texture.has_value()) {
-        texture = rg.resource_pools_[rg.curr_frame_]->GetTexure(desc);
+        const auto &placement = rg.transient_placements_[index];
+        if (placement.heap < rg.transient_heaps_.size()) {
+            texture = rg.resource_pools_[rg.curr_frame_]->GetPlacedTexture(desc, placement.heap, placement.offset);
+        } else {
+            texture = rg.resource_pools_[rg.curr_frame_]->GetTexure(desc);
+        }
     }
 }
 
 void RenderGraph::TextureNode::Destroy(RenderGraph &rg) {
     if (!imported && texture.has_value()) {
-        rg.resource_pools_[rg.curr_frame_]->RemoveTexture(desc, texture.value());
+        if (rg.transient_placements_[index].heap < rg.transient_heaps_.size()) {
+            rg.resource_pools_[rg.curr_frame_]->RemovePlacedTexture(texture.value());
+        } else {
+            rg.resource_pools_[rg.curr_frame_]->RemoveTexture(desc, texture.value());
+        }
         texture = std::nullopt;
     }
 }
 
-void RenderGraph::RenderPassNode::SetBarriers(const Ptr<gfx::CommandEncoder> &cmd_encoder, RenderGraph &rg) {
-    Vec<gfx::BufferBarrier> buffer_barriers;
-    Vec<gfx::TextureBarrier> texture_barriers;
-
-    resource.GetShaderBarriers(rg, true, buffer_barriers, texture_barriers);
+void RenderGraph::PlanBarrierBatches() {
+    constexpr size_t kNone = static_cast<size_t>(-1);
+    for (const size_t index : graph_order_) {
+        graph_nodes_[index]->barrier_batch_end = 0;
+    }
+    // passes on different queues are recorded to different submissions
+    if (async_compute_stats_.num_async_passes > 0) {
+        return;
+    }
 
-    auto target_access_type = gfx::ResourceAccessType::eColorAttachmentWrite;
-    for (size_t i = 0; i < gfx::kMaxRenderTargetsCount; i++) {
-        const auto &target_opt = color_targets[i];
-        if (!target_opt.has_value()) {
+    // first pass of the batch that last accessed each resource
+    Vec<size_t> batch_of(graph_nodes_.size(), kNone);
+    size_t batch_begin = kNone;
+    for (size_t order = 0; order < graph_order_.size(); order++) {
+        // placed resources may alias memory used by earlier passes of the batch,
+        // barriers on them can't be recorded before these passes
+        const auto &to_create = resources_to_create_[order];
+        if (std::any_of(to_create.begin(), to_create.end(),
+            [this](size_t index) { return transient_placements_[index].heap != kNone; })) {
+            batch_begin = kNone;
+        }
+        const auto &node = graph_nodes_[graph_order_[order]];
+        if (node->IsResource()) {
             continue;
         }
 
-        const auto &target = target_opt.value();
-        auto &texture = rg.Texture(target.handle);
-        if (target_access_type != texture.access_type) {
-            texture_barriers.push_back(gfx::TextureBarrier {
-                .texture = { texture.texture },
-                .src_access_type = texture.access_type,
-                .dst_access_type = target_access_type,
-            });
-            texture.access_type = target_access_type;
+        bool independent = batch_begin != kNone;
+        for (const auto &v : node->in_nodes) {
+            independent = independent && batch_of[v->index] != batch_begin;
+        }
+        for (const auto &v : node->out_nodes) {
+            independent = independent && batch_of[v->index] != batch_begin;
+        }
+        if (!independent) {
+            batch_begin = order;
+        }
+        graph_nodes_[graph_order_[batch_begin]]->barrier_batch_end = order + 1;
+
+        for (const auto &v : node->in_nodes) {
+            batch_of[v->index] = batch_begin;
+        }
+        for (const auto &v : node->out_nodes) {
+            batch_of[v->index] = batch_begin;
         }
     }
-    if (depth_stencil_target.has_value()) {
-        target_access_type = gfx::ResourceAccessType::eDepthStencilAttachmentWrite;
-        const auto &target = depth_stencil_target.value();
-        auto &texture = rg.Texture(target.handle);
-        if (target_access_type != texture.access_type) {
-            texture_barriers.push_back(gfx::TextureBarrier {
-                .texture = { texture.texture },
-                .src_access_type = texture.access_type,
-                .dst_access_type = target_access_type,
-            });
-            texture.access_type = target_access_type;
+}
+
+size_t RenderGraph::PrepareBarrierBatch(size_t order, size_t end_order) {
+    const auto &first = graph_nodes_[graph_order_[order]];
+    size_t batch_end = std::min(std::max(order + 1, first->barrier_batch_end), end_order);
+    // resources of the batch are created before its first pass, and those destroyed in the batch
+    // are returned to pool after it, so that no one is recycled within the batch
+    for (size_t i = order; i < batch_end; i++) {
+        auto create_begin = ProfileNow();
+        for (const size_t resource_index : resources_to_create_[i]) {
+            graph_nodes_[resource_index]->Create(*this);
+        }
+
+        auto barrier_begin = ProfileNow();
+        const auto &node = graph_nodes_[graph_order_[i]];
+        node->PrepareBarriers(*this);
+        node->num_barriers = node->buffer_barriers.size() + node->texture_barriers.size();
+        PrepareSplitBarriers(i, end_order);
+        if (i > order) {
+            first->buffer_barriers.insert(first->buffer_barriers.end(),
+                node->buffer_barriers.begin(), node->buffer_barriers.end());
+            first->texture_barriers.insert(first->texture_barriers.end(),
+                node->texture_barriers.begin(), node->texture_barriers.end());
+            node->buffer_barriers.clear();
+            node->texture_barriers.clear();
+        }
+        ProfilePrepare(i, create_begin, barrier_begin, ProfileNow());
+    }
+    return batch_end;
+}
+
+void RenderGraph::Node::PrepareBarriers(RenderGraph &rg) {
+    buffer_barriers.clear();
+    texture_barriers.clear();
+
+    for (const auto &plan : barrier_plans) {
+        const auto &node = rg.graph_nodes_[plan.resource];
+        if (plan.is_buffer) {
+            auto &buffer = static_cast<BufferNode *>(node.Get())->buffer.value();
+            if (plan.access_type != buffer.access_type || buffer.discard) {
+                buffer_barriers.push_back(gfx::BufferBarrier {
+                    .buffer = buffer.buffer,
+                    .src_access_type = buffer.access_type,
+                    .dst_access_type = plan.access_type,
+                    .discard = buffer.discard,
+                });
+                buffer.access_type = plan.access_type;
+                buffer.discard = false;
+            }
+        } else {
+            auto &texture = static_cast<TextureNode *>(node.Get())->texture.value();
+            if (plan.access_type != texture.access_type || texture.discard) {
+                texture_barriers.push_back(gfx::TextureBarrier {
+                    .texture = { texture.texture },
+                    .src_access_type = texture.access_type,
+                    .dst_access_type = plan.access_type,
+                    .discard = texture.discard,
+                });
+                texture.access_type = plan.access_type;
+                texture.discard = false;
+            }
         }
     }
+}
+
+void RenderGraph::Node::SetBarriers(const Ptr<gfx::CommandEncoder> &cmd_encoder) const {
+    if (!end_split_barriers.empty()) {
+        cmd_encoder->EndSplitBarrier(end_split_barriers);
+    }
+    if (!buffer_barriers.empty() || !texture_barriers.empty()) {
+        cmd_encoder->ResourceBarrier(buffer_barriers, texture_barriers);
+    }
+}
+
+void RenderGraph::Node::BeginSplitBarriers(const Ptr<gfx::CommandEncoder> &cmd_encoder) const {
+    if (!begin_split_barriers.empty()) {
+        cmd_encoder->BeginSplitBarrier(begin_split_barriers);
+    }
+}
+
+void RenderGraph::PrepareSplitBarriers(size_t order, size_t end_order) {
+    const auto &producer = graph_nodes_[graph_order_[order]];
+    const auto &plans = producer->split_barrier_plans;
+    size_t plan_index = 0;
+    while (plan_index < plans.size()) {
+        // plans are sorted by consumer, each consumer gets one split barrier
+        size_t consumer_order = plans[plan_index].consumer_order;
+        split_buffer_barriers_.clear();
+        split_texture_barriers_.clear();
+        for (; plan_index < plans.size() && plans[plan_index].consumer_order == consumer_order; plan_index++) {
+            if (consumer_order >= end_order) {
+                continue;
+            }
+            const auto &plan = plans[plan_index];
+            const auto &node = graph_nodes_[plan.resource];
+            // consumer finds the resource already in its access type and adds no barrier for it
+            if (auto buffer_node = dynamic_cast<BufferNode *>(node.Get()); buffer_node) {
+                auto &buffer = buffer_node->buffer.value();
+                if (buffer.access_type != plan.access_type) {
+                    split_buffer_barriers_.push_back(gfx::BufferBarrier {
+                        .buffer = buffer.buffer,
+                        .src_access_type = buffer.access_type,
+                        .dst_access_type = plan.access_type,
+                    });
+                    buffer.access_type = plan.access_type;
+                }
+            } else {
+                auto &texture = dynamic_cast<TextureNode *>(node.Get())->texture.value();
+                if (texture.access_type != plan.access_type) {
+                    split_texture_barriers_.push_back(gfx::TextureBarrier {
+                        .texture = { texture.texture },
+                        .src_access_type = texture.access_type,
+                        .dst_access_type = plan.access_type,
+                    });
+                    texture.access_type = plan.access_type;
+                }
+            }
+        }
 
-    cmd_encoder->ResourceBarrier(buffer_barriers, texture_barriers);
+        if (!split_buffer_barriers_.empty() || !split_texture_barriers_.empty()) {
+            auto split_barrier = contexts_[curr_frame_]->CreateSplitBarrier(split_buffer_barriers_,
+                split_texture_barriers_);
+            producer->begin_split_barriers.push_back(split_barrier);
+            graph_nodes_[graph_order_[consumer_order]]->end_split_barriers.push_back(split_barrier);
+        }
+    }
+}
+
+void RenderGraph::RenderPassNode::GetAccesses(Vec<ResourceAccess> &accesses) const {
+    GetShaderAccesses(resource, true, accesses);
+    for (const auto &target_opt : color_targets) {
+        if (target_opt.has_value()) {
+            accesses.push_back({ target_opt.value().handle.node_index_, gfx::ResourceAccessType::eColorAttachmentWrite });
+        }
+    }
+    if (depth_stencil_target.has_value()) {
+        accesses.push_back({ depth_stencil_target.value().handle.node_index_,
+            gfx::ResourceAccessType::eDepthStencilAttachmentWrite });
+    }
+}
+
+void RenderGraph::RenderPassNode::PrepareBarriers(RenderGraph &rg) {
+    Node::PrepareBarriers(rg);
+
+    // mipmaps are generated after the pass is recorded, track the access type they leave textures in
+    mipmaps_access_types.clear();
+    for (size_t i = 0; i < num_color_targets; i++) {
+        const auto &target = color_targets[i].value();
+        if (target.generate_mipmaps) {
+            auto &texture = rg.Texture(target.handle);
+            mipmaps_access_types.push_back(texture.access_type);
+            texture.access_type = HelperPipelines::MipmapsAccessType(texture.texture->Desc().format);
+        }
+    }
+    for (const auto &[_, handle] : resource.write_textures_) {
+        if (handle.generate_mipmaps) {
+            auto &texture = rg.Texture(handle.handle);
+            mipmaps_access_types.push_back(texture.access_type);
+            texture.access_type = HelperPipelines::MipmapsAccessType(texture.texture->Desc().format);
+        }
+    }
 }
 
 void RenderGraph::RenderPassNode::Execute(const Ptr<gfx::CommandEncoder> &cmd_encoder, const RenderGraph &rg) const {
@@ -399,29 +1202,39 @@ void RenderGraph::RenderPassNode::Execute(const Ptr<gfx::CommandEncoder> &cmd_en
     execute_func(render_encoder.AsRef(), resource);
 }
 
-void RenderGraph::RenderPassNode::AfterExcution(const Ptr<gfx::CommandEncoder> &cmd_encoder, RenderGraph &rg) {
+void RenderGraph::RenderPassNode::AfterExcution(const Ptr<gfx::CommandEncoder> &cmd_encoder,
+    const RenderGraph &rg) const {
+    size_t mipmaps_index = 0;
     for (size_t i = 0; i < num_color_targets; i++) {
         const auto &target = color_targets[i].value();
         if (target.generate_mipmaps) {
-            auto &texture = rg.Texture(target.handle);
-            rg.helper_pipelines_->GenerateMipmaps2D(cmd_encoder, texture.texture, texture.access_type);
+            auto access_type = mipmaps_access_types[mipmaps_index++];
+            rg.helper_pipelines_->GenerateMipmaps2D(cmd_encoder, rg.Texture(target.handle).texture, access_type);
         }
     }
     for (const auto &[_, handle] : resource.write_textures_) {
         if (handle.generate_mipmaps) {
-            auto &texture = rg.Texture(handle.handle);
-            rg.helper_pipelines_->GenerateMipmaps2D(cmd_encoder, texture.texture, texture.access_type);
+            auto access_type = mipmaps_access_types[mipmaps_index++];
+            rg.helper_pipelines_->GenerateMipmaps2D(cmd_encoder, rg.Texture(handle.handle).texture, access_type);
         }
     }
 }
 
-void RenderGraph::ComputePassNode::SetBarriers(const Ptr<gfx::CommandEncoder> &cmd_encoder, RenderGraph &rg) {
-    Vec<gfx::BufferBarrier> buffer_barriers;
-    Vec<gfx::TextureBarrier> texture_barriers;
+void RenderGraph::ComputePassNode::GetAccesses(Vec<ResourceAccess> &accesses) const {
+    GetShaderAccesses(resource, false, accesses);
+}
 
-    resource.GetShaderBarriers(rg, false, buffer_barriers, texture_barriers);
+void RenderGraph::ComputePassNode::PrepareBarriers(RenderGraph &rg) {
+    Node::PrepareBarriers(rg);
 
-    cmd_encoder->ResourceBarrier(buffer_barriers, texture_barriers);
+    mipmaps_access_types.clear();
+    for (const auto &[_, handle] : resource.write_textures_) {
+        if (handle.generate_mipmaps) {
+            auto &texture = rg.Texture(handle.handle);
+            mipmaps_access_types.push_back(texture.access_type);
+            texture.access_type = HelperPipelines::MipmapsAccessType(texture.texture->Desc().format);
+        }
+    }
 }
 
 void RenderGraph::ComputePassNode::Execute(const Ptr<gfx::CommandEncoder> &cmd_encoder, const RenderGraph &rg) const {
@@ -429,30 +1242,22 @@ void RenderGraph::ComputePassNode::Execute(const Ptr<gfx::CommandEncoder> &cmd_e
     execute_func(compute_encoder.AsRef(), resource);
 }
 
-void RenderGraph::ComputePassNode::AfterExcution(const Ptr<gfx::CommandEncoder> &cmd_encoder, RenderGraph &rg) {
+void RenderGraph::ComputePassNode::AfterExcution(const Ptr<gfx::CommandEncoder> &cmd_encoder,
+    const RenderGraph &rg) const {
+    size_t mipmaps_index = 0;
     for (const auto &[_, handle] : resource.write_textures_) {
         if (handle.generate_mipmaps) {
-            auto &texture = rg.Texture(handle.handle);
-            rg.helper_pipelines_->GenerateMipmaps2D(cmd_encoder, texture.texture, texture.access_type);
+            auto access_type = mipmaps_access_types[mipmaps_index++];
+            rg.helper_pipelines_->GenerateMipmaps2D(cmd_encoder, rg.Texture(handle.handle).texture, access_type);
         }
     }
 }
 
-void RenderGraph::PresentPassNode::SetBarriers(const Ptr<gfx::CommandEncoder> &cmd_encoder, RenderGraph &rg) {
-    auto target_access_type = gfx::ResourceAccessType::ePresent;
-    auto &rg_texture = rg.Texture(texture);
-    if (rg_texture.access_type != target_access_type) {
-        gfx::TextureBarrier barrier {
-            .texture = { rg_texture.texture },
-            .src_access_type = rg_texture.access_type,
-            .dst_access_type = target_access_type,
-        };
-        rg_texture.access_type = target_access_type;
-        cmd_encoder->ResourceBarrier({}, { barrier });
-    }
+void RenderGraph::PresentPassNode::GetAccesses(Vec<ResourceAccess> &accesses) const {
+    accesses.push_back({ texture.node_index_, gfx::ResourceAccessType::ePresent });
 }
 
-void RenderGraph::BlitPassNode::SetBarriers(const Ptr<gfx::CommandEncoder> &cmd_encoder, RenderGraph &rg) {
+void RenderGraph::BlitPassNode::PrepareBarriers(RenderGraph &rg) {
     auto &src_texture = rg.Texture(src_handle);
     gfx::TextureView src_view {
         .texture = src_texture.texture,
@@ -466,8 +1271,10 @@ void RenderGraph::BlitPassNode::SetBarriers(const Ptr<gfx::CommandEncoder> &cmd_
         .texture = src_view,
         .src_access_type = src_texture.access_type,
         .dst_access_type = src_target_access,
+        .discard = src_texture.discard,
     };
     src_texture.access_type = src_target_access;
+    src_texture.discard = false;
     
     auto &dst_texture = rg.Texture(dst_handle);
     gfx::TextureView dst_view {
@@ -481,13 +1288,15 @@ void RenderGraph::BlitPassNode::SetBarriers(const Ptr<gfx::CommandEncoder> &cmd_
         ? gfx::ResourceAccessType::eDepthStencilAttachmentWrite
         : gfx::ResourceAccessType::eColorAttachmentWrite;
     gfx::TextureBarrier dst_barrier {
-        .texture = src_view,
+        .texture = dst_view,
         .src_access_type = dst_texture.access_type,
         .dst_access_type = dst_target_access,
+        .discard = dst_texture.discard,
     };
     dst_texture.access_type = dst_target_access;
+    dst_texture.discard = false;
 
-    cmd_encoder->ResourceBarrier({}, { src_barrier, dst_barrier });
+    texture_barriers = { src_barrier, dst_barrier };
 }
 
 void RenderGraph::BlitPassNode::Execute(const Ptr<gfx::CommandEncoder> &cmd_encoder, const RenderGraph &rg) const {
@@ -513,37 +1322,527 @@ void RenderGraph::BlitPassNode::Execute(const Ptr<gfx::CommandEncoder> &cmd_enco
 void RenderGraph::Execute(Span<Ref<gfx::Semaphore>> wait_semaphores, Span<Ref<gfx::Semaphore>> signal_semaphores,
     gfx::Fence *signal_fence) {
     contexts_[curr_frame_]->Reset();
-    auto cmd_encoder = contexts_[curr_frame_]->GetCommandEncoder();
 
+    if (profiling_) {
+        BeginProfile();
+    }
+
+    resource_pools_[curr_frame_]->BeginFrame(frame_index_++);
+    resource_pools_[curr_frame_]->SetTransientHeaps(transient_heaps_, transient_heaps_version_);
+
+    for (const size_t index : graph_order_) {
+        graph_nodes_[index]->begin_split_barriers.clear();
+        graph_nodes_[index]->end_split_barriers.clear();
+    }
+
+    if (async_compute_stats_.num_async_passes > 0) {
+        Vec<Submission> submissions;
+        RecordAsyncCompute(submissions);
+
+        // user waits go to the first graphics submission, user signals go to the last one
+        // which has waited for all async compute work
+        size_t last_graphics_submission = 0;
+        for (size_t i = 0; i < submissions.size(); i++) {
+            if (!submissions[i].async_compute) {
+                last_graphics_submission = i;
+            }
+        }
+        submissions[0].wait_semaphores.insert(submissions[0].wait_semaphores.end(),
+            wait_semaphores.begin(), wait_semaphores.end());
+        auto &last_submission = submissions[last_graphics_submission];
+        last_submission.signal_semaphores.insert(last_submission.signal_semaphores.end(),
+            signal_semaphores.begin(), signal_semaphores.end());
+        ResolveProfileQueries(last_submission.cmd_encoder);
+        if (profiling_) {
+            profile_slots_[curr_frame_].profile.cpu_submit = ProfileTime(ProfileNow());
+        }
+        for (size_t i = 0; i < submissions.size(); i++) {
+            auto &submission = submissions[i];
+            Vec<Ptr<gfx::CommandBuffer>> cmd_buffers;
+            cmd_buffers.emplace_back(submission.cmd_encoder->Finish());
+            auto queue = submission.async_compute ? async_compute_queue_ : queue_.Get();
+            queue->SubmitCommandBuffer(cmd_buffers, submission.wait_semaphores, submission.signal_semaphores,
+                i == last_graphics_submission ? signal_fence : nullptr);
+        }
+        async_compute_stats_.num_submissions = submissions.size();
+
+        UpdateCompileReport();
+        Clear();
+        curr_frame_ = (curr_frame_ + 1) % contexts_.size();
+        return;
+    }
+
+    Vec<Ptr<gfx::CommandBuffer>> cmd_buffers;
+    if (thread_pool_.IsInitialized() && graph_order_.size() > 1) {
+        RecordParallel(cmd_buffers);
+    } else {
+        auto cmd_encoder = contexts_[curr_frame_]->GetCommandEncoder();
+        ResetProfileQueries(cmd_encoder);
+        size_t prepared_end = 0;
+        for (size_t order = 0; order < graph_order_.size(); order++) {
+            if (order >= prepared_end) {
+                prepared_end = PrepareBarrierBatch(order, graph_order_.size());
+            }
+
+            auto record_begin = ProfileNow();
+            const auto &node = graph_nodes_[graph_order_[order]];
+            node->SetBarriers(cmd_encoder);
+            WriteProfileTimestamp(cmd_encoder, order, false);
+            node->Execute(cmd_encoder, *this);
+            node->AfterExcution(cmd_encoder, *this);
+            WriteProfileTimestamp(cmd_encoder, order, true);
+            node->BeginSplitBarriers(cmd_encoder);
+            ProfileRecord(order, record_begin, ProfileNow(), 0);
+
+            for (const size_t resource_index : resources_to_destroy_[order]) {
+                const auto &resource_node = graph_nodes_[resource_index];
+                resource_node->Destroy(*this);
+            }
+        }
+        ResolveProfileQueries(cmd_encoder);
+        cmd_buffers.emplace_back(cmd_encoder->Finish());
+    }
+
+    if (profiling_) {
+        profile_slots_[curr_frame_].profile.cpu_submit = ProfileTime(ProfileNow());
+    }
+    queue_->SubmitCommandBuffer(cmd_buffers, wait_semaphores, signal_semaphores, signal_fence);
+
+    UpdateCompileReport();
+    Clear();
+    curr_frame_ = (curr_frame_ + 1) % contexts_.size();
+}
+
+void RenderGraph::RecordParallel(Vec<Ptr<gfx::CommandBuffer>> &cmd_buffers) {
+    size_t num_chunks = std::min<size_t>(thread_pool_->NumThreads(), graph_order_.size());
+
+    // resources are created and barriers are computed in pass order first, workers only read them,
+    // split barriers and barrier batches are only used within a chunk
+    size_t curr_chunk = 0;
+    for (size_t order = 0; order < graph_order_.size();) {
+        while (order >= graph_order_.size() * (curr_chunk + 1) / num_chunks) {
+            ++curr_chunk;
+        }
+        order = PrepareBarrierBatch(order, graph_order_.size() * (curr_chunk + 1) / num_chunks);
+    }
+    Vec<Ref<gfx::FrameContext>> thread_contexts;
+    thread_contexts.reserve(num_chunks);
+    for (size_t chunk = 0; chunk < num_chunks; chunk++) {
+        thread_contexts.push_back(contexts_[curr_frame_]->GetThreadContext(static_cast<uint32_t>(chunk)));
+    }
+
+    cmd_buffers.resize(num_chunks);
+    thread_pool_->ParallelFor(num_chunks, [&](size_t chunk) {
+        size_t begin = graph_order_.size() * chunk / num_chunks;
+        size_t end = graph_order_.size() * (chunk + 1) / num_chunks;
+        auto cmd_encoder = thread_contexts[chunk]->GetCommandEncoder();
+        // command buffers are submitted in chunk order
+        if (chunk == 0) {
+            ResetProfileQueries(cmd_encoder);
+        }
+        for (size_t order = begin; order < end; order++) {
+            auto record_begin = ProfileNow();
+            const auto &node = graph_nodes_[graph_order_[order]];
+            node->SetBarriers(cmd_encoder);
+            WriteProfileTimestamp(cmd_encoder, order, false);
+            node->Execute(cmd_encoder, *this);
+            node->AfterExcution(cmd_encoder, *this);
+            WriteProfileTimestamp(cmd_encoder, order, true);
+            node->BeginSplitBarriers(cmd_encoder);
+            ProfileRecord(order, record_begin, ProfileNow(), static_cast<uint32_t>(chunk));
+        }
+        if (chunk == num_chunks - 1) {
+            ResolveProfileQueries(cmd_encoder);
+        }
+        cmd_buffers[chunk] = cmd_encoder->Finish();
+    });
+
+    // resources are returned to pool after all chunks are recorded,
+    // so non-placed resources are not recycled within the frame in this mode
     for (size_t order = 0; order < graph_order_.size(); order++) {
+        for (const size_t resource_index : resources_to_destroy_[order]) {
+            graph_nodes_[resource_index]->Destroy(*this);
+        }
+    }
+}
+
+void RenderGraph::RecordAsyncCompute(Vec<Submission> &submissions) {
+    constexpr size_t kNone = static_cast<size_t>(-1);
+    const auto &context = contexts_[curr_frame_];
+    auto &semaphores = semaphores_[curr_frame_];
+    size_t num_semaphores = 0;
+    size_t num_ownership_transfers = 0;
+
+    // queue 0 is graphics and queue 1 is async compute, resources are owned by graphics between frames
+    gfx::Queue *queues[2] = { queue_.Get(), async_compute_queue_ };
+    size_t last_submission[2] = { kNone, kNone };
+    // latest submission of the other queue that a queue has waited for
+    size_t waited_submission[2] = { kNone, kNone };
+    Vec<uint8_t> resource_queue(graph_nodes_.size(), 0);
+    Vec<size_t> resource_submission(graph_nodes_.size(), 0);
+
+    auto open_submission = [&](size_t queue) {
+        submissions.push_back(Submission {
+            .async_compute = queue == 1,
+            .cmd_encoder = context->GetCommandEncoder(queue == 1 ? gfx::QueueType::eCompute
+                : gfx::QueueType::eGraphics),
+        });
+        last_submission[queue] = submissions.size() - 1;
+    };
+    open_submission(0);
+    ResetProfileQueries(submissions[0].cmd_encoder);
+
+    // make the queue wait for the other one if some of resources were last used there,
+    // returns the submission of the other queue that ownership of these resources is released in
+    auto sync_queue = [&](size_t queue, const Vec<size_t> &resources, bool wait_all) {
+        size_t other = 1 - queue;
+        bool need_wait = false;
+        size_t required_submission = 0;
+        for (const size_t resource_index : resources) {
+            if (resource_queue[resource_index] == other) {
+                need_wait = true;
+                required_submission = std::max(required_submission, resource_submission[resource_index]);
+            }
+        }
+        if (wait_all && last_submission[other] != kNone) {
+            need_wait = true;
+            required_submission = std::max(required_submission, last_submission[other]);
+        }
+
+        if (need_wait && (waited_submission[queue] == kNone || waited_submission[queue] < required_submission)) {
+            // waiting for the latest submission also covers earlier ones on that queue
+            size_t signal_submission = last_submission[other];
+            if (num_semaphores == semaphores.size()) {
+                semaphores.emplace_back(device_->CreateSemaphore());
+            }
+            auto semaphore = semaphores[num_semaphores++].AsRef();
+            submissions[signal_submission].signal_semaphores.push_back(semaphore);
+            submissions[signal_submission].closed = true;
+            open_submission(queue);
+            submissions.back().wait_semaphores.push_back(semaphore);
+            waited_submission[queue] = signal_submission;
+        } else if (last_submission[queue] == kNone || submissions[last_submission[queue]].closed) {
+            open_submission(queue);
+        }
+        return waited_submission[queue];
+    };
+
+    // tag barriers of resources owned by the other queue as cross queue barriers (the acquire part),
+    // and record the same barriers to the submission that the other queue releases them in
+    struct Transfer {
+        size_t index;
+        gfx::ResourceAccessType access_type;
+    };
+    auto transfer_ownership = [&](size_t queue, size_t release_submission, const Vec<Transfer> &transfers,
+        Vec<gfx::BufferBarrier> &buffer_barriers, Vec<gfx::TextureBarrier> &texture_barriers) {
+        gfx::Queue *src_queue = queues[1 - queue];
+        gfx::Queue *dst_queue = queues[queue];
+        Vec<gfx::BufferBarrier> release_buffer_barriers;
+        Vec<gfx::TextureBarrier> release_texture_barriers;
+        for (const auto &transfer : transfers) {
+            const auto &node = graph_nodes_[transfer.index];
+            if (auto buffer_node = dynamic_cast<const BufferNode *>(node.Get()); buffer_node) {
+                const auto &buffer = buffer_node->buffer.value().buffer;
+                bool found = false;
+                for (auto &barrier : buffer_barriers) {
+                    if (barrier.buffer == buffer) {
+                        barrier.src_queue = src_queue;
+                        barrier.dst_queue = dst_queue;
+                        release_buffer_barriers.push_back(barrier);
+                        found = true;
+                    }
+                }
+                if (!found) {
+                    buffer_barriers.push_back(gfx::BufferBarrier {
+                        .buffer = buffer,
+                        .src_access_type = transfer.access_type,
+                        .dst_access_type = transfer.access_type,
+                        .src_queue = src_queue,
+                        .dst_queue = dst_queue,
+                    });
+                    release_buffer_barriers.push_back(buffer_barriers.back());
+                }
+            } else {
+                const auto &texture = dynamic_cast<const TextureNode *>(node.Get())->texture.value().texture;
+                bool found = false;
+                for (auto &barrier : texture_barriers) {
+                    if (barrier.texture.texture == texture) {
+                        barrier.src_queue = src_queue;
+                        barrier.dst_queue = dst_queue;
+                        release_texture_barriers.push_back(barrier);
+                        found = true;
+                    }
+                }
+                if (!found) {
+                    texture_barriers.push_back(gfx::TextureBarrier {
+                        .texture = { texture },
+                        .src_access_type = transfer.access_type,
+                        .dst_access_type = transfer.access_type,
+                        .src_queue = src_queue,
+                        .dst_queue = dst_queue,
+                    });
+                    release_texture_barriers.push_back(texture_barriers.back());
+                }
+            }
+            resource_queue[transfer.index] = static_cast<uint8_t>(queue);
+            ++num_ownership_transfers;
+        }
+        if (!release_buffer_barriers.empty() || !release_texture_barriers.empty()) {
+            submissions[release_submission].cmd_encoder->ResourceBarrier(release_buffer_barriers,
+                release_texture_barriers);
+        }
+    };
+    auto access_type_of = [&](size_t index) {
+        const auto &node = graph_nodes_[index];
+        if (auto buffer_node = dynamic_cast<const BufferNode *>(node.Get()); buffer_node) {
+            return buffer_node->buffer.value().access_type;
+        }
+        return dynamic_cast<const TextureNode *>(node.Get())->texture.value().access_type;
+    };
+
+    Vec<size_t> resources;
+    Vec<Transfer> transfers;
+    for (size_t order = 0; order < graph_order_.size(); order++) {
+        auto create_begin = ProfileNow();
         for (const size_t resource_index : resources_to_create_[order]) {
-            const auto &resource_node = graph_nodes_[resource_index];
-            resource_node->Create(*this);
+            graph_nodes_[resource_index]->Create(*this);
         }
 
+        auto barrier_begin = ProfileNow();
         const auto &node = graph_nodes_[graph_order_[order]];
-        node->SetBarriers(cmd_encoder, *this);
+        if (node->IsResource()) {
+            ProfilePrepare(order, create_begin, barrier_begin, barrier_begin);
+            continue;
+        }
+        size_t queue = node->async_compute ? 1 : 0;
+
+        resources.clear();
+        for (const auto &v : node->in_nodes) {
+            resources.push_back(v->index);
+        }
+        for (const auto &v : node->out_nodes) {
+            resources.push_back(v->index);
+        }
+        size_t release_submission = sync_queue(queue, resources, false);
+
+        // access types before the pass are needed for resources that the pass doesn't add barrier for
+        transfers.clear();
+        for (const size_t resource_index : resources) {
+            if (resource_queue[resource_index] != queue && std::none_of(transfers.begin(), transfers.end(),
+                [resource_index](const Transfer &v) { return v.index == resource_index; })) {
+                transfers.push_back({ resource_index, access_type_of(resource_index) });
+            }
+        }
+
+        node->PrepareBarriers(*this);
+        transfer_ownership(queue, release_submission, transfers, node->buffer_barriers, node->texture_barriers);
+        node->num_barriers = node->buffer_barriers.size() + node->texture_barriers.size();
+        auto record_begin = ProfileNow();
+        ProfilePrepare(order, create_begin, barrier_begin, record_begin);
+
+        // queries are reset on graphics queue, only passes there are timed on gpu
+        const auto &cmd_encoder = submissions[last_submission[queue]].cmd_encoder;
+        node->SetBarriers(cmd_encoder);
+        if (queue == 0) {
+            WriteProfileTimestamp(cmd_encoder, order, false);
+        }
         node->Execute(cmd_encoder, *this);
         node->AfterExcution(cmd_encoder, *this);
+        if (queue == 0) {
+            WriteProfileTimestamp(cmd_encoder, order, true);
+        }
+        ProfileRecord(order, record_begin, ProfileNow(), 0);
+
+        for (const size_t resource_index : resources) {
+            resource_submission[resource_index] = last_submission[queue];
+        }
+    }
 
+    // graphics queue waits for all async compute work and takes back the ownership of all resources
+    resources.clear();
+    transfers.clear();
+    for (size_t i = 0; i < graph_nodes_.size(); i++) {
+        if (resource_queue[i] == 1) {
+            resources.push_back(i);
+            transfers.push_back({ i, access_type_of(i) });
+        }
+    }
+    size_t release_submission = sync_queue(0, resources, true);
+    Vec<gfx::BufferBarrier> buffer_barriers;
+    Vec<gfx::TextureBarrier> texture_barriers;
+    transfer_ownership(0, release_submission, transfers, buffer_barriers, texture_barriers);
+    if (!buffer_barriers.empty() || !texture_barriers.empty()) {
+        submissions[last_submission[0]].cmd_encoder->ResourceBarrier(buffer_barriers, texture_barriers);
+    }
+
+    // resources are returned to pool after all passes are recorded,
+    // non-placed resources are not recycled within the frame since they may be used on both queues
+    for (size_t order = 0; order < graph_order_.size(); order++) {
         for (const size_t resource_index : resources_to_destroy_[order]) {
-            const auto &resource_node = graph_nodes_[resource_index];
-            resource_node->Destroy(*this);
+            graph_nodes_[resource_index]->Destroy(*this);
         }
     }
 
-    queue_->SubmitCommandBuffer({ cmd_encoder->Finish() }, wait_semaphores, signal_semaphores, signal_fence);
+    async_compute_stats_.num_semaphores = num_semaphores;
+    async_compute_stats_.num_ownership_transfers = num_ownership_transfers;
+}
 
-    Clear();
-    curr_frame_ = (curr_frame_ + 1) % contexts_.size();
+void RenderGraph::SetProfiling(bool enable) {
+    if (enable && !profiling_) {
+        profile_epoch_ = std::chrono::steady_clock::now();
+        profile_slots_.resize(contexts_.size());
+    }
+    if (!enable) {
+        // query sets are kept since gpu may still be using them
+        for (auto &slot : profile_slots_) {
+            slot.pending = false;
+        }
+        latest_profile_.reset();
+    }
+    profiling_ = enable;
+}
+
+double RenderGraph::ProfileTime(ProfileTimePoint time) const {
+    return std::chrono::duration<double, std::micro>(time - profile_epoch_).count();
+}
+
+void RenderGraph::BeginProfile() {
+    constexpr size_t kNone = static_cast<size_t>(-1);
+    auto &slot = profile_slots_[curr_frame_];
+    auto &profile = slot.profile;
+    if (slot.pending) {
+        // passes that are not timed on gpu never write their queries, so results are read per pass
+        Vec<uint64_t> timestamps(profile.passes.size() * 2, 0);
+        uint64_t first_timestamp = std::numeric_limits<uint64_t>::max();
+        bool available = true;
+        for (size_t i = 0; i < profile.passes.size() && available; i++) {
+            if (profile.passes[i].has_gpu_time) {
+                available = slot.query_set->GetResults(static_cast<uint32_t>(i * 2), 2, timestamps.data() + i * 2);
+                first_timestamp = std::min(first_timestamp, timestamps[i * 2]);
+            }
+        }
+        if (available) {
+            double us_per_tick = 1e6 / static_cast<double>(queue_->TimestampFrequency());
+            for (size_t i = 0; i < profile.passes.size(); i++) {
+                auto &pass = profile.passes[i];
+                if (pass.has_gpu_time) {
+                    pass.gpu_start = static_cast<double>(timestamps[i * 2] - first_timestamp) * us_per_tick;
+                    pass.gpu_duration = static_cast<double>(timestamps[i * 2 + 1] - timestamps[i * 2]) * us_per_tick;
+                }
+            }
+            latest_profile_ = std::move(profile);
+        }
+        slot.pending = false;
+    }
+
+    profile = FrameProfile {
+        .frame = frame_index_,
+        .cpu_start = ProfileTime(ProfileNow()),
+    };
+    profile_pass_index_.assign(graph_order_.size(), kNone);
+    for (size_t order = 0; order < graph_order_.size(); order++) {
+        const auto &node = graph_nodes_[graph_order_[order]];
+        if (!node->IsResource()) {
+            profile_pass_index_[order] = profile.passes.size();
+            profile.passes.push_back(PassProfile { .name = node->name });
+        }
+    }
+
+    uint32_t num_queries = static_cast<uint32_t>(std::max<size_t>(profile.passes.size() * 2, 2));
+    if (!slot.query_set.IsInitialized() || slot.query_set->Desc().count < num_queries) {
+        slot.query_set = device_->CreateQuerySet(gfx::QuerySetDesc {
+            .name = "render graph timestamps",
+            .type = gfx::QueryType::eTimestamp,
+            .count = num_queries,
+        });
+    }
+    slot.pending = true;
+}
+
+void RenderGraph::WriteProfileTimestamp(const Ptr<gfx::CommandEncoder> &cmd_encoder, size_t order, bool end) {
+    if (!profiling_ || profile_pass_index_[order] == static_cast<size_t>(-1)) {
+        return;
+    }
+    auto &slot = profile_slots_[curr_frame_];
+    size_t index = profile_pass_index_[order];
+    cmd_encoder->WriteTimestamp(slot.query_set.AsRef(), static_cast<uint32_t>(index * 2 + (end ? 1 : 0)));
+    slot.profile.passes[index].has_gpu_time = true;
+}
+
+void RenderGraph::ResetProfileQueries(const Ptr<gfx::CommandEncoder> &cmd_encoder) {
+    if (profiling_) {
+        auto &slot = profile_slots_[curr_frame_];
+        cmd_encoder->ResetQueries(slot.query_set.AsRef(), 0, slot.query_set->Desc().count);
+    }
+}
+
+void RenderGraph::ResolveProfileQueries(const Ptr<gfx::CommandEncoder> &cmd_encoder) {
+    if (profiling_ && !profile_slots_[curr_frame_].profile.passes.empty()) {
+        auto &slot = profile_slots_[curr_frame_];
+        cmd_encoder->ResolveQueries(slot.query_set.AsRef(), 0,
+            static_cast<uint32_t>(slot.profile.passes.size() * 2));
+    }
+}
+
+void RenderGraph::ProfilePrepare(size_t order, ProfileTimePoint create_begin, ProfileTimePoint barrier_begin,
+    ProfileTimePoint barrier_end) {
+    if (!profiling_) {
+        return;
+    }
+    auto &profile = profile_slots_[curr_frame_].profile;
+    if (!resources_to_create_[order].empty()) {
+        const double create_start = ProfileTime(create_begin);
+        const double create_duration = ProfileTime(barrier_begin) - create_start;
+        profile.cpu_resource_creation_duration += create_duration;
+        profile.resource_creations.push_back(ResourceCreationProfile {
+            .cpu_start = create_start,
+            .cpu_duration = create_duration,
+        });
+    }
+    if (size_t index = profile_pass_index_[order]; index != static_cast<size_t>(-1)) {
+        auto &pass = profile.passes[index];
+        pass.cpu_barrier_start = ProfileTime(barrier_begin);
+        pass.cpu_barrier_duration = ProfileTime(barrier_end) - pass.cpu_barrier_start;
+    }
+}
+
+void RenderGraph::ProfileRecord(size_t order, ProfileTimePoint record_begin, ProfileTimePoint record_end,
+    uint32_t thread) {
+    if (!profiling_) {
+        return;
+    }
+    if (size_t index = profile_pass_index_[order]; index != static_cast<size_t>(-1)) {
+        auto &pass = profile_slots_[curr_frame_].profile.passes[index];
+        pass.cpu_thread = thread;
+        pass.cpu_record_start = ProfileTime(record_begin);
+        pass.cpu_record_duration = ProfileTime(record_end) - pass.cpu_record_start;
+    }
+}
+
+void RenderGraph::SetRecordingThreads(uint32_t num_threads) {
+    if (num_threads > 1) {
+        if (!thread_pool_.IsInitialized() || thread_pool_->NumThreads() != num_threads) {
+            thread_pool_ = Ptr<ThreadPool>::Make(num_threads);
+        }
+    } else {
+        thread_pool_ = {};
+    }
 }
 
 void RenderGraph::Clear() {
+    num_declared_nodes_ = 0;
+    if (persistent_) {
+        return;
+    }
+
     graph_nodes_.clear();
+    node_hashes_.clear();
     graph_order_.clear();
     resources_to_create_.clear();
     resources_to_destroy_.clear();
     present_pass_index_ = static_cast<size_t>(-1);
+    transient_placements_.clear();
+    compiled_ = false;
 }
 
 ResourcePool::Buffer &RenderGraph::Buffer(BufferHandle handle) {
@@ -11,9 +11,37 @@ BISMUTH_GFX_NAMESPACE_BEGIN
 
 HelperPipelines::HelperPipelines(Ref<Device> device) : device_(device) {
     shader_manager_ = Ptr<ShaderManager>::Make(device, CurrentExecutablePath() / "shader_binary");
-    
-    InitBlitPipelines();
-    InitMipmapPipelines();
+
+    const auto blit_src = fs::path(GraphicsModule::kDir) / "shaders/blit.hlsl";
+    Vec<ShaderModuleDesc> shader_descs = {
+        { "gfx-helper_piplines-blit-vs", blit_src, "VS", ShaderStage::eVertex },
+        { "gfx-helper_piplines-blit-fs", blit_src, "FS", ShaderStage::eFragment },
+        { "gfx-helper_piplines-blit-fs", blit_src, "FS", ShaderStage::eFragment, { { "BLIT_DEPTH", "" } } },
+    };
+    const size_t num_blit_shaders = shader_descs.size();
+
+    // vs, fs, depth fs and cs, mipmap mode is a specialization constant if supported,
+    // otherwise they are compiled for each mode
+    const auto mipmap_src = fs::path(GraphicsModule::kDir) / "shaders/mipmap.hlsl";
+    const int num_mipmap_variants = device_->SpecializationConstantsSupported() ? 1 : 3;
+    for (int i = 0; i < num_mipmap_variants; i++) {
+        HashMap<std::string, std::string> defines;
+        if (num_mipmap_variants > 1) {
+            defines["MIPMAP_MODE"] = std::to_string(i);
+        }
+        shader_descs.push_back({ "gfx-helper_piplines-mipmap-vs", mipmap_src, "VS", ShaderStage::eVertex, defines });
+        shader_descs.push_back({ "gfx-helper_piplines-mipmap-fs", mipmap_src, "FS", ShaderStage::eFragment, defines });
+        defines["MIPMAP_DEPTH"] = "";
+        shader_descs.push_back({ "gfx-helper_piplines-mipmap-fs", mipmap_src, "FS", ShaderStage::eFragment, defines });
+        defines.erase("MIPMAP_DEPTH");
+        defines["USE_CS"] = "";
+        shader_descs.push_back({ "gfx-helper_piplines-mipmap-cs", mipmap_src, "CS", ShaderStage::eCompute, defines });
+    }
+
+    auto shaders = shader_manager_->GetShaderModules(shader_descs);
+
+    InitBlitPipelines(Span<Ptr<ShaderModule>>(shaders.data(), num_blit_shaders));
+    InitMipmapPipelines(Span<Ptr<ShaderModule>>(shaders.data() + num_blit_shaders, shaders.size() - num_blit_shaders));
 }
 
 void HelperPipelines::BlitTexture(Ref<CommandEncoder> cmd_encoder, const TextureView &src_view,
@@ -175,21 +203,22 @@ void HelperPipelines::GenerateMipmaps2D(Ref<CommandEncoder> cmd_encoder, Ref<Tex
     tex_access_type = read_access_type;
 }
 
-void HelperPipelines::InitBlitPipelines() {
+ResourceAccessType HelperPipelines::MipmapsAccessType(ResourceFormat format) {
+    return IsDepthStencilFormat(format) || IsSrgbFormat(format)
+        ? ResourceAccessType::eRenderShaderSampledTextureRead
+        : ResourceAccessType::eComputeShaderSampledTextureRead;
+}
+
+void HelperPipelines::InitBlitPipelines(Span<Ptr<ShaderModule>> shaders) {
     SamplerDesc sampler_desc {
         .mag_filter = SamplerFilterMode::eLinear,
         .min_filter = SamplerFilterMode::eLinear,
     };
     blit_sampler_ = device_->CreateSampler(sampler_desc);
 
-    auto blit_vs = shader_manager_->GetShaderModule("gfx-helper_piplines-blit-vs",
-        fs::path(GraphicsModule::kDir) / "shaders/blit.hlsl", "VS", ShaderStage::eVertex);
-    auto blit_fs = shader_manager_->GetShaderModule("gfx-helper_piplines-blit-fs",
-        fs::path(GraphicsModule::kDir) / "shaders/blit.hlsl", "FS", ShaderStage::eFragment);
-    HashMap<std::string, std::string> defines;
-    defines["BLIT_DEPTH"] = "";
-    auto blit_fs_depth = shader_manager_->GetShaderModule("gfx-helper_piplines-blit-fs",
-        fs::path(GraphicsModule::kDir) / "shaders/blit.hlsl", "FS", ShaderStage::eFragment, defines);
+    const auto &blit_vs = shaders[0];
+    const auto &blit_fs = shaders[1];
+    const auto &blit_fs_depth = shaders[2];
 
     PipelineLayout blit_layout {
         .sets_layout = {
@@ -244,23 +273,20 @@ void HelperPipelines::InitBlitPipelines() {
     blit_pipeline_depth_ = device_->CreateRenderPipeline(blit_depth_desc);
 }
 
-void HelperPipelines::InitMipmapPipelines() {
+void HelperPipelines::InitMipmapPipelines(Span<Ptr<ShaderModule>> shaders) {
+    // shaders of all modes are the same if mode is a specialization constant
+    const bool use_specialization = shaders.Size() == 4;
     for (int i = 0; i < 3; i++) {
-        HashMap<std::string, std::string> defines;
-        defines["MIPMAP_MODE"] = std::to_string(i);
-
-        auto mipmap_vs = shader_manager_->GetShaderModule("gfx-helper_piplines-mipmap-vs",
-            fs::path(GraphicsModule::kDir) / "shaders/mipmap.hlsl", "VS", ShaderStage::eVertex, defines);
-        auto mipmap_fs = shader_manager_->GetShaderModule("gfx-helper_piplines-mipmap-fs",
-            fs::path(GraphicsModule::kDir) / "shaders/mipmap.hlsl", "FS", ShaderStage::eFragment, defines);
-        defines["MIPMAP_DEPTH"] = "";
-        auto mipmap_fs_depth = shader_manager_->GetShaderModule("gfx-helper_piplines-mipmap-fs",
-            fs::path(GraphicsModule::kDir) / "shaders/mipmap.hlsl", "FS", ShaderStage::eFragment, defines);
-
-        defines.erase("MIPMAP_DEPTH");
-        defines["USE_CS"] = "";
-        auto mipmap_cs = shader_manager_->GetShaderModule("gfx-helper_piplines-mipmap-cs",
-            fs::path(GraphicsModule::kDir) / "shaders/mipmap.hlsl", "CS", ShaderStage::eCompute, defines);
+        const size_t first_shader = use_specialization ? 0 : i * 4;
+        const auto &mipmap_vs = shaders[first_shader];
+        const auto &mipmap_fs = shaders[first_shader + 1];
+        const auto &mipmap_fs_depth = shaders[first_shader + 2];
+        const auto &mipmap_cs = shaders[first_shader + 3];
+        Vec<SpecializationConstant> specialization_constants;
+        if (use_specialization) {
+            // [[vk::constant_id(0)]] kMipmapMode in mipmap.hlsl
+            specialization_constants.push_back({ .id = 0, .value = static_cast<uint32_t>(i) });
+        }
 
         PipelineLayout mipmap_layout {
             .sets_layout = {
@@ -289,7 +315,8 @@ void HelperPipelines::InitMipmapPipelines() {
             .shaders = {
                 .vertex = mipmap_vs.AsRef(),
                 .fragment = mipmap_fs.AsRef(),
-            }
+            },
+            .specialization_constants = specialization_constants,
         };
         if (i == 0) {
             mipmap_pipeline_avg_render_ = device_->CreateRenderPipeline(mipmap_render_desc);
@@ -308,7 +335,8 @@ void HelperPipelines::InitMipmapPipelines() {
             .shaders = {
                 .vertex = mipmap_vs.AsRef(),
                 .fragment = mipmap_fs_depth.AsRef(),
-            }
+            },
+            .specialization_constants = specialization_constants,
         };
         if (i == 0) {
             mipmap_pipeline_avg_depth_ = device_->CreateRenderPipeline(mipmap_depth_desc);
@@ -328,6 +356,7 @@ void HelperPipelines::InitMipmapPipelines() {
             .layout = mipmap_layout,
             .thread_group = { 16, 16, 1 },
             .compute = mipmap_cs.AsRef(),
+            .specialization_constants = specialization_constants,
         };
         if (i == 0) {
             mipmap_pipeline_avg_compute_ = device_->CreateComputePipeline(mipmap_compute_desc);
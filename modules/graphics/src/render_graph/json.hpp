@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+
+#include "graphics/mod.hpp"
+
+BISMUTH_NAMESPACE_BEGIN
+
+BISMUTH_GFX_NAMESPACE_BEGIN
+
+// escape quotes and backslashes and replace control characters with spaces,
+// same escaping works for both json and dot strings
+inline void AppendEscapedString(std::string &out, const std::string &str) {
+    for (const char c : str) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out += ' ';
+        } else {
+            out += c;
+        }
+    }
+}
+
+inline void AppendJsonString(std::string &json, const std::string &str) {
+    json += '"';
+    AppendEscapedString(json, str);
+    json += '"';
+}
+
+BISMUTH_GFX_NAMESPACE_END
+
+BISMUTH_NAMESPACE_END
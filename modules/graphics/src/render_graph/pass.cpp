@@ -6,87 +6,124 @@ BISMUTH_NAMESPACE_BEGIN
 
 BISMUTH_GFX_NAMESPACE_BEGIN
 
-Ref<gfx::Buffer> PassResource::Buffer(const std::string &name) const {
-    if (read_buffers_.contains(name)) {
-        auto handle = read_buffers_.at(name).handle;
-        return graph_->Buffer(handle).buffer;
-    } else {
-        auto handle = write_buffers_.at(name).handle;
-        return graph_->Buffer(handle).buffer;
+namespace {
+
+// textures share the binding slots with buffers, so their keys are salted
+constexpr uint64_t kTextureBindingSalt = 0x9e3779b97f4a7c15ull;
+
+uint64_t BufferBindingKey(PassBindingId id) {
+    return id.value;
+}
+uint64_t TextureBindingKey(PassBindingId id) {
+    return id.value ^ kTextureBindingSalt;
+}
+
+// later declaration of the same binding overrides former one
+template <typename T>
+void SetBinding(PassBindings<T> &bindings, PassBindingId id, const T &value) {
+    for (auto &[binding_id, binding] : bindings) {
+        if (binding_id == id) {
+            binding = value;
+            return;
+        }
     }
+    bindings.emplace_back(id, value);
+}
+
+}
+
+Ref<gfx::Buffer> PassResource::Buffer(BufferHandle handle) const {
+    BI_ASSERT_MSG(FindSlot(declared_slots_, handle.node_index_ + 1), "buffer is not declared by the pass");
+    return graph_->Buffer(handle).buffer;
 }
 
-Ref<gfx::Texture> PassResource::Texture(const std::string &name) const {
-    if (read_textures_.contains(name)) {
-        auto handle = read_textures_.at(name).handle;
-        return graph_->Texture(handle).texture;
-    } else {
-        auto handle = write_textures_.at(name).handle;
-        return graph_->Texture(handle).texture;
+Ref<gfx::Texture> PassResource::Texture(TextureHandle handle) const {
+    BI_ASSERT_MSG(FindSlot(declared_slots_, handle.node_index_ + 1), "texture is not declared by the pass");
+    return graph_->Texture(handle).texture;
+}
+
+Ref<gfx::Buffer> PassResource::Buffer(PassBindingId id) const {
+    const auto slot = FindSlot(binding_slots_, BufferBindingKey(id));
+    BI_ASSERT_MSG(slot != nullptr, "buffer binding is not declared by the pass");
+    BufferHandle handle;
+    handle.node_index_ = slot->node_index;
+    return graph_->Buffer(handle).buffer;
+}
+
+Ref<gfx::Texture> PassResource::Texture(PassBindingId id) const {
+    const auto slot = FindSlot(binding_slots_, TextureBindingKey(id));
+    BI_ASSERT_MSG(slot != nullptr, "texture binding is not declared by the pass");
+    TextureHandle handle;
+    handle.node_index_ = slot->node_index;
+    return graph_->Texture(handle).texture;
+}
+
+void PassResource::ResolveSlots(Span<TextureHandle> target_handles) {
+    BI_ASSERT_MSG(read_buffers_.size() + write_buffers_.size() + read_textures_.size() + write_textures_.size()
+        + target_handles.Size() <= kMaxSlotKeys, "too many resources are declared by the pass");
+    // written first so that read bindings of the same id override them
+    for (const auto &[id, binding] : write_buffers_) {
+        InsertSlot(binding_slots_, BufferBindingKey(id), binding.handle.node_index_);
+        InsertSlot(declared_slots_, binding.handle.node_index_ + 1, binding.handle.node_index_);
+    }
+    for (const auto &[id, binding] : read_buffers_) {
+        InsertSlot(binding_slots_, BufferBindingKey(id), binding.handle.node_index_);
+        InsertSlot(declared_slots_, binding.handle.node_index_ + 1, binding.handle.node_index_);
+    }
+    for (const auto &[id, binding] : write_textures_) {
+        InsertSlot(binding_slots_, TextureBindingKey(id), binding.handle.node_index_);
+        InsertSlot(declared_slots_, binding.handle.node_index_ + 1, binding.handle.node_index_);
+    }
+    for (const auto &[id, binding] : read_textures_) {
+        InsertSlot(binding_slots_, TextureBindingKey(id), binding.handle.node_index_);
+        InsertSlot(declared_slots_, binding.handle.node_index_ + 1, binding.handle.node_index_);
+    }
+    for (const auto handle : target_handles) {
+        InsertSlot(declared_slots_, handle.node_index_ + 1, handle.node_index_);
     }
 }
 
-void PassResource::GetShaderBarriers(RenderGraph &rg, bool is_render_pass,
-    Vec<gfx::BufferBarrier> &buffer_barriers, Vec<gfx::TextureBarrier> &texture_barriers) {
-    for (auto &[_, handle] : read_buffers_) {
-        auto target_access_type = handle.type == BufferReadType::eStorage
-            ? (is_render_pass
-                ? gfx::ResourceAccessType::eRenderShaderStorageResourceRead
-                : gfx::ResourceAccessType::eComputeShaderStorageResourceRead)
-            : (is_render_pass
-                ? gfx::ResourceAccessType::eRenderShaderUniformBufferRead
-                : gfx::ResourceAccessType::eComputeShaderUniformBufferRead);
-
-        auto &buffer = rg.Buffer(handle.handle);
-        if (target_access_type != buffer.access_type) {
-            buffer_barriers.push_back(gfx::BufferBarrier {
-                .buffer = buffer.buffer,
-                .src_access_type = buffer.access_type,
-                .dst_access_type = target_access_type,
-            });
-            buffer.access_type = target_access_type;
+void PassResource::InsertSlot(Array<Slot, kNumSlots> &slots, uint64_t key, size_t node_index) {
+    for (size_t i = key % kNumSlots;; i = (i + 1) % kNumSlots) {
+        if (slots[i].key == 0 || slots[i].key == key) {
+            slots[i] = Slot { .key = key, .node_index = node_index };
+            return;
         }
     }
-    auto target_access_type = is_render_pass
-        ? gfx::ResourceAccessType::eRenderShaderSampledTextureRead
-        : gfx::ResourceAccessType::eComputeShaderSampledTextureRead;
-    for (auto &[_, handle] : read_textures_) {
-        auto &texture = rg.Texture(handle.handle);
-        if (target_access_type != texture.access_type) {
-            texture_barriers.push_back(gfx::TextureBarrier {
-                .texture = { texture.texture },
-                .src_access_type = texture.access_type,
-                .dst_access_type = target_access_type,
-            });
-            texture.access_type = target_access_type;
+}
+
+const PassResource::Slot *PassResource::FindSlot(const Array<Slot, kNumSlots> &slots, uint64_t key) {
+    // at most half of slots are used, so there is always an empty slot to stop at
+    for (size_t i = key % kNumSlots;; i = (i + 1) % kNumSlots) {
+        if (slots[i].key == key) {
+            return &slots[i];
+        }
+        if (slots[i].key == 0) {
+            return nullptr;
         }
     }
+}
+
+gfx::ResourceAccessType PassResource::ReadBufferAccessType(BufferReadType type, bool is_render_pass) {
+    return type == BufferReadType::eStorage
+        ? (is_render_pass
+            ? gfx::ResourceAccessType::eRenderShaderStorageResourceRead
+            : gfx::ResourceAccessType::eComputeShaderStorageResourceRead)
+        : (is_render_pass
+            ? gfx::ResourceAccessType::eRenderShaderUniformBufferRead
+            : gfx::ResourceAccessType::eComputeShaderUniformBufferRead);
+}
 
-    target_access_type = is_render_pass
+gfx::ResourceAccessType PassResource::ReadTextureAccessType(bool is_render_pass) {
+    return is_render_pass
+        ? gfx::ResourceAccessType::eRenderShaderSampledTextureRead
+        : gfx::ResourceAccessType::eComputeShaderSampledTextureRead;
+}
+
+gfx::ResourceAccessType PassResource::WriteAccessType(bool is_render_pass) {
+    return is_render_pass
         ? gfx::ResourceAccessType::eRenderShaderStorageResourceWrite
         : gfx::ResourceAccessType::eComputeShaderStorageResourceWrite;
-    for (auto &[_, handle] : write_buffers_) {
-        auto &buffer = rg.Buffer(handle.handle);
-        if (target_access_type != buffer.access_type) {
-            buffer_barriers.push_back(gfx::BufferBarrier {
-                .buffer = buffer.buffer,
-                .src_access_type = buffer.access_type,
-                .dst_access_type = target_access_type,
-            });
-            buffer.access_type = target_access_type;
-        }
-    }
-    for (auto &[_, handle] : write_textures_) {
-        auto &texture = rg.Texture(handle.handle);
-        if (target_access_type != texture.access_type) {
-            texture_barriers.push_back(gfx::TextureBarrier {
-                .texture = { texture.texture },
-                .src_access_type = texture.access_type,
-                .dst_access_type = target_access_type,
-            });
-            texture.access_type = target_access_type;
-        }
-    }
 }
 
 RenderPassColorTargetBuilder::RenderPassColorTargetBuilder(TextureHandle handle) {
@@ -166,43 +203,48 @@ RenderPassBuilder &RenderPassBuilder::DepthStencil(const RenderPassDepthStencilT
     return *this;
 }
 
-RenderPassBuilder &RenderPassBuilder::Read(const std::string &name, BufferHandle handle, BufferReadType type) {
-    read_buffers_[name] = { handle, type };
+RenderPassBuilder &RenderPassBuilder::Read(PassBindingId id, BufferHandle handle, BufferReadType type) {
+    SetBinding(read_buffers_, id, { handle, type });
+    return *this;
+}
+
+RenderPassBuilder &RenderPassBuilder::Read(PassBindingId id, TextureHandle handle) {
+    SetBinding(read_textures_, id, { handle });
     return *this;
 }
 
-RenderPassBuilder &RenderPassBuilder::Read(const std::string &name, TextureHandle handle) {
-    read_textures_[name] = { handle };
+RenderPassBuilder &RenderPassBuilder::Write(PassBindingId id, BufferHandle handle) {
+    SetBinding(write_buffers_, id, { handle });
     return *this;
 }
 
-RenderPassBuilder &RenderPassBuilder::Write(const std::string &name, BufferHandle handle) {
-    write_buffers_[name] = { handle };
+RenderPassBuilder &RenderPassBuilder::Write(PassBindingId id, TextureHandle handle, bool generate_mipmaps) {
+    SetBinding(write_textures_, id, { handle, generate_mipmaps });
     return *this;
 }
 
-RenderPassBuilder &RenderPassBuilder::Write(const std::string &name, TextureHandle handle, bool generate_mipmaps) {
-    write_textures_[name] = { handle, generate_mipmaps };
+ComputePassBuilder &ComputePassBuilder::Read(PassBindingId id, BufferHandle handle, BufferReadType type) {
+    SetBinding(read_buffers_, id, { handle, type });
     return *this;
 }
 
-ComputePassBuilder &ComputePassBuilder::Read(const std::string &name, BufferHandle handle, BufferReadType type) {
-    read_buffers_[name] = { handle, type };
+ComputePassBuilder &ComputePassBuilder::Read(PassBindingId id, TextureHandle handle) {
+    SetBinding(read_textures_, id, { handle });
     return *this;
 }
 
-ComputePassBuilder &ComputePassBuilder::Read(const std::string &name, TextureHandle handle) {
-    read_textures_[name] = { handle };
+ComputePassBuilder &ComputePassBuilder::Write(PassBindingId id, BufferHandle handle) {
+    SetBinding(write_buffers_, id, { handle });
     return *this;
 }
 
-ComputePassBuilder &ComputePassBuilder::Write(const std::string &name, BufferHandle handle) {
-    write_buffers_[name] = { handle };
+ComputePassBuilder &ComputePassBuilder::Write(PassBindingId id, TextureHandle handle, bool generate_mipmaps) {
+    SetBinding(write_textures_, id, { handle, generate_mipmaps });
     return *this;
 }
 
-ComputePassBuilder &ComputePassBuilder::Write(const std::string &name, TextureHandle handle, bool generate_mipmaps) {
-    write_textures_[name] = { handle, generate_mipmaps };
+ComputePassBuilder &ComputePassBuilder::AsyncCompute(bool async) {
+    async_compute_ = async;
     return *this;
 }
 
@@ -0,0 +1,55 @@
+#include "render_graph/profile.hpp"
+
+#include "json.hpp"
+
+BISMUTH_NAMESPACE_BEGIN
+
+BISMUTH_GFX_NAMESPACE_BEGIN
+
+namespace {
+
+void AppendEvent(std::string &json, bool &first, const std::string &name, const char *category,
+    uint32_t tid, double start, double duration, uint64_t frame) {
+    json += first ? "\n" : ",\n";
+    first = false;
+    json += "{\"name\":";
+    AppendJsonString(json, name);
+    json += ",\"cat\":\"";
+    json += category;
+    json += "\",\"ph\":\"X\",\"pid\":0,\"tid\":" + std::to_string(tid);
+    json += ",\"ts\":" + std::to_string(start);
+    json += ",\"dur\":" + std::to_string(duration);
+    json += ",\"args\":{\"frame\":" + std::to_string(frame) + "}}";
+}
+
+}
+
+std::string ToChromeTrace(Span<FrameProfile> frames) {
+    // tid 0 is gpu, cpu threads start from 1
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (const auto &frame : frames) {
+        for (const auto &creation : frame.resource_creations) {
+            AppendEvent(json, first, "create resources", "cpu", 1, creation.cpu_start, creation.cpu_duration,
+                frame.frame);
+        }
+        for (const auto &pass : frame.passes) {
+            if (pass.cpu_barrier_duration > 0.0) {
+                AppendEvent(json, first, pass.name + " barriers", "cpu", 1, pass.cpu_barrier_start,
+                    pass.cpu_barrier_duration, frame.frame);
+            }
+            AppendEvent(json, first, pass.name, "cpu", pass.cpu_thread + 1, pass.cpu_record_start,
+                pass.cpu_record_duration, frame.frame);
+            if (pass.has_gpu_time) {
+                AppendEvent(json, first, pass.name, "gpu", 0, frame.cpu_submit + pass.gpu_start,
+                    pass.gpu_duration, frame.frame);
+            }
+        }
+    }
+    json += "\n]}\n";
+    return json;
+}
+
+BISMUTH_GFX_NAMESPACE_END
+
+BISMUTH_NAMESPACE_END
@@ -0,0 +1,126 @@
+#include "render_graph/report.hpp"
+
+#include "json.hpp"
+
+BISMUTH_NAMESPACE_BEGIN
+
+BISMUTH_GFX_NAMESPACE_BEGIN
+
+namespace {
+
+void AppendField(std::string &json, const char *key, const std::string &value) {
+    json += ",\"";
+    json += key;
+    json += "\":";
+    json += value;
+}
+
+std::string ToString(bool value) {
+    return value ? "true" : "false";
+}
+
+std::string OrderToString(size_t order) {
+    return order == static_cast<size_t>(-1) ? "-1" : std::to_string(order);
+}
+
+}
+
+std::string ToJson(const CompileReport &report) {
+    std::string json = "{\"num_passes\":" + std::to_string(report.num_passes);
+    AppendField(json, "num_culled_passes", std::to_string(report.num_culled_passes));
+    AppendField(json, "num_resources", std::to_string(report.num_resources));
+    AppendField(json, "num_culled_resources", std::to_string(report.num_culled_resources));
+    AppendField(json, "unaliased_size", std::to_string(report.unaliased_size));
+    AppendField(json, "aliased_size", std::to_string(report.aliased_size));
+    AppendField(json, "peak_live_size", std::to_string(report.peak_live_size));
+    AppendField(json, "num_barriers", std::to_string(report.num_barriers));
+    AppendField(json, "num_barrier_batches", std::to_string(report.num_barrier_batches));
+    AppendField(json, "num_pool_hits", std::to_string(report.num_pool_hits));
+    AppendField(json, "num_pool_misses", std::to_string(report.num_pool_misses));
+    json += ",\"nodes\":[";
+    for (size_t i = 0; i < report.nodes.size(); i++) {
+        const auto &node = report.nodes[i];
+        json += i == 0 ? "\n{" : ",\n{";
+        json += "\"index\":" + std::to_string(i);
+        json += ",\"name\":";
+        AppendJsonString(json, node.name);
+        AppendField(json, "kind", node.is_resource ? "\"resource\"" : "\"pass\"");
+        AppendField(json, "culled", ToString(node.culled));
+        AppendField(json, "order", OrderToString(node.order));
+        if (node.is_resource) {
+            AppendField(json, "imported", ToString(node.imported));
+            AppendField(json, "size", std::to_string(node.size));
+            if (!node.culled) {
+                AppendField(json, "lifetime_start", std::to_string(node.lifetime_start));
+                AppendField(json, "lifetime_end", std::to_string(node.lifetime_end));
+            }
+            AppendField(json, "placed", ToString(node.placed));
+            if (node.placed) {
+                AppendField(json, "heap", std::to_string(node.heap));
+                AppendField(json, "offset", std::to_string(node.offset));
+            }
+        } else {
+            AppendField(json, "async_compute", ToString(node.async_compute));
+            AppendField(json, "num_planned_split_barriers", std::to_string(node.num_planned_split_barriers));
+            AppendField(json, "num_barriers", std::to_string(node.num_barriers));
+            AppendField(json, "num_split_barriers", std::to_string(node.num_split_barriers));
+        }
+        json += ",\"out_nodes\":[";
+        for (size_t j = 0; j < node.out_nodes.size(); j++) {
+            json += (j == 0 ? "" : ",") + std::to_string(node.out_nodes[j]);
+        }
+        json += "]}";
+    }
+    json += "\n]}\n";
+    return json;
+}
+
+std::string ToGraphviz(const CompileReport &report) {
+    std::string dot = "digraph render_graph {\n";
+    for (size_t i = 0; i < report.nodes.size(); i++) {
+        const auto &node = report.nodes[i];
+        std::string label;
+        AppendEscapedString(label, node.name);
+        if (node.is_resource) {
+            if (node.imported) {
+                label += "\\nimported";
+            } else {
+                label += "\\n" + std::to_string(node.size) + " bytes";
+            }
+            if (!node.culled) {
+                label += "\\nlifetime [" + std::to_string(node.lifetime_start) + ", "
+                    + std::to_string(node.lifetime_end) + "]";
+            }
+            if (node.placed) {
+                label += "\\nheap " + std::to_string(node.heap) + " + " + std::to_string(node.offset);
+            }
+        } else {
+            label += "\\norder " + OrderToString(node.order);
+            if (node.async_compute) {
+                label += "\\nasync compute";
+            }
+            if (!node.culled) {
+                label += "\\n" + std::to_string(node.num_barriers) + " barriers, "
+                    + std::to_string(node.num_split_barriers) + " split";
+            }
+        }
+        dot += "    n" + std::to_string(i) + " [label=\"" + label + "\"";
+        dot += node.is_resource ? ", shape=ellipse" : ", shape=box";
+        if (node.culled) {
+            dot += ", style=dashed, color=gray, fontcolor=gray";
+        }
+        dot += "];\n";
+    }
+    for (size_t i = 0; i < report.nodes.size(); i++) {
+        for (const size_t to : report.nodes[i].out_nodes) {
+            dot += "    n" + std::to_string(i) + " -> n" + std::to_string(to);
+            dot += report.nodes[i].culled || report.nodes[to].culled ? " [style=dashed, color=gray];\n" : ";\n";
+        }
+    }
+    dot += "}\n";
+    return dot;
+}
+
+BISMUTH_GFX_NAMESPACE_END
+
+BISMUTH_NAMESPACE_END
@@ -20,65 +20,257 @@ TextureKey::TextureKey(const gfx::TextureDesc &desc) {
     usages = desc.usages;
 }
 
+template <typename T>
+size_t ResourcePool::AddEntry(Pool<T> &pool, Ptr<T> &&resource, uint64_t size) {
+    size_t index;
+    if (!pool.evicted_index.empty()) {
+        index = pool.evicted_index.back();
+        pool.evicted_index.pop_back();
+    } else {
+        index = pool.entries.size();
+        pool.entries.emplace_back();
+    }
+    auto &entry = pool.entries[index];
+    entry.resource = std::move(resource);
+    entry.access = gfx::ResourceAccessType::eNone;
+    entry.size = size;
+    entry.last_used_frame = frame_;
+    ++stats_.num_live;
+    stats_.live_bytes += size;
+    return index;
+}
+
+template <typename T>
+size_t ResourcePool::GetIdleEntry(Pool<T> &pool) {
+    // most recently used one, so that old ones can be evicted
+    size_t index = pool.recycled_index.back();
+    pool.recycled_index.pop_back();
+    const auto &entry = pool.entries[index];
+    --stats_.num_idle;
+    stats_.idle_bytes -= entry.size;
+    ++stats_.num_live;
+    stats_.live_bytes += entry.size;
+    return index;
+}
+
+template <typename T>
+void ResourcePool::RecycleEntry(Pool<T> &pool, size_t index, gfx::ResourceAccessType access) {
+    auto &entry = pool.entries[index];
+    entry.access = access;
+    entry.last_used_frame = frame_;
+    pool.recycled_index.push_back(index);
+    --stats_.num_live;
+    stats_.live_bytes -= entry.size;
+    ++stats_.num_idle;
+    stats_.idle_bytes += entry.size;
+}
+
+template <typename T>
+void ResourcePool::EvictEntry(Pool<T> &pool, size_t index) {
+    auto &entry = pool.entries[index];
+    // destroyed when going out of scope
+    auto resource = std::move(entry.resource);
+    pool.evicted_index.push_back(index);
+    --stats_.num_idle;
+    stats_.idle_bytes -= entry.size;
+    ++stats_.num_evicted;
+    stats_.evicted_bytes += entry.size;
+}
+
+template <typename T>
+void ResourcePool::EvictByAge(Pool<T> &pool) {
+    size_t num_evicted = 0;
+    if (trim_requested_) {
+        num_evicted = pool.recycled_index.size();
+    } else if (max_idle_frames_ > 0) {
+        while (num_evicted < pool.recycled_index.size()
+            && frame_ - pool.entries[pool.recycled_index[num_evicted]].last_used_frame > max_idle_frames_) {
+            ++num_evicted;
+        }
+    }
+    for (size_t i = 0; i < num_evicted; i++) {
+        EvictEntry(pool, pool.recycled_index[i]);
+    }
+    pool.recycled_index.erase(pool.recycled_index.begin(), pool.recycled_index.begin() + num_evicted);
+}
+
+void ResourcePool::EvictToBudget(uint64_t extra_size) {
+    if (memory_budget_ == 0) {
+        return;
+    }
+    while (stats_.num_idle > 0 && stats_.live_bytes + stats_.idle_bytes + extra_size > memory_budget_) {
+        // idle entries of each pool are ordered by last use, least recently used one is at front of some pool,
+        // entries recycled in current frame may still be used by commands not submitted yet and are never evicted
+        Pool<gfx::Buffer> *oldest_buffer_pool = nullptr;
+        Pool<gfx::Texture> *oldest_texture_pool = nullptr;
+        uint64_t oldest_frame = frame_;
+        for (auto &[_, pool] : buffer_pools_) {
+            if (!pool.recycled_index.empty() && pool.entries[pool.recycled_index.front()].last_used_frame < oldest_frame) {
+                oldest_buffer_pool = &pool;
+                oldest_frame = pool.entries[pool.recycled_index.front()].last_used_frame;
+            }
+        }
+        for (auto &[_, pool] : texture_pools_) {
+            if (!pool.recycled_index.empty() && pool.entries[pool.recycled_index.front()].last_used_frame < oldest_frame) {
+                oldest_buffer_pool = nullptr;
+                oldest_texture_pool = &pool;
+                oldest_frame = pool.entries[pool.recycled_index.front()].last_used_frame;
+            }
+        }
+
+        if (oldest_texture_pool) {
+            EvictEntry(*oldest_texture_pool, oldest_texture_pool->recycled_index.front());
+            oldest_texture_pool->recycled_index.erase(oldest_texture_pool->recycled_index.begin());
+        } else if (oldest_buffer_pool) {
+            EvictEntry(*oldest_buffer_pool, oldest_buffer_pool->recycled_index.front());
+            oldest_buffer_pool->recycled_index.erase(oldest_buffer_pool->recycled_index.begin());
+        } else {
+            break;
+        }
+    }
+}
+
+void ResourcePool::BeginFrame(uint64_t frame) {
+    frame_ = frame;
+    stats_.num_hits = 0;
+    stats_.num_misses = 0;
+
+    for (auto &[_, pool] : buffer_pools_) {
+        EvictByAge(pool);
+    }
+    for (auto &[_, pool] : texture_pools_) {
+        EvictByAge(pool);
+    }
+    trim_requested_ = false;
+
+    EvictToBudget(0);
+
+    // pools of keys that are no longer used, e.g. after resolution changes
+    std::erase_if(buffer_pools_, [](const auto &item) {
+        return item.second.evicted_index.size() == item.second.entries.size();
+    });
+    std::erase_if(texture_pools_, [](const auto &item) {
+        return item.second.evicted_index.size() == item.second.entries.size();
+    });
+}
+
 ResourcePool::Buffer ResourcePool::GetBuffer(const gfx::BufferDesc &desc) {
     auto &pool = buffer_pools_[desc];
+    size_t index;
     if (!pool.recycled_index.empty()) {
-        size_t index = pool.recycled_index.back();
-        auto buffer_ref = pool.created_buffers[index].AsRef();
-        auto access = pool.access[index];
-        pool.recycled_index.pop_back();
-        return Buffer {
-            .buffer = buffer_ref,
-            .index = index,
-            .access_type = access,
-        };
+        index = GetIdleEntry(pool);
+        ++stats_.num_hits;
     } else {
-        auto buffer = device_->CreateBuffer(desc);
-        auto buffer_ref = buffer.AsRef();
-        pool.created_buffers.emplace_back(std::move(buffer));
-        pool.access.push_back(gfx::ResourceAccessType::eNone);
-        return Buffer {
-            .buffer = buffer_ref,
-            .index = pool.created_buffers.size() - 1,
-            .access_type = gfx::ResourceAccessType::eNone,
-        };
+        ++stats_.num_misses;
+        uint64_t size = device_->GetBufferMemoryRequirements(desc).size;
+        EvictToBudget(size);
+        index = AddEntry(pool, device_->CreateBuffer(desc), size);
     }
+    const auto &entry = pool.entries[index];
+    return Buffer {
+        .buffer = entry.resource.AsRef(),
+        .index = index,
+        .access_type = entry.access,
+    };
 }
 
 void ResourcePool::RemoveBuffer(const gfx::BufferDesc &desc, const Buffer &buffer) {
-    auto &pool = buffer_pools_[desc];
-    pool.recycled_index.push_back(buffer.index);
-    pool.access[buffer.index] = buffer.access_type;
+    RecycleEntry(buffer_pools_[desc], buffer.index, buffer.access_type);
 }
 
 ResourcePool::Texture ResourcePool::GetTexure(const gfx::TextureDesc &desc) {
     auto &pool = texture_pools_[desc];
-    if (!pool.recycled_index.empty()) {size_t index = pool.recycled_index.back();
-        auto texture_ref = pool.created_textures[index].AsRef();
-        auto access = pool.access[index];
-        pool.recycled_index.pop_back();
-        return Texture {
-            .texture = texture_ref,
-            .index = index,
-            .access_type = access,
-        };
+    size_t index;
+    if (!pool.recycled_index.empty()) {
+        index = GetIdleEntry(pool);
+        ++stats_.num_hits;
     } else {
-        auto texture = device_->CreateTexture(desc);
-        auto texture_ref = texture.AsRef();
-        pool.created_textures.emplace_back(std::move(texture));
-        pool.access.push_back(gfx::ResourceAccessType::eNone);
-        return Texture {
-            .texture = texture_ref,
-            .index = pool.created_textures.size() - 1,
-            .access_type = gfx::ResourceAccessType::eNone,
-        };
+        ++stats_.num_misses;
+        uint64_t size = device_->GetTextureMemoryRequirements(desc).size;
+        EvictToBudget(size);
+        index = AddEntry(pool, device_->CreateTexture(desc), size);
     }
+    const auto &entry = pool.entries[index];
+    return Texture {
+        .texture = entry.resource.AsRef(),
+        .index = index,
+        .access_type = entry.access,
+    };
 }
 
 void ResourcePool::RemoveTexture(const gfx::TextureDesc &desc, const Texture &texture) {
-    auto &pool = texture_pools_[desc];
-    pool.recycled_index.push_back(texture.index);
-    pool.access[texture.index] = texture.access_type;
+    RecycleEntry(texture_pools_[desc], texture.index, texture.access_type);
+}
+
+void ResourcePool::SetTransientHeaps(Span<gfx::MemoryHeapDesc> heaps, size_t version) {
+    if (version == transient_heaps_version_) {
+        return;
+    }
+
+    // placed resources must be destroyed before their heaps
+    placed_buffer_indices_.clear();
+    placed_buffers_.clear();
+    placed_buffers_access_.clear();
+    placed_texture_indices_.clear();
+    placed_textures_.clear();
+    placed_textures_access_.clear();
+
+    transient_heaps_.clear();
+    transient_heaps_.reserve(heaps.Size());
+    for (const auto &heap_desc : heaps) {
+        transient_heaps_.emplace_back(device_->CreateMemoryHeap(heap_desc));
+    }
+    transient_heaps_version_ = version;
+}
+
+ResourcePool::Buffer ResourcePool::GetPlacedBuffer(const gfx::BufferDesc &desc, size_t heap, uint64_t offset) {
+    PlacedBufferKey key { desc, heap, offset };
+    size_t index;
+    if (auto it = placed_buffer_indices_.find(key); it != placed_buffer_indices_.end()) {
+        index = it->second;
+        ++stats_.num_hits;
+    } else {
+        ++stats_.num_misses;
+        index = placed_buffers_.size();
+        placed_buffers_.emplace_back(device_->CreatePlacedBuffer(desc, transient_heaps_[heap].AsRef(), offset));
+        placed_buffers_access_.push_back(gfx::ResourceAccessType::eNone);
+        placed_buffer_indices_.insert({key, index});
+    }
+    return Buffer {
+        .buffer = placed_buffers_[index].AsRef(),
+        .index = index,
+        .access_type = placed_buffers_access_[index],
+        .discard = true,
+    };
+}
+
+void ResourcePool::RemovePlacedBuffer(const Buffer &buffer) {
+    placed_buffers_access_[buffer.index] = buffer.access_type;
+}
+
+ResourcePool::Texture ResourcePool::GetPlacedTexture(const gfx::TextureDesc &desc, size_t heap, uint64_t offset) {
+    PlacedTextureKey key { desc, heap, offset };
+    size_t index;
+    if (auto it = placed_texture_indices_.find(key); it != placed_texture_indices_.end()) {
+        index = it->second;
+        ++stats_.num_hits;
+    } else {
+        ++stats_.num_misses;
+        index = placed_textures_.size();
+        placed_textures_.emplace_back(device_->CreatePlacedTexture(desc, transient_heaps_[heap].AsRef(), offset));
+        placed_textures_access_.push_back(gfx::ResourceAccessType::eNone);
+        placed_texture_indices_.insert({key, index});
+    }
+    return Texture {
+        .texture = placed_textures_[index].AsRef(),
+        .index = index,
+        .access_type = placed_textures_access_[index],
+        .discard = true,
+    };
+}
+
+void ResourcePool::RemovePlacedTexture(const Texture &texture) {
+    placed_textures_access_[texture.index] = texture.access_type;
 }
 
 BISMUTH_GFX_NAMESPACE_END
@@ -0,0 +1,335 @@
+#include "shader_manager/shader_archive.hpp"
+
+#include <cstddef>
+#include <fstream>
+#include <mutex>
+#include <string_view>
+
+#include <core/file_lock.hpp>
+#include <core/module_manager.hpp>
+#include <core/utils.hpp>
+
+BISMUTH_NAMESPACE_BEGIN
+
+BISMUTH_GFX_NAMESPACE_BEGIN
+
+namespace {
+
+constexpr uint32_t kArchiveMagic = 0x41534942; // "BISA"
+constexpr uint32_t kArchiveVersion = 3;
+
+// SPIR-V words must be aligned
+constexpr uint64_t kBlobAlignment = 8;
+
+// archive is rewritten without garbage if garbage is more than live data and this size
+constexpr uint64_t kCompactThreshold = 4 << 20;
+
+struct ArchiveHeader {
+    uint32_t magic;
+    uint32_t version;
+    // slot 'generation % 2' holds the header
+    uint64_t generation;
+    uint64_t index_offset;
+    uint64_t index_size;
+    uint64_t index_hash;
+    // hash of all fields above
+    uint64_t header_hash;
+};
+
+constexpr size_t kNumHeaderSlots = 2;
+
+uint64_t HashHeader(const ArchiveHeader &header) {
+    return HashBytes(&header, offsetof(ArchiveHeader, header_hash));
+}
+
+// whether the header is completely written and its index is intact
+bool IsHeaderValid(const ArchiveHeader &header, const uint8_t *data, uint64_t size) {
+    return header.magic == kArchiveMagic && header.version == kArchiveVersion
+        && header.header_hash == HashHeader(header)
+        && header.index_offset <= size && header.index_size <= size - header.index_offset
+        && HashBytes(data + header.index_offset, header.index_size) == header.index_hash;
+}
+
+// blobs that are already in the file have 'data' == nullptr
+struct IndexRecord {
+    std::string_view name;
+    std::string_view metadata;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t hash;
+    const uint8_t *data;
+};
+
+template <typename T>
+void AppendPod(std::string &bytes, const T &value) {
+    bytes.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+class IndexReader {
+public:
+    IndexReader(const uint8_t *data, size_t size) : data_(data), size_(size) {}
+
+    template <typename T>
+    bool ReadPod(T &value) {
+        if (size_ - offset_ < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, data_ + offset_, sizeof(T));
+        offset_ += sizeof(T);
+        return true;
+    }
+
+    bool ReadString(std::string &str, size_t length) {
+        if (size_ - offset_ < length) {
+            return false;
+        }
+        str.assign(reinterpret_cast<const char *>(data_ + offset_), length);
+        offset_ += length;
+        return true;
+    }
+
+private:
+    const uint8_t *data_;
+    size_t size_;
+    size_t offset_ = 0;
+};
+
+void PadTo(std::fstream &file, uint64_t alignment) {
+    static const char kZeros[kBlobAlignment] = {};
+    const uint64_t pos = static_cast<uint64_t>(file.tellp());
+    file.write(kZeros, (alignment - pos % alignment) % alignment);
+}
+
+// write blobs at the end of file, then the index of all records, and finally the header pointing to the index
+// to the slot of its generation, the other slot keeps the previous header
+bool WriteRecords(std::fstream &file, const fs::path &path, Vec<IndexRecord> &records, uint64_t generation) {
+    file.seekp(0, std::ios::end);
+    for (auto &record : records) {
+        if (record.data != nullptr) {
+            PadTo(file, kBlobAlignment);
+            record.offset = static_cast<uint64_t>(file.tellp());
+            file.write(reinterpret_cast<const char *>(record.data), record.size);
+        }
+    }
+
+    std::string index;
+    AppendPod(index, static_cast<uint32_t>(records.size()));
+    for (const auto &record : records) {
+        AppendPod(index, record.offset);
+        AppendPod(index, record.size);
+        AppendPod(index, record.hash);
+        AppendPod(index, static_cast<uint32_t>(record.name.size()));
+        AppendPod(index, static_cast<uint32_t>(record.metadata.size()));
+        index.append(record.name);
+        index.append(record.metadata);
+    }
+    PadTo(file, kBlobAlignment);
+    ArchiveHeader header {
+        .magic = kArchiveMagic,
+        .version = kArchiveVersion,
+        .generation = generation,
+        .index_offset = static_cast<uint64_t>(file.tellp()),
+        .index_size = index.size(),
+        .index_hash = HashBytes(index.data(), index.size()),
+    };
+    header.header_hash = HashHeader(header);
+    file.write(index.data(), index.size());
+    // blobs and index must reach the disk before the header points to them, otherwise a power loss may keep
+    // the new header but not the data
+    file.flush();
+    if (!file || !SyncFile(path)) {
+        return false;
+    }
+
+    file.seekp(static_cast<std::streamoff>(generation % kNumHeaderSlots * sizeof(header)), std::ios::beg);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.flush();
+    return file && SyncFile(path);
+}
+
+}
+
+Rc<ShaderArchive> ShaderArchive::Open(const fs::path &path) {
+    static std::mutex archives_mutex;
+    static HashMap<std::string, std::weak_ptr<ShaderArchive>> archives;
+
+    std::lock_guard lock(archives_mutex);
+    auto &weak_archive = archives[fs::absolute(path).lexically_normal().string()];
+    if (auto archive = weak_archive.lock()) {
+        return archive;
+    }
+    auto archive = std::make_shared<ShaderArchive>(path);
+    weak_archive = archive;
+    return archive;
+}
+
+ShaderArchive::ShaderArchive(const fs::path &path) : path_(path) {
+    std::unique_lock lock(mutex_);
+    Load();
+}
+
+bool ShaderArchive::FindMetadata(const std::string &name, std::string &metadata) const {
+    std::shared_lock lock(mutex_);
+    auto it = entries_.find(name);
+    if (it == entries_.end()) {
+        return false;
+    }
+    metadata = it->second.metadata;
+    return true;
+}
+
+void ShaderArchive::Append(Span<Entry> entries) {
+    if (entries.Size() == 0) {
+        return;
+    }
+
+    std::unique_lock lock(mutex_);
+    // other processes may have appended since the archive was loaded, the archive is reloaded under the lock
+    // so that the new index includes their entries and blobs are written after their ones
+    auto lock_path = path_;
+    lock_path += ".lock";
+    FileLock file_lock(lock_path);
+    if (!file_lock.Locked()) {
+        BI_WARN(ModuleManager::Get<GraphicsModule>()->Lgr(), "Failed to lock shader archive '{}'", path_.string());
+        return;
+    }
+    Load();
+
+    Vec<IndexRecord> records;
+    records.reserve(entries.Size() + entries_.size());
+    HashMap<std::string_view, size_t> new_records;
+    for (const auto &entry : entries) {
+        auto [it, inserted] = new_records.insert({entry.name, records.size()});
+        IndexRecord record {
+            .name = entry.name,
+            .metadata = entry.metadata,
+            .offset = 0,
+            .size = entry.data.size(),
+            .hash = HashBytes(entry.data.data(), entry.data.size()),
+            .data = entry.data.data(),
+        };
+        if (inserted) {
+            records.push_back(record);
+        } else {
+            records[it->second] = record;
+        }
+    }
+
+    // rewrite the whole archive if it's invalid or has too much garbage
+    const uint64_t garbage_size = mapped_file_.Size() - std::min<uint64_t>(mapped_file_.Size(), live_size_);
+    const bool rewrite = !valid_ || (garbage_size > live_size_ && garbage_size > kCompactThreshold);
+
+    for (const auto &[name, entry] : entries_) {
+        if (!new_records.contains(name)) {
+            records.push_back(IndexRecord {
+                .name = name,
+                .metadata = entry.metadata,
+                .offset = entry.offset,
+                .size = entry.size,
+                .hash = entry.hash,
+                .data = rewrite ? mapped_file_.Data() + entry.offset : nullptr,
+            });
+        }
+    }
+
+    bool succeeded = false;
+    if (rewrite) {
+        // written to a temporary file first so that the archive is never partially written
+        const auto temp_path = UniqueTempPath(path_);
+        {
+            std::fstream file(temp_path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+            const ArchiveHeader empty_headers[kNumHeaderSlots] {};
+            file.write(reinterpret_cast<const char *>(empty_headers), sizeof(empty_headers));
+            succeeded = WriteRecords(file, temp_path, records, generation_ + 1);
+        }
+        if (succeeded) {
+            // old blobs are no longer used, the mapping must be released before the file can be replaced
+            mapped_file_ = MappedFile();
+            std::error_code error;
+            fs::rename(temp_path, path_, error);
+            succeeded = !error;
+        }
+        if (!succeeded) {
+            std::error_code error;
+            fs::remove(temp_path, error);
+        }
+    } else {
+        std::fstream file(path_, std::ios::in | std::ios::out | std::ios::binary);
+        succeeded = WriteRecords(file, path_, records, generation_ + 1);
+    }
+    if (!succeeded) {
+        BI_WARN(ModuleManager::Get<GraphicsModule>()->Lgr(), "Failed to append {} entries to shader archive '{}'",
+            entries.Size(), path_.string());
+    }
+
+    Load();
+}
+
+void ShaderArchive::Load() {
+    mapped_file_ = MappedFile(path_);
+    entries_.clear();
+    valid_ = false;
+    generation_ = 0;
+    live_size_ = 0;
+
+    if (mapped_file_.Size() < kNumHeaderSlots * sizeof(ArchiveHeader)) {
+        return;
+    }
+    // a torn header write only breaks the slot being written, the other one is the previous generation
+    ArchiveHeader header {};
+    bool found = false;
+    for (size_t slot = 0; slot < kNumHeaderSlots; slot++) {
+        ArchiveHeader slot_header;
+        std::memcpy(&slot_header, mapped_file_.Data() + slot * sizeof(slot_header), sizeof(slot_header));
+        if (slot_header.generation % kNumHeaderSlots == slot
+            && IsHeaderValid(slot_header, mapped_file_.Data(), mapped_file_.Size())
+            && (!found || slot_header.generation > header.generation)) {
+            header = slot_header;
+            found = true;
+        }
+    }
+    if (!found) {
+        return;
+    }
+    generation_ = header.generation;
+    const uint8_t *index_data = mapped_file_.Data() + header.index_offset;
+
+    IndexReader reader(index_data, header.index_size);
+    uint32_t num_entries = 0;
+    if (!reader.ReadPod(num_entries)) {
+        return;
+    }
+    entries_.reserve(num_entries);
+    live_size_ = kNumHeaderSlots * sizeof(ArchiveHeader) + header.index_size;
+    for (uint32_t i = 0; i < num_entries; i++) {
+        IndexEntry entry;
+        uint32_t name_size = 0;
+        uint32_t metadata_size = 0;
+        std::string name;
+        if (!reader.ReadPod(entry.offset) || !reader.ReadPod(entry.size) || !reader.ReadPod(entry.hash)
+            || !reader.ReadPod(name_size)
+            || !reader.ReadPod(metadata_size) || !reader.ReadString(name, name_size)
+            || !reader.ReadString(entry.metadata, metadata_size)
+            || entry.offset > header.index_offset || entry.size > header.index_offset - entry.offset) {
+            entries_.clear();
+            live_size_ = 0;
+            return;
+        }
+        live_size_ += entry.size;
+        entries_.insert({std::move(name), std::move(entry)});
+    }
+    valid_ = true;
+}
+
+bool ShaderArchive::VerifyEntry(const std::string &name, const IndexEntry &entry) const {
+    if (HashBytes(mapped_file_.Data() + entry.offset, entry.size) == entry.hash) {
+        return true;
+    }
+    BI_WARN(ModuleManager::Get<GraphicsModule>()->Lgr(), "Entry '{}' of shader archive '{}' is corrupted",
+        name, path_.string());
+    return false;
+}
+
+BISMUTH_GFX_NAMESPACE_END
+
+BISMUTH_NAMESPACE_END
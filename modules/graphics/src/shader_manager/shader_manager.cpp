@@ -1,24 +1,378 @@
 #include "shader_manager/shader_manager.hpp"
 
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
-#include <stack>
-#include <regex>
+#include <mutex>
+#include <sstream>
+
+#include <core/module_manager.hpp>
+#include <core/utils.hpp>
 
 #include "graphics/device.hpp"
+#include "shader_manager/shader_archive.hpp"
 
 BISMUTH_NAMESPACE_BEGIN
 
 BISMUTH_GFX_NAMESPACE_BEGIN
 
+namespace {
+
+uint64_t HashString(const std::string &str, uint64_t seed) {
+    // length is hashed too so that different splits of the same characters don't collide
+    const uint64_t length = str.size();
+    seed = HashBytes(&length, sizeof(length), seed);
+    return HashBytes(str.data(), str.size(), seed);
+}
+
+bool HashFile(const fs::path &path, uint64_t &hash) {
+    std::ifstream fin(path, std::ios::binary);
+    if (!fin) {
+        return false;
+    }
+    fin.seekg(0, std::ios::end);
+    size_t length = fin.tellg();
+    fin.seekg(0, std::ios::beg);
+    Vec<uint8_t> bytes(length);
+    fin.read(reinterpret_cast<char *>(bytes.data()), length);
+    if (!fin) {
+        return false;
+    }
+    hash = HashBytes(bytes.data(), bytes.size());
+    return true;
+}
+
+// content hashes of files used by one batch, so that files included by many shaders are read and hashed once,
+// shared by compile threads
+class FileHashCache {
+public:
+    bool Get(const fs::path &path, uint64_t &hash) {
+        std::string key = path.string();
+        {
+            std::lock_guard lock(mutex_);
+            if (auto it = hashes_.find(key); it != hashes_.end()) {
+                hash = it->second.second;
+                return it->second.first;
+            }
+        }
+        uint64_t file_hash = 0;
+        const bool found = HashFile(path, file_hash);
+        std::lock_guard lock(mutex_);
+        hashes_.insert({std::move(key), {found, file_hash}});
+        hash = file_hash;
+        return found;
+    }
+
+private:
+    std::mutex mutex_;
+    // path -> (file is readable, hash)
+    HashMap<std::string, std::pair<bool, uint64_t>> hashes_;
+};
+
+std::string ToHex(uint64_t value) {
+    char str[17];
+    std::snprintf(str, sizeof(str), "%016llx", static_cast<unsigned long long>(value));
+    return str;
+}
+
+// metadata of a binary records optimization result in the first line as
+// 'opt <optimization time> <unoptimized instructions> <instructions>',
+// then content hash of every file read during compiling, one 'dep <hash> <path>' per line
+std::string CompileInfoMetadata(const ShaderCompileInfo &info, FileHashCache &file_hashes) {
+    std::string metadata = "opt " + std::to_string(info.optimization_time_ms) + " "
+        + std::to_string(info.num_instructions_unoptimized) + " " + std::to_string(info.num_instructions) + "\n";
+    for (const auto &path : info.dependencies) {
+        uint64_t hash = 0;
+        if (file_hashes.Get(path, hash)) {
+            metadata += "dep " + ToHex(hash) + " " + path.string() + "\n";
+        }
+    }
+    return metadata;
+}
+
+// up to date if every recorded file still exists and has the same content, optimization result is read to 'stats'
+bool ReadMetadata(const std::string &metadata, ShaderCompileStats &stats, FileHashCache &file_hashes) {
+    std::istringstream sin(metadata);
+    std::string line;
+    if (!std::getline(sin, line) || line.compare(0, 4, "opt ") != 0) {
+        return false;
+    }
+    std::istringstream(line.substr(4)) >> stats.optimization_time_ms >> stats.num_instructions_unoptimized
+        >> stats.num_instructions;
+
+    size_t num_dependencies = 0;
+    while (std::getline(sin, line)) {
+        if (line.size() < 22 || line.compare(0, 4, "dep ") != 0 || line[20] != ' ') {
+            return false;
+        }
+        uint64_t hash = 0;
+        if (!file_hashes.Get(fs::path(line.substr(21)), hash) || ToHex(hash) != line.substr(4, 16)) {
+            return false;
+        }
+        ++num_dependencies;
+    }
+    return num_dependencies > 0;
+}
+
+// bump when layout of serialized reflection changes
+constexpr uint32_t kReflectionVersion = 1;
+
+// reflection is stored in archive as a separate entry next to the binary, so loading binary needn't reflect it
+std::string ReflectionEntryName(const std::string &binary_name) {
+    return binary_name + ".reflection";
+}
+
+Vec<uint8_t> SerializeReflection(const ShaderReflection &reflection) {
+    Vec<uint8_t> bytes;
+    auto write = [&bytes](uint32_t value) {
+        const auto value_bytes = reinterpret_cast<const uint8_t *>(&value);
+        bytes.insert(bytes.end(), value_bytes, value_bytes + sizeof(value));
+    };
+    write(kReflectionVersion);
+    write(static_cast<uint32_t>(reflection.stage));
+    write(static_cast<uint32_t>(reflection.entry_point.size()));
+    bytes.insert(bytes.end(), reflection.entry_point.begin(), reflection.entry_point.end());
+    write(reflection.push_constants_size);
+    write(reflection.thread_group_x);
+    write(reflection.thread_group_y);
+    write(reflection.thread_group_z);
+    write(static_cast<uint32_t>(reflection.sets_layout.size()));
+    for (const auto &set_layout : reflection.sets_layout) {
+        write(static_cast<uint32_t>(set_layout.bindings.size()));
+        for (const auto &binding : set_layout.bindings) {
+            write(static_cast<uint32_t>(binding.type));
+            write(static_cast<uint32_t>(binding.tex_dim));
+            write(static_cast<uint32_t>(binding.tex_format));
+            write(binding.count);
+            write(binding.struct_stride);
+        }
+    }
+    return bytes;
+}
+
+// return false if bytes are truncated or of another version
+bool DeserializeReflection(Span<uint8_t> bytes, ShaderReflection &reflection) {
+    size_t offset = 0;
+    auto read = [bytes, &offset](uint32_t &value) {
+        if (offset + sizeof(value) > bytes.Size()) {
+            return false;
+        }
+        memcpy(&value, bytes.Data() + offset, sizeof(value));
+        offset += sizeof(value);
+        return true;
+    };
+    // counts are checked against remaining bytes before allocating
+    auto fits = [bytes, &offset](uint32_t count, size_t element_size) {
+        return count <= (bytes.Size() - offset) / element_size;
+    };
+    constexpr size_t kBindingSize = sizeof(uint32_t) * 5;
+
+    uint32_t version = 0;
+    uint32_t stage = 0;
+    uint32_t entry_point_size = 0;
+    if (!read(version) || version != kReflectionVersion || !read(stage) || !read(entry_point_size)
+        || !fits(entry_point_size, 1)) {
+        return false;
+    }
+    reflection.stage = static_cast<ShaderStage>(stage);
+    reflection.entry_point.assign(reinterpret_cast<const char *>(bytes.Data() + offset), entry_point_size);
+    offset += entry_point_size;
+
+    uint32_t num_sets = 0;
+    if (!read(reflection.push_constants_size) || !read(reflection.thread_group_x)
+        || !read(reflection.thread_group_y) || !read(reflection.thread_group_z) || !read(num_sets)
+        || !fits(num_sets, sizeof(uint32_t))) {
+        return false;
+    }
+    reflection.sets_layout.resize(num_sets);
+    for (auto &set_layout : reflection.sets_layout) {
+        uint32_t num_bindings = 0;
+        if (!read(num_bindings) || !fits(num_bindings, kBindingSize)) {
+            return false;
+        }
+        set_layout.bindings.resize(num_bindings);
+        for (auto &binding : set_layout.bindings) {
+            uint32_t type = 0;
+            uint32_t tex_dim = 0;
+            uint32_t tex_format = 0;
+            read(type);
+            read(tex_dim);
+            read(tex_format);
+            read(binding.count);
+            read(binding.struct_stride);
+            binding.type = static_cast<DescriptorType>(type);
+            binding.tex_dim = static_cast<TextureViewDimension>(tex_dim);
+            binding.tex_format = static_cast<ResourceFormat>(tex_format);
+        }
+    }
+    return offset == bytes.Size();
+}
+
+}
+
 ShaderManager::ShaderManager(Ref<Device> device, const fs::path &binary_dir)
-    : device_(device), binary_dir_(binary_dir), compiler_(device->GetShaderCompiler()) {}
+    : device_(device), binary_dir_(binary_dir), compiler_(device->GetShaderCompiler()) {
+    std::error_code error;
+    fs::create_directories(binary_dir_, error);
+    archive_ = ShaderArchive::Open(binary_dir_ / (std::string("shader_archive") + compiler_->BinarySuffix()));
+}
 
 Ptr<ShaderModule> ShaderManager::GetShaderModule(const std::string &src_name, const fs::path &src_path,
     const std::string &entry, ShaderStage stage, const HashMap<std::string, std::string> &defines,
     const Vec<fs::path> &include_dirs, bool force) {
+    ShaderModuleDesc desc {
+        .src_name = src_name,
+        .src_path = src_path,
+        .entry = entry,
+        .stage = stage,
+        .defines = defines,
+        .include_dirs = include_dirs,
+        .force = force,
+    };
+    return GetShaderModule(desc);
+}
+
+Ptr<ShaderModule> ShaderManager::GetShaderModule(const ShaderModuleDesc &desc, ShaderCompileStats *stats) {
+    Vec<ShaderCompileStats> batch_stats;
+    auto shader_modules = GetShaderModules(Span<ShaderModuleDesc>(&desc, 1), stats ? &batch_stats : nullptr);
+    if (stats) {
+        *stats = batch_stats[0];
+    }
+    return std::move(shader_modules[0]);
+}
+
+Vec<Ptr<ShaderModule>> ShaderManager::GetShaderModules(Span<ShaderModuleDesc> descs,
+    Vec<ShaderCompileStats> *stats) {
+    const auto start = std::chrono::steady_clock::now();
+
+    // same permutation in the batch is compiled once
+    Vec<std::string> binary_names(descs.Size());
+    Vec<size_t> unique_indices;
+    Vec<size_t> source_indices(descs.Size());
+    HashMap<std::string, size_t> name_to_index;
+    for (size_t i = 0; i < descs.Size(); i++) {
+        binary_names[i] = BinaryName(descs[i]);
+        auto [it, inserted] = name_to_index.insert({binary_names[i], i});
+        if (inserted) {
+            unique_indices.push_back(i);
+        }
+        source_indices[i] = it->second;
+    }
+
+    // binaries that are not in archive or out of date are compiled, reflection is compiled with them
+    Vec<ShaderArchive::Entry> compiled(unique_indices.size());
+    Vec<ShaderArchive::Entry> compiled_reflections(unique_indices.size());
+    Vec<ShaderReflection> reflections(descs.Size());
+    Vec<ShaderCompileStats> temp_stats(descs.Size());
+    FileHashCache file_hashes;
+    auto load_or_compile = [&](size_t i) {
+        const size_t index = unique_indices[i];
+        const auto &desc = descs[index];
+        const auto shader_start = std::chrono::steady_clock::now();
+
+        std::string metadata;
+        auto &shader_stats = temp_stats[index];
+        bool reflection_loaded = false;
+        if (!desc.force && archive_->FindMetadata(binary_names[index], metadata)
+            && ReadMetadata(metadata, shader_stats, file_hashes)) {
+            archive_->Read(ReflectionEntryName(binary_names[index]), [&](Span<uint8_t> bytes) {
+                reflection_loaded = DeserializeReflection(bytes, reflections[index]);
+            });
+        }
+        if (reflection_loaded) {
+            shader_stats.binary_loaded = true;
+        } else {
+            ShaderCompileInfo info;
+            compiled[i] = ShaderArchive::Entry {
+                .name = binary_names[index],
+                .data = compiler_->Compile(desc.src_path, desc.entry, desc.stage, desc.defines, desc.include_dirs,
+                    ShaderCompileOptions { .optimization = desc.optimization }, &info),
+            };
+            compiled[i].metadata = CompileInfoMetadata(info, file_hashes);
+            compiled_reflections[i] = ShaderArchive::Entry {
+                .name = ReflectionEntryName(binary_names[index]),
+                .data = SerializeReflection(info.reflection),
+            };
+            reflections[index] = std::move(info.reflection);
+            shader_stats = ShaderCompileStats {
+                .optimization_time_ms = info.optimization_time_ms,
+                .num_instructions_unoptimized = info.num_instructions_unoptimized,
+                .num_instructions = info.num_instructions,
+            };
+        }
+        shader_stats.time_ms =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - shader_start).count();
+    };
+    if (unique_indices.size() > 1) {
+        CompileThreadPool().ParallelFor(unique_indices.size(), load_or_compile);
+    } else if (unique_indices.size() == 1) {
+        load_or_compile(0);
+    }
+
+    Vec<ShaderArchive::Entry> new_entries;
+    for (size_t i = 0; i < unique_indices.size(); i++) {
+        if (!temp_stats[unique_indices[i]].binary_loaded) {
+            new_entries.push_back(std::move(compiled[i]));
+            new_entries.push_back(std::move(compiled_reflections[i]));
+        }
+    }
+    // all new binaries of the batch become visible at once
+    archive_->Append(new_entries);
+
+    // modules are created from mapped bytes of archive and are not reflected again
+    Vec<Ptr<ShaderModule>> shader_modules;
+    shader_modules.reserve(descs.Size());
+    for (size_t i = 0; i < descs.Size(); i++) {
+        const size_t source_index = source_indices[i];
+        Ptr<ShaderModule> shader_module;
+        if (!archive_->Read(binary_names[i], [&](Span<uint8_t> bytes) {
+            shader_module = device_->CreateShaderModule(bytes, &reflections[source_index]);
+        })) {
+            // failed to write archive, use compiled bytes directly
+            for (const auto &entry : new_entries) {
+                if (entry.name == binary_names[i]) {
+                    shader_module = device_->CreateShaderModule(entry.data, &reflections[source_index]);
+                    break;
+                }
+            }
+        }
+        BI_ASSERT_MSG(shader_module.IsInitialized(), "shader binary is neither in archive nor compiled");
+        shader_modules.emplace_back(std::move(shader_module));
+        if (source_index != i) {
+            temp_stats[i] = temp_stats[source_index];
+        }
+    }
+
+    const size_t num_compiled = new_entries.size() / 2;
+    if (descs.Size() > 1) {
+        const auto duration = std::chrono::steady_clock::now() - start;
+        uint32_t num_instructions_unoptimized = 0;
+        uint32_t num_instructions = 0;
+        double optimization_time_ms = 0.0;
+        for (size_t index : unique_indices) {
+            num_instructions_unoptimized += temp_stats[index].num_instructions_unoptimized;
+            num_instructions += temp_stats[index].num_instructions;
+            if (!temp_stats[index].binary_loaded) {
+                optimization_time_ms += temp_stats[index].optimization_time_ms;
+            }
+        }
+        BI_INFO(ModuleManager::Get<GraphicsModule>()->Lgr(),
+            "Get {} shaders ({} compiled) in {:.2f} ms, {} -> {} instructions ({:.2f} ms optimizing)",
+            descs.Size(), num_compiled, std::chrono::duration<double, std::milli>(duration).count(),
+            num_instructions_unoptimized, num_instructions, optimization_time_ms);
+    }
+
+    if (stats) {
+        *stats = std::move(temp_stats);
+    }
+    return shader_modules;
+}
+
+std::string ShaderManager::BinaryName(const ShaderModuleDesc &desc) const {
     Vec<std::string> ordered_defines;
-    ordered_defines.reserve(defines.size());
-    for (const auto &[key, value] : defines) {
+    ordered_defines.reserve(desc.defines.size());
+    for (const auto &[key, value] : desc.defines) {
         if (value.empty()) {
             ordered_defines.push_back(key);
         } else {
@@ -26,26 +380,27 @@ Ptr<ShaderModule> ShaderManager::GetShaderModule(const std::string &src_name, co
         }
     }
     std::sort(ordered_defines.begin(), ordered_defines.end());
-    size_t defines_hash = 0;
+
+    // binary name is determined by compile options, file contents are checked against the dependencies metadata
+    uint64_t key = HashString(desc.src_path.generic_string(), 0);
+    key = HashString(desc.entry, key);
+    const uint32_t stage_value = static_cast<uint32_t>(desc.stage);
+    key = HashBytes(&stage_value, sizeof(stage_value), key);
     for (const auto &define : ordered_defines) {
-        defines_hash = HashCombine(defines_hash, define);
-    }
-    auto binary_path = binary_dir_ / (src_name + "-" + std::to_string(defines_hash) + compiler_->BinarySuffix());
-
-    if (!fs::exists(binary_path) || fs::last_write_time(src_path) > fs::last_write_time(binary_path) || force) {
-        auto bytes = compiler_->Compile(src_path, entry, stage, defines, include_dirs);
-        std::ofstream fout(binary_path, std::ios::binary);
-        fout.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
-        return device_->CreateShaderModule(bytes);
-    } else {
-        std::ifstream fin(binary_path, std::ios::binary);
-        fin.seekg(0, std::ios::end);
-        size_t length = fin.tellg();
-        fin.seekg(0, std::ios::beg);
-        Vec<uint8_t> bytes(length);
-        fin.read(reinterpret_cast<char *>(bytes.data()), length);
-        return device_->CreateShaderModule(bytes);
+        key = HashString(define, key);
+    }
+    for (const auto &dir : desc.include_dirs) {
+        key = HashString(dir.generic_string(), key);
     }
+    const uint32_t optimization_value = static_cast<uint32_t>(desc.optimization);
+    key = HashBytes(&optimization_value, sizeof(optimization_value), key);
+    key = HashString(compiler_->Version(), key);
+    return desc.src_name + "-" + ToHex(key);
+}
+
+ThreadPool &ShaderManager::CompileThreadPool() {
+    std::call_once(thread_pool_flag_, [this]() { thread_pool_ = Ptr<ThreadPool>::Make(); });
+    return *thread_pool_;
 }
 
 BISMUTH_GFX_NAMESPACE_END
@@ -1,5 +1,5 @@
 add_requires("volk", {configs = {header_only = true}})
-add_requires("vulkan-memory-allocator", "spirv-cross", "spirv-reflect", "glslang", "glfw")
+add_requires("vulkan-memory-allocator", "spirv-cross", "spirv-reflect", "spirv-tools", "glslang", "glfw")
 if is_plat("windows") then
     add_requires("vcpkg::d3d12-memory-allocator", "directxshadercompiler")
 end
@@ -30,7 +30,7 @@ target("bismuth-graphics")
     add_headerfiles("src/shader_manager/*.hpp", {install = false})
 
     add_deps("bismuth-core", {public = true})
-    add_packages("volk", "vulkan-memory-allocator", "spirv-cross", "spirv-reflect", "glslang", "glfw")
+    add_packages("volk", "vulkan-memory-allocator", "spirv-cross", "spirv-reflect", "spirv-tools", "glslang", "glfw")
     if is_plat("windows") then
         add_defines("VK_USE_PLATFORM_WIN32_KHR")
         add_packages("vcpkg::d3d12-memory-allocator", "directxshadercompiler")
@@ -88,3 +88,15 @@ if has_config("build_example") then
         add_deps("bismuth-graphics")
         add_packages("glfw", "glm")
 end
+
+if has_config("build_bench") then
+    set_configvar("BENCH_DIR", "$(curdir)/modules/graphics/bench")
+    add_configfiles("bench/bench.hpp.in", {prefixdir = "graphics"})
+    add_includedirs("$(buildir)")
+
+    target("bismuth-graphics-bench-descriptor_set")
+        set_kind("binary")
+        add_files("bench/descriptor_set.cpp")
+        add_deps("bismuth-graphics")
+        add_packages("glfw")
+end
@@ -6,4 +6,8 @@ option("build_example")
     set_description("If build example executables")
 option_end()
 
+option("build_bench")
+    set_description("If build benchmark executables")
+option_end()
+
 includes("modules/xmake.lua")